@@ -0,0 +1,106 @@
+#ifndef REFRAMEWORK_D2D_API_H
+#define REFRAMEWORK_D2D_API_H
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#include <stdint.h>
+
+// Native drawing API exported by reframework-d2d.dll, for plugins that want to draw without going through Lua.
+//
+// Get the function table with refd2d_get_api(REFD2D_API_VERSION_MAJOR). Minor versions only ever append to the end of the table, so
+// check version_minor (or size) before using anything newer than what you need.
+//
+// Drawing goes through layers. Each layer is meant to be used by one thread: begin a batch, record into it, submit it. The submitted
+// batch stays on screen until the layer submits again or is destroyed. Layers are drawn in ascending order, Lua scripts draw at
+// order 0, ties are drawn in the order the layers were created.
+//
+// Colors are 0xAARRGGBB. Functions that can fail return false or NULL, last_error gives the reason on the calling thread.
+
+#define REFD2D_API_VERSION_MAJOR 1
+#define REFD2D_API_VERSION_MINOR 3
+
+#define REFD2D_LUA_LAYER_ORDER 0
+
+typedef struct REFD2DLayer_* REFD2DLayerHandle;
+typedef struct REFD2DFont_* REFD2DFontHandle;
+typedef struct REFD2DImage_* REFD2DImageHandle;
+
+typedef struct {
+    // sizeof(REFD2DApi) as built into the DLL.
+    uint32_t size;
+    uint32_t version_major;
+    uint32_t version_minor;
+
+    const char* (*last_error)(void);
+
+    // The size scripts draw in. Both are 0 until the renderer has been created.
+    void (*surface_size)(uint32_t* width, uint32_t* height);
+
+    REFD2DLayerHandle (*create_layer)(const char* name, int order);
+    void (*destroy_layer)(REFD2DLayerHandle layer);
+    // Throws away anything recorded since the last submit.
+    void (*begin)(REFD2DLayerHandle layer);
+    void (*submit)(REFD2DLayerHandle layer);
+
+    // Fonts and images are reference counted, destroying the handle doesn't affect batches already recorded with it.
+    REFD2DFontHandle (*create_font)(const char* family, int size, bool bold, bool italic);
+    // Loads a font file. An empty family picks the file's first family.
+    REFD2DFontHandle (*load_font)(const char* filepath, const char* family, int size, bool bold, bool italic);
+    void (*destroy_font)(REFD2DFontHandle font);
+    bool (*measure_text)(REFD2DFontHandle font, const char* text, float* width, float* height);
+
+    // Takes a full path, unlike d2d.Image.new in Lua which looks in reframework/images.
+    REFD2DImageHandle (*load_image)(const char* filepath);
+    void (*destroy_image)(REFD2DImageHandle image);
+    void (*image_size)(REFD2DImageHandle image, uint32_t* width, uint32_t* height);
+
+    void (*text)(REFD2DLayerHandle layer, REFD2DFontHandle font, const char* text, float x, float y, uint32_t color);
+    void (*fill_rect)(REFD2DLayerHandle layer, float x, float y, float w, float h, uint32_t color);
+    void (*outline_rect)(REFD2DLayerHandle layer, float x, float y, float w, float h, float thickness, uint32_t color);
+    void (*rounded_rect)(
+        REFD2DLayerHandle layer, float x, float y, float w, float h, float rx, float ry, float thickness, uint32_t color);
+    void (*fill_rounded_rect)(REFD2DLayerHandle layer, float x, float y, float w, float h, float rx, float ry, uint32_t color);
+    void (*quad)(REFD2DLayerHandle layer, float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4,
+        float thickness, uint32_t color);
+    void (*fill_quad)(
+        REFD2DLayerHandle layer, float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, uint32_t color);
+    void (*line)(REFD2DLayerHandle layer, float x1, float y1, float x2, float y2, float thickness, uint32_t color);
+    void (*image)(REFD2DLayerHandle layer, REFD2DImageHandle image, float x, float y, float w, float h, float alpha);
+    void (*image_rect)(REFD2DLayerHandle layer, REFD2DImageHandle image, float sx, float sy, float sw, float sh, float x, float y,
+        float w, float h, float alpha);
+    void (*fill_circle)(REFD2DLayerHandle layer, float x, float y, float rx, float ry, uint32_t color);
+    void (*circle)(REFD2DLayerHandle layer, float x, float y, float rx, float ry, float thickness, uint32_t color);
+    void (*pie)(REFD2DLayerHandle layer, float x, float y, float r, float start_angle, float sweep_angle, uint32_t color,
+        bool clockwise);
+    void (*outline_pie)(REFD2DLayerHandle layer, float x, float y, float r, float start_angle, float sweep_angle, float thickness,
+        uint32_t color, bool clockwise);
+    void (*ring)(REFD2DLayerHandle layer, float x, float y, float outer_radius, float inner_radius, float start_angle,
+        float sweep_angle, uint32_t color, bool clockwise);
+    void (*outline_ring)(REFD2DLayerHandle layer, float x, float y, float outer_radius, float inner_radius, float start_angle,
+        float sweep_angle, float thickness, uint32_t color, bool clockwise);
+
+    // Since 1.1. Transforms what's drawn until the matching pop_transform, on top of the transforms already pushed. The matrix maps
+    // (x, y) to (x * m11 + y * m21 + dx, x * m12 + y * m22 + dy). Batches start untransformed, extra pops are ignored.
+    void (*push_transform)(REFD2DLayerHandle layer, float m11, float m12, float m21, float m22, float dx, float dy);
+    void (*pop_transform)(REFD2DLayerHandle layer);
+
+    // Since 1.2. Clips what's drawn until the matching pop_clip to the rectangle, in the coordinates of the current transform (its
+    // bounds if rotated), within the clips already pushed. Draws entirely outside the clip are dropped as they're recorded. Batches
+    // start unclipped, extra pops are ignored.
+    void (*push_clip)(REFD2DLayerHandle layer, float x, float y, float w, float h);
+    void (*pop_clip)(REFD2DLayerHandle layer);
+
+    // Since 1.3. points is point_count x, y pairs, drawn as one figure with joined segments. Polylines need at least 2 points and
+    // polygons 3, fewer draw nothing.
+    void (*polyline)(REFD2DLayerHandle layer, const float* points, uint32_t point_count, float thickness, uint32_t color, bool closed);
+    void (*fill_polygon)(REFD2DLayerHandle layer, const float* points, uint32_t point_count, uint32_t color);
+} REFD2DApi;
+
+// Returns NULL if the DLL doesn't implement the requested major version.
+typedef const REFD2DApi* (*REFD2DGetApiFn)(uint32_t version_major);
+
+#define REFD2D_GET_API_EXPORT "refd2d_get_api"
+
+#endif
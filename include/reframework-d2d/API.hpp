@@ -0,0 +1,205 @@
+#pragma once
+
+// Header only C++ wrapper around API.h. Handles are owned by move only RAII types, failures throw std::runtime_error.
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "API.h"
+
+namespace refd2d {
+namespace detail {
+template <typename Handle, void (*REFD2DApi::*Destroy)(Handle)> class Owned {
+public:
+    Owned() = default;
+    Owned(const REFD2DApi* api, Handle handle)
+        : m_api{api}
+        , m_handle{handle} {
+        if (m_handle == nullptr) {
+            throw std::runtime_error{m_api->last_error()};
+        }
+    }
+    Owned(const Owned&) = delete;
+    Owned(Owned&& other) noexcept
+        : m_api{other.m_api}
+        , m_handle{std::exchange(other.m_handle, nullptr)} {}
+    ~Owned() { reset(); }
+
+    Owned& operator=(const Owned&) = delete;
+    Owned& operator=(Owned&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_api = other.m_api;
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+
+        return *this;
+    }
+
+    void reset() {
+        if (m_handle != nullptr) {
+            (m_api->*Destroy)(m_handle);
+            m_handle = nullptr;
+        }
+    }
+
+    Handle handle() const { return m_handle; }
+    const REFD2DApi* api() const { return m_api; }
+    explicit operator bool() const { return m_handle != nullptr; }
+
+private:
+    const REFD2DApi* m_api{};
+    Handle m_handle{};
+};
+} // namespace detail
+
+#ifdef _WIN32
+// The API of the already loaded reframework-d2d.dll, nullptr if it isn't loaded or doesn't implement this major version.
+inline const REFD2DApi* get_api(const char* module_name = "reframework-d2d.dll") {
+    auto module = GetModuleHandleA(module_name);
+
+    if (module == nullptr) {
+        return nullptr;
+    }
+
+    auto get = (REFD2DGetApiFn)GetProcAddress(module, REFD2D_GET_API_EXPORT);
+
+    return get != nullptr ? get(REFD2D_API_VERSION_MAJOR) : nullptr;
+}
+#endif
+
+inline std::tuple<uint32_t, uint32_t> surface_size(const REFD2DApi* api) {
+    uint32_t w{};
+    uint32_t h{};
+    api->surface_size(&w, &h);
+    return {w, h};
+}
+
+class Font : public detail::Owned<REFD2DFontHandle, &REFD2DApi::destroy_font> {
+public:
+    Font() = default;
+    Font(const REFD2DApi* api, const std::string& family, int size, bool bold = false, bool italic = false)
+        : Owned{api, api->create_font(family.c_str(), size, bold, italic)} {}
+
+    static Font load(const REFD2DApi* api, const std::string& filepath, const std::string& family, int size, bool bold = false,
+        bool italic = false) {
+        return Font{api, api->load_font(filepath.c_str(), family.c_str(), size, bold, italic)};
+    }
+
+    std::tuple<float, float> measure(const std::string& text) const {
+        float w{};
+        float h{};
+
+        if (!api()->measure_text(handle(), text.c_str(), &w, &h)) {
+            throw std::runtime_error{api()->last_error()};
+        }
+
+        return {w, h};
+    }
+
+private:
+    Font(const REFD2DApi* api, REFD2DFontHandle handle)
+        : Owned{api, handle} {}
+};
+
+class Image : public detail::Owned<REFD2DImageHandle, &REFD2DApi::destroy_image> {
+public:
+    Image() = default;
+    Image(const REFD2DApi* api, const std::string& filepath)
+        : Owned{api, api->load_image(filepath.c_str())} {}
+
+    std::tuple<uint32_t, uint32_t> size() const {
+        uint32_t w{};
+        uint32_t h{};
+        api()->image_size(handle(), &w, &h);
+        return {w, h};
+    }
+};
+
+// Lua draws at order 0, the default puts native layers on top of it.
+class Layer : public detail::Owned<REFD2DLayerHandle, &REFD2DApi::destroy_layer> {
+public:
+    Layer() = default;
+    Layer(const REFD2DApi* api, const std::string& name, int order = REFD2D_LUA_LAYER_ORDER + 1)
+        : Owned{api, api->create_layer(name.c_str(), order)} {}
+
+    void begin() { api()->begin(handle()); }
+    void submit() { api()->submit(handle()); }
+
+    void text(const Font& font, const std::string& text, float x, float y, uint32_t color) {
+        api()->text(handle(), font.handle(), text.c_str(), x, y, color);
+    }
+    void fill_rect(float x, float y, float w, float h, uint32_t color) { api()->fill_rect(handle(), x, y, w, h, color); }
+    void outline_rect(float x, float y, float w, float h, float thickness, uint32_t color) {
+        api()->outline_rect(handle(), x, y, w, h, thickness, color);
+    }
+    void rounded_rect(float x, float y, float w, float h, float rx, float ry, float thickness, uint32_t color) {
+        api()->rounded_rect(handle(), x, y, w, h, rx, ry, thickness, color);
+    }
+    void fill_rounded_rect(float x, float y, float w, float h, float rx, float ry, uint32_t color) {
+        api()->fill_rounded_rect(handle(), x, y, w, h, rx, ry, color);
+    }
+    void quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, float thickness, uint32_t color) {
+        api()->quad(handle(), x1, y1, x2, y2, x3, y3, x4, y4, thickness, color);
+    }
+    void fill_quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, uint32_t color) {
+        api()->fill_quad(handle(), x1, y1, x2, y2, x3, y3, x4, y4, color);
+    }
+    void line(float x1, float y1, float x2, float y2, float thickness, uint32_t color) {
+        api()->line(handle(), x1, y1, x2, y2, thickness, color);
+    }
+    void image(const Image& image, float x, float y, float alpha = 1.0f) {
+        auto [w, h] = image.size();
+        this->image(image, x, y, (float)w, (float)h, alpha);
+    }
+    void image(const Image& image, float x, float y, float w, float h, float alpha = 1.0f) {
+        api()->image(handle(), image.handle(), x, y, w, h, alpha);
+    }
+    void image(const Image& image, float sx, float sy, float sw, float sh, float x, float y, float w, float h, float alpha = 1.0f) {
+        api()->image_rect(handle(), image.handle(), sx, sy, sw, sh, x, y, w, h, alpha);
+    }
+    void fill_circle(float x, float y, float r, uint32_t color) { api()->fill_circle(handle(), x, y, r, r, color); }
+    void circle(float x, float y, float r, float thickness, uint32_t color) { api()->circle(handle(), x, y, r, r, thickness, color); }
+    void fill_oval(float x, float y, float rx, float ry, uint32_t color) { api()->fill_circle(handle(), x, y, rx, ry, color); }
+    void oval(float x, float y, float rx, float ry, float thickness, uint32_t color) {
+        api()->circle(handle(), x, y, rx, ry, thickness, color);
+    }
+    void pie(float x, float y, float r, float start_angle, float sweep_angle, uint32_t color, bool clockwise = true) {
+        api()->pie(handle(), x, y, r, start_angle, sweep_angle, color, clockwise);
+    }
+    void outline_pie(
+        float x, float y, float r, float start_angle, float sweep_angle, float thickness, uint32_t color, bool clockwise = true) {
+        api()->outline_pie(handle(), x, y, r, start_angle, sweep_angle, thickness, color, clockwise);
+    }
+    void ring(float x, float y, float outer_radius, float inner_radius, float start_angle, float sweep_angle, uint32_t color,
+        bool clockwise = true) {
+        api()->ring(handle(), x, y, outer_radius, inner_radius, start_angle, sweep_angle, color, clockwise);
+    }
+    void outline_ring(float x, float y, float outer_radius, float inner_radius, float start_angle, float sweep_angle, float thickness,
+        uint32_t color, bool clockwise = true) {
+        api()->outline_ring(handle(), x, y, outer_radius, inner_radius, start_angle, sweep_angle, thickness, color, clockwise);
+    }
+    // Need API version 1.1.
+    void push_transform(float m11, float m12, float m21, float m22, float dx, float dy) {
+        api()->push_transform(handle(), m11, m12, m21, m22, dx, dy);
+    }
+    void pop_transform() { api()->pop_transform(handle()); }
+    // Need API version 1.3. points is point_count x, y pairs.
+    void polyline(const float* points, uint32_t point_count, float thickness, uint32_t color, bool closed = false) {
+        api()->polyline(handle(), points, point_count, thickness, color, closed);
+    }
+    void fill_polygon(const float* points, uint32_t point_count, uint32_t color) {
+        api()->fill_polygon(handle(), points, point_count, color);
+    }
+    // Need API version 1.2.
+    void push_clip(float x, float y, float w, float h) { api()->push_clip(handle(), x, y, w, h); }
+    void pop_clip() { api()->pop_clip(handle()); }
+};
+} // namespace refd2d
@@ -0,0 +1,186 @@
+#ifndef REFRAMEWORK_D2D_CHANNEL_H
+#define REFRAMEWORK_D2D_CHANNEL_H
+
+#include <stdint.h>
+
+// Wire format of the shared memory channel that lets another process draw on the overlay.
+//
+// The plugin creates a named file mapping (REFD2D_CHANNEL_NAME) holding a REFD2DChannelHeader followed by `capacity` bytes of ring.
+// Exactly one producer process writes records into the ring and the plugin consumes them, neither ever waits on the other.
+//
+// write_pos and read_pos count bytes since the channel was created, the position in the ring is the count modulo capacity. Only the
+// producer stores write_pos and next_sequence, only the consumer stores read_pos. Stores are release, loads of the other side's
+// counter are acquire. The producer may only write between write_pos and read_pos + capacity.
+//
+// Records are REFD2D_CHANNEL_ALIGN aligned and never wrap around the end of the ring, a PAD record fills the rest instead. Draw
+// records are grouped into frames, FRAME_BEGIN ... FRAME_END, and the producer publishes whole frames only by moving write_pos past
+// FRAME_END. The consumer draws the newest published frame and skips the draws of older ones, their definitions still apply. A frame
+// that doesn't fit is dropped by the producer, the consumer notices from the gap in sequence numbers.
+//
+// Fonts and images are defined once with an id and referenced by that id afterwards. Definitions stay until redefined.
+
+#define REFD2D_CHANNEL_NAME "Local\\reframework-d2d-channel"
+#define REFD2D_CHANNEL_MAGIC 0x43443252u // "R2DC"
+#define REFD2D_CHANNEL_VERSION 1
+#define REFD2D_CHANNEL_DEFAULT_CAPACITY (1u << 20)
+#define REFD2D_CHANNEL_ALIGN 8
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    // A multiple of REFD2D_CHANNEL_ALIGN.
+    uint32_t capacity;
+    uint32_t reserved0[13];
+
+    // Producer owned.
+    uint64_t write_pos;
+    // Sequence number of the next FRAME_BEGIN, so a restarted producer carries on where the last one stopped.
+    uint64_t next_sequence;
+    uint64_t reserved1[6];
+
+    // Consumer owned.
+    uint64_t read_pos;
+    uint64_t reserved2[7];
+} REFD2DChannelHeader;
+
+typedef enum {
+    REFD2D_CHANNEL_PAD = 0,
+    REFD2D_CHANNEL_FRAME_BEGIN = 1,
+    REFD2D_CHANNEL_FRAME_END = 2,
+    REFD2D_CHANNEL_DEFINE_FONT = 3,
+    REFD2D_CHANNEL_DEFINE_IMAGE = 4,
+    REFD2D_CHANNEL_DEFINE_FONT_FILE = 5,
+
+    REFD2D_CHANNEL_TEXT = 16,
+    REFD2D_CHANNEL_FILL_RECT,
+    REFD2D_CHANNEL_OUTLINE_RECT,
+    REFD2D_CHANNEL_ROUNDED_RECT,
+    REFD2D_CHANNEL_FILL_ROUNDED_RECT,
+    REFD2D_CHANNEL_QUAD,
+    REFD2D_CHANNEL_FILL_QUAD,
+    REFD2D_CHANNEL_LINE,
+    REFD2D_CHANNEL_IMAGE,
+    REFD2D_CHANNEL_IMAGE_RECT,
+    REFD2D_CHANNEL_FILL_CIRCLE,
+    REFD2D_CHANNEL_CIRCLE,
+    REFD2D_CHANNEL_PIE,
+    REFD2D_CHANNEL_OUTLINE_PIE,
+    REFD2D_CHANNEL_RING,
+    REFD2D_CHANNEL_OUTLINE_RING,
+    REFD2D_CHANNEL_PUSH_TRANSFORM,
+    // A bare REFD2DChannelRecord.
+    REFD2D_CHANNEL_POP_TRANSFORM,
+    REFD2D_CHANNEL_PUSH_CLIP,
+    // A bare REFD2DChannelRecord.
+    REFD2D_CHANNEL_POP_CLIP,
+    // REFD2DChannelPolyline.
+    REFD2D_CHANNEL_POLYLINE,
+    REFD2D_CHANNEL_FILL_POLYGON,
+} REFD2DChannelRecordType;
+
+// REFD2DChannelRecord.flags
+#define REFD2D_CHANNEL_BOLD 0x1
+#define REFD2D_CHANNEL_ITALIC 0x2
+#define REFD2D_CHANNEL_CLOCKWISE 0x1
+#define REFD2D_CHANNEL_CLOSED 0x1
+
+typedef struct {
+    // Of the whole record including this header, a multiple of REFD2D_CHANNEL_ALIGN.
+    uint32_t size;
+    uint16_t type;
+    uint16_t flags;
+} REFD2DChannelRecord;
+
+typedef struct {
+    REFD2DChannelRecord record;
+    uint64_t sequence;
+} REFD2DChannelFrameBegin;
+
+// family_length bytes of UTF-8 family name follow. Flags are BOLD and ITALIC.
+typedef struct {
+    REFD2DChannelRecord record;
+    uint32_t id;
+    int32_t size;
+    uint32_t family_length;
+    uint32_t reserved;
+} REFD2DChannelDefineFont;
+
+// A font loaded from a file. path_length bytes of UTF-8 full path follow, then family_length bytes of family name, empty for the file's
+// first family. Flags are BOLD and ITALIC.
+typedef struct {
+    REFD2DChannelRecord record;
+    uint32_t id;
+    int32_t size;
+    uint32_t path_length;
+    uint32_t family_length;
+} REFD2DChannelDefineFontFile;
+
+// path_length bytes of UTF-8 full path follow.
+typedef struct {
+    REFD2DChannelRecord record;
+    uint32_t id;
+    uint32_t path_length;
+} REFD2DChannelDefineImage;
+
+// text_length bytes of UTF-8 text follow.
+typedef struct {
+    REFD2DChannelRecord record;
+    uint32_t color;
+    uint32_t font;
+    float x;
+    float y;
+    uint32_t text_length;
+    uint32_t reserved;
+} REFD2DChannelText;
+
+// POLYLINE and FILL_POLYGON. point_count x, y float pairs follow. thickness is unused for polygons, the CLOSED flag applies to
+// polylines.
+typedef struct {
+    REFD2DChannelRecord record;
+    uint32_t color;
+    uint32_t point_count;
+    float thickness;
+} REFD2DChannelPolyline;
+
+// Every other draw. value is the 0xAARRGGBB color, or the image id for IMAGE and IMAGE_RECT. It's followed by
+// refd2d_channel_arg_count(type) floats, the arguments of the same function in API.h between the layer (or image) and the color,
+// with alpha last for images. The CLOCKWISE flag applies to pies and rings. PUSH_TRANSFORM's value is unused, its floats are the matrix
+// m11, m12, m21, m22, dx, dy. PUSH_CLIP's value is unused too, its floats are x, y, w, h. Transforms and clips apply until popped or
+// the end of the frame.
+typedef struct {
+    REFD2DChannelRecord record;
+    uint32_t value;
+} REFD2DChannelShape;
+
+// Number of floats following a REFD2DChannelShape, 0 for types that aren't shapes.
+static inline uint32_t refd2d_channel_arg_count(uint16_t type) {
+    switch (type) {
+    case REFD2D_CHANNEL_FILL_RECT:
+    case REFD2D_CHANNEL_FILL_CIRCLE:
+    case REFD2D_CHANNEL_PUSH_CLIP:
+        return 4;
+    case REFD2D_CHANNEL_OUTLINE_RECT:
+    case REFD2D_CHANNEL_LINE:
+    case REFD2D_CHANNEL_CIRCLE:
+    case REFD2D_CHANNEL_PIE:
+    case REFD2D_CHANNEL_IMAGE:
+        return 5;
+    case REFD2D_CHANNEL_FILL_ROUNDED_RECT:
+    case REFD2D_CHANNEL_OUTLINE_PIE:
+    case REFD2D_CHANNEL_RING:
+    case REFD2D_CHANNEL_PUSH_TRANSFORM:
+        return 6;
+    case REFD2D_CHANNEL_ROUNDED_RECT:
+    case REFD2D_CHANNEL_OUTLINE_RING:
+        return 7;
+    case REFD2D_CHANNEL_FILL_QUAD:
+        return 8;
+    case REFD2D_CHANNEL_QUAD:
+    case REFD2D_CHANNEL_IMAGE_RECT:
+        return 9;
+    default:
+        return 0;
+    }
+}
+
+#endif
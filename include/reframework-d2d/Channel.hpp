@@ -0,0 +1,301 @@
+#pragma once
+
+// Header only producer side of the channel described in Channel.h, for drawing on the overlay from another process.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "Channel.h"
+
+namespace refd2d {
+// Encodes the records of Channel.h. Derived provides the memory through
+//
+//     void* reserve(size_t size);  // room for a record of size bytes, or nullptr if there's none
+//
+// Draws are dropped silently once reserve fails, the frame as a whole is what succeeds or fails.
+template <typename Derived> class ChannelEncoder {
+public:
+    void define_font(uint32_t id, std::string_view family, int size, bool bold = false, bool italic = false) {
+        auto flags = (bold ? REFD2D_CHANNEL_BOLD : 0) | (italic ? REFD2D_CHANNEL_ITALIC : 0);
+
+        if (auto rec = alloc<REFD2DChannelDefineFont>(REFD2D_CHANNEL_DEFINE_FONT, family.size(), flags)) {
+            rec->id = id;
+            rec->size = size;
+            rec->family_length = (uint32_t)family.size();
+            std::memcpy(rec + 1, family.data(), family.size());
+        }
+    }
+
+    // A font file the game can read, empty family picks the file's first family.
+    void define_font_file(uint32_t id, std::string_view path, std::string_view family, int size, bool bold = false, bool italic = false) {
+        auto flags = (bold ? REFD2D_CHANNEL_BOLD : 0) | (italic ? REFD2D_CHANNEL_ITALIC : 0);
+
+        if (auto rec = alloc<REFD2DChannelDefineFontFile>(REFD2D_CHANNEL_DEFINE_FONT_FILE, path.size() + family.size(), flags)) {
+            rec->id = id;
+            rec->size = size;
+            rec->path_length = (uint32_t)path.size();
+            rec->family_length = (uint32_t)family.size();
+            std::memcpy(rec + 1, path.data(), path.size());
+            std::memcpy((char*)(rec + 1) + path.size(), family.data(), family.size());
+        }
+    }
+
+    void define_image(uint32_t id, std::string_view path) {
+        if (auto rec = alloc<REFD2DChannelDefineImage>(REFD2D_CHANNEL_DEFINE_IMAGE, path.size())) {
+            rec->id = id;
+            rec->path_length = (uint32_t)path.size();
+            std::memcpy(rec + 1, path.data(), path.size());
+        }
+    }
+
+    void text(uint32_t font, std::string_view text, float x, float y, uint32_t color) {
+        if (auto rec = alloc<REFD2DChannelText>(REFD2D_CHANNEL_TEXT, text.size())) {
+            rec->color = color;
+            rec->font = font;
+            rec->x = x;
+            rec->y = y;
+            rec->text_length = (uint32_t)text.size();
+            std::memcpy(rec + 1, text.data(), text.size());
+        }
+    }
+
+    void fill_rect(float x, float y, float w, float h, uint32_t color) { shape(REFD2D_CHANNEL_FILL_RECT, color, {x, y, w, h}); }
+    void outline_rect(float x, float y, float w, float h, float thickness, uint32_t color) {
+        shape(REFD2D_CHANNEL_OUTLINE_RECT, color, {x, y, w, h, thickness});
+    }
+    void rounded_rect(float x, float y, float w, float h, float rx, float ry, float thickness, uint32_t color) {
+        shape(REFD2D_CHANNEL_ROUNDED_RECT, color, {x, y, w, h, rx, ry, thickness});
+    }
+    void fill_rounded_rect(float x, float y, float w, float h, float rx, float ry, uint32_t color) {
+        shape(REFD2D_CHANNEL_FILL_ROUNDED_RECT, color, {x, y, w, h, rx, ry});
+    }
+    void quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, float thickness, uint32_t color) {
+        shape(REFD2D_CHANNEL_QUAD, color, {x1, y1, x2, y2, x3, y3, x4, y4, thickness});
+    }
+    void fill_quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, uint32_t color) {
+        shape(REFD2D_CHANNEL_FILL_QUAD, color, {x1, y1, x2, y2, x3, y3, x4, y4});
+    }
+    void line(float x1, float y1, float x2, float y2, float thickness, uint32_t color) {
+        shape(REFD2D_CHANNEL_LINE, color, {x1, y1, x2, y2, thickness});
+    }
+    void image(uint32_t image, float x, float y, float w, float h, float alpha = 1.0f) {
+        shape(REFD2D_CHANNEL_IMAGE, image, {x, y, w, h, alpha});
+    }
+    void image(uint32_t image, float sx, float sy, float sw, float sh, float x, float y, float w, float h, float alpha = 1.0f) {
+        shape(REFD2D_CHANNEL_IMAGE_RECT, image, {sx, sy, sw, sh, x, y, w, h, alpha});
+    }
+    void fill_circle(float x, float y, float rx, float ry, uint32_t color) { shape(REFD2D_CHANNEL_FILL_CIRCLE, color, {x, y, rx, ry}); }
+    void circle(float x, float y, float rx, float ry, float thickness, uint32_t color) {
+        shape(REFD2D_CHANNEL_CIRCLE, color, {x, y, rx, ry, thickness});
+    }
+    void pie(float x, float y, float r, float start_angle, float sweep_angle, uint32_t color, bool clockwise = true) {
+        shape(REFD2D_CHANNEL_PIE, color, {x, y, r, start_angle, sweep_angle}, clockwise);
+    }
+    void outline_pie(
+        float x, float y, float r, float start_angle, float sweep_angle, float thickness, uint32_t color, bool clockwise = true) {
+        shape(REFD2D_CHANNEL_OUTLINE_PIE, color, {x, y, r, start_angle, sweep_angle, thickness}, clockwise);
+    }
+    void ring(float x, float y, float outer_radius, float inner_radius, float start_angle, float sweep_angle, uint32_t color,
+        bool clockwise = true) {
+        shape(REFD2D_CHANNEL_RING, color, {x, y, outer_radius, inner_radius, start_angle, sweep_angle}, clockwise);
+    }
+    void outline_ring(float x, float y, float outer_radius, float inner_radius, float start_angle, float sweep_angle, float thickness,
+        uint32_t color, bool clockwise = true) {
+        shape(REFD2D_CHANNEL_OUTLINE_RING, color, {x, y, outer_radius, inner_radius, start_angle, sweep_angle, thickness}, clockwise);
+    }
+    // points is point_count x, y pairs.
+    void polyline(const float* points, uint32_t point_count, float thickness, uint32_t color, bool closed = false) {
+        poly(REFD2D_CHANNEL_POLYLINE, points, point_count, thickness, color, closed ? REFD2D_CHANNEL_CLOSED : 0);
+    }
+    void fill_polygon(const float* points, uint32_t point_count, uint32_t color) {
+        poly(REFD2D_CHANNEL_FILL_POLYGON, points, point_count, 0.0f, color, 0);
+    }
+    // Transforms the draws up to the matching pop_transform, see push_transform in API.h.
+    void push_transform(float m11, float m12, float m21, float m22, float dx, float dy) {
+        shape(REFD2D_CHANNEL_PUSH_TRANSFORM, 0, {m11, m12, m21, m22, dx, dy});
+    }
+    void pop_transform() { alloc<REFD2DChannelRecord>(REFD2D_CHANNEL_POP_TRANSFORM); }
+    // Clips the draws up to the matching pop_clip, see push_clip in API.h.
+    void push_clip(float x, float y, float w, float h) { shape(REFD2D_CHANNEL_PUSH_CLIP, 0, {x, y, w, h}); }
+    void pop_clip() { alloc<REFD2DChannelRecord>(REFD2D_CHANNEL_POP_CLIP); }
+
+protected:
+    // A zeroed record of type T plus extra trailing bytes with its header filled in, or nullptr.
+    template <typename T> T* alloc(uint16_t type, size_t extra = 0, uint16_t flags = 0) {
+        auto size = (sizeof(T) + extra + REFD2D_CHANNEL_ALIGN - 1) & ~(size_t)(REFD2D_CHANNEL_ALIGN - 1);
+        auto rec = (T*)static_cast<Derived*>(this)->reserve(size);
+
+        if (rec == nullptr) {
+            return nullptr;
+        }
+
+        std::memset(rec, 0, sizeof(T));
+        auto header = (REFD2DChannelRecord*)rec;
+        header->size = (uint32_t)size;
+        header->type = type;
+        header->flags = flags;
+
+        return rec;
+    }
+
+private:
+    void poly(uint16_t type, const float* points, uint32_t point_count, float thickness, uint32_t color, uint16_t flags) {
+        auto size = (size_t)point_count * 2 * sizeof(float);
+
+        if (auto rec = alloc<REFD2DChannelPolyline>(type, size, flags)) {
+            rec->color = color;
+            rec->point_count = point_count;
+            rec->thickness = thickness;
+            std::memcpy(rec + 1, points, size);
+        }
+    }
+
+    void shape(uint16_t type, uint32_t value, std::initializer_list<float> args, bool clockwise = false) {
+        auto flags = clockwise ? REFD2D_CHANNEL_CLOCKWISE : 0;
+
+        if (auto rec = alloc<REFD2DChannelShape>(type, args.size() * sizeof(float), flags)) {
+            rec->value = value;
+            std::memcpy(rec + 1, args.begin(), args.size() * sizeof(float));
+        }
+    }
+};
+
+// Writes frames into an already mapped channel. Not thread safe, and only one writer may be attached to a channel at a time.
+class ChannelWriter : public ChannelEncoder<ChannelWriter> {
+public:
+    explicit ChannelWriter(void* memory)
+        : m_header{(REFD2DChannelHeader*)memory}
+        , m_ring{(uint8_t*)memory + sizeof(REFD2DChannelHeader)} {
+        if (m_header->magic != REFD2D_CHANNEL_MAGIC || m_header->version != REFD2D_CHANNEL_VERSION) {
+            throw std::runtime_error{"Not a reframework-d2d channel or an unsupported version"};
+        }
+
+        m_capacity = m_header->capacity;
+        m_cursor = load(m_header->write_pos, std::memory_order_relaxed);
+        m_sequence = load(m_header->next_sequence, std::memory_order_relaxed);
+    }
+
+    // Everything between begin_frame and end_frame is published at once.
+    void begin_frame() {
+        m_frame_start = m_cursor;
+        m_read = load(m_header->read_pos, std::memory_order_acquire);
+        m_overflow = false;
+
+        if (auto rec = alloc<REFD2DChannelFrameBegin>(REFD2D_CHANNEL_FRAME_BEGIN)) {
+            rec->sequence = m_sequence;
+        }
+
+        ++m_sequence;
+    }
+
+    // Returns false if the frame didn't fit because the consumer is behind. It's dropped as a whole, so definitions made in it have
+    // to be repeated.
+    bool end_frame() {
+        alloc<REFD2DChannelRecord>(REFD2D_CHANNEL_FRAME_END);
+        store(m_header->next_sequence, m_sequence);
+
+        if (m_overflow) {
+            m_cursor = m_frame_start;
+            return false;
+        }
+
+        store(m_header->write_pos, m_cursor);
+        return true;
+    }
+
+private:
+    friend class ChannelEncoder<ChannelWriter>;
+
+    REFD2DChannelHeader* m_header{};
+    uint8_t* m_ring{};
+    uint32_t m_capacity{};
+    // write_pos as of the records written so far, published by end_frame.
+    uint64_t m_cursor{};
+    uint64_t m_frame_start{};
+    // read_pos as last seen, only reloaded when the ring looks full.
+    uint64_t m_read{};
+    uint64_t m_sequence{};
+    bool m_overflow{};
+
+    static uint64_t load(uint64_t& value, std::memory_order order) { return std::atomic_ref<uint64_t>{value}.load(order); }
+    static void store(uint64_t& value, uint64_t desired) { std::atomic_ref<uint64_t>{value}.store(desired, std::memory_order_release); }
+
+    bool fits(uint64_t end) {
+        if (end - m_read <= m_capacity) {
+            return true;
+        }
+
+        m_read = load(m_header->read_pos, std::memory_order_acquire);
+        return end - m_read <= m_capacity;
+    }
+
+    // Room for a record at the cursor, or nullptr once the frame has overflowed.
+    void* reserve(size_t size) {
+        if (m_overflow || size > m_capacity) {
+            m_overflow = true;
+            return nullptr;
+        }
+
+        auto offset = m_cursor % m_capacity;
+        auto pad = offset + size > m_capacity ? m_capacity - offset : 0;
+
+        if (!fits(m_cursor + pad + size)) {
+            m_overflow = true;
+            return nullptr;
+        }
+
+        if (pad != 0) {
+            auto rec = (REFD2DChannelRecord*)(m_ring + offset);
+            rec->size = (uint32_t)pad;
+            rec->type = REFD2D_CHANNEL_PAD;
+            rec->flags = 0;
+            m_cursor += pad;
+            offset = 0;
+        }
+
+        m_cursor += size;
+        return m_ring + offset;
+    }
+};
+
+#ifdef _WIN32
+// Maps the channel the plugin created. Throws if reframework-d2d isn't loaded in a running game.
+class Channel {
+public:
+    Channel() {
+        m_mapping = OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, REFD2D_CHANNEL_NAME);
+
+        if (m_mapping == nullptr) {
+            throw std::runtime_error{"reframework-d2d channel not found"};
+        }
+
+        m_view = MapViewOfFile(m_mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+
+        if (m_view == nullptr) {
+            CloseHandle(m_mapping);
+            throw std::runtime_error{"Failed to map the reframework-d2d channel"};
+        }
+    }
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+    ~Channel() {
+        UnmapViewOfFile(m_view);
+        CloseHandle(m_mapping);
+    }
+
+    void* memory() const { return m_view; }
+
+private:
+    HANDLE m_mapping{};
+    void* m_view{};
+};
+#endif
+} // namespace refd2d
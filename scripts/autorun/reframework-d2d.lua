@@ -1,4 +1,5 @@
 local cfg = json.load_file("reframework-d2d.json")
+local last_capture_path = nil
 
 re.on_config_save(
     function()
@@ -15,6 +16,69 @@ re.on_draw_ui(
             cfg.max_update_rate = value 
         end
 
+        changed, value = imgui.slider_int("Update Every N Presents (0 = Off)", cfg.present_interval, 0, 8)
+        if changed then
+            cfg.present_interval = value
+        end
+
+        changed, value = imgui.slider_float("Update Budget (ms, 0 = Off)", cfg.update_budget, 0.0, 10.0)
+        if changed then
+            cfg.update_budget = value
+        end
+
+        changed, value = imgui.slider_float("Render Scale", cfg.render_scale, 0.5, 1.0)
+        if changed then
+            cfg.render_scale = value
+        end
+
+        changed, value = imgui.checkbox("Tiled Composite", cfg.composite_tiling)
+        if changed then
+            cfg.composite_tiling = value
+        end
+
+        local update_stats = d2d.detail.get_update_stats()
+        imgui.text(string.format("Updates: %.1f Hz, %.2f ms each", update_stats.effective_rate, update_stats.average_cost))
+
+        local render_stats = d2d.detail.get_render_stats()
+        if render_stats.frames_rendered then
+            imgui.text(string.format("Render: %.2f ms (avg %.2f ms), composite %.2f ms, %d superseded", render_stats.last_render_ms,
+                render_stats.average_render_ms, render_stats.last_composite_ms, render_stats.frames_superseded))
+            imgui.text(string.format("Fence waits: %d overlay (%.1f ms total), %d composite", render_stats.overlay_waits,
+                render_stats.overlay_wait_ms, render_stats.composite_waits))
+            imgui.text(string.format("Composite: %.1f%% of screen, %d skipped", render_stats.last_composite_coverage * 100.0,
+                render_stats.composites_skipped))
+            imgui.text(string.format("Command lists: %d deep, %d stalls (%.1f ms total)", render_stats.command_ring_depth,
+                render_stats.command_stalls, render_stats.command_stall_ms))
+            imgui.text(string.format("GPU: D2D %.2f ms (avg %.2f, max %.2f), composite %.2f ms (avg %.2f, max %.2f)",
+                render_stats.gpu_d2d_ms, render_stats.gpu_d2d_avg_ms, render_stats.gpu_d2d_max_ms, render_stats.gpu_composite_ms,
+                render_stats.gpu_composite_avg_ms, render_stats.gpu_composite_max_ms))
+        end
+
+        local channel_stats = d2d.detail.get_channel_stats()
+        if channel_stats.frames and channel_stats.frames > 0 then
+            imgui.text(string.format("Channel: %d frames, %d skipped, %d dropped, %d corrupt", channel_stats.frames, channel_stats.skipped,
+                channel_stats.dropped, channel_stats.corrupt))
+        end
+
+        local capture = d2d.detail.get_capture_status()
+        if capture.frames then
+            imgui.text(string.format("Capturing: %d / %d frames to %s", capture.captured, capture.frames, capture.path))
+        elseif imgui.button("Capture 300 Frames") then
+            last_capture_path = d2d.detail.start_capture(300)
+        end
+
+        if not capture.frames and last_capture_path then
+            imgui.text("Last capture: " .. last_capture_path)
+        end
+
+        changed, value = imgui.slider_int("Image Memory Budget (MB)", cfg.image_budget, 16, 2048)
+        if changed then
+            cfg.image_budget = value
+        end
+
+        local stats = d2d.detail.get_image_stats()
+        imgui.text(string.format("Images: %d resident, %.1f MB, %d evictions", stats.images, stats.resident / (1024 * 1024), stats.evictions))
+
         local last_error = d2d.detail.get_last_error()
         if last_error ~= "" then
             imgui.text("Last Script Error:")
@@ -30,8 +94,33 @@ d2d.register(
                 max_update_rate = d2d.detail.get_max_updaterate() 
             }
         end
+
+        if not cfg.present_interval then
+            cfg.present_interval = d2d.detail.get_present_interval()
+        end
+
+        if not cfg.update_budget then
+            cfg.update_budget = d2d.detail.get_update_budget()
+        end
+
+        if not cfg.render_scale then
+            cfg.render_scale = d2d.detail.get_render_scale()
+        end
+
+        if cfg.composite_tiling == nil then
+            cfg.composite_tiling = d2d.detail.get_composite_tiling()
+        end
+
+        if not cfg.image_budget then
+            cfg.image_budget = math.floor(d2d.detail.get_image_budget())
+        end
     end,
     function()
         d2d.detail.set_max_updaterate(cfg.max_update_rate)
+        d2d.detail.set_present_interval(cfg.present_interval)
+        d2d.detail.set_update_budget(cfg.update_budget)
+        d2d.detail.set_render_scale(cfg.render_scale)
+        d2d.detail.set_composite_tiling(cfg.composite_tiling)
+        d2d.detail.set_image_budget(cfg.image_budget)
     end
 )
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <optional>
+
+namespace AtlasSource {
+struct Rect {
+    float left{};
+    float top{};
+    float right{};
+    float bottom{};
+};
+
+// Moves a source rect given in an image's own pixels to where the image sits in an atlas page. Returns nothing when the source
+// reaches outside the image, the entry's gutter is only a pixel wide so that would sample the neighbouring entries.
+inline std::optional<Rect> map(const Rect& slot, float sx, float sy, float sw, float sh) {
+    auto w = slot.right - slot.left;
+    auto h = slot.bottom - slot.top;
+
+    // Written so that NaNs fail too.
+    if (!(sx >= 0.0f && sy >= 0.0f && sw >= 0.0f && sh >= 0.0f && sx + sw <= w && sy + sh <= h)) {
+        return std::nullopt;
+    }
+
+    return Rect{slot.left + sx, slot.top + sy, slot.left + sx + sw, slot.top + sy + sh};
+}
+} // namespace AtlasSource
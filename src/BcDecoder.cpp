@@ -0,0 +1,421 @@
+#include <cstring>
+#include <utility>
+
+#include "BcDecoder.hpp"
+
+namespace {
+uint16_t read_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t read_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void unpack_565(uint16_t c, uint8_t (&rgb)[3]) {
+    auto r = (c >> 11) & 0x1F;
+    auto g = (c >> 5) & 0x3F;
+    auto b = c & 0x1F;
+    rgb[0] = (uint8_t)((r << 3) | (r >> 2));
+    rgb[1] = (uint8_t)((g << 2) | (g >> 4));
+    rgb[2] = (uint8_t)((b << 3) | (b >> 2));
+}
+
+// The color half shared by BC1, BC2 and BC3. BC2/BC3 always use the four color mode regardless of endpoint order.
+void decode_color_block(const uint8_t* block, uint8_t (&texels)[16][4], bool allow_punchthrough) {
+    auto c0 = read_u16(block);
+    auto c1 = read_u16(block + 2);
+    auto indices = read_u32(block + 4);
+    uint8_t palette[4][4]{};
+
+    unpack_565(c0, reinterpret_cast<uint8_t(&)[3]>(palette[0]));
+    unpack_565(c1, reinterpret_cast<uint8_t(&)[3]>(palette[1]));
+    palette[0][3] = palette[1][3] = 255;
+
+    if (c0 > c1 || !allow_punchthrough) {
+        for (auto i = 0; i < 3; ++i) {
+            palette[2][i] = (uint8_t)((2 * palette[0][i] + palette[1][i] + 1) / 3);
+            palette[3][i] = (uint8_t)((palette[0][i] + 2 * palette[1][i] + 1) / 3);
+        }
+
+        palette[2][3] = palette[3][3] = 255;
+    } else {
+        for (auto i = 0; i < 3; ++i) {
+            palette[2][i] = (uint8_t)((palette[0][i] + palette[1][i]) / 2);
+            palette[3][i] = 0;
+        }
+
+        palette[2][3] = 255;
+        palette[3][3] = 0;
+    }
+
+    for (auto i = 0; i < 16; ++i) {
+        std::memcpy(texels[i], palette[(indices >> (i * 2)) & 3], 4);
+    }
+}
+
+//
+// BC7
+//
+
+// Subset index of every texel for the 64 two subset partitions, one bit per texel (texel 0 is the LSB).
+constexpr uint16_t BC7_PARTITIONS_2[64]{
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+    0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+    0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+    0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+// Subset index of every texel for the 64 three subset partitions.
+constexpr uint8_t BC7_PARTITIONS_3[64][16]{
+    {0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2},
+    {0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+    {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2},
+    {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2},
+    {0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1},
+    {0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2},
+    {0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+    {0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2},
+    {0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2},
+    {0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+    {0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+    {0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2},
+    {0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0},
+    {0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2},
+    {0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+    {0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2},
+    {0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2},
+    {0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+    {0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0},
+    {0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2},
+    {0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0},
+    {0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+    {0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2},
+    {0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1},
+    {0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+    {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2},
+    {0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0},
+    {0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+    {0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0},
+    {0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1},
+    {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1},
+    {0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+    {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1},
+    {0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1},
+    {0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+    {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2},
+    {0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1},
+    {0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2},
+    {0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2},
+    {0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2},
+    {0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+    {0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1},
+    {0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0},
+};
+
+// Anchor texel of the second subset for two subset partitions.
+constexpr uint8_t BC7_ANCHORS_2[64]{
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, //
+    15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,              //
+    15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,          //
+    6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,        //
+};
+
+// Anchor texels of the second and third subsets for three subset partitions.
+constexpr uint8_t BC7_ANCHORS_3_SECOND[64]{
+    3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,     //
+    3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,     //
+    8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15, //
+    3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3,   //
+};
+
+constexpr uint8_t BC7_ANCHORS_3_THIRD[64]{
+    15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8, //
+    15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,  //
+    15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,    //
+    15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8, //
+};
+
+constexpr uint8_t BC7_WEIGHTS_2[4]{0, 21, 43, 64};
+constexpr uint8_t BC7_WEIGHTS_3[8]{0, 9, 18, 27, 37, 46, 55, 64};
+constexpr uint8_t BC7_WEIGHTS_4[16]{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct Bc7Mode {
+    uint8_t subsets;
+    uint8_t partition_bits;
+    uint8_t rotation_bits;
+    uint8_t index_selection_bits;
+    uint8_t color_bits;
+    uint8_t alpha_bits;
+    uint8_t endpoint_pbits;
+    uint8_t shared_pbits;
+    uint8_t index_bits;
+    uint8_t index_bits2;
+};
+
+constexpr Bc7Mode BC7_MODES[8]{
+    {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+    {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+    {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+    {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+    {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+    {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+    {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+    {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data)
+        : m_lo{(uint64_t)read_u32(data) | ((uint64_t)read_u32(data + 4) << 32)}
+        , m_hi{(uint64_t)read_u32(data + 8) | ((uint64_t)read_u32(data + 12) << 32)} {}
+
+    uint32_t read(uint32_t count) {
+        if (count == 0) {
+            return 0;
+        }
+
+        auto value = (uint32_t)(m_lo & ((1ull << count) - 1));
+
+        m_lo = (m_lo >> count) | (m_hi << (64 - count));
+        m_hi >>= count;
+
+        return value;
+    }
+
+private:
+    uint64_t m_lo{};
+    uint64_t m_hi{};
+};
+
+uint8_t bc7_subset(const Bc7Mode& mode, uint32_t partition, int texel) {
+    switch (mode.subsets) {
+    case 2:
+        return (BC7_PARTITIONS_2[partition] >> texel) & 1;
+    case 3:
+        return BC7_PARTITIONS_3[partition][texel];
+    default:
+        return 0;
+    }
+}
+
+bool bc7_is_anchor(const Bc7Mode& mode, uint32_t partition, int texel) {
+    if (texel == 0) {
+        return true;
+    }
+
+    switch (mode.subsets) {
+    case 2:
+        return texel == BC7_ANCHORS_2[partition];
+    case 3:
+        return texel == BC7_ANCHORS_3_SECOND[partition] || texel == BC7_ANCHORS_3_THIRD[partition];
+    default:
+        return false;
+    }
+}
+
+uint8_t bc7_expand(uint32_t value, uint32_t bits) {
+    value <<= 8 - bits;
+    return (uint8_t)(value | (value >> bits));
+}
+
+uint8_t bc7_interpolate(uint8_t e0, uint8_t e1, uint32_t index, uint32_t index_bits) {
+    uint32_t w{};
+
+    switch (index_bits) {
+    case 2:
+        w = BC7_WEIGHTS_2[index];
+        break;
+    case 3:
+        w = BC7_WEIGHTS_3[index];
+        break;
+    default:
+        w = BC7_WEIGHTS_4[index];
+        break;
+    }
+
+    return (uint8_t)(((64 - w) * e0 + w * e1 + 32) >> 6);
+}
+} // namespace
+
+namespace BcDecoder {
+void decode_bc1(const uint8_t* block, uint8_t (&texels)[16][4]) {
+    decode_color_block(block, texels, true);
+}
+
+void decode_bc2(const uint8_t* block, uint8_t (&texels)[16][4]) {
+    decode_color_block(block + 8, texels, false);
+
+    for (auto i = 0; i < 16; ++i) {
+        auto a = (block[i / 2] >> ((i % 2) * 4)) & 0xF;
+        texels[i][3] = (uint8_t)(a * 17);
+    }
+}
+
+void decode_bc3(const uint8_t* block, uint8_t (&texels)[16][4]) {
+    decode_color_block(block + 8, texels, false);
+
+    uint8_t alphas[8]{block[0], block[1]};
+
+    if (alphas[0] > alphas[1]) {
+        for (auto i = 1; i < 7; ++i) {
+            alphas[i + 1] = (uint8_t)(((7 - i) * alphas[0] + i * alphas[1] + 3) / 7);
+        }
+    } else {
+        for (auto i = 1; i < 5; ++i) {
+            alphas[i + 1] = (uint8_t)(((5 - i) * alphas[0] + i * alphas[1] + 2) / 5);
+        }
+
+        alphas[6] = 0;
+        alphas[7] = 255;
+    }
+
+    uint64_t indices{};
+
+    for (auto i = 0; i < 6; ++i) {
+        indices |= (uint64_t)block[2 + i] << (i * 8);
+    }
+
+    for (auto i = 0; i < 16; ++i) {
+        texels[i][3] = alphas[(indices >> (i * 3)) & 7];
+    }
+}
+
+void decode_bc7(const uint8_t* block, uint8_t (&texels)[16][4]) {
+    BitReader bits{block};
+    auto mode_index = 0u;
+
+    while (mode_index < 8 && bits.read(1) == 0) {
+        ++mode_index;
+    }
+
+    // Reserved mode, the spec says to decode it as transparent black.
+    if (mode_index >= 8) {
+        std::memset(texels, 0, sizeof(texels));
+        return;
+    }
+
+    const auto& mode = BC7_MODES[mode_index];
+    auto partition = bits.read(mode.partition_bits);
+    auto rotation = bits.read(mode.rotation_bits);
+    auto index_selection = bits.read(mode.index_selection_bits);
+    auto num_endpoints = mode.subsets * 2;
+    uint32_t endpoints[6][4]{};
+
+    for (auto channel = 0; channel < 3; ++channel) {
+        for (auto i = 0; i < num_endpoints; ++i) {
+            endpoints[i][channel] = bits.read(mode.color_bits);
+        }
+    }
+
+    for (auto i = 0; i < num_endpoints; ++i) {
+        endpoints[i][3] = mode.alpha_bits ? bits.read(mode.alpha_bits) : 255;
+    }
+
+    auto color_bits = (uint32_t)mode.color_bits;
+    auto alpha_bits = (uint32_t)mode.alpha_bits;
+
+    if (mode.endpoint_pbits || mode.shared_pbits) {
+        uint32_t pbits[6]{};
+
+        if (mode.endpoint_pbits) {
+            for (auto i = 0; i < num_endpoints; ++i) {
+                pbits[i] = bits.read(1);
+            }
+        } else {
+            for (auto i = 0; i < mode.subsets; ++i) {
+                pbits[i * 2] = pbits[i * 2 + 1] = bits.read(1);
+            }
+        }
+
+        for (auto i = 0; i < num_endpoints; ++i) {
+            for (auto channel = 0; channel < 3; ++channel) {
+                endpoints[i][channel] = (endpoints[i][channel] << 1) | pbits[i];
+            }
+
+            if (mode.alpha_bits) {
+                endpoints[i][3] = (endpoints[i][3] << 1) | pbits[i];
+            }
+        }
+
+        ++color_bits;
+
+        if (alpha_bits) {
+            ++alpha_bits;
+        }
+    }
+
+    uint8_t colors[6][4]{};
+
+    for (auto i = 0; i < num_endpoints; ++i) {
+        for (auto channel = 0; channel < 3; ++channel) {
+            colors[i][channel] = bc7_expand(endpoints[i][channel], color_bits);
+        }
+
+        colors[i][3] = alpha_bits ? bc7_expand(endpoints[i][3], alpha_bits) : 255;
+    }
+
+    uint32_t indices[16]{};
+    uint32_t indices2[16]{};
+
+    for (auto i = 0; i < 16; ++i) {
+        indices[i] = bits.read(bc7_is_anchor(mode, partition, i) ? mode.index_bits - 1 : mode.index_bits);
+    }
+
+    if (mode.index_bits2) {
+        for (auto i = 0; i < 16; ++i) {
+            indices2[i] = bits.read(i == 0 ? mode.index_bits2 - 1 : mode.index_bits2);
+        }
+    }
+
+    for (auto i = 0; i < 16; ++i) {
+        auto subset = bc7_subset(mode, partition, i);
+        const auto& e0 = colors[subset * 2];
+        const auto& e1 = colors[subset * 2 + 1];
+        auto& texel = texels[i];
+
+        if (mode.index_bits2) {
+            // Modes 4 and 5 carry separate color and alpha indices, mode 4 can swap which one uses the wider index.
+            auto color_index = index_selection ? indices2[i] : indices[i];
+            auto color_index_bits = index_selection ? mode.index_bits2 : mode.index_bits;
+            auto alpha_index = index_selection ? indices[i] : indices2[i];
+            auto alpha_index_bits = index_selection ? mode.index_bits : mode.index_bits2;
+
+            for (auto channel = 0; channel < 3; ++channel) {
+                texel[channel] = bc7_interpolate(e0[channel], e1[channel], color_index, color_index_bits);
+            }
+
+            texel[3] = bc7_interpolate(e0[3], e1[3], alpha_index, alpha_index_bits);
+        } else {
+            for (auto channel = 0; channel < 4; ++channel) {
+                texel[channel] = bc7_interpolate(e0[channel], e1[channel], indices[i], mode.index_bits);
+            }
+        }
+
+        if (rotation != 0) {
+            std::swap(texel[3], texel[rotation - 1]);
+        }
+    }
+}
+} // namespace BcDecoder
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Software decoders for the block compressed formats we accept in DDS images. Each function decodes a single 4x4 block into 16
+// straight (non-premultiplied) RGBA8 texels in row major order.
+namespace BcDecoder {
+void decode_bc1(const uint8_t* block, uint8_t (&texels)[16][4]);
+void decode_bc2(const uint8_t* block, uint8_t (&texels)[16][4]);
+void decode_bc3(const uint8_t* block, uint8_t (&texels)[16][4]);
+void decode_bc7(const uint8_t* block, uint8_t (&texels)[16][4]);
+} // namespace BcDecoder
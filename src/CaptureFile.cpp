@@ -0,0 +1,99 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "CaptureFile.hpp"
+
+static_assert(sizeof(CaptureFileHeader) == 24);
+
+void CaptureEncoder::begin_frame(uint64_t sequence) {
+    alloc<REFD2DChannelFrameBegin>(REFD2D_CHANNEL_FRAME_BEGIN)->sequence = sequence;
+}
+
+void CaptureEncoder::end_frame() {
+    alloc<REFD2DChannelRecord>(REFD2D_CHANNEL_FRAME_END);
+}
+
+void* CaptureEncoder::reserve(size_t size) {
+    auto offset = m_data.size();
+    m_data.resize(offset + size);
+    return m_data.data() + offset;
+}
+
+CaptureReader::CaptureReader(std::istream& in)
+    : m_in{in} {
+    if (!m_in.read((char*)&m_header, sizeof(m_header)) || m_header.magic != CaptureFileHeader::MAGIC) {
+        throw std::runtime_error{"Not a capture file"};
+    }
+
+    if (m_header.version != CaptureFileHeader::VERSION || m_header.channel_version != REFD2D_CHANNEL_VERSION) {
+        throw std::runtime_error{"Unsupported capture file version"};
+    }
+}
+
+bool CaptureReader::read_frame(CaptureFrame& frame) {
+    frame.clear();
+    auto in_frame = false;
+
+    for (;;) {
+        REFD2DChannelRecord header{};
+
+        if (!m_in.read((char*)&header, sizeof(header))) {
+            return false;
+        }
+
+        if (header.size < sizeof(header) || header.size % REFD2D_CHANNEL_ALIGN != 0 || header.size > MAX_RECORD_SIZE) {
+            throw std::runtime_error{"Corrupt capture file"};
+        }
+
+        auto offset = frame.size();
+        frame.resize(offset + header.size);
+        std::memcpy(frame.data() + offset, &header, sizeof(header));
+
+        if (!m_in.read((char*)frame.data() + offset + sizeof(header), header.size - sizeof(header))) {
+            return false;
+        }
+
+        auto record = parse_channel_record(frame.data() + offset, header.size);
+
+        if (!record || (is_channel_draw(record->type) && !in_frame)) {
+            throw std::runtime_error{"Corrupt capture file"};
+        }
+
+        if (record->type == REFD2D_CHANNEL_FRAME_BEGIN) {
+            if (in_frame) {
+                throw std::runtime_error{"Corrupt capture file"};
+            }
+
+            in_frame = true;
+        } else if (record->type == REFD2D_CHANNEL_FRAME_END) {
+            if (!in_frame) {
+                throw std::runtime_error{"Corrupt capture file"};
+            }
+
+            return true;
+        }
+    }
+}
+
+void replay_capture_frame(const CaptureFrame& frame, ChannelSink& sink) {
+    for (size_t pos = 0; pos < frame.size();) {
+        // Already validated by CaptureReader.
+        auto record = *parse_channel_record(frame.data() + pos, frame.size() - pos);
+
+        switch (record.type) {
+        case REFD2D_CHANNEL_FRAME_BEGIN:
+            sink.begin_frame();
+            break;
+
+        case REFD2D_CHANNEL_FRAME_END:
+            sink.end_frame();
+            break;
+
+        default:
+            dispatch_channel_record(record, sink);
+            break;
+        }
+
+        pos += record.size;
+    }
+}
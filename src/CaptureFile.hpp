@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+#include "reframework-d2d/Channel.hpp"
+
+#include "ChannelRecord.hpp"
+
+// Capture files hold frames of draw commands so they can be replayed outside the game. After a CaptureFileHeader they're a plain
+// stream of the records from include/reframework-d2d/Channel.h: each frame is FRAME_BEGIN, the definitions of fonts and images it's
+// the first to use, its draws, then FRAME_END. There's no padding and no index, so files can be written and read as a stream and one
+// that was cut off is still good up to its last complete frame. All values are little endian.
+//
+// Fonts and images are defined by reference, by family name or file path, so replaying needs the same files at the same paths.
+// Images made in memory (d2d.PixelImage) have no path and aren't embedded, their draws are left out of the capture.
+struct CaptureFileHeader {
+    static constexpr uint32_t MAGIC = 0x46443252; // "R2DF"
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic{MAGIC};
+    uint32_t version{VERSION};
+    // REFD2D_CHANNEL_VERSION of the records.
+    uint32_t channel_version{REFD2D_CHANNEL_VERSION};
+    uint32_t reserved{};
+    // The size scripts drew in.
+    uint32_t width{};
+    uint32_t height{};
+};
+
+// Encodes records into memory, to be appended to a capture file.
+class CaptureEncoder : public refd2d::ChannelEncoder<CaptureEncoder> {
+public:
+    void begin_frame(uint64_t sequence);
+    void end_frame();
+
+    const uint8_t* data() const { return m_data.data(); }
+    size_t size() const { return m_data.size(); }
+    void clear() { m_data.clear(); }
+
+private:
+    friend class refd2d::ChannelEncoder<CaptureEncoder>;
+
+    // Allocations are at least 8 byte aligned and records are a multiple of 8 bytes, so every record stays aligned.
+    std::vector<uint8_t> m_data{};
+
+    void* reserve(size_t size);
+};
+
+// The records of one frame, definitions included, as read from a capture file.
+using CaptureFrame = std::vector<uint8_t>;
+
+// Reads a capture file one frame at a time. Throws on anything that isn't a well formed capture file.
+class CaptureReader {
+public:
+    // Records bigger than this are treated as corruption rather than allocated.
+    static constexpr uint32_t MAX_RECORD_SIZE = 16 * 1024 * 1024;
+
+    explicit CaptureReader(std::istream& in);
+
+    const CaptureFileHeader& header() const { return m_header; }
+
+    // Reads and validates the next frame into frame. Returns false at the end of the file, a trailing partial frame is ignored.
+    bool read_frame(CaptureFrame& frame);
+
+private:
+    std::istream& m_in;
+    CaptureFileHeader m_header{};
+};
+
+// Passes a frame read by CaptureReader on to sink: its definitions, begin_frame, its draws, end_frame.
+void replay_capture_frame(const CaptureFrame& frame, ChannelSink& sink);
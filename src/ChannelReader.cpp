@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#include "ChannelReader.hpp"
+
+static_assert(sizeof(REFD2DChannelHeader) == 192);
+
+namespace {
+uint64_t load(uint64_t& value) {
+    return std::atomic_ref<uint64_t>{value}.load(std::memory_order_acquire);
+}
+} // namespace
+
+void ChannelReader::format(void* memory, uint32_t capacity) {
+    auto header = (REFD2DChannelHeader*)memory;
+    std::memset(header, 0, sizeof(REFD2DChannelHeader));
+    header->magic = REFD2D_CHANNEL_MAGIC;
+    header->version = REFD2D_CHANNEL_VERSION;
+    header->capacity = capacity & ~(uint32_t)(REFD2D_CHANNEL_ALIGN - 1);
+}
+
+ChannelReader::ChannelReader(void* memory)
+    : m_header{(REFD2DChannelHeader*)memory}
+    , m_ring{(const uint8_t*)memory + sizeof(REFD2DChannelHeader)} {
+    if (m_header->magic != REFD2D_CHANNEL_MAGIC || m_header->version != REFD2D_CHANNEL_VERSION) {
+        throw std::runtime_error{"Channel isn't formatted"};
+    }
+
+    // Kept locally since the producer can write to the header too.
+    m_capacity = m_header->capacity;
+
+    if (m_capacity == 0 || m_capacity % REFD2D_CHANNEL_ALIGN != 0) {
+        throw std::runtime_error{"Invalid channel capacity"};
+    }
+
+    m_read = load(m_header->read_pos);
+}
+
+bool ChannelReader::consume(Sink& sink) {
+    auto write = load(m_header->write_pos);
+
+    if (write == m_read) {
+        return false;
+    }
+
+    if (write < m_read || write - m_read > m_capacity) {
+        ++m_stats.corrupt;
+        release(write);
+        return false;
+    }
+
+    // Validate everything first and find the newest frame.
+    std::optional<uint64_t> newest{};
+    auto in_frame = false;
+
+    for (auto pos = m_read; pos != write;) {
+        auto record = parse(pos, write);
+        auto valid = record.has_value();
+
+        if (valid && record->type == REFD2D_CHANNEL_FRAME_BEGIN) {
+            valid = !in_frame;
+            in_frame = true;
+            newest = pos;
+        } else if (valid && record->type == REFD2D_CHANNEL_FRAME_END) {
+            valid = in_frame;
+            in_frame = false;
+        } else if (valid && is_channel_draw(record->type)) {
+            valid = in_frame;
+        }
+
+        if (!valid) {
+            ++m_stats.corrupt;
+            release(write);
+            return false;
+        }
+
+        pos += record->size;
+    }
+
+    // Only whole frames are ever published.
+    if (in_frame) {
+        ++m_stats.corrupt;
+        release(write);
+        return false;
+    }
+
+    auto drawing = false;
+
+    for (auto pos = m_read; pos != write;) {
+        auto record = parse(pos, write);
+
+        // Changed since it was validated. Whatever was recorded so far is never submitted.
+        if (!record) {
+            ++m_stats.corrupt;
+            release(write);
+            return false;
+        }
+
+        switch (record->type) {
+        case REFD2D_CHANNEL_FRAME_BEGIN:
+            count_sequence(record->sequence);
+            drawing = pos == newest;
+
+            if (drawing) {
+                sink.begin_frame();
+            } else {
+                ++m_stats.skipped;
+            }
+            break;
+
+        case REFD2D_CHANNEL_FRAME_END:
+            if (drawing) {
+                sink.end_frame();
+                ++m_stats.frames;
+                drawing = false;
+            }
+            break;
+
+        case REFD2D_CHANNEL_PAD:
+            break;
+
+        default:
+            // Definitions always apply, draws only for the frame being drawn.
+            if (drawing || !is_channel_draw(record->type)) {
+                dispatch_channel_record(*record, sink);
+            }
+            break;
+        }
+
+        pos += record->size;
+    }
+
+    release(write);
+    return newest.has_value();
+}
+
+std::optional<ChannelRecord> ChannelReader::parse(uint64_t pos, uint64_t end) const {
+    auto offset = pos % m_capacity;
+
+    // Records never wrap around the end of the ring.
+    return parse_channel_record(m_ring + offset, std::min<uint64_t>(end - pos, m_capacity - offset));
+}
+
+void ChannelReader::count_sequence(uint64_t sequence) {
+    // Going backwards means the producer restarted without carrying on from next_sequence, nothing was lost.
+    if (m_last_sequence && sequence > *m_last_sequence + 1) {
+        m_stats.dropped += sequence - *m_last_sequence - 1;
+    }
+
+    m_last_sequence = sequence;
+}
+
+void ChannelReader::release(uint64_t pos) {
+    m_read = pos;
+    std::atomic_ref<uint64_t>{m_header->read_pos}.store(pos, std::memory_order_release);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "ChannelRecord.hpp"
+
+// Consumer side of the channel described in include/reframework-d2d/Channel.h. Records are decoded in place. Nothing the producer
+// writes is trusted, anything malformed throws away everything published so far rather than drawing part of it.
+class ChannelReader {
+public:
+    struct Stats {
+        uint64_t frames{};
+        // Published frames that were superseded by a newer one before they could be drawn.
+        uint64_t skipped{};
+        // Frames the producer couldn't fit, from gaps in the sequence numbers.
+        uint64_t dropped{};
+        uint64_t corrupt{};
+    };
+
+    using Sink = ChannelSink;
+
+    static size_t memory_size(uint32_t capacity) { return sizeof(REFD2DChannelHeader) + capacity; }
+
+    // Sets up a newly created, zeroed channel.
+    static void format(void* memory, uint32_t capacity);
+
+    explicit ChannelReader(void* memory);
+
+    // Applies every published definition and draws the newest published frame, if there's one. Returns true if it drew.
+    bool consume(Sink& sink);
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    REFD2DChannelHeader* m_header{};
+    const uint8_t* m_ring{};
+    uint32_t m_capacity{};
+    uint64_t m_read{};
+    std::optional<uint64_t> m_last_sequence{};
+    Stats m_stats{};
+
+    // The record at pos, if it lies within [pos, end) and is well formed for its type.
+    std::optional<ChannelRecord> parse(uint64_t pos, uint64_t end) const;
+    void count_sequence(uint64_t sequence);
+    void release(uint64_t pos);
+};
@@ -0,0 +1,201 @@
+#include "ChannelRecord.hpp"
+
+static_assert(sizeof(REFD2DChannelRecord) == REFD2D_CHANNEL_ALIGN);
+// ChannelDraw::args runs from thickness into the points.
+static_assert(sizeof(REFD2DChannelPolyline) == offsetof(REFD2DChannelPolyline, thickness) + sizeof(float));
+
+namespace {
+// Reads a field of shared memory exactly once.
+template <typename T> T read(const T& field) {
+    return *(const volatile T*)&field;
+}
+} // namespace
+
+std::optional<ChannelRecord> parse_channel_record(const uint8_t* data, size_t available) {
+    if (available < sizeof(REFD2DChannelRecord)) {
+        return std::nullopt;
+    }
+
+    auto rec_header = (const REFD2DChannelRecord*)data;
+    REFD2DChannelRecord header{read(rec_header->size), read(rec_header->type), read(rec_header->flags)};
+
+    if (header.size < sizeof(REFD2DChannelRecord) || header.size % REFD2D_CHANNEL_ALIGN != 0 || header.size > available) {
+        return std::nullopt;
+    }
+
+    ChannelRecord record{};
+    record.size = header.size;
+    record.type = (REFD2DChannelRecordType)header.type;
+    record.flags = header.flags;
+
+    // The string at offset bytes past the record struct T, if it fits in the record.
+    auto trailing = [&]<typename T>(const T* rec, uint64_t offset, uint32_t length) -> std::optional<std::string_view> {
+        if (offset + length > header.size - sizeof(T)) {
+            return std::nullopt;
+        }
+
+        return std::string_view{(const char*)(rec + 1) + offset, length};
+    };
+
+    switch (header.type) {
+    case REFD2D_CHANNEL_PAD:
+    case REFD2D_CHANNEL_FRAME_END:
+        return record;
+
+    case REFD2D_CHANNEL_FRAME_BEGIN: {
+        if (header.size < sizeof(REFD2DChannelFrameBegin)) {
+            return std::nullopt;
+        }
+
+        record.sequence = read(((const REFD2DChannelFrameBegin*)data)->sequence);
+        return record;
+    }
+
+    case REFD2D_CHANNEL_DEFINE_FONT: {
+        auto rec = (const REFD2DChannelDefineFont*)data;
+
+        if (header.size < sizeof(*rec)) {
+            return std::nullopt;
+        }
+
+        record.id = read(rec->id);
+        record.font_size = read(rec->size);
+        auto str = trailing(rec, 0, read(rec->family_length));
+
+        if (!str) {
+            return std::nullopt;
+        }
+
+        record.str = *str;
+        return record;
+    }
+
+    case REFD2D_CHANNEL_DEFINE_FONT_FILE: {
+        auto rec = (const REFD2DChannelDefineFontFile*)data;
+
+        if (header.size < sizeof(*rec)) {
+            return std::nullopt;
+        }
+
+        record.id = read(rec->id);
+        record.font_size = read(rec->size);
+        auto path = trailing(rec, 0, read(rec->path_length));
+        auto str = path ? trailing(rec, path->size(), read(rec->family_length)) : std::nullopt;
+
+        if (!path || !str || path->empty()) {
+            return std::nullopt;
+        }
+
+        record.path = *path;
+        record.str = *str;
+        return record;
+    }
+
+    case REFD2D_CHANNEL_DEFINE_IMAGE: {
+        auto rec = (const REFD2DChannelDefineImage*)data;
+
+        if (header.size < sizeof(*rec)) {
+            return std::nullopt;
+        }
+
+        record.id = read(rec->id);
+        auto str = trailing(rec, 0, read(rec->path_length));
+
+        if (!str) {
+            return std::nullopt;
+        }
+
+        record.str = *str;
+        return record;
+    }
+
+    case REFD2D_CHANNEL_TEXT: {
+        auto rec = (const REFD2DChannelText*)data;
+
+        if (header.size < sizeof(*rec)) {
+            return std::nullopt;
+        }
+
+        auto str = trailing(rec, 0, read(rec->text_length));
+
+        if (!str) {
+            return std::nullopt;
+        }
+
+        record.draw.type = record.type;
+        record.draw.flags = header.flags;
+        record.draw.value = read(rec->color);
+        record.draw.font = read(rec->font);
+        record.draw.text = *str;
+        record.draw.args = &rec->x;
+        record.draw.arg_count = 2;
+        return record;
+    }
+
+    case REFD2D_CHANNEL_POLYLINE:
+    case REFD2D_CHANNEL_FILL_POLYGON: {
+        auto rec = (const REFD2DChannelPolyline*)data;
+
+        if (header.size < sizeof(*rec)) {
+            return std::nullopt;
+        }
+
+        auto point_count = read(rec->point_count);
+
+        if ((uint64_t)point_count * 2 * sizeof(float) > header.size - sizeof(*rec)) {
+            return std::nullopt;
+        }
+
+        record.draw.type = record.type;
+        record.draw.flags = header.flags;
+        record.draw.value = read(rec->color);
+        record.draw.args = &rec->thickness;
+        record.draw.arg_count = 1 + point_count * 2;
+        return record;
+    }
+
+    case REFD2D_CHANNEL_POP_TRANSFORM:
+    case REFD2D_CHANNEL_POP_CLIP:
+        record.draw.type = record.type;
+        record.draw.flags = header.flags;
+        return record;
+
+    default: {
+        auto arg_count = refd2d_channel_arg_count(header.type);
+        auto rec = (const REFD2DChannelShape*)data;
+
+        if (arg_count == 0 || header.size < sizeof(*rec) + arg_count * sizeof(float)) {
+            return std::nullopt;
+        }
+
+        record.draw.type = record.type;
+        record.draw.flags = header.flags;
+        record.draw.value = read(rec->value);
+        record.draw.args = (const float*)(rec + 1);
+        record.draw.arg_count = arg_count;
+        return record;
+    }
+    }
+}
+
+void dispatch_channel_record(const ChannelRecord& record, ChannelSink& sink) {
+    auto bold = (record.flags & REFD2D_CHANNEL_BOLD) != 0;
+    auto italic = (record.flags & REFD2D_CHANNEL_ITALIC) != 0;
+
+    switch (record.type) {
+    case REFD2D_CHANNEL_DEFINE_FONT:
+    case REFD2D_CHANNEL_DEFINE_FONT_FILE:
+        sink.define_font(record.id, record.path, record.str, record.font_size, bold, italic);
+        break;
+
+    case REFD2D_CHANNEL_DEFINE_IMAGE:
+        sink.define_image(record.id, record.str);
+        break;
+
+    default:
+        if (is_channel_draw(record.type)) {
+            sink.draw(record.draw);
+        }
+        break;
+    }
+}
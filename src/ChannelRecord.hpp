@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "reframework-d2d/Channel.h"
+
+// Decoding of the records in include/reframework-d2d/Channel.h, shared by the channel ring and capture files.
+
+// A draw record. Points into the record's memory.
+struct ChannelDraw {
+    REFD2DChannelRecordType type{};
+    uint16_t flags{};
+    // The color, or the image id for images.
+    uint32_t value{};
+    // For text only.
+    uint32_t font{};
+    std::string_view text{};
+    // x and y for text, thickness then the points for polylines and polygons, see refd2d_channel_arg_count for everything else.
+    const float* args{};
+    uint32_t arg_count{};
+};
+
+// A validated record. Every field is read from memory exactly once, so a producer changing the record under the reader can't get
+// around the checks.
+struct ChannelRecord {
+    uint32_t size{};
+    REFD2DChannelRecordType type{};
+    uint16_t flags{};
+    uint64_t sequence{};
+    // Definitions. str is the family for fonts and the path for images, path the font file.
+    uint32_t id{};
+    int font_size{};
+    std::string_view str{};
+    std::string_view path{};
+    ChannelDraw draw{};
+};
+
+// Receives decoded frames.
+class ChannelSink {
+public:
+    virtual ~ChannelSink() = default;
+
+    // An empty path means a system font.
+    virtual void define_font(uint32_t id, std::string_view path, std::string_view family, int size, bool bold, bool italic) = 0;
+    virtual void define_image(uint32_t id, std::string_view path) = 0;
+    virtual void begin_frame() = 0;
+    virtual void draw(const ChannelDraw& draw) = 0;
+    virtual void end_frame() = 0;
+};
+
+inline bool is_channel_draw(uint16_t type) {
+    return type >= REFD2D_CHANNEL_TEXT && type <= REFD2D_CHANNEL_FILL_POLYGON;
+}
+
+// The record at data if it fits within available bytes and is well formed for its type. data has to be REFD2D_CHANNEL_ALIGN aligned.
+std::optional<ChannelRecord> parse_channel_record(const uint8_t* data, size_t available);
+
+// Passes a definition or draw on to the sink. Frame markers and padding are left to the caller.
+void dispatch_channel_record(const ChannelRecord& record, ChannelSink& sink);
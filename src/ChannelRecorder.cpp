@@ -0,0 +1,186 @@
+#include <filesystem>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "utf8.h"
+
+#include "ChannelRecorder.hpp"
+
+namespace {
+std::filesystem::path to_wide_path(std::string_view utf8_path) {
+    std::wstring wide{};
+    utf8::utf8to16(utf8_path.begin(), utf8_path.end(), std::back_inserter(wide));
+    return wide;
+}
+} // namespace
+
+ChannelRecorder::ChannelRecorder(
+    DrawList& drawlist, int order, std::function<const D2DPainter::Factories&()> factories, ErrorFn on_error)
+    : m_drawlist{drawlist}
+    , m_order{order}
+    , m_factories{std::move(factories)}
+    , m_on_error{std::move(on_error)} {}
+
+void ChannelRecorder::define_font(uint32_t id, std::string_view path, std::string_view family, int size, bool bold, bool italic) try {
+    if (path.empty()) {
+        m_fonts[id] = std::make_shared<D2DFont>(m_factories().dwrite, std::string{family}, size, bold, italic);
+        return;
+    }
+
+    auto wide_path = to_wide_path(path);
+
+    if (!std::filesystem::is_regular_file(wide_path)) {
+        throw std::runtime_error{"File not found"};
+    }
+
+    m_fonts[id] = std::make_shared<D2DFont>(m_factories().dwrite, wide_path, std::string{family}, size, bold, italic);
+} catch (const std::exception& e) {
+    m_fonts.erase(id);
+    error("Font " + std::to_string(id) + ": " + e.what());
+}
+
+void ChannelRecorder::define_image(uint32_t id, std::string_view path) try {
+    auto wide_path = to_wide_path(path);
+
+    if (!std::filesystem::is_regular_file(wide_path)) {
+        throw std::runtime_error{"File not found"};
+    }
+
+    m_images[id] = std::make_shared<D2DImage>(m_factories().wic, wide_path);
+} catch (const std::exception& e) {
+    m_images.erase(id);
+    error("Image " + std::to_string(id) + ": " + e.what());
+}
+
+void ChannelRecorder::begin_frame() {
+    if (m_producer == nullptr) {
+        m_producer = m_drawlist.create_producer(m_order);
+    }
+
+    m_producer->reset();
+}
+
+void ChannelRecorder::draw(const ChannelDraw& draw) {
+    auto cmds = DrawList::Recorder{*m_producer};
+    auto a = draw.args;
+    auto color = draw.value;
+    auto clockwise = (draw.flags & REFD2D_CHANNEL_CLOCKWISE) != 0;
+
+    // Fonts and images that failed to load, or were never defined, are skipped.
+    auto find = [](auto& map, uint32_t id) {
+        auto it = map.find(id);
+        return it != map.end() ? it->second : nullptr;
+    };
+
+    switch (draw.type) {
+    case REFD2D_CHANNEL_TEXT:
+        if (auto font = find(m_fonts, draw.font)) {
+            cmds.text(font, std::string{draw.text}, a[0], a[1], color);
+        }
+        break;
+
+    case REFD2D_CHANNEL_FILL_RECT:
+        cmds.fill_rect(a[0], a[1], a[2], a[3], color);
+        break;
+
+    case REFD2D_CHANNEL_OUTLINE_RECT:
+        cmds.outline_rect(a[0], a[1], a[2], a[3], a[4], color);
+        break;
+
+    case REFD2D_CHANNEL_ROUNDED_RECT:
+        cmds.rounded_rect(a[0], a[1], a[2], a[3], a[4], a[5], a[6], color);
+        break;
+
+    case REFD2D_CHANNEL_FILL_ROUNDED_RECT:
+        cmds.fill_rounded_rect(a[0], a[1], a[2], a[3], a[4], a[5], color);
+        break;
+
+    case REFD2D_CHANNEL_QUAD:
+        cmds.quad(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8], color);
+        break;
+
+    case REFD2D_CHANNEL_FILL_QUAD:
+        cmds.fill_quad(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], color);
+        break;
+
+    case REFD2D_CHANNEL_LINE:
+        cmds.line(a[0], a[1], a[2], a[3], a[4], color);
+        break;
+
+    case REFD2D_CHANNEL_IMAGE:
+        if (auto image = find(m_images, draw.value)) {
+            cmds.image(image, a[0], a[1], a[2], a[3], a[4]);
+        }
+        break;
+
+    case REFD2D_CHANNEL_IMAGE_RECT:
+        if (auto image = find(m_images, draw.value)) {
+            cmds.image_rect(image, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8]);
+        }
+        break;
+
+    case REFD2D_CHANNEL_FILL_CIRCLE:
+        cmds.fill_circle(a[0], a[1], a[2], a[3], color);
+        break;
+
+    case REFD2D_CHANNEL_CIRCLE:
+        cmds.circle(a[0], a[1], a[2], a[3], a[4], color);
+        break;
+
+    case REFD2D_CHANNEL_PIE:
+        cmds.pie(a[0], a[1], a[2], a[3], a[4], color, clockwise);
+        break;
+
+    case REFD2D_CHANNEL_OUTLINE_PIE:
+        cmds.outline_pie(a[0], a[1], a[2], a[3], a[4], a[5], color, clockwise);
+        break;
+
+    case REFD2D_CHANNEL_RING:
+        cmds.ring(a[0], a[1], a[2], a[3], a[4], a[5], color, clockwise);
+        break;
+
+    case REFD2D_CHANNEL_OUTLINE_RING:
+        cmds.outline_ring(a[0], a[1], a[2], a[3], a[4], a[5], a[6], color, clockwise);
+        break;
+
+    // The ring is reused once the frame is read, the points are copied.
+    case REFD2D_CHANNEL_POLYLINE:
+        cmds.polyline(std::string{(const char*)(a + 1), (draw.arg_count - 1) * sizeof(float)}, a[0], color,
+            (draw.flags & REFD2D_CHANNEL_CLOSED) != 0);
+        break;
+
+    case REFD2D_CHANNEL_FILL_POLYGON:
+        cmds.fill_polygon(std::string{(const char*)(a + 1), (draw.arg_count - 1) * sizeof(float)}, color);
+        break;
+
+    case REFD2D_CHANNEL_PUSH_TRANSFORM:
+        cmds.push_transform({a[0], a[1], a[2], a[3], a[4], a[5]});
+        break;
+
+    case REFD2D_CHANNEL_POP_TRANSFORM:
+        cmds.pop_transform();
+        break;
+
+    case REFD2D_CHANNEL_PUSH_CLIP:
+        cmds.push_clip(a[0], a[1], a[2], a[3]);
+        break;
+
+    case REFD2D_CHANNEL_POP_CLIP:
+        cmds.pop_clip();
+        break;
+
+    default:
+        break;
+    }
+}
+
+void ChannelRecorder::end_frame() {
+    m_producer->submit();
+}
+
+void ChannelRecorder::error(const std::string& msg) {
+    if (m_on_error) {
+        m_on_error(msg);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "ChannelRecord.hpp"
+#include "D2DPainter.hpp"
+#include "DrawList.hpp"
+
+// Records decoded channel frames into a DrawList producer of their own, each frame replacing the last. Definitions are turned into
+// fonts and images, draws referring to ones that failed to load or were never defined are skipped.
+class ChannelRecorder : public ChannelSink {
+public:
+    using ErrorFn = std::function<void(const std::string&)>;
+
+    // The producer is created with the first frame, so nothing is drawn, and the renderer isn't started, for a channel that's unused.
+    ChannelRecorder(DrawList& drawlist, int order, std::function<const D2DPainter::Factories&()> factories, ErrorFn on_error = {});
+
+    void define_font(uint32_t id, std::string_view path, std::string_view family, int size, bool bold, bool italic) override;
+    void define_image(uint32_t id, std::string_view path) override;
+    void begin_frame() override;
+    void draw(const ChannelDraw& draw) override;
+    void end_frame() override;
+
+private:
+    DrawList& m_drawlist;
+    int m_order{};
+    std::function<const D2DPainter::Factories&()> m_factories{};
+    ErrorFn m_on_error{};
+
+    std::shared_ptr<DrawList::Producer> m_producer{};
+    std::unordered_map<uint32_t, std::shared_ptr<D2DFont>> m_fonts{};
+    std::unordered_map<uint32_t, std::shared_ptr<D2DImage>> m_images{};
+
+    void error(const std::string& msg);
+};
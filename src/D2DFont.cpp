@@ -3,10 +3,10 @@
 #include "utf8.h"
 
 #include "D2DFont.hpp"
-#include "reframework/API.hpp"
 
 D2DFont::D2DFont(ComPtr<IDWriteFactory5> dwrite, const std::string& family, int size, bool bold, bool italic)
-    : m_dwrite{dwrite} {
+    : m_description{{}, family, size, bold, italic}
+    , m_dwrite{dwrite} {
     std::wstring wide_family{};
     utf8::utf8to16(family.begin(), family.end(), std::back_inserter(wide_family));
 
@@ -18,7 +18,8 @@ D2DFont::D2DFont(ComPtr<IDWriteFactory5> dwrite, const std::string& family, int
 
 D2DFont::D2DFont(
     ComPtr<IDWriteFactory5> dwrite, std::filesystem::path filepath, const std::string& family, int size, bool bold, bool italic)
-    : m_dwrite{dwrite} {
+    : m_description{filepath, family, size, bold, italic}
+    , m_dwrite{dwrite} {
     ComPtr<IDWriteFontSetBuilder1> fontSetBuilder;
     if (FAILED(m_dwrite->CreateFontSetBuilder(&fontSetBuilder))) {
         throw std::runtime_error{"Failed to create DWrite font set builder"};
@@ -84,8 +85,6 @@ D2DFont::D2DFont(
         }
     }
 
-    reframework::API::get()->log_info("[reframework-d2d] [D2DFont] Chose family %S for font %S", wide_family.c_str(), filepath.filename().c_str() );
-
     if (FAILED(m_dwrite->CreateTextFormat(wide_family.c_str(), m_fontCollection.Get(),
             bold ? DWRITE_FONT_WEIGHT_BOLD : DWRITE_FONT_WEIGHT_NORMAL,
             italic ? DWRITE_FONT_STYLE_ITALIC : DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL, size, L"en-us", &m_format))) {
@@ -93,8 +92,21 @@ D2DFont::D2DFont(
     }
 }
 
-D2DFont::ComPtr<IDWriteTextLayout> D2DFont::layout(const std::string& text) {
-    if (auto l = m_layouts.get(text)) {
+std::wstring D2DFont::family_name() const {
+    std::wstring name(m_format->GetFontFamilyNameLength() + 1, L'\0');
+
+    if (FAILED(m_format->GetFontFamilyName(name.data(), (UINT32)name.size()))) {
+        throw std::runtime_error{"IDWriteTextFormat::GetFontFamilyName failed"};
+    }
+
+    name.resize(name.size() - 1);
+    return name;
+}
+
+D2DFont::ComPtr<IDWriteTextLayout> D2DFont::layout(std::string_view text, size_t hash) {
+    std::scoped_lock _{m_layouts_mtx};
+
+    if (auto l = m_layouts.get(TextKey::Hashed{text, hash})) {
         return (*l).get();
     }
 
@@ -107,12 +119,12 @@ D2DFont::ComPtr<IDWriteTextLayout> D2DFont::layout(const std::string& text) {
         throw std::runtime_error{"Failed to create dwrite text layout"};
     }
 
-    m_layouts.put(text, l);
+    m_layouts.put(std::string{text}, l);
 
     return l;
 }
 
-std::tuple<float, float> D2DFont::measure(const std::string& text) {
+std::tuple<float, float> D2DFont::measure(std::string_view text) {
     DWRITE_TEXT_METRICS metrics{};
 
     layout(text)->GetMetrics(&metrics);
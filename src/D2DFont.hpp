@@ -1,7 +1,9 @@
 #pragma once
 
 #include <filesystem>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <tuple>
 
 #include <d2d1.h>
@@ -10,21 +12,45 @@
 #include <wrl.h>
 
 #include "LruCache.hpp"
+#include "TextKey.hpp"
 
 class D2DFont {
 public:
     template <typename T> using ComPtr = Microsoft::WRL::ComPtr<T>;
 
+    // What the font was created from, an empty filepath means a system font.
+    struct Description {
+        std::filesystem::path filepath{};
+        std::string family{};
+        int size{};
+        bool bold{};
+        bool italic{};
+    };
+
     D2DFont(ComPtr<IDWriteFactory5> dwrite, const std::string& family, int size, bool bold, bool italic);
     D2DFont(ComPtr<IDWriteFactory5> dwrite, std::filesystem::path filepath, const std::string& family, int size, bool bold, bool italic);
 
-    ComPtr<IDWriteTextLayout> layout(const std::string& text);
-    std::tuple<float, float> measure(const std::string& text);
+    // The hash layouts are cached by. Text recorded for drawing carries it so the render worker doesn't hash it again.
+    static size_t hash_text(std::string_view text) { return TextKey::hash(text); }
+
+    ComPtr<IDWriteTextLayout> layout(std::string_view text) { return layout(text, hash_text(text)); }
+    ComPtr<IDWriteTextLayout> layout(std::string_view text, size_t hash);
+    std::tuple<float, float> measure(std::string_view text);
+
+    const auto& description() const { return m_description; }
+
+    // The family actually used, for file fonts created without one it's picked from the file.
+    std::wstring family_name() const;
 
 private:
+    Description m_description{};
     ComPtr<IDWriteFactory5> m_dwrite{};
     ComPtr<IDWriteFontFile> m_fontFile{};
     ComPtr<IDWriteFontCollection1> m_fontCollection{};
     ComPtr<IDWriteTextFormat> m_format{};
-    LruCache<std::string, ComPtr<IDWriteTextLayout>> m_layouts{100};
+    // Looked up by a TextKey::Hashed, so neither a hit nor a miss copies the text before it has to be stored.
+    LruCache<std::string, ComPtr<IDWriteTextLayout>, TextKey::Hash, TextKey::Equal> m_layouts{100};
+
+    // Scripts measure text on the game thread while the render worker lays it out for drawing.
+    std::mutex m_layouts_mtx{};
 };
\ No newline at end of file
@@ -1,8 +1,45 @@
+#include <algorithm>
+#include <cmath>
+#include <cwctype>
 #include <stdexcept>
+#include <vector>
+
+#include "ImageScaler.hpp"
 
 #include "D2DImage.hpp"
 
-D2DImage::D2DImage(ComPtr<IWICImagingFactory> wic, ComPtr<ID2D1DeviceContext> context, std::filesystem::path filepath) {
+namespace {
+constexpr float MIN_MIP_REDUCTION = 2.0f;
+
+D2D1_BITMAP_PROPERTIES1 bitmap_props(DXGI_FORMAT format) {
+    return D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_NONE, D2D1::PixelFormat(format, D2D1_ALPHA_MODE_PREMULTIPLIED));
+}
+
+D2DImage::ComPtr<ID2D1Bitmap> make_bitmap(
+    ID2D1DeviceContext* context, D2D1_SIZE_U size, const void* data, UINT32 pitch, DXGI_FORMAT format) {
+    D2DImage::ComPtr<ID2D1Bitmap1> bitmap{};
+
+    if (FAILED(context->CreateBitmap(size, data, pitch, bitmap_props(format), &bitmap))) {
+        throw std::runtime_error{"Failed to create D2D bitmap"};
+    }
+
+    return bitmap;
+}
+
+bool is_dds(const std::filesystem::path& filepath) {
+    auto ext = filepath.extension().wstring();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](wchar_t c) { return (wchar_t)std::towlower(c); });
+    return ext == L".dds";
+}
+} // namespace
+
+D2DImage::D2DImage(ComPtr<IWICImagingFactory> wic, std::filesystem::path filepath)
+    : m_filepath{filepath} {
+    if (is_dds(filepath)) {
+        load_dds(filepath);
+        return;
+    }
+
     ComPtr<IWICBitmapDecoder> decoder{};
 
     if (FAILED(wic->CreateDecoderFromFilename(filepath.c_str(), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnLoad, &decoder))) {
@@ -26,9 +63,170 @@ D2DImage::D2DImage(ComPtr<IWICImagingFactory> wic, ComPtr<ID2D1DeviceContext> co
         throw std::runtime_error{"Failed to initialize WIC format converter"};
     }
 
-    if (FAILED(context->CreateBitmapFromWicBitmap(converter.Get(), nullptr, &m_bitmap))) {
-        throw std::runtime_error{"Failed to create D2D bitmap from WIC bitmap"};
+    if (FAILED(converter->GetSize(&m_size.width, &m_size.height))) {
+        throw std::runtime_error{"Failed to get WIC bitmap size"};
+    }
+
+    m_pixels.resize((size_t)m_size.width * m_size.height * 4);
+
+    if (FAILED(converter->CopyPixels(nullptr, m_size.width * 4, (UINT)m_pixels.size(), m_pixels.data()))) {
+        throw std::runtime_error{"Failed to copy WIC bitmap pixels"};
+    }
+}
+
+D2DImage::D2DImage(UINT32 width, UINT32 height)
+    : m_size{width, height} {
+    if (width == 0 || height == 0) {
+        throw std::runtime_error{"Invalid image size"};
+    }
+
+    m_pixels.resize((size_t)width * height * 4);
+}
+
+void D2DImage::load_dds(const std::filesystem::path& filepath) {
+    m_dds = std::make_unique<DdsFile>(filepath);
+    m_size = {m_dds->width(), m_dds->height()};
+    auto gpu_format = DXGI_FORMAT_UNKNOWN;
+
+    // D2D can sample BC1-3 directly but only as premultiplied alpha and only when the size is block aligned. BC1's punchthrough
+    // texels decode to transparent black so they're always valid premultiplied data, BC2/BC3 need to have been authored that way.
+    switch (m_dds->format()) {
+    case DdsFile::Format::BC1:
+        gpu_format = DXGI_FORMAT_BC1_UNORM;
+        break;
+    case DdsFile::Format::BC2:
+        gpu_format = m_dds->alpha_mode() != DdsFile::AlphaMode::STRAIGHT ? DXGI_FORMAT_BC2_UNORM : DXGI_FORMAT_UNKNOWN;
+        break;
+    case DdsFile::Format::BC3:
+        gpu_format = m_dds->alpha_mode() != DdsFile::AlphaMode::STRAIGHT ? DXGI_FORMAT_BC3_UNORM : DXGI_FORMAT_UNKNOWN;
+        break;
+    default:
+        break;
+    }
+
+    // Whether the device can actually sample it is checked once a bitmap gets made.
+    if (gpu_format != DXGI_FORMAT_UNKNOWN && m_size.width % 4 == 0 && m_size.height % 4 == 0) {
+        m_gpu_format = gpu_format;
+        return;
+    }
+
+    // Everything else gets decoded on the CPU.
+    decode_dds();
+}
+
+void D2DImage::decode_dds() {
+    m_pixels.resize((size_t)m_size.width * m_size.height * 4);
+    m_dds->decode_bgra(m_pixels.data(), (size_t)m_size.width * 4);
+    m_dds.reset();
+    m_gpu_format = DXGI_FORMAT_B8G8R8A8_UNORM;
+}
+
+ID2D1Bitmap* D2DImage::bitmap(ID2D1DeviceContext* context) {
+    if (m_bitmap == nullptr) {
+        m_bitmap = create_bitmap(context);
+    }
+
+    return m_bitmap.Get();
+}
+
+D2DImage::ComPtr<ID2D1Bitmap> D2DImage::create_bitmap(ID2D1DeviceContext* context) {
+    if (m_dds != nullptr && !context->IsDxgiFormatSupported(m_gpu_format)) {
+        decode_dds();
+    }
+
+    if (m_dds != nullptr) {
+        return make_bitmap(context, m_size, m_dds->data(), m_dds->pitch(), m_gpu_format);
+    }
+
+    return make_bitmap(context, m_size, m_pixels.data(), m_size.width * 4, DXGI_FORMAT_B8G8R8A8_UNORM);
+}
+
+D2DImage::Level D2DImage::level_for(ID2D1DeviceContext* context, float src_w, float src_h, float dst_w, float dst_h) {
+    if (dst_w <= 0.0f || dst_h <= 0.0f) {
+        return {bitmap(context)};
+    }
+
+    // The reduction along the axis that's shrunk the least decides, so no axis ends up sampled below its destination size.
+    auto reduction = std::min(src_w / dst_w, src_h / dst_h);
+
+    if (reduction < MIN_MIP_REDUCTION) {
+        return {bitmap(context)};
+    }
+
+    auto level = (size_t)std::floor(std::log2(reduction));
+    auto& m = mip(context, level);
+
+    return {m.bitmap.Get(), (float)m.size.width / m_size.width, (float)m.size.height / m_size.height};
+}
+
+void D2DImage::evict() {
+    m_bitmap.Reset();
+
+    for (auto& m : m_mips) {
+        m.bitmap.Reset();
+    }
+}
+
+void D2DImage::bind(uint64_t generation) {
+    if (m_device.rebind(generation)) {
+        evict();
+    }
+}
+
+uint64_t D2DImage::resident_bytes() const {
+    uint64_t bytes{};
+
+    if (m_bitmap != nullptr) {
+        bytes += m_dds != nullptr ? (uint64_t)m_dds->data_size() : (uint64_t)m_size.width * m_size.height * 4;
+    }
+
+    for (const auto& m : m_mips) {
+        if (m.bitmap != nullptr) {
+            bytes += m.pixels.size();
+        }
+    }
+
+    return bytes;
+}
+
+D2DImage::Mip& D2DImage::mip(ID2D1DeviceContext* context, size_t level) {
+    // Clamp to the last level that still has a meaningful size.
+    auto max_level = (size_t)std::floor(std::log2((float)std::max(m_size.width, m_size.height)));
+    level = std::clamp<size_t>(level, 1, std::max<size_t>(max_level, 1));
+
+    if (m_mips.size() < level) {
+        std::vector<uint8_t> decoded{};
+        const auto* src = m_pixels.data();
+        auto src_size = m_size;
+
+        if (!m_mips.empty()) {
+            src = m_mips.back().pixels.data();
+            src_size = m_mips.back().size;
+        } else if (m_pixels.empty()) {
+            // Block compressed images only get decoded when a mip chain is actually needed.
+            decoded.resize((size_t)m_size.width * m_size.height * 4);
+            m_dds->decode_bgra(decoded.data(), (size_t)m_size.width * 4);
+            src = decoded.data();
+        }
+
+        while (m_mips.size() < level) {
+            Mip m{};
+            m.size = {ImageScaler::half(src_size.width), ImageScaler::half(src_size.height)};
+            m.pixels.resize((size_t)m.size.width * m.size.height * 4);
+            ImageScaler::downsample_2x(
+                src, src_size.width, src_size.height, (size_t)src_size.width * 4, m.pixels.data(), (size_t)m.size.width * 4);
+
+            m_mips.push_back(std::move(m));
+            src = m_mips.back().pixels.data();
+            src_size = m_mips.back().size;
+        }
+    }
+
+    auto& m = m_mips[level - 1];
+
+    if (m.bitmap == nullptr) {
+        m.bitmap = make_bitmap(context, m.size, m.pixels.data(), m.size.width * 4, DXGI_FORMAT_B8G8R8A8_UNORM);
     }
 
-    m_size = m_bitmap->GetPixelSize();
+    return m;
 }
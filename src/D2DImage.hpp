@@ -1,22 +1,91 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <tuple>
+#include <vector>
 
 #include <d2d1_3.h>
 #include <wincodec.h>
 #include <wrl.h>
 
+#include "DdsFile.hpp"
+#include "DeviceGeneration.hpp"
+
 class D2DImage {
 public:
     template <typename T> using ComPtr = Microsoft::WRL::ComPtr<T>;
 
-    D2DImage(ComPtr<IWICImagingFactory> wic, ComPtr<ID2D1DeviceContext> context, std::filesystem::path filepath);
+    // A bitmap to draw with and the factor to scale source rectangles (given in full resolution pixels) by.
+    struct Level {
+        ID2D1Bitmap* bitmap{};
+        float scale_x{1.0f};
+        float scale_y{1.0f};
+    };
+
+    // Loading only touches device independent state, no bitmap is made until the image is drawn.
+    D2DImage(ComPtr<IWICImagingFactory> wic, std::filesystem::path filepath);
+    virtual ~D2DImage() = default;
+
+    // The full resolution bitmap. Bitmaps are created on first use and recreated from the CPU copy after being evicted.
+    virtual ID2D1Bitmap* bitmap(ID2D1DeviceContext* context);
+
+    // Picks the smallest mip level that is still at least as large as the destination so heavily downscaled draws don't sample the
+    // full resolution bitmap. Levels are built on first use.
+    virtual Level level_for(ID2D1DeviceContext* context, float src_w, float src_h, float dst_w, float dst_h);
+
+    // Images whose contents change after creation, these are kept out of the atlas.
+    virtual bool is_dynamic() const { return false; }
+
+    // Releases every bitmap, the CPU copies are kept so they can be recreated on the next draw.
+    void evict();
+
+    // Called before drawing with the painter's device generation. Bitmaps left over from a previous device are evicted.
+    void bind(uint64_t generation);
 
-    const auto& bitmap() const { return m_bitmap; }
     auto size() const { return std::make_tuple(m_size.width, m_size.height); }
 
+    // The file the image was loaded from, empty for images made in memory.
+    const auto& filepath() const { return m_filepath; }
+
+    // 32bpp premultiplied BGRA, empty for images kept block compressed.
+    const auto& pixels() const { return m_pixels; }
+
+    // Video memory currently held by this image's bitmaps.
+    uint64_t resident_bytes() const;
+
+protected:
+    // A blank image of the given size, for subclasses that fill m_pixels themselves.
+    D2DImage(UINT32 width, UINT32 height);
+
+    ComPtr<ID2D1Bitmap> create_bitmap(ID2D1DeviceContext* context);
+
 private:
+    struct Mip {
+        D2D1_SIZE_U size{};
+        std::vector<uint8_t> pixels{};
+        ComPtr<ID2D1Bitmap> bitmap{};
+    };
+
+protected:
     ComPtr<ID2D1Bitmap> m_bitmap{};
     D2D1_SIZE_U m_size{};
+
+    // CPU copy of the image as 32bpp premultiplied BGRA. Empty when the image is kept block compressed, in which case m_dds holds it
+    // and m_gpu_format says which format to upload it as.
+    std::vector<uint8_t> m_pixels{};
+    std::unique_ptr<DdsFile> m_dds{};
+    DXGI_FORMAT m_gpu_format{DXGI_FORMAT_B8G8R8A8_UNORM};
+
+private:
+    std::filesystem::path m_filepath{};
+
+    // Levels 1 and up, level 0 is m_bitmap.
+    std::vector<Mip> m_mips{};
+    DeviceTag m_device{};
+
+    void load_dds(const std::filesystem::path& filepath);
+    void decode_dds();
+    Mip& mip(ID2D1DeviceContext* context, size_t level);
 };
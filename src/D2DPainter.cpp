@@ -1,14 +1,37 @@
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 #include "utf8.h"
 
+#include "AtlasSource.hpp"
 #include "D2DPainter.hpp"
 
-D2DPainter::D2DPainter(ID3D11Device* device, IDXGISurface* surface) {
-    if (FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, m_d2d1.GetAddressOf()))) {
+D2DPainter::Factories D2DPainter::Factories::create() {
+    Factories factories{};
+
+    // Drawing happens on the render worker but images are loaded on the game thread, so D2D has to serialize access itself.
+    if (FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_MULTI_THREADED, factories.d2d1.GetAddressOf()))) {
         throw std::runtime_error{"Failed to create D2D factory"};
     }
 
+    if (FAILED(DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory5), &factories.dwrite))) {
+        throw std::runtime_error{"Failed to create DWrite factory"};
+    }
+
+    if (FAILED(CoCreateInstance(CLSID_WICImagingFactory1, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factories.wic)))) {
+        throw std::runtime_error{"Failed to create WIC factory"};
+    }
+
+    return factories;
+}
+
+D2DPainter::D2DPainter(const Factories& factories, ID3D11Device* device, const std::vector<IDXGISurface*>& surfaces, D2D1_SIZE_U size)
+    : m_d2d1{factories.d2d1}
+    , m_size{size}
+    , m_dwrite{factories.dwrite}
+    , m_wic{factories.wic}
+    , m_generation{DeviceGeneration::next()} {
     ComPtr<IDXGIDevice> dxgi_device{};
 
     if (FAILED(device->QueryInterface(dxgi_device.GetAddressOf()))) {
@@ -23,68 +46,247 @@ D2DPainter::D2DPainter(ID3D11Device* device, IDXGISurface* surface) {
         throw std::runtime_error{"Failed to create D2D device context"};
     }
 
-    if (FAILED(surface->GetDesc(&m_rt_desc))) {
+    if (surfaces.empty() || FAILED(surfaces.front()->GetDesc(&m_rt_desc))) {
         throw std::runtime_error{"Failed to get DXGI surface description"};
     }
 
-    if (FAILED(m_context->CreateBitmapFromDxgiSurface(surface, nullptr, &m_rt))) {
-        throw std::runtime_error{"Failed to create D2D render target from dxgi surface"};
+    if (m_size.width == 0 || m_size.height == 0) {
+        throw std::runtime_error{"Invalid D2D painter size"};
+    }
+
+    m_scale_x = (float)m_rt_desc.Width / m_size.width;
+    m_scale_y = (float)m_rt_desc.Height / m_size.height;
+
+    for (auto surface : surfaces) {
+        ComPtr<ID2D1Bitmap1> rt{};
+
+        if (FAILED(m_context->CreateBitmapFromDxgiSurface(surface, nullptr, &rt))) {
+            throw std::runtime_error{"Failed to create D2D render target from dxgi surface"};
+        }
+
+        m_rts.push_back(std::move(rt));
     }
 
     if (FAILED(m_context->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &m_brush))) {
         throw std::runtime_error{"Failed to create D2D brush"};
     }
 
-    if (FAILED(DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory5), &m_dwrite))) {
-        throw std::runtime_error{"Failed to create DWrite factory"};
-    }
+    m_atlas = std::make_unique<ImageAtlas>(m_context);
+    m_bounds = DrawBounds{(int)m_rt_desc.Width, (int)m_rt_desc.Height};
+}
 
-    if (FAILED(CoCreateInstance(CLSID_WICImagingFactory1, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&m_wic)))) {
-        throw std::runtime_error{"Failed to create WIC factory"};
+D2DPainter::~D2DPainter() {
+    // Images outlive the painter, don't leave them holding on to this device's bitmaps.
+    for (auto& [key, weak_image] : m_resident_images) {
+        if (auto image = weak_image.lock()) {
+            image->evict();
+        }
     }
 }
 
-void D2DPainter::begin() {
-    m_context->SetTarget(m_rt.Get());
+void D2DPainter::begin(size_t target) {
+    ++m_frame;
+    m_bounds.clear();
+    m_atlas->collect();
+    m_residency.remove_if([this](const D2DImage* key) {
+        if (auto it = m_resident_images.find(key); it != m_resident_images.end() && it->second.expired()) {
+            m_resident_images.erase(it);
+            return true;
+        }
+
+        return false;
+    });
+    m_context->SetTarget(m_rts.at(target).Get());
     m_context->BeginDraw();
     m_context->Clear(D2D1::ColorF(D2D1::ColorF::Black, 0.0f));
+    reset_transform();
 }
 
 void D2DPainter::end() {
+    // D2D fails EndDraw with clips still pushed.
+    reset_clips();
     m_context->EndDraw();
+
+    std::scoped_lock _{m_image_stats_mtx};
+    m_residency.set_budget(m_image_budget);
+
+    // Evicting after EndDraw so nothing still batched references the bitmaps.
+    for (auto key : m_residency.evict(m_frame)) {
+        if (auto it = m_resident_images.find(key); it != m_resident_images.end()) {
+            if (auto image = it->second.lock()) {
+                image->evict();
+            }
+
+            m_resident_images.erase(it);
+        }
+    }
+
+    m_image_stats = {m_residency.budget(), m_residency.resident(), m_residency.evictions(), m_residency.size()};
+}
+
+void D2DPainter::set_image_budget(uint64_t bytes) {
+    std::scoped_lock _{m_image_stats_mtx};
+    m_image_budget = bytes;
+    m_image_stats.budget = bytes;
+}
+
+D2DPainter::ImageStats D2DPainter::image_stats() {
+    std::scoped_lock _{m_image_stats_mtx};
+    return m_image_stats;
+}
+
+void D2DPainter::track(const std::shared_ptr<D2DImage>& image) {
+    auto [it, inserted] = m_resident_images.try_emplace(image.get(), image);
+
+    // Another image used to live at this address, its bitmaps went away with it.
+    if (!inserted && it->second.expired()) {
+        m_residency.remove(image.get());
+        it->second = image;
+    }
+
+    m_residency.touch(image.get(), image->resident_bytes(), m_frame);
+}
+
+void D2DPainter::add_bounds(float left, float top, float right, float bottom, float stroke) {
+    // Strokes are centered on the outline.
+    auto pad = stroke * 0.5f;
+    DrawPrepass::Rect r{std::min(left, right) - pad, std::min(top, bottom) - pad, std::max(left, right) + pad, std::max(top, bottom) + pad};
+
+    if (!m_transform.is_identity()) {
+        r = DrawPrepass::transform_bounds(m_transform, r);
+    }
+
+    if (!m_clips.empty()) {
+        r = DrawPrepass::intersect(r, m_clips.back());
+
+        if (r.left > r.right) {
+            return;
+        }
+    }
+
+    m_bounds.add(r.left * m_scale_x, r.top * m_scale_y, r.right * m_scale_x, r.bottom * m_scale_y);
+}
+
+void D2DPainter::push_transform(const DrawPrepass::Transform& transform) {
+    m_transforms.push_back(m_transform);
+    m_transform = DrawPrepass::multiply(transform, m_transform);
+    apply_transform();
+}
+
+void D2DPainter::pop_transform() {
+    if (m_transforms.empty()) {
+        return;
+    }
+
+    m_transform = m_transforms.back();
+    m_transforms.pop_back();
+    apply_transform();
+}
+
+void D2DPainter::reset_transform() {
+    m_transforms.clear();
+    m_transform = {};
+    apply_transform();
+}
+
+void D2DPainter::push_clip(float x, float y, float w, float h) {
+    D2D1_RECT_F rect{std::min(x, x + w), std::min(y, y + h), std::max(x, x + w), std::max(y, y + h)};
+    DrawPrepass::Rect clip{rect.left, rect.top, rect.right, rect.bottom};
+
+    if (!m_transform.is_identity()) {
+        clip = DrawPrepass::transform_bounds(m_transform, clip);
+    }
+
+    m_clips.push_back(m_clips.empty() ? clip : DrawPrepass::intersect(clip, m_clips.back()));
+    m_context->PushAxisAlignedClip(rect, D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+}
+
+void D2DPainter::pop_clip() {
+    if (m_clips.empty()) {
+        return;
+    }
+
+    m_clips.pop_back();
+    m_context->PopAxisAlignedClip();
+}
+
+void D2DPainter::reset_clips() {
+    while (!m_clips.empty()) {
+        pop_clip();
+    }
+}
+
+void D2DPainter::apply_transform() {
+    auto& t = m_transform;
+    m_context->SetTransform(D2D1::Matrix3x2F{t.m11, t.m12, t.m21, t.m22, t.dx, t.dy} * D2D1::Matrix3x2F::Scale(m_scale_x, m_scale_y));
+}
+
+std::tuple<float, float> D2DPainter::pixel_scale() const {
+    if (m_transform.is_translation()) {
+        return {m_scale_x, m_scale_y};
+    }
+
+    // Lengths of the transformed unit vectors, which is enough for choosing a mip level under rotation.
+    return {std::hypot(m_transform.m11 * m_scale_x, m_transform.m12 * m_scale_y),
+        std::hypot(m_transform.m21 * m_scale_x, m_transform.m22 * m_scale_y)};
 }
 
 void D2DPainter::set_color(unsigned int color) {
-    float r = ((color & 0xFF'0000) >> 16) / 255.0f;
-    float g = ((color & 0xFF00) >> 8) / 255.0f;
-    float b = ((color & 0xFF) >> 0) / 255.0f;
-    float a = ((color & 0xFF00'0000) >> 24) / 255.0f;
-    m_brush->SetColor({r, g, b, a});
+    // Runs of draws in the same color are common, and the brush keeps its color across frames.
+    if (color == m_brush_color) {
+        return;
+    }
+
+    DrawPrepass::Color rgba{};
+    DrawPrepass::unpack_color(color, &rgba.r);
+    set_color(color, rgba);
+}
+
+void D2DPainter::set_color(unsigned int color, const DrawPrepass::Color& rgba) {
+    if (color == m_brush_color) {
+        return;
+    }
+
+    m_brush->SetColor(D2D1::ColorF{rgba.r, rgba.g, rgba.b, rgba.a});
+    m_brush_color = color;
 }
 
-void D2DPainter::text(std::shared_ptr<D2DFont>& font, const std::string& text, float x, float y, unsigned int color) {
+void D2DPainter::text(std::shared_ptr<D2DFont>& font, std::string_view text, size_t hash, float x, float y, unsigned int color) {
+    auto layout = font->layout(text, hash);
+    DWRITE_TEXT_METRICS metrics{};
+    layout->GetMetrics(&metrics);
+
+    // Glyphs can overhang their advance (italics, accents), half a line on each side is plenty.
+    auto overhang = metrics.height * 0.5f;
+    add_bounds(x + metrics.left - overhang, y + metrics.top - overhang,
+        x + metrics.left + metrics.widthIncludingTrailingWhitespace + overhang, y + metrics.top + metrics.height + overhang);
+
     set_color(color);
-    m_context->DrawTextLayout({x, y}, font->layout(text).Get(), m_brush.Get());
+    m_context->DrawTextLayout({x, y}, layout.Get(), m_brush.Get());
 }
 
 void D2DPainter::fill_rect(float x, float y, float w, float h, unsigned int color) {
     set_color(color);
     m_context->FillRectangle({x, y, x + w, y + h}, m_brush.Get());
+    add_bounds(x, y, x + w, y + h);
 }
 
 void D2DPainter::outline_rect(float x, float y, float w, float h, float thickness, unsigned int color) {
     set_color(color);
     m_context->DrawRectangle({x, y, x + w, y + h}, m_brush.Get(), thickness);
+    add_bounds(x, y, x + w, y + h, thickness);
 }
 
 void D2DPainter::rounded_rect(float x, float y, float w, float h, float radiusX, float radiusY, float thickness, unsigned int color) {
     set_color(color);
     m_context->DrawRoundedRectangle({x, y, x + w, y + h, radiusX, radiusY}, m_brush.Get(), thickness);
+    add_bounds(x, y, x + w, y + h, thickness);
 }
 
 void D2DPainter::fill_rounded_rect(float x, float y, float w, float h, float radiusX, float radiusY, unsigned int color) {
     set_color(color);
     m_context->FillRoundedRectangle({x, y, x + w, y + h, radiusX, radiusY}, m_brush.Get());
+    add_bounds(x, y, x + w, y + h);
 }
 
 void D2DPainter::quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, float thickness, unsigned int color) {
@@ -104,6 +306,9 @@ void D2DPainter::quad(float x1, float y1, float x2, float y2, float x3, float y3
 
     set_color(color);
     m_context->DrawGeometry(pathGeometry.Get(), m_brush.Get(), thickness);
+    // Miter joins can reach well past the corners on sharp angles, D2D limits them to 10x the stroke width.
+    add_bounds(std::min({x1, x2, x3, x4}), std::min({y1, y2, y3, y4}), std::max({x1, x2, x3, x4}), std::max({y1, y2, y3, y4}),
+        thickness * 10.0f);
 }
 
 void D2DPainter::fill_quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, unsigned int color) {
@@ -123,44 +328,125 @@ void D2DPainter::fill_quad(float x1, float y1, float x2, float y2, float x3, flo
 
     set_color(color);
     m_context->FillGeometry(pathGeometry.Get(), m_brush.Get());
+    add_bounds(std::min({x1, x2, x3, x4}), std::min({y1, y2, y3, y4}), std::max({x1, x2, x3, x4}), std::max({y1, y2, y3, y4}));
 }
 
 void D2DPainter::line(float x1, float y1, float x2, float y2, float thickness, unsigned int color) {
     set_color(color);
     m_context->DrawLine({x1, y1}, {x2, y2}, m_brush.Get(), thickness);
+    add_bounds(x1, y1, x2, y2, thickness);
+}
+
+ComPtr<ID2D1PathGeometry> D2DPainter::polygon_geometry(const float* points, size_t count, bool closed) {
+    ComPtr<ID2D1PathGeometry> pathGeometry;
+    m_d2d1->CreatePathGeometry(&pathGeometry);
+
+    ComPtr<ID2D1GeometrySink> sink;
+    pathGeometry->Open(&sink);
+
+    // x, y pairs are laid out like D2D1_POINT_2F.
+    auto xy = (const D2D1_POINT_2F*)points;
+    sink->BeginFigure(xy[0], D2D1_FIGURE_BEGIN_FILLED);
+    sink->AddLines(xy + 1, (UINT32)(count - 1));
+
+    sink->EndFigure(closed ? D2D1_FIGURE_END_CLOSED : D2D1_FIGURE_END_OPEN);
+    sink->Close();
+
+    return pathGeometry;
+}
+
+void D2DPainter::polyline(const float* points, size_t count, float thickness, unsigned int color, bool closed) {
+    auto pathGeometry = polygon_geometry(points, count, closed);
+
+    set_color(color);
+    m_context->DrawGeometry(pathGeometry.Get(), m_brush.Get(), thickness);
+    // Miter joins, like quad.
+    auto bounds = DrawPrepass::point_bounds(points, count, 0.0f);
+    add_bounds(bounds.left, bounds.top, bounds.right, bounds.bottom, thickness * 10.0f);
+}
+
+void D2DPainter::fill_polygon(const float* points, size_t count, unsigned int color) {
+    auto pathGeometry = polygon_geometry(points, count, true);
+
+    set_color(color);
+    m_context->FillGeometry(pathGeometry.Get(), m_brush.Get());
+    auto bounds = DrawPrepass::point_bounds(points, count, 0.0f);
+    add_bounds(bounds.left, bounds.top, bounds.right, bounds.bottom);
 }
 
 void D2DPainter::image(std::shared_ptr<D2DImage>& image, float x, float y, float alpha) {
     auto [w, h] = image->size();
-    m_context->DrawBitmap(image->bitmap().Get(), {x, y, x + w, y + h}, alpha);
+    this->image(image, x, y, (float)w, (float)h, alpha);
 }
 
 void D2DPainter::image(std::shared_ptr<D2DImage>& image, float x, float y, float w, float h, float alpha) {
-    m_context->DrawBitmap(image->bitmap().Get(), {x, y, x + w, y + h}, alpha);
+    add_bounds(x, y, x + w, y + h);
+    image->bind(m_generation);
+
+    // Small images are transparently redirected to their spot in the atlas.
+    if (auto slot = m_atlas->resolve(image)) {
+        m_context->DrawBitmap(slot->bitmap, {x, y, x + w, y + h}, alpha, D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, &slot->rect);
+        return;
+    }
+
+    auto [image_w, image_h] = image->size();
+    auto [pixel_x, pixel_y] = pixel_scale();
+    auto level = image->level_for(m_context.Get(), (float)image_w, (float)image_h, w * pixel_x, h * pixel_y);
+    m_context->DrawBitmap(level.bitmap, {x, y, x + w, y + h}, alpha);
+    track(image);
+}
+
+void D2DPainter::image(
+    std::shared_ptr<D2DImage>& image, float sx, float sy, float sw, float sh, float x, float y, float w, float h, float alpha) {
+    add_bounds(x, y, x + w, y + h);
+    image->bind(m_generation);
+
+    D2D1_RECT_F src{sx, sy, sx + sw, sy + sh};
+
+    // Source rects reaching outside the image take the standalone bitmap, in the atlas they'd pick up the neighbouring entries.
+    if (auto slot = m_atlas->resolve(image)) {
+        auto r = slot->rect;
+
+        if (auto mapped = AtlasSource::map({r.left, r.top, r.right, r.bottom}, sx, sy, sw, sh)) {
+            D2D1_RECT_F atlas_src{mapped->left, mapped->top, mapped->right, mapped->bottom};
+            m_context->DrawBitmap(slot->bitmap, {x, y, x + w, y + h}, alpha, D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, &atlas_src);
+            return;
+        }
+    }
+
+    auto [pixel_x, pixel_y] = pixel_scale();
+    auto level = image->level_for(m_context.Get(), sw, sh, w * pixel_x, h * pixel_y);
+    src = {src.left * level.scale_x, src.top * level.scale_y, src.right * level.scale_x, src.bottom * level.scale_y};
+    m_context->DrawBitmap(level.bitmap, {x, y, x + w, y + h}, alpha, D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, &src);
+    track(image);
 }
 
 void D2DPainter::fill_circle(float centerX, float centerY, float radius, unsigned int color) {
     set_color(color);
     D2D1_ELLIPSE ellipse = D2D1::Ellipse(D2D1::Point2F(centerX, centerY), radius, radius);
     m_context->FillEllipse(ellipse, m_brush.Get());
+    add_bounds(centerX - radius, centerY - radius, centerX + radius, centerY + radius);
 }
 
 void D2DPainter::fill_circle(float centerX, float centerY, float radiusX, float radiusY, unsigned int color) {
     set_color(color);
     D2D1_ELLIPSE ellipse = D2D1::Ellipse(D2D1::Point2F(centerX, centerY), radiusX, radiusY);
     m_context->FillEllipse(ellipse, m_brush.Get());
+    add_bounds(centerX - radiusX, centerY - radiusY, centerX + radiusX, centerY + radiusY);
 }
 
 void D2DPainter::circle(float centerX, float centerY, float radius, float thickness, unsigned int color) {
     set_color(color);
     D2D1_ELLIPSE ellipse = D2D1::Ellipse(D2D1::Point2F(centerX, centerY), radius, radius);
     m_context->DrawEllipse(ellipse, m_brush.Get(), thickness);
+    add_bounds(centerX - radius, centerY - radius, centerX + radius, centerY + radius, thickness);
 }
 
 void D2DPainter::circle(float centerX, float centerY, float radiusX, float radiusY, float thickness, unsigned int color) {
     set_color(color);
     D2D1_ELLIPSE ellipse = D2D1::Ellipse(D2D1::Point2F(centerX, centerY), radiusX, radiusY);
     m_context->DrawEllipse(ellipse, m_brush.Get(), thickness);
+    add_bounds(centerX - radiusX, centerY - radiusY, centerX + radiusX, centerY + radiusY, thickness);
 }
 
 void D2DPainter::pie(float centerX, float centerY, float radius, float startAngle, float sweepAngle, float thickness,
@@ -182,6 +468,9 @@ void D2DPainter::pie(float centerX, float centerY, float radius, float startAngl
     }
     auto direction = clockwise ? D2D1_SWEEP_DIRECTION_CLOCKWISE : D2D1_SWEEP_DIRECTION_COUNTER_CLOCKWISE;
 
+    // The whole circle is a cheap superset of the slice, the stroke pad covers the miter at the center.
+    add_bounds(centerX - radius, centerY - radius, centerX + radius, centerY + radius, thickness * 10.0f);
+
     ComPtr<ID2D1PathGeometry> pathGeometry;
     m_d2d1->CreatePathGeometry(&pathGeometry);
 
@@ -220,6 +509,8 @@ void D2DPainter::pie(float centerX, float centerY, float radius, float startAngl
 }
 
 void D2DPainter::ring(float centerX, float centerY, float outerRadius, float innerRadius, float thickness, unsigned int color) {
+    add_bounds(centerX - outerRadius, centerY - outerRadius, centerX + outerRadius, centerY + outerRadius, thickness);
+
     ComPtr<ID2D1EllipseGeometry> outerCircle;
     m_d2d1->CreateEllipseGeometry(D2D1::Ellipse(D2D1::Point2F(centerX, centerY), outerRadius, outerRadius), &outerCircle);
     ComPtr<ID2D1EllipseGeometry> innerCircle;
@@ -257,6 +548,8 @@ void D2DPainter::ring(float centerX, float centerY, float outerRadius, float inn
     auto direction = clockwise ? D2D1_SWEEP_DIRECTION_CLOCKWISE : D2D1_SWEEP_DIRECTION_COUNTER_CLOCKWISE;
     auto counterDirection = !clockwise ? D2D1_SWEEP_DIRECTION_CLOCKWISE : D2D1_SWEEP_DIRECTION_COUNTER_CLOCKWISE;
 
+    add_bounds(centerX - outerRadius, centerY - outerRadius, centerX + outerRadius, centerY + outerRadius, thickness * 10.0f);
+
     set_color(color);
 
     ComPtr<ID2D1PathGeometry> pathGeometry;
@@ -1,5 +1,11 @@
+#pragma once
+
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
@@ -12,19 +18,60 @@
 
 #include "D2DFont.hpp"
 #include "D2DImage.hpp"
+#include "DrawBounds.hpp"
+#include "DrawPrepass.hpp"
+#include "ImageAtlas.hpp"
+#include "ResidencyTracker.hpp"
 
 class D2DPainter {
 public:
     template <typename T> using ComPtr = Microsoft::WRL::ComPtr<T>;
 
-    D2DPainter(ID3D11Device* device, IDXGISurface* surface);
+    static constexpr uint64_t DEFAULT_IMAGE_BUDGET = 256ull * 1024 * 1024;
+
+    // Device independent factories. These outlive any one painter so a device reset doesn't recreate them, and fonts and images made
+    // from them stay valid.
+    struct Factories {
+        ComPtr<ID2D1Factory3> d2d1{};
+        ComPtr<IDWriteFactory5> dwrite{};
+        ComPtr<IWICImagingFactory> wic{};
+
+        static Factories create();
+    };
+
+    struct ImageStats {
+        uint64_t budget{};
+        uint64_t resident{};
+        uint64_t evictions{};
+        size_t images{};
+    };
 
-    void begin();
+    // One render target is created per surface, begin picks which one to draw into. All surfaces must be the same size. Drawing is
+    // done in size coordinates, surfaces smaller than that get everything scaled down to fit.
+    D2DPainter(const Factories& factories, ID3D11Device* device, const std::vector<IDXGISurface*>& surfaces, D2D1_SIZE_U size);
+    ~D2DPainter();
+
+    void begin(size_t target);
     void end();
 
     void set_color(unsigned int color);
+    // For colors DrawList::prepare already unpacked, rgba has to be color unpacked.
+    void set_color(unsigned int color, const DrawPrepass::Color& rgba);
+
+    // Draws from here on are transformed by transform, applied before the ones already pushed. begin starts without any.
+    void push_transform(const DrawPrepass::Transform& transform);
+    // Does nothing if nothing has been pushed.
+    void pop_transform();
+    void reset_transform();
+
+    // Clips draws from here on to the rectangle, in the coordinates of the current transform, within the clips already pushed. end pops
+    // the ones left, pop_clip does nothing if nothing has been pushed.
+    void push_clip(float x, float y, float w, float h);
+    void pop_clip();
+    void reset_clips();
 
-    void text(std::shared_ptr<D2DFont>& font, const std::string& text, float x, float y, unsigned int color);
+    // hash is D2DFont::hash_text(text).
+    void text(std::shared_ptr<D2DFont>& font, std::string_view text, size_t hash, float x, float y, unsigned int color);
     void fill_rect(float x, float y, float w, float h, unsigned int color);
     void outline_rect(float x, float y, float w, float h, float thickness, unsigned int color);
     void rounded_rect(float x, float y, float w, float h, float radiusX, float radiusY, float thickness, unsigned int color);
@@ -34,6 +81,7 @@ public:
     void line(float x1, float y1, float x2, float y2, float thickness, unsigned int color);
     void image(std::shared_ptr<D2DImage>& image, float x, float y, float alpha);
     void image(std::shared_ptr<D2DImage>& image, float x, float y, float w, float h, float alpha);
+    void image(std::shared_ptr<D2DImage>& image, float sx, float sy, float sw, float sh, float x, float y, float w, float h, float alpha);
     void fill_circle(float centerX, float centerY, float radius, unsigned int color);
     void fill_circle(float centerX, float centerY, float radiusX, float radiusY, unsigned int color);
     void circle(float centerX, float centerY, float radius, float thickness, unsigned int color);
@@ -43,22 +91,67 @@ public:
     void ring(float centerX, float centerY, float outerRadius, float innerRadius, float thickness, unsigned int color);
     void ring(float centerX, float centerY, float outerRadius, float innerRadius, float startAngle, float sweepAngle, float thickness,
         unsigned int color, bool clockwise);
+    // points is count x, y pairs, drawn as one figure so the segments are joined.
+    void polyline(const float* points, size_t count, float thickness, unsigned int color, bool closed);
+    void fill_polygon(const float* points, size_t count, unsigned int color);
 
-    auto surface_size() const { return std::make_tuple(m_rt_desc.Width, m_rt_desc.Height); }
+    // Image bitmaps that haven't been drawn recently are released once their total size goes over budget. They're recreated from the
+    // image's CPU copy the next time they're drawn.
+    // Both are safe to call from any thread, the budget gets applied at the end of the next frame.
+    void set_image_budget(uint64_t bytes);
+    ImageStats image_stats();
+
+    // What the last frame drew to in surface pixels, valid once end() has been called.
+    const auto& drawn_bounds() const { return m_bounds; }
+
+    // The size scripts draw in, not the size of the surfaces.
+    auto surface_size() const { return std::make_tuple(m_size.width, m_size.height); }
 
     const auto& context() const { return m_context; }
     const auto& dwrite() const { return m_dwrite; }
     const auto& wic() const { return m_wic; }
 
+    // Unique to this painter's D2D device, see DeviceGeneration.
+    auto generation() const { return m_generation; }
+
 private:
     ComPtr<ID2D1Factory3> m_d2d1{};
     ComPtr<ID2D1Device> m_device{};
     ComPtr<ID2D1DeviceContext> m_context{};
 
     DXGI_SURFACE_DESC m_rt_desc{};
-    ComPtr<ID2D1Bitmap1> m_rt{};
+    D2D1_SIZE_U m_size{};
+    float m_scale_x{1.0f};
+    float m_scale_y{1.0f};
+    // The pushed transforms combined, in size coordinates. m_transforms holds what to restore on pop.
+    DrawPrepass::Transform m_transform{};
+    std::vector<DrawPrepass::Transform> m_transforms{};
+    // The pushed clips intersected, in size coordinates, one per push.
+    std::vector<DrawPrepass::Rect> m_clips{};
+    std::vector<ComPtr<ID2D1Bitmap1>> m_rts{};
     ComPtr<ID2D1SolidColorBrush> m_brush{};
+    // The brush's current color, it's created white.
+    unsigned int m_brush_color{0xFFFF'FFFF};
 
     ComPtr<IDWriteFactory5> m_dwrite{};
     ComPtr<IWICImagingFactory> m_wic{};
+
+    std::unique_ptr<ImageAtlas> m_atlas{};
+    DrawBounds m_bounds{0, 0};
+
+    uint64_t m_generation{};
+    uint64_t m_frame{};
+    ResidencyTracker<const D2DImage*> m_residency{DEFAULT_IMAGE_BUDGET};
+    std::unordered_map<const D2DImage*, std::weak_ptr<D2DImage>> m_resident_images{};
+
+    std::mutex m_image_stats_mtx{};
+    uint64_t m_image_budget{DEFAULT_IMAGE_BUDGET};
+    ImageStats m_image_stats{DEFAULT_IMAGE_BUDGET};
+
+    void track(const std::shared_ptr<D2DImage>& image);
+    void add_bounds(float left, float top, float right, float bottom, float stroke = 0.0f);
+    void apply_transform();
+    ComPtr<ID2D1PathGeometry> polygon_geometry(const float* points, size_t count, bool closed);
+    // Surface pixels per unit drawn along x and y under the current transform, for picking image levels.
+    std::tuple<float, float> pixel_scale() const;
 };
@@ -0,0 +1,75 @@
+#include "PixelWriter.hpp"
+
+#include "D2DPixelImage.hpp"
+
+D2DPixelImage::D2DPixelImage(UINT32 width, UINT32 height)
+    : D2DImage{width, height}
+    , m_dirty{width, height} {
+}
+
+void D2DPixelImage::write_rgba(int x, int y, uint32_t w, uint32_t h, const uint8_t* src, size_t src_pitch) {
+    PixelWriter::Clip c{};
+
+    if (!PixelWriter::clip(x, y, w, h, m_size.width, m_size.height, c)) {
+        return;
+    }
+
+    std::scoped_lock _{m_mutex};
+    PixelWriter::write_rgba(
+        pixel_at(c.x, c.y), (size_t)m_size.width * 4, src + c.src_y * src_pitch + (size_t)c.src_x * 4, src_pitch, c.w, c.h);
+    m_dirty.add(c.x, c.y, c.w, c.h);
+}
+
+void D2DPixelImage::write_argb(int x, int y, uint32_t w, uint32_t h, const uint32_t* src) {
+    PixelWriter::Clip c{};
+
+    if (!PixelWriter::clip(x, y, w, h, m_size.width, m_size.height, c)) {
+        return;
+    }
+
+    std::scoped_lock _{m_mutex};
+    PixelWriter::write_argb(pixel_at(c.x, c.y), (size_t)m_size.width * 4, src + (size_t)c.src_y * w + c.src_x, (size_t)w * 4, c.w, c.h);
+    m_dirty.add(c.x, c.y, c.w, c.h);
+}
+
+void D2DPixelImage::fill(int x, int y, uint32_t w, uint32_t h, uint32_t color) {
+    PixelWriter::Clip c{};
+
+    if (!PixelWriter::clip(x, y, w, h, m_size.width, m_size.height, c)) {
+        return;
+    }
+
+    std::scoped_lock _{m_mutex};
+    PixelWriter::fill_argb(pixel_at(c.x, c.y), (size_t)m_size.width * 4, color, c.w, c.h);
+    m_dirty.add(c.x, c.y, c.w, c.h);
+}
+
+void D2DPixelImage::set_pixel(int x, int y, uint32_t color) {
+    fill(x, y, 1, 1, color);
+}
+
+ID2D1Bitmap* D2DPixelImage::bitmap(ID2D1DeviceContext* context) {
+    std::scoped_lock _{m_mutex};
+
+    // A fresh bitmap already has everything, dirty or not.
+    if (m_bitmap == nullptr) {
+        m_bitmap = create_bitmap(context);
+        m_dirty.clear();
+        return m_bitmap.Get();
+    }
+
+    auto pitch = m_size.width * 4;
+
+    for (const auto& r : m_dirty.rects()) {
+        D2D1_RECT_U dst{r.x, r.y, r.x + r.w, r.y + r.h};
+        m_bitmap->CopyFromMemory(&dst, pixel_at(r.x, r.y), pitch);
+    }
+
+    m_dirty.clear();
+
+    return m_bitmap.Get();
+}
+
+D2DImage::Level D2DPixelImage::level_for(ID2D1DeviceContext* context, float, float, float, float) {
+    return {bitmap(context)};
+}
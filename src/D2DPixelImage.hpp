@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+#include "D2DImage.hpp"
+#include "DirtyRegion.hpp"
+
+// An image whose pixels are written by scripts. Writes land in the CPU copy and only the changed rectangles are uploaded, the next
+// time the image is drawn.
+class D2DPixelImage : public D2DImage {
+public:
+    D2DPixelImage(UINT32 width, UINT32 height);
+
+    // Straight alpha RGBA bytes with the given row pitch. Parts outside the image are clipped.
+    void write_rgba(int x, int y, uint32_t w, uint32_t h, const uint8_t* src, size_t src_pitch);
+
+    // Straight alpha 0xAARRGGBB values, w per row. Parts outside the image are clipped.
+    void write_argb(int x, int y, uint32_t w, uint32_t h, const uint32_t* src);
+
+    void fill(int x, int y, uint32_t w, uint32_t h, uint32_t color);
+    void set_pixel(int x, int y, uint32_t color);
+
+    ID2D1Bitmap* bitmap(ID2D1DeviceContext* context) override;
+
+    // Contents change too often for a mip chain to pay for itself, so these always draw the full resolution bitmap.
+    Level level_for(ID2D1DeviceContext* context, float src_w, float src_h, float dst_w, float dst_h) override;
+
+    bool is_dynamic() const override { return true; }
+
+private:
+    // Scripts write from the game thread while replay happens on the render thread.
+    std::mutex m_mutex{};
+    DirtyRegion m_dirty;
+
+    uint8_t* pixel_at(uint32_t x, uint32_t y) { return m_pixels.data() + ((size_t)y * m_size.width + x) * 4; }
+};
@@ -0,0 +1,52 @@
+#include <stdexcept>
+
+#include "D3D11TimestampQueries.hpp"
+
+D3D11TimestampQueries::D3D11TimestampQueries(ID3D11Device* device, ID3D11DeviceContext* context, size_t slots)
+    : m_context{context}
+    , m_slots(slots) {
+    D3D11_QUERY_DESC disjoint_desc{D3D11_QUERY_TIMESTAMP_DISJOINT};
+    D3D11_QUERY_DESC timestamp_desc{D3D11_QUERY_TIMESTAMP};
+
+    for (auto& slot : m_slots) {
+        if (FAILED(device->CreateQuery(&disjoint_desc, &slot.disjoint)) || FAILED(device->CreateQuery(&timestamp_desc, &slot.begin)) ||
+            FAILED(device->CreateQuery(&timestamp_desc, &slot.end))) {
+            throw std::runtime_error{"Failed to create D3D11 timestamp queries"};
+        }
+    }
+}
+
+void D3D11TimestampQueries::begin(size_t slot) {
+    auto& s = m_slots[slot];
+    m_context->Begin(s.disjoint.Get());
+    m_context->End(s.begin.Get());
+}
+
+void D3D11TimestampQueries::end(size_t slot) {
+    auto& s = m_slots[slot];
+    m_context->End(s.end.Get());
+    m_context->End(s.disjoint.Get());
+}
+
+GpuTiming D3D11TimestampQueries::poll(size_t slot) {
+    auto& s = m_slots[slot];
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint{};
+
+    if (m_context->GetData(s.disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+        return {};
+    }
+
+    UINT64 begin{};
+    UINT64 end{};
+
+    if (m_context->GetData(s.begin.Get(), &begin, sizeof(begin), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+        m_context->GetData(s.end.Get(), &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+        return {};
+    }
+
+    if (disjoint.Disjoint || disjoint.Frequency == 0 || end < begin) {
+        return {GpuTiming::State::INVALID};
+    }
+
+    return {GpuTiming::State::READY, (double)(end - begin) * 1000.0 / disjoint.Frequency};
+}
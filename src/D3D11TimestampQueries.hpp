@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+#include <d3d11.h>
+#include <wrl.h>
+
+#include "GpuTimerRing.hpp"
+
+// GpuTimerRing source for a D3D11 immediate context. Each slot is a disjoint query bracketing a pair of timestamps, results are
+// polled without flushing.
+class D3D11TimestampQueries {
+public:
+    template <typename T> using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+    D3D11TimestampQueries(ID3D11Device* device, ID3D11DeviceContext* context, size_t slots);
+
+    void begin(size_t slot);
+    void end(size_t slot);
+    GpuTiming poll(size_t slot);
+
+private:
+    struct Slot {
+        ComPtr<ID3D11Query> disjoint{};
+        ComPtr<ID3D11Query> begin{};
+        ComPtr<ID3D11Query> end{};
+    };
+
+    ComPtr<ID3D11DeviceContext> m_context{};
+    std::vector<Slot> m_slots{};
+};
@@ -1,86 +1,157 @@
+#include <chrono>
+#include <stdexcept>
+
 #include "D3D12CommandContext.hpp"
 
-D3D12CommandContext::D3D12CommandContext(ID3D12Device* device, const wchar_t* name) {
+D3D12CommandContext::D3D12CommandContext(ID3D12Device* device, const wchar_t* name)
+    : m_device{device}
+    , m_name{name} {
     std::scoped_lock _{m_mtx};
 
-    m_cmd_allocator.Reset();
-    m_cmd_list.Reset();
-    m_fence.Reset();
+    if (FAILED(device->CreateFence(m_fence_value, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)))) {
+        throw std::runtime_error{"Failed to create fence"};
+    }
 
-    if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_cmd_allocator)))) {
-        throw std::runtime_error{"Failed to create command allocator"};
+    m_fence->SetName(name);
+    m_fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+
+    for (size_t i = 0; i < INITIAL_SLOTS; ++i) {
+        add_slot();
     }
 
-    m_cmd_allocator->SetName(name);
+    m_is_setup = true;
+}
+
+void D3D12CommandContext::add_slot() {
+    Slot slot{};
 
-    if (FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_cmd_allocator.Get(), nullptr, IID_PPV_ARGS(&m_cmd_list)))) {
-        throw std::runtime_error{"Failed to create command list"};
+    if (FAILED(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&slot.cmd_allocator)))) {
+        throw std::runtime_error{"Failed to create command allocator"};
     }
 
-    m_cmd_list->SetName(name);
+    slot.cmd_allocator->SetName(m_name);
 
-    if (FAILED(device->CreateFence(m_fence_value, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)))) {
-        throw std::runtime_error{"Failed to create fence"};
+    if (FAILED(m_device->CreateCommandList(
+            0, D3D12_COMMAND_LIST_TYPE_DIRECT, slot.cmd_allocator.Get(), nullptr, IID_PPV_ARGS(&slot.cmd_list)))) {
+        throw std::runtime_error{"Failed to create command list"};
     }
 
-    m_fence->SetName(name);
+    slot.cmd_list->SetName(m_name);
 
-    m_fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-    m_is_setup = true;
+    // Lists are created open, close it so every slot starts out the same way.
+    slot.cmd_list->Close();
+
+    m_slots.push_back(std::move(slot));
+    m_stats.depth = m_slots.size();
 }
 
 void D3D12CommandContext::reset() {
     std::scoped_lock _{m_mtx};
     wait(2000);
 
-    m_cmd_allocator.Reset();
-    m_cmd_list.Reset();
+    m_slots.clear();
     m_fence.Reset();
     m_fence_value = 0;
 
     CloseHandle(m_fence_event);
 
     m_fence_event = nullptr;
-    m_waiting_for_fence = false;
+}
+
+bool D3D12CommandContext::wait_for(UINT64 value, uint32_t ms) {
+    if (m_fence == nullptr || m_fence->GetCompletedValue() >= value) {
+        return true;
+    }
+
+    m_fence->SetEventOnCompletion(value, m_fence_event);
+
+    return WaitForSingleObject(m_fence_event, ms) == WAIT_OBJECT_0;
 }
 
 void D3D12CommandContext::wait(uint32_t ms) {
     std::scoped_lock _{m_mtx};
 
-    if (m_fence_event && m_waiting_for_fence) {
-        WaitForSingleObject(m_fence_event, ms);
-        ResetEvent(m_fence_event);
+    if (m_fence_event) {
+        wait_for(m_fence_value, ms);
+    }
+}
 
-        m_waiting_for_fence = false;
+D3D12CommandContext::ComPtr<ID3D12GraphicsCommandList>& D3D12CommandContext::begin() {
+    m_mtx.lock();
 
-        if (FAILED(m_cmd_allocator->Reset())) {
-            throw std::runtime_error{"Failed to reset command allocator"};
+    auto completed = m_fence->GetCompletedValue();
+    auto found = false;
+
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        if (m_slots[i].fence_value <= completed) {
+            m_current = i;
+            found = true;
+            break;
         }
+    }
 
-        if (FAILED(m_cmd_list->Reset(m_cmd_allocator.Get(), nullptr))) {
-            throw std::runtime_error{"Failed to reset command list"};
+    if (!found && m_slots.size() < MAX_SLOTS) {
+        try {
+            add_slot();
+        } catch (...) {
+            m_mtx.unlock();
+            throw;
         }
+
+        m_current = m_slots.size() - 1;
+        ++m_stats.grows;
+        found = true;
     }
-}
 
-D3D12CommandContext::ComPtr<ID3D12GraphicsCommandList>& D3D12CommandContext::begin() {
-    m_mtx.lock();
-    wait(INFINITE);
-    return m_cmd_list;
+    // The ring is as big as it gets, wait for whichever slot was submitted first.
+    if (!found) {
+        m_current = 0;
+
+        for (size_t i = 1; i < m_slots.size(); ++i) {
+            if (m_slots[i].fence_value < m_slots[m_current].fence_value) {
+                m_current = i;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        wait_for(m_slots[m_current].fence_value, INFINITE);
+        ++m_stats.stalls;
+        m_stats.stall_ms += std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count();
+    }
+
+    auto& slot = m_slots[m_current];
+
+    if (FAILED(slot.cmd_allocator->Reset())) {
+        m_mtx.unlock();
+        throw std::runtime_error{"Failed to reset command allocator"};
+    }
+
+    if (FAILED(slot.cmd_list->Reset(slot.cmd_allocator.Get(), nullptr))) {
+        m_mtx.unlock();
+        throw std::runtime_error{"Failed to reset command list"};
+    }
+
+    return slot.cmd_list;
 }
 
 void D3D12CommandContext::end(ID3D12CommandQueue* command_queue) {
-    if (FAILED(m_cmd_list->Close())) {
+    auto& slot = m_slots[m_current];
+
+    if (FAILED(slot.cmd_list->Close())) {
+        m_mtx.unlock();
         throw std::runtime_error("Failed to close command list");
     }
 
-    ID3D12CommandList* const cmd_lists[] = {m_cmd_list.Get()};
+    ID3D12CommandList* const cmd_lists[] = {slot.cmd_list.Get()};
 
     command_queue->ExecuteCommandLists(1, cmd_lists);
     command_queue->Signal(m_fence.Get(), ++m_fence_value);
-    m_fence->SetEventOnCompletion(m_fence_value, m_fence_event);
-
-    m_waiting_for_fence = true;
+    slot.fence_value = m_fence_value;
 
     m_mtx.unlock();
 }
+
+D3D12CommandContext::Stats D3D12CommandContext::stats() {
+    std::scoped_lock _{m_mtx};
+    return m_stats;
+}
@@ -1,13 +1,28 @@
 #pragma once
 
+#include <cstdint>
 #include <d3d12.h>
 #include <mutex>
+#include <vector>
 #include <wrl.h>
 
+// A ring of command allocator/list pairs sharing one fence. begin() records into the first slot the GPU is done with, and when
+// none is free the ring grows (up to MAX_SLOTS) instead of blocking the caller on the GPU.
 class D3D12CommandContext {
 public:
     template <typename T> using ComPtr = Microsoft::WRL::ComPtr<T>;
 
+    static constexpr size_t INITIAL_SLOTS = 2;
+    static constexpr size_t MAX_SLOTS = 8;
+
+    struct Stats {
+        // Times begin() had to wait on the GPU because the ring was full, and for how long in total.
+        uint64_t stalls{};
+        double stall_ms{};
+        uint64_t grows{};
+        size_t depth{};
+    };
+
     D3D12CommandContext() = delete;
     D3D12CommandContext(ID3D12Device* device, const wchar_t* name = L"REFD2D D3D12CommandContext object");
     virtual ~D3D12CommandContext() { reset(); }
@@ -19,15 +34,29 @@ public:
 
     [[nodiscard]] bool is_setup() const { return m_is_setup; }
 
+    Stats stats();
+
 private:
-    ComPtr<ID3D12CommandAllocator> m_cmd_allocator{};
-    ComPtr<ID3D12GraphicsCommandList> m_cmd_list{};
+    struct Slot {
+        ComPtr<ID3D12CommandAllocator> cmd_allocator{};
+        ComPtr<ID3D12GraphicsCommandList> cmd_list{};
+        // Fence value signaled once the GPU is done with this slot's last submission, 0 if it was never submitted.
+        UINT64 fence_value{};
+    };
+
+    ComPtr<ID3D12Device> m_device{};
+    const wchar_t* m_name{};
+    std::vector<Slot> m_slots{};
+    size_t m_current{};
     ComPtr<ID3D12Fence> m_fence{};
     UINT64 m_fence_value{};
     HANDLE m_fence_event{};
+    Stats m_stats{};
 
     std::recursive_mutex m_mtx{};
 
-    bool m_waiting_for_fence{};
     bool m_is_setup{};
-};
\ No newline at end of file
+
+    void add_slot();
+    bool wait_for(UINT64 value, uint32_t ms);
+};
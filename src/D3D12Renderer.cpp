@@ -1,16 +1,45 @@
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
 #include <stdexcept>
 
 #include <d3d11on12.h>
-#include <d3dcompiler.h>
 
 #include "D3D12Shaders.hpp"
 
 #include "D3D12Renderer.hpp"
 
-D3D12Renderer::D3D12Renderer(IDXGISwapChain* swapchain_, ID3D12Device* device_, ID3D12CommandQueue* cmd_queue_)
+#ifdef REFD2D_RUNTIME_SHADERS
+namespace {
+Microsoft::WRL::ComPtr<ID3DBlob> compile_shader(const char* name, const char* target) {
+    auto path = std::filesystem::path{REFD2D_SHADER_DIR} / name;
+    Microsoft::WRL::ComPtr<ID3DBlob> blob{};
+    Microsoft::WRL::ComPtr<ID3DBlob> errors{};
+
+    if (FAILED(D3DCompileFromFile(path.c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "main", target,
+            D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, 0, &blob, &errors))) {
+        auto msg = std::string{"Failed to compile "} + name;
+
+        if (errors != nullptr) {
+            msg += ": ";
+            msg.append((const char*)errors->GetBufferPointer(), errors->GetBufferSize());
+        }
+
+        throw std::runtime_error{msg};
+    }
+
+    return blob;
+}
+} // namespace
+#endif
+
+D3D12Renderer::D3D12Renderer(IDXGISwapChain* swapchain_, ID3D12Device* device_, ID3D12CommandQueue* cmd_queue_,
+    const D2DPainter::Factories& factories, int overlay_count, float render_scale)
     : m_swapchain{(IDXGISwapChain3*)swapchain_}
     , m_device{device_}
-    , m_cmd_queue{cmd_queue_} {
+    , m_cmd_queue{cmd_queue_}
+    , m_render_scale{std::clamp(render_scale, MIN_RENDER_SCALE, MAX_RENDER_SCALE)}
+    , m_overlays(std::max(overlay_count, MIN_OVERLAY_COUNT)) {
 
     if (FAILED(D3D11On12CreateDevice(m_device.Get(), D3D11_CREATE_DEVICE_BGRA_SUPPORT, nullptr, 0, (IUnknown**)m_cmd_queue.GetAddressOf(),
             1, 0, &m_d3d11_device, &m_d3d11_context, nullptr))) {
@@ -33,7 +62,7 @@ D3D12Renderer::D3D12Renderer(IDXGISwapChain* swapchain_, ID3D12Device* device_,
 
     // Create SRV descriptor heap
     D3D12_DESCRIPTOR_HEAP_DESC srv_desc = {};
-    srv_desc.NumDescriptors = 1;
+    srv_desc.NumDescriptors = (UINT)m_overlays.size();
     srv_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
     srv_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 
@@ -67,18 +96,20 @@ D3D12Renderer::D3D12Renderer(IDXGISwapChain* swapchain_, ID3D12Device* device_,
 
     m_frames_in_flight = m_cmd_contexts.size();
 
-    // Create D2D render target
+    // Create the D2D overlay render targets.
     auto& backbuffer = get_rt(RTV::BACKBUFFER_0);
     auto backbuffer_desc = backbuffer->GetDesc();
 
     m_width = backbuffer_desc.Width;
     m_height = backbuffer_desc.Height;
+    m_overlay_width = std::max(1, (int)(m_width * m_render_scale + 0.5f));
+    m_overlay_height = std::max(1, (int)(m_height * m_render_scale + 0.5f));
 
     D3D12_RESOURCE_DESC d2d_desc{};
     d2d_desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
     d2d_desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
-    d2d_desc.Width = backbuffer_desc.Width;
-    d2d_desc.Height = backbuffer_desc.Height;
+    d2d_desc.Width = m_overlay_width;
+    d2d_desc.Height = m_overlay_height;
     d2d_desc.DepthOrArraySize = 1;
     d2d_desc.MipLevels = 1;
     d2d_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -94,27 +125,48 @@ D3D12Renderer::D3D12Renderer(IDXGISwapChain* swapchain_, ID3D12Device* device_,
     D3D12_CLEAR_VALUE clear_value{};
     clear_value.Format = d2d_desc.Format;
 
-    if (FAILED(m_device->CreateCommittedResource(&d2d_heap_props, D3D12_HEAP_FLAG_NONE, &d2d_desc,
-            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, &clear_value, IID_PPV_ARGS(&m_rts[(int)RTV::D2D])))) {
-        throw std::runtime_error{"Failed to create D2D render target"};
-    }
+    std::vector<ComPtr<IDXGISurface>> dxgi_surfaces{};
+    std::vector<IDXGISurface*> surfaces{};
+
+    for (auto i = 0; i < (int)m_overlays.size(); ++i) {
+        auto& overlay = m_overlays[i];
+
+        if (FAILED(m_device->CreateCommittedResource(&d2d_heap_props, D3D12_HEAP_FLAG_NONE, &d2d_desc,
+                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, &clear_value, IID_PPV_ARGS(&overlay.texture)))) {
+            throw std::runtime_error{"Failed to create D2D render target"};
+        }
+
+        m_device->CreateShaderResourceView(overlay.texture.Get(), nullptr, get_cpu_srv(SRV::D2D, i));
+
+        D3D11_RESOURCE_FLAGS res_flags{D3D11_BIND_RENDER_TARGET};
+        if (FAILED(m_d3d11on12_device->CreateWrappedResource(overlay.texture.Get(), &res_flags, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, IID_PPV_ARGS(&overlay.wrapped)))) {
+            throw std::runtime_error{"Failed to create wrapped render target"};
+        }
+
+        ComPtr<IDXGISurface> dxgi_surface{};
 
-    m_device->CreateRenderTargetView(m_rts[(int)RTV::D2D].Get(), nullptr, get_cpu_rtv(RTV::D2D));
-    m_device->CreateShaderResourceView(m_rts[(int)RTV::D2D].Get(), nullptr, get_cpu_srv(SRV::D2D));
+        if (FAILED(overlay.wrapped.As(&dxgi_surface))) {
+            throw std::runtime_error{"Failed to query DXGI surface"};
+        }
 
-    D3D11_RESOURCE_FLAGS res_flags{D3D11_BIND_RENDER_TARGET};
-    if (FAILED(m_d3d11on12_device->CreateWrappedResource(get_rt(RTV::D2D).Get(), &res_flags, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, IID_PPV_ARGS(&m_wrapped_rt)))) {
-        throw std::runtime_error{"Failed to create wrapped render target"};
+        surfaces.push_back(dxgi_surface.Get());
+        dxgi_surfaces.push_back(std::move(dxgi_surface));
     }
 
-    ComPtr<IDXGISurface> dxgi_surface{};
+    m_d2d = std::make_unique<D2DPainter>(factories, m_d3d11_device.Get(), surfaces, D2D1::SizeU(m_width, m_height));
 
-    if (FAILED(m_wrapped_rt.As(&dxgi_surface))) {
-        throw std::runtime_error{"Failed to query DXGI surface"};
+    if (FAILED(m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_d2d_fence))) ||
+        FAILED(m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_composite_fence)))) {
+        throw std::runtime_error{"Failed to create overlay fences"};
     }
 
-    m_d2d = std::make_unique<D2DPainter>(m_d3d11_device.Get(), dxgi_surface.Get());
+    m_composite_timer = std::make_unique<GpuTimerRing<D3D12TimestampQueries, GPU_TIMER_SLOTS>>(
+        m_device.Get(), m_cmd_queue.Get(), m_composite_fence.Get(), GPU_TIMER_SLOTS);
+    m_d2d_timer = std::make_unique<GpuTimerRing<D3D11TimestampQueries, GPU_TIMER_SLOTS>>(
+        m_d3d11_device.Get(), m_d3d11_context.Get(), GPU_TIMER_SLOTS);
+
+    m_worker_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
 
     // Create root signature.
     D3D12_DESCRIPTOR_RANGE desc_range{};
@@ -138,9 +190,10 @@ D3D12Renderer::D3D12Renderer(IDXGISwapChain* swapchain_, ID3D12Device* device_,
 
     D3D12_STATIC_SAMPLER_DESC sampler_desc{};
     sampler_desc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-    sampler_desc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-    sampler_desc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-    sampler_desc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+    // Clamped so upscaling a reduced resolution overlay doesn't bleed the opposite edge in.
+    sampler_desc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler_desc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    sampler_desc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
     sampler_desc.MipLODBias = 0.0f;
     sampler_desc.MaxAnisotropy = 0;
     sampler_desc.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
@@ -178,21 +231,16 @@ D3D12Renderer::D3D12Renderer(IDXGISwapChain* swapchain_, ID3D12Device* device_,
     pso_desc.SampleDesc.Count = 1;
     pso_desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
 
-    ComPtr<ID3DBlob> vertshader_blob{};
-    ComPtr<ID3DBlob> pixshader_blob{};
-
-    if (FAILED(D3DCompile(
-            D3D12_VERT_SHADER, strlen(D3D12_VERT_SHADER), nullptr, nullptr, nullptr, "main", "vs_5_0", 0, 0, &vertshader_blob, nullptr))) {
-        throw std::runtime_error{"Failed to compile vertex shader"};
-    }
-
-    if (FAILED(D3DCompile(
-            D3D12_PIX_SHADER, strlen(D3D12_PIX_SHADER), nullptr, nullptr, nullptr, "main", "ps_5_0", 0, 0, &pixshader_blob, nullptr))) {
-        throw std::runtime_error{"Failed to compile pixel shader"};
-    }
+#ifdef REFD2D_RUNTIME_SHADERS
+    auto vertshader_blob = compile_shader("composite_vs.hlsl", "vs_5_0");
+    auto pixshader_blob = compile_shader("composite_ps.hlsl", "ps_5_0");
 
     pso_desc.VS = {vertshader_blob->GetBufferPointer(), vertshader_blob->GetBufferSize()};
     pso_desc.PS = {pixshader_blob->GetBufferPointer(), pixshader_blob->GetBufferSize()};
+#else
+    pso_desc.VS = {g_composite_vs, sizeof(g_composite_vs)};
+    pso_desc.PS = {g_composite_ps, sizeof(g_composite_ps)};
+#endif
 
     static D3D12_INPUT_ELEMENT_DESC input_layout[]{
         {"POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
@@ -291,23 +339,85 @@ D3D12Renderer::D3D12Renderer(IDXGISwapChain* swapchain_, ID3D12Device* device_,
         vert_buffer->Unmap(0, &range);
         m_render_resources.push_back(std::move(resources));
     }
+
+    m_worker = std::thread{&D3D12Renderer::worker_main, this};
 }
 
 void D3D12Renderer::render(std::function<void(D2DPainter&)> draw_fn, bool update_d2d) {
+    auto composite_start = Clock::now();
+    auto overlay_index = -1;
+    UINT64 ready_value{};
+    UINT64 read_value{};
+    std::string worker_error{};
+
+    {
+        std::scoped_lock _{m_worker_mtx};
+
+        if (update_d2d) {
+            if (m_pending) {
+                ++m_stats.frames_superseded;
+            }
+
+            m_pending = std::move(draw_fn);
+            m_worker_cv.notify_one();
+        }
+
+        worker_error = std::move(m_worker_error);
+        m_worker_error.clear();
+        overlay_index = m_latest;
+
+        // Reserve the fence value this composite will signal so the worker leaves the overlay alone until it's been sampled.
+        if (overlay_index >= 0) {
+            ready_value = m_overlays[overlay_index].ready_value;
+            read_value = ++m_composite_fence_value;
+            m_overlays[overlay_index].read_value = read_value;
+
+            if (m_d2d_fence->GetCompletedValue() < ready_value) {
+                ++m_stats.composite_waits;
+            }
+        }
+    }
+
+    if (!worker_error.empty()) {
+        throw std::runtime_error{worker_error};
+    }
+
+    // Nothing has finished rendering yet.
+    if (overlay_index < 0) {
+        return;
+    }
+
+    try {
+        composite(overlay_index, ready_value, read_value);
+    } catch (...) {
+        m_cmd_queue->Signal(m_composite_fence.Get(), read_value);
+        throw;
+    }
+
+    m_cmd_queue->Signal(m_composite_fence.Get(), read_value);
+
+    std::scoped_lock _{m_worker_mtx};
+    m_stats.last_composite_ms = std::chrono::duration<double, std::milli>{Clock::now() - composite_start}.count();
+}
+
+void D3D12Renderer::composite(int overlay_index, UINT64 ready_value, UINT64 read_value) {
+    // The overlay can't be redrawn until this composite's fence value is signaled, so it's safe to read without the lock.
+    auto& overlay = m_overlays[overlay_index];
+
+    m_composite_timer->collect();
+
+    if (overlay.empty) {
+        std::scoped_lock _{m_worker_mtx};
+        ++m_stats.composites_skipped;
+        m_stats.last_composite_coverage = 0.0;
+        return;
+    }
+
     auto& cmd_context = m_cmd_contexts[m_swapchain->GetCurrentBackBufferIndex() % m_cmd_contexts.size()];
     auto& resources = m_render_resources[m_swapchain->GetCurrentBackBufferIndex() % m_render_resources.size()];
     auto& cmd_list = cmd_context->begin();
     auto& vert_buffer = resources->vert_buffer;
 
-    if (update_d2d) {
-        m_d3d11on12_device->AcquireWrappedResources(m_wrapped_rt.GetAddressOf(), 1);
-        m_d2d->begin();
-        draw_fn(*m_d2d);
-        m_d2d->end();
-        m_d3d11on12_device->ReleaseWrappedResources(m_wrapped_rt.GetAddressOf(), 1);
-        m_d3d11_context->Flush();
-    }
-
     auto L = 0.0f;
     auto R = (float)m_width;
     auto T = 0.0f;
@@ -327,13 +437,6 @@ void D3D12Renderer::render(std::function<void(D2DPainter&)> draw_fn, bool update
     vp.TopLeftX = vp.TopLeftY = 0;
     cmd_list->RSSetViewports(1, &vp);
 
-    D3D12_RECT sr{};
-    sr.left = 0;
-    sr.top = 0;
-    sr.right = m_width;
-    sr.bottom = m_height;
-    cmd_list->RSSetScissorRects(1, &sr);
-
     D3D12_VERTEX_BUFFER_VIEW vbv{};
     vbv.BufferLocation = vert_buffer->GetGPUVirtualAddress();
     vbv.SizeInBytes = sizeof(Vert) * 6;
@@ -363,14 +466,247 @@ void D3D12Renderer::render(std::function<void(D2DPainter&)> draw_fn, bool update
     cmd_list->OMSetRenderTargets(1, rts, FALSE, NULL);
     cmd_list->SetDescriptorHeaps(1, m_srv_heap.GetAddressOf());
 
-    // draw.
-    cmd_list->SetGraphicsRootDescriptorTable(1, get_gpu_srv(SRV::D2D));
-    cmd_list->DrawInstanced(6, 1, 0, 0);
+    // draw, scissored to what D2D actually touched.
+    cmd_list->SetGraphicsRootDescriptorTable(1, get_gpu_srv(SRV::D2D, overlay_index));
+
+    int64_t area{};
+
+    m_composite_timer->source().set_target(cmd_list.Get(), read_value);
+    m_composite_timer->begin();
+
+    for (const auto& r : overlay.scissors) {
+        D3D12_RECT sr{r.left, r.top, r.right, r.bottom};
+        cmd_list->RSSetScissorRects(1, &sr);
+        cmd_list->DrawInstanced(6, 1, 0, 0);
+        area += r.area();
+    }
+
+    m_composite_timer->end();
 
     barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
     barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
     cmd_list->ResourceBarrier(1, &barrier);
 
+    // The worker flushed the overlay's D2D work to the queue before publishing it, the wait makes the dependency explicit.
+    m_cmd_queue->Wait(m_d2d_fence.Get(), ready_value);
+
     // end(...) calls Close() on the command list.
     cmd_context->end(m_cmd_queue.Get());
+
+    std::scoped_lock _{m_worker_mtx};
+    m_stats.last_composite_coverage = (double)area / ((double)m_width * m_height);
+}
+
+D3D12Renderer::Stats D3D12Renderer::stats() {
+    Stats stats{};
+
+    {
+        std::scoped_lock _{m_worker_mtx};
+        stats = m_stats;
+    }
+
+    for (auto& cmd_context : m_cmd_contexts) {
+        auto context_stats = cmd_context->stats();
+        stats.command_stalls += context_stats.stalls;
+        stats.command_stall_ms += context_stats.stall_ms;
+        stats.command_ring_depth = std::max(stats.command_ring_depth, context_stats.depth);
+    }
+
+    auto composite_timing = m_composite_timer->stats();
+    auto d2d_timing = m_d2d_timer->stats();
+    stats.gpu_composite_ms = composite_timing.last_ms;
+    stats.gpu_composite_avg_ms = composite_timing.average_ms;
+    stats.gpu_composite_max_ms = composite_timing.max_ms;
+    stats.gpu_d2d_ms = d2d_timing.last_ms;
+    stats.gpu_d2d_avg_ms = d2d_timing.average_ms;
+    stats.gpu_d2d_max_ms = d2d_timing.max_ms;
+    stats.gpu_samples_dropped = composite_timing.dropped + d2d_timing.dropped;
+
+    return stats;
+}
+
+void D3D12Renderer::worker_main() {
+    while (true) {
+        std::function<void(D2DPainter&)> draw_fn{};
+        auto index = 0;
+
+        {
+            std::unique_lock lock{m_worker_mtx};
+            m_worker_cv.wait(lock, [this] { return m_stop || m_pending; });
+
+            if (m_stop) {
+                return;
+            }
+
+            draw_fn = std::move(m_pending);
+            m_pending = nullptr;
+            index = pick_overlay();
+        }
+
+        try {
+            if (!wait_for_composite(index)) {
+                return;
+            }
+
+            auto start = Clock::now();
+            draw_overlay(index, draw_fn);
+            auto ms = std::chrono::duration<double, std::milli>{Clock::now() - start}.count();
+
+            std::scoped_lock _{m_worker_mtx};
+            m_latest = index;
+            m_stats.average_render_ms = m_stats.frames_rendered == 0 ? ms : m_stats.average_render_ms * 0.9 + ms * 0.1;
+            m_stats.last_render_ms = ms;
+            ++m_stats.frames_rendered;
+        } catch (const std::exception& e) {
+            std::scoped_lock _{m_worker_mtx};
+            m_worker_error = e.what();
+        }
+    }
+}
+
+void D3D12Renderer::draw_overlay(int index, std::function<void(D2DPainter&)>& draw_fn) {
+    auto& overlay = m_overlays[index];
+    std::string error{};
+
+    m_d3d11on12_device->AcquireWrappedResources(overlay.wrapped.GetAddressOf(), 1);
+    m_d2d_timer->collect();
+    m_d2d_timer->begin();
+    m_d2d->begin(index);
+
+    // Always end the frame and give the overlay back, even when replay fails half way.
+    try {
+        draw_fn(*m_d2d);
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+
+    m_d2d->end();
+    m_d2d_timer->end();
+    m_d3d11on12_device->ReleaseWrappedResources(overlay.wrapped.GetAddressOf(), 1);
+
+    const auto& drawn = m_d2d->drawn_bounds();
+    std::vector<DrawBounds::Rect> scissors{};
+
+    if (!drawn.empty()) {
+        if (m_composite_tiling && drawn.tile_coverage() < TILE_COVERAGE_THRESHOLD) {
+            scissors = drawn.tiles();
+        } else {
+            scissors.push_back(drawn.bounds());
+        }
+    }
+
+    // Scissors are applied to the back buffer, widen them to whole back buffer pixels. The extra pixel covers the bilinear footprint
+    // of the upscale.
+    if (m_overlay_width != m_width || m_overlay_height != m_height) {
+        auto sx = (float)m_width / m_overlay_width;
+        auto sy = (float)m_height / m_overlay_height;
+
+        for (auto& r : scissors) {
+            r.left = std::max(0, (int)(r.left * sx) - 1);
+            r.top = std::max(0, (int)(r.top * sy) - 1);
+            r.right = std::min(m_width, (int)std::ceil(r.right * sx) + 1);
+            r.bottom = std::min(m_height, (int)std::ceil(r.bottom * sy) + 1);
+        }
+    }
+
+    m_d3d11_context->Flush();
+
+    auto ready_value = ++m_d2d_fence_value;
+    m_cmd_queue->Signal(m_d2d_fence.Get(), ready_value);
+
+    {
+        std::scoped_lock _{m_worker_mtx};
+        overlay.ready_value = ready_value;
+        overlay.empty = drawn.empty();
+        overlay.scissors = std::move(scissors);
+    }
+
+    if (!error.empty()) {
+        throw std::runtime_error{error};
+    }
+}
+
+int D3D12Renderer::pick_overlay() {
+    auto count = (int)m_overlays.size();
+    auto completed = m_composite_fence->GetCompletedValue();
+    auto fallback = -1;
+
+    // Round robin over everything but the overlay being shown, taking the first one the GPU is done sampling. If all of them are
+    // still in use, the one released earliest is the one to wait on.
+    for (auto i = 0; i < count; ++i) {
+        auto index = (m_next_overlay + i) % count;
+
+        if (index == m_latest) {
+            continue;
+        }
+
+        if (m_overlays[index].read_value <= completed) {
+            m_next_overlay = (index + 1) % count;
+            return index;
+        }
+
+        if (fallback < 0 || m_overlays[index].read_value < m_overlays[fallback].read_value) {
+            fallback = index;
+        }
+    }
+
+    m_next_overlay = (fallback + 1) % count;
+    return fallback;
+}
+
+bool D3D12Renderer::wait_for_composite(int index) {
+    UINT64 read_value{};
+
+    {
+        std::scoped_lock _{m_worker_mtx};
+        read_value = m_overlays[index].read_value;
+    }
+
+    if (m_composite_fence->GetCompletedValue() >= read_value) {
+        return true;
+    }
+
+    auto start = Clock::now();
+
+    // The value may only have been reserved so far, keep checking for shutdown while the present thread gets around to signaling it.
+    while (m_composite_fence->GetCompletedValue() < read_value) {
+        m_composite_fence->SetEventOnCompletion(read_value, m_worker_event);
+
+        if (WaitForSingleObject(m_worker_event, 100) == WAIT_TIMEOUT) {
+            std::scoped_lock _{m_worker_mtx};
+
+            if (m_stop) {
+                return false;
+            }
+        }
+    }
+
+    std::scoped_lock _{m_worker_mtx};
+    ++m_stats.overlay_waits;
+    m_stats.overlay_wait_ms += std::chrono::duration<double, std::milli>{Clock::now() - start}.count();
+
+    return true;
+}
+
+void D3D12Renderer::stop_worker() {
+    {
+        std::scoped_lock _{m_worker_mtx};
+        m_stop = true;
+        m_worker_cv.notify_one();
+    }
+
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+
+    // Let any D2D work already on the queue finish before the overlays go away.
+    if (m_d2d_fence != nullptr && m_d2d_fence->GetCompletedValue() < m_d2d_fence_value) {
+        m_d2d_fence->SetEventOnCompletion(m_d2d_fence_value, m_worker_event);
+        WaitForSingleObject(m_worker_event, 2000);
+    }
+
+    if (m_worker_event != nullptr) {
+        CloseHandle(m_worker_event);
+        m_worker_event = nullptr;
+    }
 }
\ No newline at end of file
@@ -1,6 +1,13 @@
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <d3d11.h>
 #include <d3d11on12.h>
@@ -8,7 +15,10 @@
 #include <dxgi1_4.h>
 #include <wrl.h>
 
+#include "D3D11TimestampQueries.hpp"
 #include "D3D12CommandContext.hpp"
+#include "D3D12TimestampQueries.hpp"
+#include "GpuTimerRing.hpp"
 
 #include "D2DPainter.hpp"
 
@@ -19,14 +29,64 @@ public:
         BACKBUFFER_1,
         BACKBUFFER_2,
         BACKBUFFER_3,
-        D2D,
         COUNT,
     };
 
+    // Overlay textures get consecutive SRVs starting here.
     enum class SRV : int { D2D };
 
-    D3D12Renderer(IDXGISwapChain* swapchain_, ID3D12Device* device_, ID3D12CommandQueue* cmd_queue_);
+    // D2D draws into one overlay while the composite samples another. With more than two, a new update can start while the GPU is
+    // still sampling the previous ones instead of waiting for it.
+    static constexpr int MIN_OVERLAY_COUNT = 2;
+    static constexpr int DEFAULT_OVERLAY_COUNT = 3;
+
+    // Overlays can be rasterized below back buffer resolution and get upscaled by the composite, scripts keep drawing in back buffer
+    // coordinates either way.
+    static constexpr float MIN_RENDER_SCALE = 0.5f;
+    static constexpr float MAX_RENDER_SCALE = 1.0f;
+
+    // With tiling on, sparse content is composited tile by tile once the touched tiles cover less than this much of the bounds.
+    static constexpr float TILE_COVERAGE_THRESHOLD = 0.5f;
+
+    // GPU timings are read back this many measurements later at most, anything newer is skipped until a slot frees up.
+    static constexpr size_t GPU_TIMER_SLOTS = 8;
+
+    struct Stats {
+        uint64_t frames_rendered{};
+        // Updates that were replaced by a newer one before the worker got to them.
+        uint64_t frames_superseded{};
+        double last_render_ms{};
+        double average_render_ms{};
+        double last_composite_ms{};
+        // Times the worker had to block until the GPU was done sampling every free overlay.
+        uint64_t overlay_waits{};
+        double overlay_wait_ms{};
+        // Composites submitted before the overlay's D2D work had finished on the GPU.
+        uint64_t composite_waits{};
+        // Summed over the per back buffer command contexts, depth is the largest ring.
+        uint64_t command_stalls{};
+        double command_stall_ms{};
+        size_t command_ring_depth{};
+        // Composites skipped because the overlay was empty.
+        uint64_t composites_skipped{};
+        // Fraction of the screen the last composite blended.
+        double last_composite_coverage{};
+        // GPU time spent compositing and rasterizing with D2D, averaged over the recent samples.
+        double gpu_composite_ms{};
+        double gpu_composite_avg_ms{};
+        double gpu_composite_max_ms{};
+        double gpu_d2d_ms{};
+        double gpu_d2d_avg_ms{};
+        double gpu_d2d_max_ms{};
+        uint64_t gpu_samples_dropped{};
+    };
+
+    // The factories are shared with whatever outlives the renderer, everything else here is tied to the device and swapchain.
+    D3D12Renderer(IDXGISwapChain* swapchain_, ID3D12Device* device_, ID3D12CommandQueue* cmd_queue_, const D2DPainter::Factories& factories,
+        int overlay_count = DEFAULT_OVERLAY_COUNT, float render_scale = MAX_RENDER_SCALE);
     virtual ~D3D12Renderer() {
+        stop_worker();
+
         // Give the command contexts priority cleanup before everything else
         // so any command lists can finish executing before destroying everything
         for (auto& cmd_context : m_cmd_contexts) {
@@ -36,10 +96,19 @@ public:
         m_cmd_contexts.clear();
     }
 
+    // Composites the most recently completed overlay onto the back buffer. When update_d2d is set, draw_fn is handed to the render
+    // worker which rasterizes it into the other overlay, it shows up on a later frame once finished.
     void render(std::function<void(D2DPainter&)> draw_fn, bool update_d2d);
 
     auto& get_d2d() { return m_d2d; }
 
+    Stats stats();
+
+    void set_composite_tiling(bool enabled) { m_composite_tiling = enabled; }
+    bool composite_tiling() const { return m_composite_tiling; }
+
+    float render_scale() const { return m_render_scale; }
+
 private:
     template <typename T> using ComPtr = Microsoft::WRL::ComPtr<T>;
 
@@ -56,7 +125,6 @@ private:
     ComPtr<ID3D11Device> m_d3d11_device{};
     ComPtr<ID3D11DeviceContext> m_d3d11_context{};
     ComPtr<ID3D11On12Device> m_d3d11on12_device{};
-    ComPtr<ID3D11Resource> m_wrapped_rt{};
 
     ComPtr<ID3D12DescriptorHeap> m_rtv_heap{};
     ComPtr<ID3D12DescriptorHeap> m_srv_heap{};
@@ -75,9 +143,59 @@ private:
 
     int m_width{};
     int m_height{};
+    float m_render_scale{MAX_RENDER_SCALE};
+    int m_overlay_width{};
+    int m_overlay_height{};
 
     std::unique_ptr<D2DPainter> m_d2d{};
 
+    using Clock = std::chrono::steady_clock;
+
+    struct Overlay {
+        ComPtr<ID3D12Resource> texture{};
+        ComPtr<ID3D11Resource> wrapped{};
+        // m_d2d_fence value signaled once D2D is done drawing into this overlay.
+        UINT64 ready_value{};
+        // m_composite_fence value signaled once the last composite sampling this overlay is done.
+        UINT64 read_value{};
+        // What D2D drew into this overlay, in back buffer pixels. Empty overlays aren't composited at all, otherwise only the drawn
+        // area is.
+        bool empty{true};
+        std::vector<DrawBounds::Rect> scissors{};
+    };
+
+    std::vector<Overlay> m_overlays{};
+
+    ComPtr<ID3D12Fence> m_d2d_fence{};
+    UINT64 m_d2d_fence_value{};
+    ComPtr<ID3D12Fence> m_composite_fence{};
+    UINT64 m_composite_fence_value{};
+
+    // Everything below is shared between the present thread and the render worker and guarded by m_worker_mtx.
+    std::thread m_worker{};
+    std::mutex m_worker_mtx{};
+    std::condition_variable m_worker_cv{};
+    HANDLE m_worker_event{};
+    std::function<void(D2DPainter&)> m_pending{};
+    int m_latest{-1};
+    int m_next_overlay{};
+    bool m_stop{};
+    std::string m_worker_error{};
+    Stats m_stats{};
+
+    std::atomic<bool> m_composite_tiling{};
+
+    // Composite timings are recorded on the present thread, D2D timings on the render worker.
+    std::unique_ptr<GpuTimerRing<D3D12TimestampQueries, GPU_TIMER_SLOTS>> m_composite_timer{};
+    std::unique_ptr<GpuTimerRing<D3D11TimestampQueries, GPU_TIMER_SLOTS>> m_d2d_timer{};
+
+    void worker_main();
+    void stop_worker();
+    void draw_overlay(int index, std::function<void(D2DPainter&)>& draw_fn);
+    void composite(int overlay_index, UINT64 ready_value, UINT64 read_value);
+    int pick_overlay();
+    bool wait_for_composite(int index);
+
     auto& get_rt(RTV rtv) { return m_rts[(int)rtv]; }
 
     D3D12_CPU_DESCRIPTOR_HANDLE get_cpu_rtv(RTV rtv) {
@@ -85,13 +203,13 @@ private:
                 (int)rtv * m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV)};
     }
 
-    D3D12_CPU_DESCRIPTOR_HANDLE get_cpu_srv(SRV srv) {
+    D3D12_CPU_DESCRIPTOR_HANDLE get_cpu_srv(SRV srv, int offset = 0) {
         return {m_srv_heap->GetCPUDescriptorHandleForHeapStart().ptr +
-                (int)srv * m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)};
+                ((int)srv + offset) * m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)};
     }
 
-    D3D12_GPU_DESCRIPTOR_HANDLE get_gpu_srv(SRV srv) {
+    D3D12_GPU_DESCRIPTOR_HANDLE get_gpu_srv(SRV srv, int offset = 0) {
         return {m_srv_heap->GetGPUDescriptorHandleForHeapStart().ptr +
-                (int)srv * m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)};
+                ((int)srv + offset) * m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)};
     }
 };
\ No newline at end of file
@@ -1,42 +1,10 @@
 #pragma once
 
-const char* D3D12_VERT_SHADER = R"(
-cbuffer vert_buffer : register(b0) {
-    float4x4 mvp;
-};
-
-struct VS_INPUT {
-    float2 pos : POSITION;
-    float4 color : COLOR;
-    float2 uv : TEXCOORD;
-};
-
-struct PS_INPUT {
-    float4 pos : SV_POSITION;
-    float4 color : COLOR;
-    float2 uv : TEXCOORD;
-};
-
-PS_INPUT main(VS_INPUT input) {
-    PS_INPUT output;
-    output.pos = mul(mvp, float4(input.pos.xy, 0.0f, 1.0f));
-    output.color = input.color;
-    output.uv = input.uv;
-    return output;
-}
-)";
-
-const char* D3D12_PIX_SHADER = R"(
-struct PS_INPUT {
-    float4 pos : SV_POSITION;
-    float4 color : COLOR;
-    float2 uv : TEXCOORD;
-};
-
-SamplerState sampler0 : register(s0);
-Texture2D texture0 : register(t0);
-
-float4 main(PS_INPUT input) : SV_TARGET {
-    return input.color * texture0.Sample(sampler0, input.uv);
-}
-)";
+// The composite shaders live in src/shaders. Normally they're compiled at build time and embedded as g_<name> bytecode arrays,
+// REFD2D_RUNTIME_SHADERS builds compile them from REFD2D_SHADER_DIR when the renderer is created instead.
+#ifdef REFD2D_RUNTIME_SHADERS
+#include <d3dcompiler.h>
+#else
+#include "composite_ps.h"
+#include "composite_vs.h"
+#endif
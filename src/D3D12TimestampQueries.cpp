@@ -0,0 +1,74 @@
+#include <stdexcept>
+
+#include "D3D12TimestampQueries.hpp"
+
+D3D12TimestampQueries::D3D12TimestampQueries(ID3D12Device* device, ID3D12CommandQueue* queue, ID3D12Fence* fence, size_t slots)
+    : m_fence{fence}
+    , m_slot_fence_values(slots) {
+    UINT64 frequency{};
+
+    if (FAILED(queue->GetTimestampFrequency(&frequency)) || frequency == 0) {
+        throw std::runtime_error{"Failed to get timestamp frequency"};
+    }
+
+    m_ticks_per_ms = (double)frequency / 1000.0;
+
+    D3D12_QUERY_HEAP_DESC heap_desc{};
+    heap_desc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    heap_desc.Count = (UINT)slots * 2;
+
+    if (FAILED(device->CreateQueryHeap(&heap_desc, IID_PPV_ARGS(&m_heap)))) {
+        throw std::runtime_error{"Failed to create timestamp query heap"};
+    }
+
+    D3D12_HEAP_PROPERTIES heap_props{};
+    heap_props.Type = D3D12_HEAP_TYPE_READBACK;
+
+    D3D12_RESOURCE_DESC desc{};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    desc.Width = heap_desc.Count * sizeof(UINT64);
+    desc.Height = 1;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    if (FAILED(device->CreateCommittedResource(
+            &heap_props, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m_readback)))) {
+        throw std::runtime_error{"Failed to create timestamp readback buffer"};
+    }
+}
+
+void D3D12TimestampQueries::begin(size_t slot) {
+    m_cmd_list->EndQuery(m_heap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, (UINT)slot * 2);
+}
+
+void D3D12TimestampQueries::end(size_t slot) {
+    m_cmd_list->EndQuery(m_heap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, (UINT)slot * 2 + 1);
+    m_cmd_list->ResolveQueryData(m_heap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, (UINT)slot * 2, 2, m_readback.Get(), slot * 2 * sizeof(UINT64));
+    m_slot_fence_values[slot] = m_fence_value;
+}
+
+GpuTiming D3D12TimestampQueries::poll(size_t slot) {
+    if (m_fence->GetCompletedValue() < m_slot_fence_values[slot]) {
+        return {};
+    }
+
+    D3D12_RANGE range{slot * 2 * sizeof(UINT64), (slot * 2 + 2) * sizeof(UINT64)};
+    UINT64* ticks{};
+
+    if (FAILED(m_readback->Map(0, &range, (void**)&ticks))) {
+        return {GpuTiming::State::INVALID};
+    }
+
+    auto begin = ticks[slot * 2];
+    auto end = ticks[slot * 2 + 1];
+    D3D12_RANGE written{};
+    m_readback->Unmap(0, &written);
+
+    if (end < begin) {
+        return {GpuTiming::State::INVALID};
+    }
+
+    return {GpuTiming::State::READY, (double)(end - begin) / m_ticks_per_ms};
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include "GpuTimerRing.hpp"
+
+// GpuTimerRing source for D3D12 command lists. Each slot is a pair of timestamps resolved into a readback buffer, a slot's results
+// are read once the fence value given for it has been reached.
+class D3D12TimestampQueries {
+public:
+    template <typename T> using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+    D3D12TimestampQueries(ID3D12Device* device, ID3D12CommandQueue* queue, ID3D12Fence* fence, size_t slots);
+
+    // Where the next begin/end get recorded, and the fence value that's signaled once the list has finished executing.
+    void set_target(ID3D12GraphicsCommandList* cmd_list, UINT64 fence_value) {
+        m_cmd_list = cmd_list;
+        m_fence_value = fence_value;
+    }
+
+    void begin(size_t slot);
+    void end(size_t slot);
+    GpuTiming poll(size_t slot);
+
+private:
+    ComPtr<ID3D12QueryHeap> m_heap{};
+    ComPtr<ID3D12Resource> m_readback{};
+    ComPtr<ID3D12Fence> m_fence{};
+    double m_ticks_per_ms{};
+
+    ID3D12GraphicsCommandList* m_cmd_list{};
+    UINT64 m_fence_value{};
+    std::vector<UINT64> m_slot_fence_values{};
+};
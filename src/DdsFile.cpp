@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "BcDecoder.hpp"
+
+#include "DdsFile.hpp"
+
+namespace {
+constexpr uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+constexpr uint32_t DDS_HEADER_SIZE = 124;
+constexpr uint32_t DDS_DX10_HEADER_SIZE = 20;
+
+constexpr uint32_t DDPF_ALPHAPIXELS = 0x1;
+constexpr uint32_t DDPF_FOURCC = 0x4;
+constexpr uint32_t DDPF_RGB = 0x40;
+
+constexpr uint32_t DDS_RESOURCE_DIMENSION_TEXTURE2D = 3;
+
+constexpr uint32_t DDS_ALPHA_MODE_PREMULTIPLIED = 2;
+constexpr uint32_t DDS_ALPHA_MODE_OPAQUE = 3;
+
+// The subset of DXGI_FORMAT values we understand.
+constexpr uint32_t DXGI_FORMAT_R8G8B8A8_UNORM = 28;
+constexpr uint32_t DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29;
+constexpr uint32_t DXGI_FORMAT_BC1_UNORM = 71;
+constexpr uint32_t DXGI_FORMAT_BC1_UNORM_SRGB = 72;
+constexpr uint32_t DXGI_FORMAT_BC2_UNORM = 74;
+constexpr uint32_t DXGI_FORMAT_BC2_UNORM_SRGB = 75;
+constexpr uint32_t DXGI_FORMAT_BC3_UNORM = 77;
+constexpr uint32_t DXGI_FORMAT_BC3_UNORM_SRGB = 78;
+constexpr uint32_t DXGI_FORMAT_B8G8R8A8_UNORM = 87;
+constexpr uint32_t DXGI_FORMAT_B8G8R8A8_UNORM_SRGB = 91;
+constexpr uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+constexpr uint32_t DXGI_FORMAT_BC7_UNORM_SRGB = 99;
+
+constexpr uint32_t make_fourcc(char a, char b, char c, char d) {
+    return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+}
+
+uint32_t read_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint8_t premultiply(uint8_t c, uint8_t a) {
+    return (uint8_t)((c * a + 127) / 255);
+}
+} // namespace
+
+DdsFile::DdsFile(const std::filesystem::path& filepath) {
+    std::ifstream file{filepath, std::ios::binary | std::ios::ate};
+
+    if (!file) {
+        throw std::runtime_error{"Failed to open DDS file"};
+    }
+
+    m_file.resize((size_t)file.tellg());
+    file.seekg(0);
+
+    if (!file.read((char*)m_file.data(), m_file.size())) {
+        throw std::runtime_error{"Failed to read DDS file"};
+    }
+
+    parse();
+}
+
+DdsFile::DdsFile(std::vector<uint8_t> file)
+    : m_file{std::move(file)} {
+    parse();
+}
+
+void DdsFile::parse() {
+    if (m_file.size() < 4 + DDS_HEADER_SIZE || read_u32(m_file.data()) != DDS_MAGIC) {
+        throw std::runtime_error{"Not a DDS file"};
+    }
+
+    auto header = m_file.data() + 4;
+
+    if (read_u32(header) != DDS_HEADER_SIZE) {
+        throw std::runtime_error{"Invalid DDS header size"};
+    }
+
+    m_height = read_u32(header + 8);
+    m_width = read_u32(header + 12);
+
+    // DDS_PIXELFORMAT starts at offset 72 of the header.
+    auto pf = header + 72;
+    auto pf_flags = read_u32(pf + 4);
+    auto fourcc = read_u32(pf + 8);
+    m_data_offset = 4 + DDS_HEADER_SIZE;
+    m_alpha_mode = AlphaMode::STRAIGHT;
+
+    if (pf_flags & DDPF_FOURCC) {
+        if (fourcc == make_fourcc('D', 'X', '1', '0')) {
+            if (m_file.size() < m_data_offset + DDS_DX10_HEADER_SIZE) {
+                throw std::runtime_error{"Truncated DDS DX10 header"};
+            }
+
+            auto dx10 = m_file.data() + m_data_offset;
+            auto dxgi_format = read_u32(dx10);
+            auto dimension = read_u32(dx10 + 4);
+            auto alpha_mode = read_u32(dx10 + 16) & 0x7;
+
+            if (dimension != DDS_RESOURCE_DIMENSION_TEXTURE2D) {
+                throw std::runtime_error{"Only 2D DDS textures are supported"};
+            }
+
+            switch (dxgi_format) {
+            case DXGI_FORMAT_BC1_UNORM:
+            case DXGI_FORMAT_BC1_UNORM_SRGB:
+                m_format = Format::BC1;
+                break;
+            case DXGI_FORMAT_BC2_UNORM:
+            case DXGI_FORMAT_BC2_UNORM_SRGB:
+                m_format = Format::BC2;
+                break;
+            case DXGI_FORMAT_BC3_UNORM:
+            case DXGI_FORMAT_BC3_UNORM_SRGB:
+                m_format = Format::BC3;
+                break;
+            case DXGI_FORMAT_BC7_UNORM:
+            case DXGI_FORMAT_BC7_UNORM_SRGB:
+                m_format = Format::BC7;
+                break;
+            case DXGI_FORMAT_B8G8R8A8_UNORM:
+            case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+                m_format = Format::BGRA8;
+                break;
+            case DXGI_FORMAT_R8G8B8A8_UNORM:
+            case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+                m_format = Format::RGBA8;
+                break;
+            default:
+                throw std::runtime_error{"Unsupported DDS DXGI format"};
+            }
+
+            if (alpha_mode == DDS_ALPHA_MODE_PREMULTIPLIED) {
+                m_alpha_mode = AlphaMode::PREMULTIPLIED;
+            } else if (alpha_mode == DDS_ALPHA_MODE_OPAQUE) {
+                m_alpha_mode = AlphaMode::OPAQUE;
+            }
+
+            m_data_offset += DDS_DX10_HEADER_SIZE;
+        } else if (fourcc == make_fourcc('D', 'X', 'T', '1')) {
+            m_format = Format::BC1;
+        } else if (fourcc == make_fourcc('D', 'X', 'T', '2')) {
+            m_format = Format::BC2;
+            m_alpha_mode = AlphaMode::PREMULTIPLIED;
+        } else if (fourcc == make_fourcc('D', 'X', 'T', '3')) {
+            m_format = Format::BC2;
+        } else if (fourcc == make_fourcc('D', 'X', 'T', '4')) {
+            m_format = Format::BC3;
+            m_alpha_mode = AlphaMode::PREMULTIPLIED;
+        } else if (fourcc == make_fourcc('D', 'X', 'T', '5')) {
+            m_format = Format::BC3;
+        } else {
+            throw std::runtime_error{"Unsupported DDS FourCC"};
+        }
+    } else if ((pf_flags & DDPF_RGB) && read_u32(pf + 12) == 32) {
+        auto r_mask = read_u32(pf + 16);
+        auto g_mask = read_u32(pf + 20);
+        auto b_mask = read_u32(pf + 24);
+
+        if (r_mask == 0x00FF0000 && g_mask == 0x0000FF00 && b_mask == 0x000000FF) {
+            m_format = Format::BGRA8;
+        } else if (r_mask == 0x000000FF && g_mask == 0x0000FF00 && b_mask == 0x00FF0000) {
+            m_format = Format::RGBA8;
+        } else {
+            throw std::runtime_error{"Unsupported DDS RGB channel layout"};
+        }
+
+        if (!(pf_flags & DDPF_ALPHAPIXELS) || read_u32(pf + 28) == 0) {
+            m_alpha_mode = AlphaMode::OPAQUE;
+        }
+    } else {
+        throw std::runtime_error{"Unsupported DDS pixel format"};
+    }
+
+    if (m_width == 0 || m_height == 0 || m_width > MAX_DIMENSION || m_height > MAX_DIMENSION) {
+        throw std::runtime_error{"Invalid DDS dimensions"};
+    }
+
+    auto rows = is_block_compressed() ? (m_height + 3) / 4 : m_height;
+    auto data_size = (uint64_t)pitch() * rows;
+
+    if ((uint64_t)(m_file.size() - m_data_offset) < data_size) {
+        throw std::runtime_error{"Truncated DDS pixel data"};
+    }
+
+    m_data_size = (size_t)data_size;
+}
+
+uint32_t DdsFile::block_size() const {
+    switch (m_format) {
+    case Format::BC1:
+        return 8;
+    case Format::BC2:
+    case Format::BC3:
+    case Format::BC7:
+        return 16;
+    default:
+        return 4;
+    }
+}
+
+uint32_t DdsFile::pitch() const {
+    if (is_block_compressed()) {
+        return std::max(1u, (m_width + 3) / 4) * block_size();
+    }
+
+    return m_width * 4;
+}
+
+void DdsFile::decode_bgra(uint8_t* dst, size_t dst_pitch) const {
+    auto src = data();
+    auto src_pitch = pitch();
+    auto premultiplied = m_alpha_mode != AlphaMode::STRAIGHT;
+
+    if (!is_block_compressed()) {
+        auto swap_rb = m_format == Format::RGBA8;
+
+        for (auto y = 0u; y < m_height; ++y) {
+            auto in = src + (size_t)y * src_pitch;
+            auto out = dst + (size_t)y * dst_pitch;
+
+            for (auto x = 0u; x < m_width; ++x, in += 4, out += 4) {
+                auto a = m_alpha_mode == AlphaMode::OPAQUE ? (uint8_t)255 : in[3];
+                auto r = swap_rb ? in[0] : in[2];
+                auto g = in[1];
+                auto b = swap_rb ? in[2] : in[0];
+
+                out[0] = premultiplied ? b : premultiply(b, a);
+                out[1] = premultiplied ? g : premultiply(g, a);
+                out[2] = premultiplied ? r : premultiply(r, a);
+                out[3] = a;
+            }
+        }
+
+        return;
+    }
+
+    void (*decode_block)(const uint8_t*, uint8_t(&)[16][4]){};
+
+    switch (m_format) {
+    case Format::BC1:
+        decode_block = BcDecoder::decode_bc1;
+        break;
+    case Format::BC2:
+        decode_block = BcDecoder::decode_bc2;
+        break;
+    case Format::BC3:
+        decode_block = BcDecoder::decode_bc3;
+        break;
+    default:
+        decode_block = BcDecoder::decode_bc7;
+        break;
+    }
+
+    auto blocks_wide = (m_width + 3) / 4;
+    auto blocks_high = (m_height + 3) / 4;
+    uint8_t texels[16][4]{};
+
+    for (auto by = 0u; by < blocks_high; ++by) {
+        auto row = src + (size_t)by * src_pitch;
+
+        for (auto bx = 0u; bx < blocks_wide; ++bx) {
+            decode_block(row + (size_t)bx * block_size(), texels);
+
+            // Edge blocks may hang past the image bounds when the size isn't a multiple of 4.
+            auto w = std::min(4u, m_width - bx * 4);
+            auto h = std::min(4u, m_height - by * 4);
+
+            for (auto ty = 0u; ty < h; ++ty) {
+                auto out = dst + (size_t)(by * 4 + ty) * dst_pitch + (size_t)bx * 16;
+
+                for (auto tx = 0u; tx < w; ++tx, out += 4) {
+                    const auto& t = texels[ty * 4 + tx];
+                    auto a = m_alpha_mode == AlphaMode::OPAQUE ? (uint8_t)255 : t[3];
+
+                    out[0] = premultiplied ? t[2] : premultiply(t[2], a);
+                    out[1] = premultiplied ? t[1] : premultiply(t[1], a);
+                    out[2] = premultiplied ? t[0] : premultiply(t[0], a);
+                    out[3] = a;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Minimal DDS container reader. Only the top level mip of a 2D texture is exposed. This file is platform neutral on purpose so it
+// doesn't pull in any of the Windows/DXGI headers.
+class DdsFile {
+public:
+    enum class Format { BC1, BC2, BC3, BC7, BGRA8, RGBA8 };
+    enum class AlphaMode { STRAIGHT, PREMULTIPLIED, OPAQUE };
+
+    // Largest width or height accepted, D3D's own limit for 2D textures. Keeps pitch() well within 32 bits.
+    static constexpr uint32_t MAX_DIMENSION = 16384;
+
+    DdsFile(const std::filesystem::path& filepath);
+    DdsFile(std::vector<uint8_t> file);
+
+    auto format() const { return m_format; }
+    auto alpha_mode() const { return m_alpha_mode; }
+    auto width() const { return m_width; }
+    auto height() const { return m_height; }
+
+    bool is_block_compressed() const { return m_format != Format::BGRA8 && m_format != Format::RGBA8; }
+
+    // Bytes per 4x4 block for block compressed formats, bytes per pixel otherwise.
+    uint32_t block_size() const;
+
+    // Bytes between rows of blocks (block compressed) or rows of pixels (uncompressed).
+    uint32_t pitch() const;
+
+    const uint8_t* data() const { return m_file.data() + m_data_offset; }
+    size_t data_size() const { return m_data_size; }
+
+    // Decodes the top level mip to 32bpp premultiplied BGRA with the given destination row pitch.
+    void decode_bgra(uint8_t* dst, size_t dst_pitch) const;
+
+private:
+    std::vector<uint8_t> m_file{};
+    size_t m_data_offset{};
+    size_t m_data_size{};
+
+    Format m_format{};
+    AlphaMode m_alpha_mode{};
+    uint32_t m_width{};
+    uint32_t m_height{};
+
+    void parse();
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Every D2D device the plugin creates gets its own generation. Device dependent resources (bitmaps and the like) remember the
+// generation they were created for, so after a device reset anything still holding resources from the old device can tell and
+// recreate them on next use, while its device independent state is kept.
+namespace DeviceGeneration {
+// A new generation, never 0 and never repeated.
+inline uint64_t next() {
+    static std::atomic<uint64_t> s_generation{};
+    return ++s_generation;
+}
+} // namespace DeviceGeneration
+
+// The generation a resource's device dependent parts currently belong to. 0 means none have been created yet.
+class DeviceTag {
+public:
+    // Adopts the given generation. Returns true if the resource held parts created for a different one which have to be dropped.
+    bool rebind(uint64_t generation) {
+        auto stale = m_generation != 0 && m_generation != generation;
+        m_generation = generation;
+        return stale;
+    }
+
+    bool bound_to(uint64_t generation) const { return m_generation == generation; }
+    auto generation() const { return m_generation; }
+
+    void unbind() { m_generation = 0; }
+
+private:
+    uint64_t m_generation{};
+};
@@ -0,0 +1,82 @@
+#include <algorithm>
+
+#include "DirtyRegion.hpp"
+
+namespace {
+uint64_t area_of(const DirtyRegion::Rect& r) {
+    return (uint64_t)r.w * r.h;
+}
+
+DirtyRegion::Rect union_of(const DirtyRegion::Rect& a, const DirtyRegion::Rect& b) {
+    auto x = std::min(a.x, b.x);
+    auto y = std::min(a.y, b.y);
+    auto right = std::max(a.x + a.w, b.x + b.w);
+    auto bottom = std::max(a.y + a.h, b.y + b.h);
+    return {x, y, right - x, bottom - y};
+}
+} // namespace
+
+DirtyRegion::DirtyRegion(uint32_t width, uint32_t height)
+    : m_width{width}
+    , m_height{height} {
+}
+
+void DirtyRegion::add(int64_t x, int64_t y, int64_t w, int64_t h) {
+    auto left = std::clamp<int64_t>(x, 0, m_width);
+    auto top = std::clamp<int64_t>(y, 0, m_height);
+    auto right = std::clamp<int64_t>(x + w, 0, m_width);
+    auto bottom = std::clamp<int64_t>(y + h, 0, m_height);
+
+    if (right <= left || bottom <= top) {
+        return;
+    }
+
+    Rect rect{(uint32_t)left, (uint32_t)top, (uint32_t)(right - left), (uint32_t)(bottom - top)};
+
+    // Merging can make the result overlap rectangles it didn't before, so keep going until nothing else gets absorbed.
+    for (auto merged = true; merged;) {
+        merged = false;
+
+        for (auto it = m_rects.begin(); it != m_rects.end(); ++it) {
+            auto u = union_of(*it, rect);
+
+            if ((float)area_of(u) <= (float)(area_of(*it) + area_of(rect)) * MERGE_SLACK) {
+                rect = u;
+                m_rects.erase(it);
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    m_rects.push_back(rect);
+
+    if (m_rects.size() > MAX_RECTS) {
+        auto b = bounds();
+        m_rects.assign(1, b);
+    }
+}
+
+DirtyRegion::Rect DirtyRegion::bounds() const {
+    if (m_rects.empty()) {
+        return {};
+    }
+
+    auto b = m_rects.front();
+
+    for (const auto& r : m_rects) {
+        b = union_of(b, r);
+    }
+
+    return b;
+}
+
+uint64_t DirtyRegion::area() const {
+    uint64_t total{};
+
+    for (const auto& r : m_rects) {
+        total += area_of(r);
+    }
+
+    return total;
+}
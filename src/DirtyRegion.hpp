@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Accumulates the parts of an image that changed since the last upload as a short list of rectangles. Nearby rectangles are merged
+// when the union wastes little area, and once there are too many everything collapses into the bounding box.
+class DirtyRegion {
+public:
+    struct Rect {
+        uint32_t x{};
+        uint32_t y{};
+        uint32_t w{};
+        uint32_t h{};
+    };
+
+    static constexpr size_t MAX_RECTS = 8;
+
+    // Merging two rectangles is accepted when the union covers at most this much more than the two of them combined.
+    static constexpr float MERGE_SLACK = 1.25f;
+
+    DirtyRegion(uint32_t width, uint32_t height);
+
+    // Clipped to the image bounds.
+    void add(int64_t x, int64_t y, int64_t w, int64_t h);
+    void add_all() { add(0, 0, m_width, m_height); }
+    void clear() { m_rects.clear(); }
+
+    bool empty() const { return m_rects.empty(); }
+    const auto& rects() const { return m_rects; }
+
+    Rect bounds() const;
+    uint64_t area() const;
+
+private:
+    uint32_t m_width{};
+    uint32_t m_height{};
+    std::vector<Rect> m_rects{};
+};
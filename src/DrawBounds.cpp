@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+
+#include "DrawBounds.hpp"
+
+DrawBounds::DrawBounds(int width, int height)
+    : m_width{width}
+    , m_height{height}
+    , m_tile_w{std::max((width + TILES_X - 1) / TILES_X, 1)}
+    , m_tile_h{std::max((height + TILES_Y - 1) / TILES_Y, 1)} {
+}
+
+void DrawBounds::clear() {
+    m_empty = true;
+    m_bounds = {};
+    m_tiles.reset();
+}
+
+void DrawBounds::add(float left, float top, float right, float bottom) {
+    // NaNs fail every comparison, so check for the valid case rather than the invalid one.
+    if (!(right > left && bottom > top)) {
+        return;
+    }
+
+    // Clamped while still floats, converting something outside of int's range (or infinite) is undefined.
+    auto w = (float)m_width;
+    auto h = (float)m_height;
+    auto l = (int)std::clamp(std::floor(left - PADDING), 0.0f, w);
+    auto t = (int)std::clamp(std::floor(top - PADDING), 0.0f, h);
+    auto r = (int)std::clamp(std::ceil(right + PADDING), 0.0f, w);
+    auto b = (int)std::clamp(std::ceil(bottom + PADDING), 0.0f, h);
+
+    if (r <= l || b <= t) {
+        return;
+    }
+
+    if (m_empty) {
+        m_bounds = {l, t, r, b};
+        m_empty = false;
+    } else {
+        m_bounds = {std::min(m_bounds.left, l), std::min(m_bounds.top, t), std::max(m_bounds.right, r), std::max(m_bounds.bottom, b)};
+    }
+
+    auto tx0 = l / m_tile_w;
+    auto tx1 = std::min((r - 1) / m_tile_w, TILES_X - 1);
+    auto ty0 = t / m_tile_h;
+    auto ty1 = std::min((b - 1) / m_tile_h, TILES_Y - 1);
+
+    for (auto ty = ty0; ty <= ty1; ++ty) {
+        for (auto tx = tx0; tx <= tx1; ++tx) {
+            m_tiles.set(ty * TILES_X + tx);
+        }
+    }
+}
+
+DrawBounds::Rect DrawBounds::tile_rect(int tx0, int tx1, int ty) const {
+    // Edge tiles are trimmed to the bounds, no point covering space outside of them.
+    return {std::max(tx0 * m_tile_w, m_bounds.left), std::max(ty * m_tile_h, m_bounds.top),
+        std::min((tx1 + 1) * m_tile_w, m_bounds.right), std::min((ty + 1) * m_tile_h, m_bounds.bottom)};
+}
+
+std::vector<DrawBounds::Rect> DrawBounds::tiles() const {
+    std::vector<Rect> runs{};
+
+    for (auto ty = 0; ty < TILES_Y; ++ty) {
+        for (auto tx = 0; tx < TILES_X; ++tx) {
+            if (!m_tiles.test(ty * TILES_X + tx)) {
+                continue;
+            }
+
+            auto start = tx;
+
+            while (tx + 1 < TILES_X && m_tiles.test(ty * TILES_X + tx + 1)) {
+                ++tx;
+            }
+
+            runs.push_back(tile_rect(start, tx, ty));
+        }
+    }
+
+    return runs;
+}
+
+float DrawBounds::tile_coverage() const {
+    if (m_empty) {
+        return 0.0f;
+    }
+
+    int64_t covered{};
+
+    for (const auto& r : tiles()) {
+        covered += r.area();
+    }
+
+    return std::min((float)covered / (float)m_bounds.area(), 1.0f);
+}
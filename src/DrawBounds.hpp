@@ -0,0 +1,52 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+// Conservative record of which parts of a surface were drawn to during a frame, as the union of every draw's bounds and as a
+// coarse grid of touched tiles for content that's spread out thinly.
+class DrawBounds {
+public:
+    static constexpr int TILES_X = 16;
+    static constexpr int TILES_Y = 16;
+
+    // Added around every draw to cover antialiasing.
+    static constexpr float PADDING = 1.0f;
+
+    struct Rect {
+        int left{};
+        int top{};
+        int right{};
+        int bottom{};
+
+        int64_t area() const { return (int64_t)(right - left) * (bottom - top); }
+    };
+
+    DrawBounds(int width, int height);
+
+    void clear();
+
+    // Bounds are in surface pixels and get clipped to the surface.
+    void add(float left, float top, float right, float bottom);
+
+    bool empty() const { return m_empty; }
+    Rect bounds() const { return m_bounds; }
+
+    // The touched tiles, merged into horizontal runs.
+    std::vector<Rect> tiles() const;
+
+    // Fraction of the bounds area covered by touched tiles, low values mean tiles would skip a lot of empty space.
+    float tile_coverage() const;
+
+private:
+    int m_width{};
+    int m_height{};
+    int m_tile_w{};
+    int m_tile_h{};
+    bool m_empty{true};
+    Rect m_bounds{};
+    std::bitset<TILES_X * TILES_Y> m_tiles{};
+
+    Rect tile_rect(int tx0, int tx1, int ty) const;
+};
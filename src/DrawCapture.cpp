@@ -0,0 +1,242 @@
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "utf8.h"
+
+#include "D2DFont.hpp"
+#include "D2DImage.hpp"
+
+#include "DrawCapture.hpp"
+
+namespace {
+std::string to_utf8(const std::filesystem::path& path) {
+    auto wide = path.wstring();
+    std::string narrow{};
+    utf8::utf16to8(wide.begin(), wide.end(), std::back_inserter(narrow));
+    return narrow;
+}
+} // namespace
+
+DrawCapture::DrawCapture(const std::filesystem::path& path, uint32_t frames)
+    : m_path{path}
+    , m_file{path, std::ios::binary | std::ios::trunc}
+    , m_frames{frames} {
+    if (!m_file) {
+        throw std::runtime_error{"Failed to create the capture file"};
+    }
+}
+
+bool DrawCapture::add(const std::vector<DrawList::Batch*>& batches, uint32_t width, uint32_t height) {
+    if (m_captured >= m_frames) {
+        return false;
+    }
+
+    // Written with the first frame since that's when the size is known.
+    if (m_captured == 0) {
+        CaptureFileHeader header{};
+        header.width = width;
+        header.height = height;
+        m_file.write((const char*)&header, sizeof(header));
+    }
+
+    m_encoder.clear();
+    m_encoder.begin_frame(m_captured);
+
+    for (auto batch : batches) {
+        m_transform_depth = 0;
+        m_clip_depth = 0;
+
+        for (auto& cmd : *batch) {
+            encode(cmd);
+        }
+
+        // Batches are merged into one frame, what one leaves pushed must not apply to the next.
+        for (; m_transform_depth > 0; --m_transform_depth) {
+            m_encoder.pop_transform();
+        }
+
+        for (; m_clip_depth > 0; --m_clip_depth) {
+            m_encoder.pop_clip();
+        }
+    }
+
+    m_encoder.end_frame();
+    m_file.write((const char*)m_encoder.data(), m_encoder.size());
+
+    if (!m_file) {
+        throw std::runtime_error{"Failed to write the capture file"};
+    }
+
+    if (++m_captured == m_frames) {
+        m_file.close();
+    }
+
+    return m_captured < m_frames;
+}
+
+uint32_t DrawCapture::font_id(const std::shared_ptr<D2DFont>& font) {
+    if (auto it = m_font_ids.find(font.get()); it != m_font_ids.end()) {
+        return it->second;
+    }
+
+    // Definitions go in the frame that first uses them, ahead of the draw.
+    auto id = (uint32_t)(m_font_ids.size() + 1);
+    auto& desc = font->description();
+
+    if (desc.filepath.empty()) {
+        m_encoder.define_font(id, desc.family, desc.size, desc.bold, desc.italic);
+    } else {
+        m_encoder.define_font_file(id, to_utf8(desc.filepath), desc.family, desc.size, desc.bold, desc.italic);
+    }
+
+    m_font_ids[font.get()] = id;
+    m_resources.emplace_back(font);
+    return id;
+}
+
+std::optional<uint32_t> DrawCapture::image_id(const std::shared_ptr<D2DImage>& image) {
+    if (auto it = m_image_ids.find(image.get()); it != m_image_ids.end()) {
+        return it->second;
+    }
+
+    if (image->filepath().empty()) {
+        ++m_skipped_images;
+        return std::nullopt;
+    }
+
+    auto id = (uint32_t)(m_image_ids.size() + 1);
+    m_encoder.define_image(id, to_utf8(image->filepath()));
+    m_image_ids[image.get()] = id;
+    m_resources.emplace_back(image);
+    return id;
+}
+
+void DrawCapture::encode(const DrawList::Command& cmd) {
+    using CommandType = DrawList::CommandType;
+
+    switch (cmd.type) {
+    case CommandType::TEXT:
+        if (cmd.font_resource != nullptr) {
+            m_encoder.text(font_id(cmd.font_resource), cmd.text_str(), cmd.text.x, cmd.text.y, cmd.text.color);
+        }
+        break;
+
+    case CommandType::FILL_RECT:
+        m_encoder.fill_rect(cmd.fill_rect.x, cmd.fill_rect.y, cmd.fill_rect.w, cmd.fill_rect.h, cmd.fill_rect.color);
+        break;
+
+    case CommandType::OUTLINE_RECT:
+        m_encoder.outline_rect(cmd.outline_rect.x, cmd.outline_rect.y, cmd.outline_rect.w, cmd.outline_rect.h,
+            cmd.outline_rect.thickness, cmd.outline_rect.color);
+        break;
+
+    case CommandType::ROUNDED_RECT:
+        m_encoder.rounded_rect(cmd.rounded_rect.x, cmd.rounded_rect.y, cmd.rounded_rect.w, cmd.rounded_rect.h, cmd.rounded_rect.rX,
+            cmd.rounded_rect.rY, cmd.rounded_rect.thickness, cmd.rounded_rect.color);
+        break;
+
+    case CommandType::FILL_ROUNDED_RECT:
+        m_encoder.fill_rounded_rect(cmd.rounded_rect.x, cmd.rounded_rect.y, cmd.rounded_rect.w, cmd.rounded_rect.h,
+            cmd.rounded_rect.rX, cmd.rounded_rect.rY, cmd.rounded_rect.color);
+        break;
+
+    case CommandType::QUAD:
+        m_encoder.quad(cmd.quad.x1, cmd.quad.y1, cmd.quad.x2, cmd.quad.y2, cmd.quad.x3, cmd.quad.y3, cmd.quad.x4, cmd.quad.y4,
+            cmd.quad.thickness, cmd.quad.color);
+        break;
+
+    case CommandType::FILL_QUAD:
+        m_encoder.fill_quad(cmd.fill_quad.x1, cmd.fill_quad.y1, cmd.fill_quad.x2, cmd.fill_quad.y2, cmd.fill_quad.x3,
+            cmd.fill_quad.y3, cmd.fill_quad.x4, cmd.fill_quad.y4, cmd.fill_quad.color);
+        break;
+
+    case CommandType::LINE:
+        m_encoder.line(cmd.line.x1, cmd.line.y1, cmd.line.x2, cmd.line.y2, cmd.line.thickness, cmd.line.color);
+        break;
+
+    case CommandType::IMAGE:
+        if (cmd.image_resource == nullptr) {
+            break;
+        }
+
+        if (auto id = image_id(cmd.image_resource)) {
+            m_encoder.image(*id, cmd.image.x, cmd.image.y, cmd.image.w, cmd.image.h, cmd.image.alpha);
+        }
+        break;
+
+    case CommandType::IMAGE_RECT:
+        if (cmd.image_resource == nullptr) {
+            break;
+        }
+
+        if (auto id = image_id(cmd.image_resource)) {
+            m_encoder.image(*id, cmd.image_rect.sx, cmd.image_rect.sy, cmd.image_rect.sw, cmd.image_rect.sh, cmd.image_rect.x,
+                cmd.image_rect.y, cmd.image_rect.w, cmd.image_rect.h, cmd.image_rect.alpha);
+        }
+        break;
+
+    case CommandType::FILL_CIRCLE:
+        m_encoder.fill_circle(
+            cmd.fill_circle.x, cmd.fill_circle.y, cmd.fill_circle.radiusX, cmd.fill_circle.radiusY, cmd.fill_circle.color);
+        break;
+
+    case CommandType::CIRCLE:
+        m_encoder.circle(cmd.circle.x, cmd.circle.y, cmd.circle.radiusX, cmd.circle.radiusY, cmd.circle.thickness, cmd.circle.color);
+        break;
+
+    case CommandType::PIE:
+        m_encoder.pie(cmd.pie.x, cmd.pie.y, cmd.pie.r, cmd.pie.startAngle, cmd.pie.sweepAngle, cmd.pie.color, cmd.pie.clockwise);
+        break;
+
+    case CommandType::OUTLINE_PIE:
+        m_encoder.outline_pie(cmd.outline_pie.x, cmd.outline_pie.y, cmd.outline_pie.r, cmd.outline_pie.startAngle,
+            cmd.outline_pie.sweepAngle, cmd.outline_pie.thickness, cmd.outline_pie.color, cmd.outline_pie.clockwise);
+        break;
+
+    case CommandType::RING:
+        m_encoder.ring(cmd.ring.x, cmd.ring.y, cmd.ring.outerRadius, cmd.ring.innerRadius, cmd.ring.startAngle, cmd.ring.sweepAngle,
+            cmd.ring.color, cmd.ring.clockwise);
+        break;
+
+    case CommandType::OUTLINE_RING:
+        m_encoder.outline_ring(cmd.outline_ring.x, cmd.outline_ring.y, cmd.outline_ring.outerRadius, cmd.outline_ring.innerRadius,
+            cmd.outline_ring.startAngle, cmd.outline_ring.sweepAngle, cmd.outline_ring.thickness, cmd.outline_ring.color,
+            cmd.outline_ring.clockwise);
+        break;
+
+    case CommandType::POLYLINE:
+        m_encoder.polyline(cmd.points(), (uint32_t)cmd.point_count(), cmd.polyline.thickness, cmd.polyline.color, cmd.polyline.closed);
+        break;
+
+    case CommandType::FILL_POLYGON:
+        m_encoder.fill_polygon(cmd.points(), (uint32_t)cmd.point_count(), cmd.fill_polygon.color);
+        break;
+
+    case CommandType::PUSH_TRANSFORM:
+        m_encoder.push_transform(cmd.transform.m11, cmd.transform.m12, cmd.transform.m21, cmd.transform.m22, cmd.transform.dx,
+            cmd.transform.dy);
+        ++m_transform_depth;
+        break;
+
+    // Extra pops don't do anything when drawn.
+    case CommandType::POP_TRANSFORM:
+        if (m_transform_depth > 0) {
+            m_encoder.pop_transform();
+            --m_transform_depth;
+        }
+        break;
+
+    case CommandType::PUSH_CLIP:
+        m_encoder.push_clip(cmd.clip.x, cmd.clip.y, cmd.clip.w, cmd.clip.h);
+        ++m_clip_depth;
+        break;
+
+    case CommandType::POP_CLIP:
+        if (m_clip_depth > 0) {
+            m_encoder.pop_clip();
+            --m_clip_depth;
+        }
+        break;
+    }
+}
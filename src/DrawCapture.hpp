@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "CaptureFile.hpp"
+#include "DrawList.hpp"
+
+// Writes what the renderer draws into a capture file (see CaptureFile.hpp), one frame per update. Fonts and images are written as
+// references, by file path or family name. Images made in memory have no path to refer to, their draws are left out and counted.
+class DrawCapture {
+public:
+    DrawCapture(const std::filesystem::path& path, uint32_t frames);
+
+    // Adds a frame made of the given batches, in order. Returns false once the requested number of frames has been written, the file is
+    // complete then.
+    bool add(const std::vector<DrawList::Batch*>& batches, uint32_t width, uint32_t height);
+
+    uint32_t captured() const { return m_captured; }
+    uint32_t frames() const { return m_frames; }
+    // Image draws left out because their image wasn't loaded from a file.
+    uint32_t skipped_images() const { return m_skipped_images; }
+    const auto& path() const { return m_path; }
+
+private:
+    std::filesystem::path m_path{};
+    std::ofstream m_file{};
+    uint32_t m_frames{};
+    uint32_t m_captured{};
+    uint32_t m_skipped_images{};
+    CaptureEncoder m_encoder{};
+    // Transforms and clips pushed and not yet popped in the batch being encoded.
+    uint32_t m_transform_depth{};
+    uint32_t m_clip_depth{};
+
+    // Resources are kept alive for the duration of the capture so their addresses can't be reused by something else.
+    std::unordered_map<const D2DFont*, uint32_t> m_font_ids{};
+    std::unordered_map<const D2DImage*, uint32_t> m_image_ids{};
+    std::vector<std::shared_ptr<void>> m_resources{};
+
+    uint32_t font_id(const std::shared_ptr<D2DFont>& font);
+    // Nothing for images made in memory.
+    std::optional<uint32_t> image_id(const std::shared_ptr<D2DImage>& image);
+    void encode(const DrawList::Command& cmd);
+};
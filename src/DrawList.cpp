@@ -1,17 +1,197 @@
+#include <algorithm>
+#include <cmath>
+
+#include "DrawBounds.hpp"
+#include "TextKey.hpp"
+
 #include "DrawList.hpp"
 
-void DrawList::CommandLock::text(std::shared_ptr<D2DFont>& font, std::string text, float x, float y, unsigned int color) {
+namespace {
+// Text only extends right and down from its origin. How far isn't known until layout, a far but finite edge keeps its bounds
+// meaningful under any transform.
+constexpr auto TEXT_EXTENT = 1e18f;
+
+// Strokes are centered on the outline but miter joins can reach further, up to half the default miter limit of 10 times the stroke.
+float stroke_pad(float thickness) {
+    return thickness * 5.0f + DrawBounds::PADDING;
+}
+
+DrawPrepass::Rect rect_bounds(float x, float y, float w, float h, float pad) {
+    // Negative sizes extend the other way.
+    return {std::min(x, x + w) - pad, std::min(y, y + h) - pad, std::max(x, x + w) + pad, std::max(y, y + h) + pad};
+}
+
+DrawPrepass::Rect ellipse_bounds(float x, float y, float rx, float ry, float pad) {
+    rx = std::abs(rx) + pad;
+    ry = std::abs(ry) + pad;
+    return {x - rx, y - ry, x + rx, y + ry};
+}
+
+// Conservative bounds of what a draw draws.
+DrawPrepass::Rect command_bounds(const DrawList::Command& cmd) {
+    using CommandType = DrawList::CommandType;
+    constexpr auto pad = DrawBounds::PADDING;
+
+    switch (cmd.type) {
+    case CommandType::TEXT: {
+        // Apart from overhangs that are well within a font size.
+        auto size = cmd.font_resource != nullptr ? DrawList::font_size(*cmd.font_resource) : 0.0f;
+        return {cmd.text.x - size, cmd.text.y - size, TEXT_EXTENT, TEXT_EXTENT};
+    }
+
+    case CommandType::FILL_RECT:
+        return rect_bounds(cmd.fill_rect.x, cmd.fill_rect.y, cmd.fill_rect.w, cmd.fill_rect.h, pad);
+
+    case CommandType::OUTLINE_RECT:
+        return rect_bounds(cmd.outline_rect.x, cmd.outline_rect.y, cmd.outline_rect.w, cmd.outline_rect.h,
+            stroke_pad(cmd.outline_rect.thickness));
+
+    case CommandType::ROUNDED_RECT:
+        return rect_bounds(cmd.rounded_rect.x, cmd.rounded_rect.y, cmd.rounded_rect.w, cmd.rounded_rect.h,
+            stroke_pad(cmd.rounded_rect.thickness));
+
+    case CommandType::FILL_ROUNDED_RECT:
+        return rect_bounds(cmd.rounded_rect.x, cmd.rounded_rect.y, cmd.rounded_rect.w, cmd.rounded_rect.h, pad);
+
+    case CommandType::QUAD: {
+        auto& q = cmd.quad;
+        float xy[]{q.x1, q.y1, q.x2, q.y2, q.x3, q.y3, q.x4, q.y4};
+        return DrawPrepass::point_bounds(xy, 4, stroke_pad(q.thickness));
+    }
+
+    case CommandType::FILL_QUAD: {
+        auto& q = cmd.fill_quad;
+        float xy[]{q.x1, q.y1, q.x2, q.y2, q.x3, q.y3, q.x4, q.y4};
+        return DrawPrepass::point_bounds(xy, 4, pad);
+    }
+
+    case CommandType::LINE: {
+        float xy[]{cmd.line.x1, cmd.line.y1, cmd.line.x2, cmd.line.y2};
+        return DrawPrepass::point_bounds(xy, 2, stroke_pad(cmd.line.thickness));
+    }
+
+    case CommandType::IMAGE:
+        return rect_bounds(cmd.image.x, cmd.image.y, cmd.image.w, cmd.image.h, pad);
+
+    case CommandType::IMAGE_RECT:
+        return rect_bounds(cmd.image_rect.x, cmd.image_rect.y, cmd.image_rect.w, cmd.image_rect.h, pad);
+
+    case CommandType::FILL_CIRCLE:
+        return ellipse_bounds(cmd.fill_circle.x, cmd.fill_circle.y, cmd.fill_circle.radiusX, cmd.fill_circle.radiusY, pad);
+
+    case CommandType::CIRCLE:
+        return ellipse_bounds(
+            cmd.circle.x, cmd.circle.y, cmd.circle.radiusX, cmd.circle.radiusY, stroke_pad(cmd.circle.thickness));
+
+    // Slices get the bounds of their whole circle.
+    case CommandType::PIE:
+        return ellipse_bounds(cmd.pie.x, cmd.pie.y, cmd.pie.r, cmd.pie.r, pad);
+
+    case CommandType::OUTLINE_PIE:
+        return ellipse_bounds(
+            cmd.outline_pie.x, cmd.outline_pie.y, cmd.outline_pie.r, cmd.outline_pie.r, stroke_pad(cmd.outline_pie.thickness));
+
+    case CommandType::RING:
+        return ellipse_bounds(cmd.ring.x, cmd.ring.y, cmd.ring.outerRadius, cmd.ring.outerRadius, pad);
+
+    case CommandType::OUTLINE_RING:
+        return ellipse_bounds(cmd.outline_ring.x, cmd.outline_ring.y, cmd.outline_ring.outerRadius, cmd.outline_ring.outerRadius,
+            stroke_pad(cmd.outline_ring.thickness));
+
+    case CommandType::POLYLINE:
+        return DrawPrepass::point_bounds(cmd.points(), cmd.point_count(), stroke_pad(cmd.polyline.thickness));
+
+    case CommandType::FILL_POLYGON:
+        return DrawPrepass::point_bounds(cmd.points(), cmd.point_count(), pad);
+
+    // Not drawn.
+    case CommandType::PUSH_TRANSFORM:
+    case CommandType::POP_TRANSFORM:
+    case CommandType::PUSH_CLIP:
+    case CommandType::POP_CLIP:
+        break;
+    }
+
+    return {};
+}
+
+// The color a draw is drawn in, images have none.
+uint32_t command_color(const DrawList::Command& cmd) {
+    using CommandType = DrawList::CommandType;
+
+    switch (cmd.type) {
+    case CommandType::TEXT:
+        return cmd.text.color;
+    case CommandType::FILL_RECT:
+        return cmd.fill_rect.color;
+    case CommandType::OUTLINE_RECT:
+        return cmd.outline_rect.color;
+    case CommandType::ROUNDED_RECT:
+    case CommandType::FILL_ROUNDED_RECT:
+        return cmd.rounded_rect.color;
+    case CommandType::QUAD:
+        return cmd.quad.color;
+    case CommandType::FILL_QUAD:
+        return cmd.fill_quad.color;
+    case CommandType::LINE:
+        return cmd.line.color;
+    case CommandType::FILL_CIRCLE:
+        return cmd.fill_circle.color;
+    case CommandType::CIRCLE:
+        return cmd.circle.color;
+    case CommandType::PIE:
+        return cmd.pie.color;
+    case CommandType::OUTLINE_PIE:
+        return cmd.outline_pie.color;
+    case CommandType::RING:
+        return cmd.ring.color;
+    case CommandType::OUTLINE_RING:
+        return cmd.outline_ring.color;
+    case CommandType::POLYLINE:
+        return cmd.polyline.color;
+    case CommandType::FILL_POLYGON:
+        return cmd.fill_polygon.color;
+    default:
+        return 0;
+    }
+}
+
+// Bounds of a draw under transform.
+DrawPrepass::Rect drawn_bounds(const DrawList::Command& cmd, const DrawPrepass::Transform& transform) {
+    auto bounds = command_bounds(cmd);
+    return transform.is_identity() ? bounds : DrawPrepass::transform_bounds(transform, bounds);
+}
+
+constexpr size_t POINT_SIZE = 2 * sizeof(float);
+} // namespace
+
+void DrawList::Recorder::text(std::shared_ptr<D2DFont>& font, std::string text, float x, float y, unsigned int color) {
     Command cmd{};
     cmd.type = CommandType::TEXT;
     cmd.text.x = x;
     cmd.text.y = y;
     cmd.text.color = color;
     cmd.str = std::move(text);
+    cmd.str_hash = TextKey::hash(cmd.str);
     cmd.font_resource = font;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::fill_rect(float x, float y, float w, float h, unsigned int color) {
+void DrawList::Recorder::text(
+    std::shared_ptr<D2DFont>& font, std::string_view text, std::shared_ptr<const void> owner, float x, float y, unsigned int color) {
+    Command cmd{};
+    cmd.type = CommandType::TEXT;
+    cmd.text.x = x;
+    cmd.text.y = y;
+    cmd.text.color = color;
+    cmd.str_view = text;
+    cmd.str_owner = std::move(owner);
+    cmd.str_hash = TextKey::hash(text);
+    cmd.font_resource = font;
+    push(std::move(cmd));
+}
+
+void DrawList::Recorder::fill_rect(float x, float y, float w, float h, unsigned int color) {
     Command cmd{};
     cmd.type = CommandType::FILL_RECT;
     cmd.fill_rect.x = x;
@@ -19,10 +199,10 @@ void DrawList::CommandLock::fill_rect(float x, float y, float w, float h, unsign
     cmd.fill_rect.w = w;
     cmd.fill_rect.h = h;
     cmd.fill_rect.color = color;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::outline_rect(float x, float y, float w, float h, float thickness, unsigned int color) {
+void DrawList::Recorder::outline_rect(float x, float y, float w, float h, float thickness, unsigned int color) {
     Command cmd{};
     cmd.type = CommandType::OUTLINE_RECT;
     cmd.outline_rect.x = x;
@@ -31,10 +211,10 @@ void DrawList::CommandLock::outline_rect(float x, float y, float w, float h, flo
     cmd.outline_rect.h = h;
     cmd.outline_rect.thickness = thickness;
     cmd.outline_rect.color = color;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::rounded_rect(float x, float y, float w, float h, float rX, float rY, float thickness, unsigned int color) {
+void DrawList::Recorder::rounded_rect(float x, float y, float w, float h, float rX, float rY, float thickness, unsigned int color) {
     Command cmd{};
     cmd.type = CommandType::ROUNDED_RECT;
     cmd.rounded_rect.x = x;
@@ -45,10 +225,10 @@ void DrawList::CommandLock::rounded_rect(float x, float y, float w, float h, flo
     cmd.rounded_rect.rY = rY;
     cmd.rounded_rect.thickness = thickness;
     cmd.rounded_rect.color = color;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::fill_rounded_rect(float x, float y, float w, float h, float rX, float rY, unsigned int color) {
+void DrawList::Recorder::fill_rounded_rect(float x, float y, float w, float h, float rX, float rY, unsigned int color) {
     Command cmd{};
     cmd.type = CommandType::FILL_ROUNDED_RECT;
     cmd.rounded_rect.x = x;
@@ -58,10 +238,10 @@ void DrawList::CommandLock::fill_rounded_rect(float x, float y, float w, float h
     cmd.rounded_rect.rX = rX;
     cmd.rounded_rect.rY = rY;
     cmd.rounded_rect.color = color;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::quad(
+void DrawList::Recorder::quad(
     float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, float thickness, unsigned int color) {
     Command cmd{};
     cmd.type = CommandType::QUAD;
@@ -75,10 +255,10 @@ void DrawList::CommandLock::quad(
     cmd.quad.y4 = y4;
     cmd.quad.thickness = thickness;
     cmd.quad.color = color;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::fill_quad(
+void DrawList::Recorder::fill_quad(
     float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, unsigned int color) {
     Command cmd{};
     cmd.type = CommandType::FILL_QUAD;
@@ -91,10 +271,10 @@ void DrawList::CommandLock::fill_quad(
     cmd.fill_quad.x4 = x4;
     cmd.fill_quad.y4 = y4;
     cmd.fill_quad.color = color;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::line(float x1, float y1, float x2, float y2, float thickness, unsigned int color) {
+void DrawList::Recorder::line(float x1, float y1, float x2, float y2, float thickness, unsigned int color) {
     Command cmd{};
     cmd.type = CommandType::LINE;
     cmd.line.x1 = x1;
@@ -103,10 +283,10 @@ void DrawList::CommandLock::line(float x1, float y1, float x2, float y2, float t
     cmd.line.y2 = y2;
     cmd.line.thickness = thickness;
     cmd.line.color = color;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::image(std::shared_ptr<D2DImage>& image, float x, float y, float w, float h, float alpha) {
+void DrawList::Recorder::image(std::shared_ptr<D2DImage>& image, float x, float y, float w, float h, float alpha) {
     Command cmd{};
     cmd.type = CommandType::IMAGE;
     cmd.image.x = x;
@@ -115,10 +295,27 @@ void DrawList::CommandLock::image(std::shared_ptr<D2DImage>& image, float x, flo
     cmd.image.h = h;
 	cmd.image.alpha = alpha;
     cmd.image_resource = image;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::fill_circle(float x, float y, float radiusX, float radiusY, unsigned int color) {
+void DrawList::Recorder::image_rect(
+    std::shared_ptr<D2DImage>& image, float sx, float sy, float sw, float sh, float x, float y, float w, float h, float alpha) {
+    Command cmd{};
+    cmd.type = CommandType::IMAGE_RECT;
+    cmd.image_rect.sx = sx;
+    cmd.image_rect.sy = sy;
+    cmd.image_rect.sw = sw;
+    cmd.image_rect.sh = sh;
+    cmd.image_rect.x = x;
+    cmd.image_rect.y = y;
+    cmd.image_rect.w = w;
+    cmd.image_rect.h = h;
+    cmd.image_rect.alpha = alpha;
+    cmd.image_resource = image;
+    push(std::move(cmd));
+}
+
+void DrawList::Recorder::fill_circle(float x, float y, float radiusX, float radiusY, unsigned int color) {
     Command cmd{};
     cmd.type = CommandType::FILL_CIRCLE;
     cmd.fill_circle.x = x;
@@ -126,10 +323,10 @@ void DrawList::CommandLock::fill_circle(float x, float y, float radiusX, float r
     cmd.fill_circle.radiusX = radiusX;
     cmd.fill_circle.radiusY = radiusY;
     cmd.fill_circle.color = color;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::circle(float x, float y, float radiusX, float radiusY, float thickness, unsigned int color) {
+void DrawList::Recorder::circle(float x, float y, float radiusX, float radiusY, float thickness, unsigned int color) {
     Command cmd{};
     cmd.type = CommandType::CIRCLE;
     cmd.circle.x = x;
@@ -138,10 +335,10 @@ void DrawList::CommandLock::circle(float x, float y, float radiusX, float radius
     cmd.circle.radiusY = radiusY;
     cmd.circle.thickness = thickness;
     cmd.circle.color = color;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::pie(float x, float y, float r, float startAngle, float sweepAngle, unsigned int color, bool clockwise) {
+void DrawList::Recorder::pie(float x, float y, float r, float startAngle, float sweepAngle, unsigned int color, bool clockwise) {
     Command cmd{};
     cmd.type = CommandType::PIE;
     cmd.pie.x = x;
@@ -151,10 +348,10 @@ void DrawList::CommandLock::pie(float x, float y, float r, float startAngle, flo
     cmd.pie.sweepAngle = sweepAngle;
     cmd.pie.color = color;
     cmd.pie.clockwise = clockwise;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::outline_pie(float x, float y, float r, float startAngle, float sweepAngle, float thickness, unsigned int color, bool clockwise) {
+void DrawList::Recorder::outline_pie(float x, float y, float r, float startAngle, float sweepAngle, float thickness, unsigned int color, bool clockwise) {
     Command cmd{};
     cmd.type = CommandType::OUTLINE_PIE;
     cmd.outline_pie.x = x;
@@ -165,10 +362,10 @@ void DrawList::CommandLock::outline_pie(float x, float y, float r, float startAn
     cmd.outline_pie.thickness = thickness;
     cmd.outline_pie.color = color;
     cmd.outline_pie.clockwise = clockwise;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::ring(float x, float y, float outerRadius, float innerRadius, float startAngle, float sweepAngle, unsigned int color, bool clockwise) {
+void DrawList::Recorder::ring(float x, float y, float outerRadius, float innerRadius, float startAngle, float sweepAngle, unsigned int color, bool clockwise) {
     Command cmd{};
     cmd.type = CommandType::RING;
     cmd.ring.x = x;
@@ -179,10 +376,10 @@ void DrawList::CommandLock::ring(float x, float y, float outerRadius, float inne
     cmd.ring.sweepAngle = sweepAngle;
     cmd.ring.color = color;
     cmd.ring.clockwise = clockwise;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
 }
 
-void DrawList::CommandLock::outline_ring(float x, float y, float outerRadius, float innerRadius, float startAngle, float sweepAngle,
+void DrawList::Recorder::outline_ring(float x, float y, float outerRadius, float innerRadius, float startAngle, float sweepAngle,
     float thickness, unsigned int color, bool clockwise) {
     Command cmd{};
     cmd.type = CommandType::OUTLINE_RING;
@@ -195,5 +392,160 @@ void DrawList::CommandLock::outline_ring(float x, float y, float outerRadius, fl
     cmd.outline_ring.thickness = thickness;
     cmd.outline_ring.color = color;
     cmd.outline_ring.clockwise = clockwise;
-    commands.emplace_back(std::move(cmd));
+    push(std::move(cmd));
+}
+
+void DrawList::Recorder::polyline(std::string points, float thickness, unsigned int color, bool closed) {
+    if (points.size() < 2 * POINT_SIZE) {
+        return;
+    }
+
+    Command cmd{};
+    cmd.type = CommandType::POLYLINE;
+    cmd.polyline.thickness = thickness;
+    cmd.polyline.color = color;
+    cmd.polyline.closed = closed;
+    cmd.str = std::move(points);
+    push(std::move(cmd));
+}
+
+void DrawList::Recorder::polyline(
+    std::string_view points, std::shared_ptr<const void> owner, float thickness, unsigned int color, bool closed) {
+    if (points.size() < 2 * POINT_SIZE) {
+        return;
+    }
+
+    Command cmd{};
+    cmd.type = CommandType::POLYLINE;
+    cmd.polyline.thickness = thickness;
+    cmd.polyline.color = color;
+    cmd.polyline.closed = closed;
+    cmd.str_view = points;
+    cmd.str_owner = std::move(owner);
+    push(std::move(cmd));
+}
+
+void DrawList::Recorder::fill_polygon(std::string points, unsigned int color) {
+    if (points.size() < 3 * POINT_SIZE) {
+        return;
+    }
+
+    Command cmd{};
+    cmd.type = CommandType::FILL_POLYGON;
+    cmd.fill_polygon.color = color;
+    cmd.str = std::move(points);
+    push(std::move(cmd));
+}
+
+void DrawList::Recorder::fill_polygon(std::string_view points, std::shared_ptr<const void> owner, unsigned int color) {
+    if (points.size() < 3 * POINT_SIZE) {
+        return;
+    }
+
+    Command cmd{};
+    cmd.type = CommandType::FILL_POLYGON;
+    cmd.fill_polygon.color = color;
+    cmd.str_view = points;
+    cmd.str_owner = std::move(owner);
+    push(std::move(cmd));
+}
+
+void DrawList::Recorder::push_transform(const DrawPrepass::Transform& transform) {
+    producer.state().push_transform(transform);
+
+    Command cmd{};
+    cmd.type = CommandType::PUSH_TRANSFORM;
+    cmd.transform.m11 = transform.m11;
+    cmd.transform.m12 = transform.m12;
+    cmd.transform.m21 = transform.m21;
+    cmd.transform.m22 = transform.m22;
+    cmd.transform.dx = transform.dx;
+    cmd.transform.dy = transform.dy;
+    push(std::move(cmd));
+}
+
+void DrawList::Recorder::pop_transform() {
+    if (!producer.state().pop_transform()) {
+        return;
+    }
+
+    Command cmd{};
+    cmd.type = CommandType::POP_TRANSFORM;
+    push(std::move(cmd));
+}
+
+void DrawList::Recorder::push_clip(float x, float y, float w, float h) {
+    // Negative sizes extend the other way.
+    float xy[]{x, y, x + w, y + h};
+    producer.state().push_clip(DrawPrepass::point_bounds(xy, 2, 0.0f));
+
+    Command cmd{};
+    cmd.type = CommandType::PUSH_CLIP;
+    cmd.clip.x = x;
+    cmd.clip.y = y;
+    cmd.clip.w = w;
+    cmd.clip.h = h;
+    push(std::move(cmd));
+}
+
+void DrawList::Recorder::pop_clip() {
+    if (!producer.state().pop_clip()) {
+        return;
+    }
+
+    Command cmd{};
+    cmd.type = CommandType::POP_CLIP;
+    push(std::move(cmd));
+}
+
+bool DrawList::Recorder::clipped(const Command& cmd) const {
+    auto& state = producer.state();
+    return is_draw(cmd.type) && state.clipped(drawn_bounds(cmd, state.transform));
+}
+
+DrawPrepass::Transform DrawList::Command::local_transform() const {
+    return {transform.m11, transform.m12, transform.m21, transform.m22, transform.dx, transform.dy};
+}
+
+void DrawList::prepare(const Batch& batch, float width, float height, Prepared& prepared) {
+    auto& draws = prepared.draws;
+    auto& stack = prepared.transforms;
+    stack.clear();
+
+    // Sized for every command to be a draw, then cut down to the draws there were.
+    draws.resize(batch.size());
+    size_t count = 0;
+
+    // Tracks the transforms the same way the painter will while replaying. The draws since the transform last changed are
+    // transformed together.
+    DrawPrepass::Transform transform{};
+    size_t run = 0;
+
+    auto end_run = [&] {
+        if (!transform.is_identity()) {
+            DrawPrepass::transform_bounds(transform, draws, run, count);
+        }
+
+        run = count;
+    };
+
+    for (auto& cmd : batch) {
+        // Clips were already applied while recording.
+        if (is_draw(cmd.type)) {
+            draws.set(count++, command_bounds(cmd), command_color(cmd));
+        } else if (cmd.type == CommandType::PUSH_TRANSFORM) {
+            end_run();
+            stack.push_back(transform);
+            transform = DrawPrepass::multiply(cmd.local_transform(), transform);
+        } else if (cmd.type == CommandType::POP_TRANSFORM && !stack.empty()) {
+            end_run();
+            transform = stack.back();
+            stack.pop_back();
+        }
+    }
+
+    end_run();
+    draws.resize(count);
+    DrawPrepass::cull(draws, {0.0f, 0.0f, width, height});
+    DrawPrepass::unpack_colors(draws);
 }
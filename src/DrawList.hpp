@@ -1,16 +1,22 @@
 #pragma once
 
 #include <memory>
-#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
-#include "D2DFont.hpp"
-#include "D2DImage.hpp"
+#include "DrawPrepass.hpp"
+#include "ProducerBuffers.hpp"
+
+// Only replay, in DrawListReplay.cpp, needs these. Recording and prepare build without D2D.
+class D2DFont;
+class D2DImage;
+class D2DPainter;
 
 class DrawList {
 public:
-    enum class CommandType { TEXT, FILL_RECT, OUTLINE_RECT, ROUNDED_RECT, FILL_ROUNDED_RECT, QUAD, FILL_QUAD, LINE, IMAGE, FILL_CIRCLE, CIRCLE, PIE, OUTLINE_PIE, RING, OUTLINE_RING };
+    // Draws, then the commands that change how later draws are drawn.
+    enum class CommandType { TEXT, FILL_RECT, OUTLINE_RECT, ROUNDED_RECT, FILL_ROUNDED_RECT, QUAD, FILL_QUAD, LINE, IMAGE, IMAGE_RECT, FILL_CIRCLE, CIRCLE, PIE, OUTLINE_PIE, RING, OUTLINE_RING, POLYLINE, FILL_POLYGON, PUSH_TRANSFORM, POP_TRANSFORM, PUSH_CLIP, POP_CLIP };
 
     struct Command {
         CommandType type;
@@ -92,6 +98,17 @@ public:
                 float h{};
 				float alpha{1.0f};
             } image;
+            struct {
+                float sx{};
+                float sy{};
+                float sw{};
+                float sh{};
+                float x{};
+                float y{};
+                float w{};
+                float h{};
+                float alpha{1.0f};
+            } image_rect;
             struct {
                 float x{};
                 float y{};
@@ -147,17 +164,71 @@ public:
                 unsigned int color{};
                 bool clockwise{};
             } outline_ring;
+            struct {
+                float thickness{};
+                unsigned int color{};
+                bool closed{};
+            } polyline;
+            struct {
+                unsigned int color{};
+            } fill_polygon;
+            // Relative to the transform in effect, see DrawPrepass::Transform.
+            struct {
+                float m11{};
+                float m12{};
+                float m21{};
+                float m22{};
+                float dx{};
+                float dy{};
+            } transform;
+            // In the coordinates of the transform in effect.
+            struct {
+                float x{};
+                float y{};
+                float w{};
+                float h{};
+            } clip;
         };
+        // TEXT's string, or the points of POLYLINE and FILL_POLYGON as packed x, y floats. Owned in str or borrowed through str_view
+        // from memory str_owner keeps alive. Use text_str() or points().
         std::string str{};
+        std::string_view str_view{};
+        std::shared_ptr<const void> str_owner{};
+        // TextKey::hash of the string.
+        size_t str_hash{};
         std::shared_ptr<D2DFont> font_resource{};
         std::shared_ptr<D2DImage> image_resource{};
+
+        std::string_view text_str() const { return str_owner != nullptr ? str_view : std::string_view{str}; }
+        const float* points() const { return (const float*)text_str().data(); }
+        size_t point_count() const { return text_str().size() / (2 * sizeof(float)); }
+        // PUSH_TRANSFORM's transform.
+        DrawPrepass::Transform local_transform() const;
     };
 
-    struct [[nodiscard]] CommandLock {
-        std::vector<Command>& commands;
-        std::scoped_lock<std::mutex> lock;
+    // What recording keeps track of per producer, to drop draws that the clip would hide before they're recorded.
+    using RecordState = DrawPrepass::RecordState;
+
+    using Producer = ProducerBuffers<Command, RecordState>::Producer;
+    using Batch = ProducerBuffers<Command, RecordState>::Batch;
+
+    // Lua scripts record with this order, producers with a lower one are drawn below them and higher ones on top.
+    static constexpr int LUA_ORDER = 0;
+
+    // Records into a producer's current batch, from the thread that owns the producer.
+    struct Recorder {
+        Producer& producer;
+
+        void push(Command&& cmd) {
+            if (producer.state().clips.empty() || !clipped(cmd)) {
+                producer.batch().emplace_back(std::move(cmd));
+            }
+        }
 
         void text(std::shared_ptr<D2DFont>& font, std::string text, float x, float y, unsigned int color);
+        // Borrows text instead of copying it. owner has to keep it alive and unchanged for as long as the command exists.
+        void text(std::shared_ptr<D2DFont>& font, std::string_view text, std::shared_ptr<const void> owner, float x, float y,
+            unsigned int color);
         void fill_rect(float x, float y, float w, float h, unsigned int color);
         void outline_rect(float x, float y, float w, float h, float thickness, unsigned int color);
         void rounded_rect(float x, float y, float w, float h, float rX, float rY, float thickness, unsigned int color);
@@ -166,6 +237,8 @@ public:
         void fill_quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, unsigned int color);
         void line(float x1, float y1, float x2, float y2, float thickness, unsigned int color);
         void image(std::shared_ptr<D2DImage>& image, float x, float y, float w, float h, float alpha = 1.0f);
+        void image_rect(std::shared_ptr<D2DImage>& image, float sx, float sy, float sw, float sh, float x, float y, float w, float h,
+            float alpha = 1.0f);
         void fill_circle(float x, float y, float radiusX, float radiusY, unsigned int color);
         void circle(float x, float y, float radiusX, float radiusY, float thickness, unsigned int color);
         void pie(float x, float y, float r, float startAngle, float sweepAngle, unsigned int color, bool clockwise);
@@ -173,11 +246,57 @@ public:
         void ring(float x, float y, float outerRadius, float innerRadius, float startAngle, float sweepAngle, unsigned int color, bool clockwise);
         void outline_ring(float x, float y, float outerRadius, float innerRadius, float startAngle, float sweepAngle, float thickness,
             unsigned int color, bool clockwise);
+        // points is packed x, y floats, trailing bytes that don't make a whole point are ignored. Polylines need at least 2 points and
+        // polygons 3, fewer draw nothing. The borrowing overloads work like text's.
+        void polyline(std::string points, float thickness, unsigned int color, bool closed);
+        void polyline(std::string_view points, std::shared_ptr<const void> owner, float thickness, unsigned int color, bool closed);
+        void fill_polygon(std::string points, unsigned int color);
+        void fill_polygon(std::string_view points, std::shared_ptr<const void> owner, unsigned int color);
+        // Applies transform to everything drawn until the matching pop, on top of the transforms already pushed. A batch starts out
+        // untransformed, pushes it leaves unpopped end with it and extra pops are ignored.
+        void push_transform(const DrawPrepass::Transform& transform);
+        void pop_transform();
+        // Clips everything drawn until the matching pop to the rectangle, within the clips already pushed. Under a rotation the
+        // rectangle's bounds are used. Draws entirely outside the clip aren't recorded at all. Unpopped clips and extra pops are
+        // treated like transforms.
+        void push_clip(float x, float y, float w, float h);
+        void pop_clip();
+
+    private:
+        // Whether a draw lies entirely outside the current clip.
+        bool clipped(const Command& cmd) const;
     };
 
-    auto acquire() { return CommandLock{m_commands, std::scoped_lock{m_commands_mux}}; }
+    // Every thread that wants to draw gets its own producer, recording never takes a lock.
+    auto create_producer(int order = LUA_ORDER) { return m_buffers.create_producer(order); }
+
+    // See ProducerBuffers. Only the render worker publishes, the batches stay valid until it publishes again.
+    const auto& publish() { return m_buffers.publish(); }
+    uint64_t submissions() const { return m_buffers.submissions(); }
+    size_t producer_count() { return m_buffers.producer_count(); }
+
+    // What prepare works out for a batch. Whoever replays keeps one, so its arrays are reused from batch to batch.
+    struct Prepared {
+        // One entry per draw command, in the order they were recorded.
+        DrawPrepass::Draws draws{};
+        std::vector<DrawPrepass::Transform> transforms{};
+    };
+
+    // Draws, as opposed to the commands that change how later draws are drawn.
+    static bool is_draw(CommandType type) { return type < CommandType::PUSH_TRANSFORM; }
+
+    // The size text bounds are padded by, defined with replay.
+    static float font_size(const D2DFont& font);
+
+    // Works out every draw's bounds once transformed and its color as float4, then flags the draws that fall entirely outside a
+    // surface of the given size.
+    static void prepare(const Batch& batch, float width, float height, Prepared& prepared);
+
+    // Draws a batch, skipping what prepare culls for the painter's surface and setting the colors it unpacked.
+    static void replay(D2DPainter& d2d, Batch& batch, Prepared& prepared);
+    // Draws a recorded command.
+    static void replay(D2DPainter& d2d, Command& cmd);
 
 private:
-    std::vector<Command> m_commands{};
-    std::mutex m_commands_mux{};
+    ProducerBuffers<Command, RecordState> m_buffers{};
 };
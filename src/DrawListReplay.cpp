@@ -0,0 +1,141 @@
+#include "D2DFont.hpp"
+#include "D2DPainter.hpp"
+
+#include "DrawList.hpp"
+
+float DrawList::font_size(const D2DFont& font) {
+    return (float)font.description().size;
+}
+
+void DrawList::replay(D2DPainter& d2d, Batch& batch, Prepared& prepared) {
+    auto [width, height] = d2d.surface_size();
+    prepare(batch, (float)width, (float)height, prepared);
+    auto& draws = prepared.draws;
+    size_t draw = 0;
+
+    for (auto& cmd : batch) {
+        if (!is_draw(cmd.type)) {
+            replay(d2d, cmd);
+            continue;
+        }
+
+        auto i = draw++;
+
+        if (draws.culled[i]) {
+            continue;
+        }
+
+        // The draw's own set_color then finds the brush already set.
+        if (cmd.type != CommandType::IMAGE && cmd.type != CommandType::IMAGE_RECT) {
+            d2d.set_color(draws.colors[i], draws.rgba[i]);
+        }
+
+        replay(d2d, cmd);
+    }
+
+    // Pushes the batch left unpopped don't carry over into the next one.
+    d2d.reset_clips();
+    d2d.reset_transform();
+}
+
+void DrawList::replay(D2DPainter& d2d, Command& cmd) {
+    switch (cmd.type) {
+    case CommandType::TEXT:
+        d2d.text(cmd.font_resource, cmd.text_str(), cmd.str_hash, cmd.text.x, cmd.text.y, cmd.text.color);
+        break;
+
+    case CommandType::FILL_RECT:
+        d2d.fill_rect(cmd.fill_rect.x, cmd.fill_rect.y, cmd.fill_rect.w, cmd.fill_rect.h, cmd.fill_rect.color);
+        break;
+
+    case CommandType::OUTLINE_RECT:
+        d2d.outline_rect(cmd.outline_rect.x, cmd.outline_rect.y, cmd.outline_rect.w, cmd.outline_rect.h,
+            cmd.outline_rect.thickness, cmd.outline_rect.color);
+        break;
+
+    case CommandType::ROUNDED_RECT:
+        d2d.rounded_rect(cmd.rounded_rect.x, cmd.rounded_rect.y, cmd.rounded_rect.w, cmd.rounded_rect.h,
+            cmd.rounded_rect.rX, cmd.rounded_rect.rY, cmd.rounded_rect.thickness, cmd.rounded_rect.color);
+        break;
+
+    case CommandType::FILL_ROUNDED_RECT:
+        d2d.fill_rounded_rect(cmd.rounded_rect.x, cmd.rounded_rect.y, cmd.rounded_rect.w, cmd.rounded_rect.h,
+            cmd.rounded_rect.rX, cmd.rounded_rect.rY, cmd.rounded_rect.color);
+        break;
+
+    case CommandType::QUAD:
+        d2d.quad(cmd.quad.x1, cmd.quad.y1, cmd.quad.x2, cmd.quad.y2, cmd.quad.x3, cmd.quad.y3, 
+            cmd.quad.x4, cmd.quad.y4, cmd.quad.thickness, cmd.quad.color);
+        break;
+
+    case CommandType::FILL_QUAD:
+        d2d.fill_quad(cmd.fill_quad.x1, cmd.fill_quad.y1, cmd.fill_quad.x2, cmd.fill_quad.y2, 
+            cmd.fill_quad.x3, cmd.fill_quad.y3, cmd.fill_quad.x4, cmd.fill_quad.y4, cmd.fill_quad.color);
+        break;
+
+    case CommandType::LINE:
+        d2d.line(cmd.line.x1, cmd.line.y1, cmd.line.x2, cmd.line.y2, cmd.line.thickness, cmd.line.color);
+        break;
+
+    case CommandType::IMAGE:
+        d2d.image(cmd.image_resource, cmd.image.x, cmd.image.y, cmd.image.w, cmd.image.h, cmd.image.alpha);
+        break;
+
+    case CommandType::IMAGE_RECT:
+        d2d.image(cmd.image_resource, cmd.image_rect.sx, cmd.image_rect.sy, cmd.image_rect.sw, cmd.image_rect.sh,
+            cmd.image_rect.x, cmd.image_rect.y, cmd.image_rect.w, cmd.image_rect.h, cmd.image_rect.alpha);
+        break;
+
+    case CommandType::FILL_CIRCLE:
+        d2d.fill_circle(
+            cmd.fill_circle.x, cmd.fill_circle.y, cmd.fill_circle.radiusX, cmd.fill_circle.radiusY, cmd.fill_circle.color);
+        break;
+
+    case CommandType::CIRCLE:
+        d2d.circle(cmd.circle.x, cmd.circle.y, cmd.circle.radiusX, cmd.circle.radiusY, cmd.circle.thickness, cmd.circle.color);
+        break;
+
+    case CommandType::PIE:
+        d2d.pie(cmd.pie.x, cmd.pie.y, cmd.pie.r, cmd.pie.startAngle, cmd.pie.sweepAngle, 0, cmd.pie.color, cmd.pie.clockwise);
+        break;
+
+    case CommandType::OUTLINE_PIE:
+        d2d.pie(cmd.outline_pie.x, cmd.outline_pie.y, cmd.outline_pie.r, cmd.outline_pie.startAngle,
+            cmd.outline_pie.sweepAngle, cmd.outline_pie.thickness, cmd.outline_pie.color, cmd.outline_pie.clockwise);
+        break;
+
+    case CommandType::RING:
+        d2d.ring(cmd.ring.x, cmd.ring.y, cmd.ring.outerRadius, cmd.ring.innerRadius, cmd.ring.startAngle, cmd.ring.sweepAngle,
+            0, cmd.ring.color, cmd.ring.clockwise);
+        break;
+
+    case CommandType::OUTLINE_RING:
+        d2d.ring(cmd.outline_ring.x, cmd.outline_ring.y, cmd.outline_ring.outerRadius, cmd.outline_ring.innerRadius,
+            cmd.outline_ring.startAngle, cmd.outline_ring.sweepAngle, cmd.outline_ring.thickness, cmd.outline_ring.color, cmd.outline_ring.clockwise);
+        break;
+
+    case CommandType::POLYLINE:
+        d2d.polyline(cmd.points(), cmd.point_count(), cmd.polyline.thickness, cmd.polyline.color, cmd.polyline.closed);
+        break;
+
+    case CommandType::FILL_POLYGON:
+        d2d.fill_polygon(cmd.points(), cmd.point_count(), cmd.fill_polygon.color);
+        break;
+
+    case CommandType::PUSH_TRANSFORM:
+        d2d.push_transform(cmd.local_transform());
+        break;
+
+    case CommandType::POP_TRANSFORM:
+        d2d.pop_transform();
+        break;
+
+    case CommandType::PUSH_CLIP:
+        d2d.push_clip(cmd.clip.x, cmd.clip.y, cmd.clip.w, cmd.clip.h);
+        break;
+
+    case CommandType::POP_CLIP:
+        d2d.pop_clip();
+        break;
+    }
+}
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Define DRAWPREPASS_SCALAR to use the scalar fallback even where SSE2 is available.
+#if !defined(DRAWPREPASS_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define DRAWPREPASS_SSE2
+#include <emmintrin.h>
+#endif
+
+// The work done before replay: conservative bounds for culling, transformed, and color unpacking. The single rect and color helpers
+// serve recording and the painter, the Draws passes run over a whole batch 4 draws at a time. Uses SSE2 when available with a scalar
+// fallback, both produce identical results for finite input.
+namespace DrawPrepass {
+struct Rect {
+    float left{};
+    float top{};
+    float right{};
+    float bottom{};
+};
+
+// A 2D affine transform laid out like D2D1_MATRIX_3X2_F. Points are row vectors, (x, y) maps to
+// (x * m11 + y * m21 + dx, x * m12 + y * m22 + dy).
+struct Transform {
+    float m11{1.0f};
+    float m12{};
+    float m21{};
+    float m22{1.0f};
+    float dx{};
+    float dy{};
+
+    // Scales, then rotates clockwise by rotation degrees, then moves the origin to (x, y).
+    static Transform make(float x, float y, float rotation, float scale_x, float scale_y) {
+        auto radians = rotation * 0.017453292f;
+        auto c = std::cos(radians);
+        auto s = std::sin(radians);
+        return Transform{c * scale_x, s * scale_x, -s * scale_y, c * scale_y, x, y};
+    }
+
+    bool is_translation() const { return m11 == 1.0f && m12 == 0.0f && m21 == 0.0f && m22 == 1.0f; }
+    bool is_identity() const { return is_translation() && dx == 0.0f && dy == 0.0f; }
+};
+
+// a, then b.
+inline Transform multiply(const Transform& a, const Transform& b) {
+    return Transform{a.m11 * b.m11 + a.m12 * b.m21, a.m11 * b.m12 + a.m12 * b.m22, a.m21 * b.m11 + a.m22 * b.m21,
+        a.m21 * b.m12 + a.m22 * b.m22, a.dx * b.m11 + a.dy * b.m21 + b.dx, a.dx * b.m12 + a.dy * b.m22 + b.dy};
+}
+
+// 0xAARRGGBB to straight r, g, b, a in [0, 1].
+inline void unpack_color(uint32_t color, float rgba[4]) {
+#ifdef DRAWPREPASS_SSE2
+    auto zero = _mm_setzero_si128();
+    auto bgra = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)color), zero), zero);
+    auto f = _mm_mul_ps(_mm_cvtepi32_ps(bgra), _mm_set1_ps(1.0f / 255.0f));
+    _mm_storeu_ps(rgba, _mm_shuffle_ps(f, f, _MM_SHUFFLE(3, 0, 1, 2)));
+#else
+    rgba[0] = (float)((color >> 16) & 0xFF) * (1.0f / 255.0f);
+    rgba[1] = (float)((color >> 8) & 0xFF) * (1.0f / 255.0f);
+    rgba[2] = (float)(color & 0xFF) * (1.0f / 255.0f);
+    rgba[3] = (float)(color >> 24) * (1.0f / 255.0f);
+#endif
+}
+
+// Bounds of count x, y pairs grown by pad on every side. count must be at least 1.
+inline Rect point_bounds(const float* xy, size_t count, float pad) {
+#ifdef DRAWPREPASS_SSE2
+    // Two points per register, x y x y.
+    auto lo = _mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)xy));
+    lo = _mm_movelh_ps(lo, lo);
+    auto hi = lo;
+    size_t i = 1;
+
+    for (; i + 2 <= count; i += 2) {
+        auto p = _mm_loadu_ps(xy + i * 2);
+        lo = _mm_min_ps(lo, p);
+        hi = _mm_max_ps(hi, p);
+    }
+
+    if (i < count) {
+        auto p = _mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)(xy + i * 2)));
+        p = _mm_movelh_ps(p, p);
+        lo = _mm_min_ps(lo, p);
+        hi = _mm_max_ps(hi, p);
+    }
+
+    lo = _mm_min_ps(lo, _mm_movehl_ps(lo, lo));
+    hi = _mm_max_ps(hi, _mm_movehl_ps(hi, hi));
+
+    auto vpad = _mm_set1_ps(pad);
+    alignas(16) float out[4];
+    _mm_store_ps(out, _mm_movelh_ps(_mm_sub_ps(lo, vpad), _mm_add_ps(hi, vpad)));
+    return Rect{out[0], out[1], out[2], out[3]};
+#else
+    Rect r{xy[0], xy[1], xy[0], xy[1]};
+
+    for (size_t i = 1; i < count; ++i) {
+        auto x = xy[i * 2];
+        auto y = xy[i * 2 + 1];
+        r.left = x < r.left ? x : r.left;
+        r.top = y < r.top ? y : r.top;
+        r.right = x > r.right ? x : r.right;
+        r.bottom = y > r.bottom ? y : r.bottom;
+    }
+
+    return Rect{r.left - pad, r.top - pad, r.right + pad, r.bottom + pad};
+#endif
+}
+
+// Bounds of r's four corners after t. r has to be finite.
+inline Rect transform_bounds(const Transform& t, const Rect& r) {
+#ifdef DRAWPREPASS_SSE2
+    // The corners as x x x x and y y y y.
+    auto xs = _mm_setr_ps(r.left, r.right, r.left, r.right);
+    auto ys = _mm_setr_ps(r.top, r.top, r.bottom, r.bottom);
+    auto tx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xs, _mm_set1_ps(t.m11)), _mm_mul_ps(ys, _mm_set1_ps(t.m21))), _mm_set1_ps(t.dx));
+    auto ty = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xs, _mm_set1_ps(t.m12)), _mm_mul_ps(ys, _mm_set1_ps(t.m22))), _mm_set1_ps(t.dy));
+
+    // x y x y, reduced like point_bounds.
+    auto lo = _mm_min_ps(_mm_unpacklo_ps(tx, ty), _mm_unpackhi_ps(tx, ty));
+    auto hi = _mm_max_ps(_mm_unpacklo_ps(tx, ty), _mm_unpackhi_ps(tx, ty));
+    lo = _mm_min_ps(lo, _mm_movehl_ps(lo, lo));
+    hi = _mm_max_ps(hi, _mm_movehl_ps(hi, hi));
+
+    alignas(16) float out[4];
+    _mm_store_ps(out, _mm_movelh_ps(lo, hi));
+    return Rect{out[0], out[1], out[2], out[3]};
+#else
+    float xy[8];
+    float xs[4]{r.left, r.right, r.left, r.right};
+    float ys[4]{r.top, r.top, r.bottom, r.bottom};
+
+    for (int i = 0; i < 4; ++i) {
+        xy[i * 2] = xs[i] * t.m11 + ys[i] * t.m21 + t.dx;
+        xy[i * 2 + 1] = xs[i] * t.m12 + ys[i] * t.m22 + t.dy;
+    }
+
+    return point_bounds(xy, 4, 0.0f);
+#endif
+}
+
+// Whether r misses area entirely. NaN bounds are never outside.
+inline bool outside(const Rect& r, const Rect& area) {
+#ifdef DRAWPREPASS_SSE2
+    // left >= area.right, top >= area.bottom, -right >= -area.left, -bottom >= -area.top.
+    auto sign = _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f);
+    auto flipped = _mm_xor_ps(_mm_loadu_ps(&r.left), sign);
+    auto limits = _mm_xor_ps(_mm_setr_ps(area.right, area.bottom, area.left, area.top), sign);
+    return _mm_movemask_ps(_mm_cmpge_ps(flipped, limits)) != 0;
+#else
+    return r.left >= area.right || r.top >= area.bottom || r.right <= area.left || r.bottom <= area.top;
+#endif
+}
+
+// Where a and b overlap. If they don't, an inverted rect that everything is outside of.
+inline Rect intersect(const Rect& a, const Rect& b) {
+    Rect r{a.left > b.left ? a.left : b.left, a.top > b.top ? a.top : b.top, a.right < b.right ? a.right : b.right,
+        a.bottom < b.bottom ? a.bottom : b.bottom};
+
+    if (!(r.left < r.right && r.top < r.bottom)) {
+        auto inf = std::numeric_limits<float>::infinity();
+        return Rect{inf, inf, -inf, -inf};
+    }
+
+    return r;
+}
+
+// 0xAARRGGBB unpacked by unpack_color, laid out like D2D1_COLOR_F.
+struct Color {
+    float r{};
+    float g{};
+    float b{};
+    float a{};
+};
+
+// What the pre-pass keeps per draw, each in an array of its own so the passes below can take 4 draws at a time.
+struct Draws {
+    std::vector<float> left{};
+    std::vector<float> top{};
+    std::vector<float> right{};
+    std::vector<float> bottom{};
+    std::vector<uint32_t> colors{};
+    // Set by unpack_colors and cull.
+    std::vector<Color> rgba{};
+    std::vector<uint8_t> culled{};
+
+    size_t size() const { return left.size(); }
+
+    void resize(size_t count) {
+        left.resize(count);
+        top.resize(count);
+        right.resize(count);
+        bottom.resize(count);
+        colors.resize(count);
+        rgba.resize(count);
+        culled.resize(count);
+    }
+
+    void set(size_t i, const Rect& bounds, uint32_t color) {
+        left[i] = bounds.left;
+        top[i] = bounds.top;
+        right[i] = bounds.right;
+        bottom[i] = bounds.bottom;
+        colors[i] = color;
+    }
+};
+
+// Replaces the bounds of draws first up to last with their bounds after t, the same as transform_bounds on each. They have to be
+// finite.
+inline void transform_bounds(const Transform& t, Draws& draws, size_t first, size_t last) {
+    size_t i = first;
+
+#ifdef DRAWPREPASS_SSE2
+    auto m11 = _mm_set1_ps(t.m11);
+    auto m12 = _mm_set1_ps(t.m12);
+    auto m21 = _mm_set1_ps(t.m21);
+    auto m22 = _mm_set1_ps(t.m22);
+    auto dx = _mm_set1_ps(t.dx);
+    auto dy = _mm_set1_ps(t.dy);
+
+    for (; i + 4 <= last; i += 4) {
+        auto l = _mm_loadu_ps(draws.left.data() + i);
+        auto tp = _mm_loadu_ps(draws.top.data() + i);
+        auto r = _mm_loadu_ps(draws.right.data() + i);
+        auto b = _mm_loadu_ps(draws.bottom.data() + i);
+
+        // The corners in the order transform_bounds takes them: left top, right top, left bottom, right bottom.
+        auto lx = _mm_mul_ps(l, m11);
+        auto rx = _mm_mul_ps(r, m11);
+        auto ty = _mm_mul_ps(tp, m21);
+        auto by = _mm_mul_ps(b, m21);
+        auto x0 = _mm_add_ps(_mm_add_ps(lx, ty), dx);
+        auto x1 = _mm_add_ps(_mm_add_ps(rx, ty), dx);
+        auto x2 = _mm_add_ps(_mm_add_ps(lx, by), dx);
+        auto x3 = _mm_add_ps(_mm_add_ps(rx, by), dx);
+
+        lx = _mm_mul_ps(l, m12);
+        rx = _mm_mul_ps(r, m12);
+        ty = _mm_mul_ps(tp, m22);
+        by = _mm_mul_ps(b, m22);
+        auto y0 = _mm_add_ps(_mm_add_ps(lx, ty), dy);
+        auto y1 = _mm_add_ps(_mm_add_ps(rx, ty), dy);
+        auto y2 = _mm_add_ps(_mm_add_ps(lx, by), dy);
+        auto y3 = _mm_add_ps(_mm_add_ps(rx, by), dy);
+
+        // Reduced in the scalar point_bounds' order and with its operand order, so ties between zeros come out the same.
+        _mm_storeu_ps(draws.left.data() + i, _mm_min_ps(x3, _mm_min_ps(x2, _mm_min_ps(x1, x0))));
+        _mm_storeu_ps(draws.top.data() + i, _mm_min_ps(y3, _mm_min_ps(y2, _mm_min_ps(y1, y0))));
+        _mm_storeu_ps(draws.right.data() + i, _mm_max_ps(x3, _mm_max_ps(x2, _mm_max_ps(x1, x0))));
+        _mm_storeu_ps(draws.bottom.data() + i, _mm_max_ps(y3, _mm_max_ps(y2, _mm_max_ps(y1, y0))));
+    }
+#endif
+
+    for (; i < last; ++i) {
+        auto r = transform_bounds(t, Rect{draws.left[i], draws.top[i], draws.right[i], draws.bottom[i]});
+        draws.left[i] = r.left;
+        draws.top[i] = r.top;
+        draws.right[i] = r.right;
+        draws.bottom[i] = r.bottom;
+    }
+}
+
+// Sets culled for the draws entirely outside area, like outside.
+inline void cull(Draws& draws, const Rect& area) {
+    size_t i = 0;
+
+#ifdef DRAWPREPASS_SSE2
+    auto right = _mm_set1_ps(area.right);
+    auto bottom = _mm_set1_ps(area.bottom);
+    auto left = _mm_set1_ps(area.left);
+    auto top = _mm_set1_ps(area.top);
+
+    for (; i + 4 <= draws.size(); i += 4) {
+        auto past = _mm_or_ps(_mm_cmpge_ps(_mm_loadu_ps(draws.left.data() + i), right),
+            _mm_cmpge_ps(_mm_loadu_ps(draws.top.data() + i), bottom));
+        auto before = _mm_or_ps(_mm_cmple_ps(_mm_loadu_ps(draws.right.data() + i), left),
+            _mm_cmple_ps(_mm_loadu_ps(draws.bottom.data() + i), top));
+        auto mask = _mm_movemask_ps(_mm_or_ps(past, before));
+
+        for (auto j = 0; j < 4; ++j) {
+            draws.culled[i + j] = (uint8_t)((mask >> j) & 1);
+        }
+    }
+#endif
+
+    for (; i < draws.size(); ++i) {
+        draws.culled[i] = outside(Rect{draws.left[i], draws.top[i], draws.right[i], draws.bottom[i]}, area);
+    }
+}
+
+// Fills rgba from colors, like unpack_color.
+inline void unpack_colors(Draws& draws) {
+    size_t i = 0;
+
+#ifdef DRAWPREPASS_SSE2
+    auto byte = _mm_set1_epi32(0xFF);
+    auto scale = _mm_set1_ps(1.0f / 255.0f);
+
+    for (; i + 4 <= draws.size(); i += 4) {
+        auto c = _mm_loadu_si128((const __m128i*)(draws.colors.data() + i));
+        auto r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(c, 16), byte)), scale);
+        auto g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(c, 8), byte)), scale);
+        auto b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(c, byte)), scale);
+        auto a = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(c, 24)), scale);
+
+        // Channel per register to color per register.
+        _MM_TRANSPOSE4_PS(r, g, b, a);
+        _mm_storeu_ps(&draws.rgba[i].r, r);
+        _mm_storeu_ps(&draws.rgba[i + 1].r, g);
+        _mm_storeu_ps(&draws.rgba[i + 2].r, b);
+        _mm_storeu_ps(&draws.rgba[i + 3].r, a);
+    }
+#endif
+
+    for (; i < draws.size(); ++i) {
+        unpack_color(draws.colors[i], &draws.rgba[i].r);
+    }
+}
+
+// The transform and clip stacks as recording sees them, to drop draws the clip hides before they're recorded. The clip is kept in
+// size coordinates, under a rotation that's the bounds of the rotated rectangle. Pops without a matching push are ignored and return
+// false.
+struct RecordState {
+    Transform transform{};
+    // Only meaningful while clips isn't empty.
+    Rect clip{};
+    // What to restore on pop.
+    std::vector<Transform> transforms{};
+    std::vector<Rect> clips{};
+
+    void push_transform(const Transform& t) {
+        transforms.push_back(transform);
+        transform = multiply(t, transform);
+    }
+
+    bool pop_transform() {
+        if (transforms.empty()) {
+            return false;
+        }
+
+        transform = transforms.back();
+        transforms.pop_back();
+        return true;
+    }
+
+    // r is in the current transform's coordinates and has to be finite.
+    void push_clip(const Rect& r) {
+        auto transformed = transform.is_identity() ? r : transform_bounds(transform, r);
+        clips.push_back(clip);
+        clip = clips.size() > 1 ? intersect(transformed, clip) : transformed;
+    }
+
+    bool pop_clip() {
+        if (clips.empty()) {
+            return false;
+        }
+
+        clip = clips.back();
+        clips.pop_back();
+        return true;
+    }
+
+    // Whether bounds in size coordinates are entirely hidden by the clip.
+    bool clipped(const Rect& bounds) const { return !clips.empty() && outside(bounds, clip); }
+
+    void clear() {
+        transform = {};
+        transforms.clear();
+        clips.clear();
+    }
+};
+} // namespace DrawPrepass
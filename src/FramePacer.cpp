@@ -0,0 +1,96 @@
+#include <algorithm>
+
+#include "FramePacer.hpp"
+
+FramePacer::FramePacer(double rate) {
+    set_rate(rate);
+}
+
+bool FramePacer::begin_update(Clock::time_point now, uint64_t presents) {
+    if (mode() == Mode::PRESENT) {
+        // Throttling skips extra presents on top of the requested interval.
+        auto n = (uint64_t)std::max(1.0, (double)m_present_interval / m_scale + 0.5);
+
+        // The present this is called in counts as the first one.
+        if (!m_scheduled) {
+            m_last_present = presents - 1;
+            m_scheduled = true;
+        }
+
+        if (presents - m_last_present < n) {
+            return false;
+        }
+
+        m_last_present = presents;
+    } else {
+        auto step = std::chrono::duration_cast<Clock::duration>(interval());
+
+        if (!m_scheduled) {
+            m_next = now;
+            m_scheduled = true;
+        }
+
+        if (now < m_next) {
+            return false;
+        }
+
+        m_next += step;
+
+        if (now - m_next > step * MAX_CATCH_UP) {
+            m_dropped += (uint64_t)((now - m_next) / step);
+            m_next = now + step;
+        }
+    }
+
+    m_update_start = now;
+    return true;
+}
+
+void FramePacer::end_update(Clock::time_point now) {
+    Duration cost = now - m_update_start;
+
+    m_average_cost = m_updates == 0 ? cost : m_average_cost + (cost - m_average_cost) * COST_SMOOTHING;
+    ++m_updates;
+
+    adapt();
+}
+
+void FramePacer::set_rate(double hz) {
+    hz = std::max(hz, 1.0);
+
+    // Scripts tend to reapply their settings every update, which shouldn't reset the schedule.
+    if (hz == m_rate) {
+        return;
+    }
+
+    m_rate = hz;
+    m_scale = 1.0;
+    m_scheduled = false;
+}
+
+void FramePacer::set_present_interval(uint32_t n) {
+    if (n == m_present_interval) {
+        return;
+    }
+
+    m_present_interval = n;
+    m_scheduled = false;
+}
+
+void FramePacer::set_budget(Duration budget) {
+    m_budget = budget;
+
+    if (m_budget <= Duration::zero()) {
+        m_scale = 1.0;
+    }
+}
+
+void FramePacer::adapt() {
+    if (m_budget <= Duration::zero()) {
+        return;
+    }
+
+    // Draw functions cost about the same no matter how often they run, so an update that goes over budget has its rate scaled down
+    // until the time spent per second matches what running at the requested rate within budget would have cost.
+    m_scale = std::clamp(m_budget / m_average_cost, MIN_ADAPTIVE_SCALE, 1.0);
+}
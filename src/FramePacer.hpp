@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Decides when scripts get to run their draw functions. Callers pass the current time in, which keeps the pacer free of any clock
+// and lets it be driven by a fake one.
+//
+// In time mode updates are scheduled on a fixed timestep: the deadline advances by exactly one interval per update instead of being
+// reset from "now", so the average rate matches the requested one. Falling a few intervals behind is caught up by updating on
+// consecutive presents, falling further behind drops the backlog. In present mode an update happens every n presents instead, counted
+// by the caller since draw functions don't necessarily get a chance to run exactly once per present.
+//
+// With a budget set, the time spent in draw functions is measured and the update rate is lowered in proportion while it runs over
+// budget, going back to the requested rate once it fits again.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Duration = std::chrono::duration<double>;
+
+    enum class Mode { TIME, PRESENT };
+
+    static constexpr double DEFAULT_RATE = 60.0;
+
+    // How many intervals behind the schedule may get before the backlog is dropped rather than caught up.
+    static constexpr int MAX_CATCH_UP = 3;
+
+    // The adaptive rate never drops below this fraction of the requested rate.
+    static constexpr double MIN_ADAPTIVE_SCALE = 0.25;
+
+    FramePacer(double rate = DEFAULT_RATE);
+
+    // Call whenever the draw functions could run, with how many presents there have been so far. Returns true when they should run,
+    // in which case end_update must follow.
+    bool begin_update(Clock::time_point now, uint64_t presents);
+    void end_update(Clock::time_point now);
+
+    void set_rate(double hz);
+    auto rate() const { return m_rate; }
+
+    // The rate updates actually happen at once adaptive throttling has been applied.
+    double effective_rate() const { return m_rate * m_scale; }
+
+    // n > 0 switches to updating every n presents, 0 goes back to time mode.
+    void set_present_interval(uint32_t n);
+    auto present_interval() const { return m_present_interval; }
+    auto mode() const { return m_present_interval > 0 ? Mode::PRESENT : Mode::TIME; }
+
+    // A zero budget turns adaptive throttling off.
+    void set_budget(Duration budget);
+    auto budget() const { return m_budget; }
+
+    // Smoothed time spent between begin_update and end_update.
+    auto average_cost() const { return m_average_cost; }
+
+    auto updates() const { return m_updates; }
+    auto dropped() const { return m_dropped; }
+
+private:
+    // Weight of the newest sample in the cost average.
+    static constexpr double COST_SMOOTHING = 0.1;
+
+    double m_rate{};
+    double m_scale{1.0};
+    uint32_t m_present_interval{};
+    // The present count of the last update in present mode.
+    uint64_t m_last_present{};
+    Duration m_budget{};
+    Duration m_average_cost{};
+
+    bool m_scheduled{};
+    Clock::time_point m_next{};
+    Clock::time_point m_update_start{};
+
+    uint64_t m_updates{};
+    uint64_t m_dropped{};
+
+    Duration interval() const { return Duration{1.0 / effective_rate()}; }
+    void adapt();
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+// Result of polling one slot of GPU timestamps.
+struct GpuTiming {
+    enum class State {
+        // The GPU hasn't gotten there yet.
+        PENDING,
+        READY,
+        // Finished but unusable, e.g. the clock changed frequency in between.
+        INVALID,
+    };
+
+    State state{State::PENDING};
+    double ms{};
+};
+
+// Bookkeeping for GPU timestamps that are read back asynchronously a few frames after being recorded. The API specifics are left to
+// Source, which has to provide:
+//
+//     void begin(size_t slot);         // record the start timestamp into slot
+//     void end(size_t slot);           // record the end timestamp and queue its readback
+//     GpuTiming poll(size_t slot);     // never blocks
+//
+// Slots are recycled in order. If every slot is still waiting on the GPU the measurement is skipped rather than stalling.
+// begin/end/collect are meant to be called from a single thread, stats() from any.
+template <typename Source, size_t SLOTS = 8, size_t WINDOW = 64> class GpuTimerRing {
+public:
+    struct Stats {
+        uint64_t samples{};
+        // Measurements skipped because every slot was busy, or discarded as invalid.
+        uint64_t dropped{};
+        double last_ms{};
+        // Over the last WINDOW samples.
+        double average_ms{};
+        double max_ms{};
+    };
+
+    template <typename... Args>
+    explicit GpuTimerRing(Args&&... args)
+        : m_source{std::forward<Args>(args)...} {}
+
+    auto& source() { return m_source; }
+
+    // Returns false if the measurement was skipped, end() is a no-op then.
+    bool begin() {
+        if (m_state[m_next] != SlotState::FREE) {
+            std::scoped_lock _{m_stats_mtx};
+            ++m_stats.dropped;
+            m_recording = false;
+            return false;
+        }
+
+        m_source.begin(m_next);
+        m_state[m_next] = SlotState::RECORDING;
+        m_recording = true;
+        return true;
+    }
+
+    void end() {
+        if (!m_recording) {
+            return;
+        }
+
+        m_source.end(m_next);
+        m_state[m_next] = SlotState::PENDING;
+        m_next = (m_next + 1) % SLOTS;
+        m_recording = false;
+    }
+
+    // Folds finished slots into the stats, oldest first. Stops at the first one still pending since the GPU finishes them in order.
+    void collect() {
+        for (auto i = 0u; i < SLOTS; ++i) {
+            auto slot = (m_next + i) % SLOTS;
+
+            if (m_state[slot] != SlotState::PENDING) {
+                continue;
+            }
+
+            auto timing = m_source.poll(slot);
+
+            if (timing.state == GpuTiming::State::PENDING) {
+                break;
+            }
+
+            m_state[slot] = SlotState::FREE;
+            record(timing);
+        }
+    }
+
+    Stats stats() {
+        std::scoped_lock _{m_stats_mtx};
+        return m_stats;
+    }
+
+    size_t pending() const {
+        size_t count{};
+
+        for (auto state : m_state) {
+            count += state == SlotState::PENDING ? 1 : 0;
+        }
+
+        return count;
+    }
+
+private:
+    enum class SlotState { FREE, RECORDING, PENDING };
+
+    Source m_source;
+    std::array<SlotState, SLOTS> m_state{};
+    size_t m_next{};
+    bool m_recording{};
+
+    std::array<double, WINDOW> m_window{};
+    size_t m_window_size{};
+    size_t m_window_next{};
+
+    std::mutex m_stats_mtx{};
+    Stats m_stats{};
+
+    void record(const GpuTiming& timing) {
+        std::scoped_lock _{m_stats_mtx};
+
+        if (timing.state != GpuTiming::State::READY) {
+            ++m_stats.dropped;
+            return;
+        }
+
+        m_window[m_window_next] = timing.ms;
+        m_window_next = (m_window_next + 1) % WINDOW;
+        m_window_size = m_window_size < WINDOW ? m_window_size + 1 : WINDOW;
+
+        auto sum = 0.0;
+        auto max = 0.0;
+
+        for (auto i = 0u; i < m_window_size; ++i) {
+            sum += m_window[i];
+            max = m_window[i] > max ? m_window[i] : max;
+        }
+
+        ++m_stats.samples;
+        m_stats.last_ms = timing.ms;
+        m_stats.average_ms = sum / m_window_size;
+        m_stats.max_ms = max;
+    }
+};
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "ImageAtlas.hpp"
+
+ImageAtlas::ImageAtlas(ComPtr<ID2D1DeviceContext> context)
+    : m_context{std::move(context)} {
+}
+
+std::optional<ImageAtlas::Slot> ImageAtlas::resolve(const std::shared_ptr<D2DImage>& image) {
+    auto it = m_entries.find(image.get());
+
+    // A dead entry at the same address belongs to an image that has since been destroyed.
+    if (it != m_entries.end() && it->second.image.expired()) {
+        m_pages[it->second.page]->packer.release(it->second.rect);
+        m_entries.erase(it);
+        it = m_entries.end();
+    }
+
+    if (it == m_entries.end()) {
+        if (!is_eligible(*image)) {
+            return std::nullopt;
+        }
+
+        auto entry = insert(image);
+
+        if (!entry) {
+            return std::nullopt;
+        }
+
+        it = m_entries.emplace(image.get(), *entry).first;
+    }
+
+    const auto& entry = it->second;
+    const auto& r = entry.rect;
+
+    return Slot{m_pages[entry.page]->bitmap.Get(),
+        {(float)(r.x + GUTTER), (float)(r.y + GUTTER), (float)(r.x + r.w - GUTTER), (float)(r.y + r.h - GUTTER)}};
+}
+
+void ImageAtlas::collect() {
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->second.image.expired()) {
+            m_pages[it->second.page]->packer.release(it->second.rect);
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool ImageAtlas::is_eligible(const D2DImage& image) const {
+    auto [w, h] = image.size();
+
+    // Entries are filled from the CPU copy, so block compressed images (which don't keep one) stay standalone. So do images whose
+    // contents change, the atlas copy would go stale.
+    return !image.is_dynamic() && !image.pixels().empty() && w <= MAX_IMAGE_SIZE && h <= MAX_IMAGE_SIZE;
+}
+
+std::optional<ImageAtlas::Entry> ImageAtlas::insert(const std::shared_ptr<D2DImage>& image) {
+    auto [image_w, image_h] = image->size();
+    auto w = (int)image_w + GUTTER * 2;
+    auto h = (int)image_h + GUTTER * 2;
+
+    auto place = [&](size_t page_index) -> std::optional<Entry> {
+        auto& page = *m_pages[page_index];
+        auto rect = page.packer.insert(w, h);
+
+        if (!rect) {
+            return std::nullopt;
+        }
+
+        copy(page.bitmap.Get(), *rect, image->pixels().data(), image_w, image_h);
+
+        return Entry{image, page_index, *rect};
+    };
+
+    for (size_t i = 0; i < m_pages.size(); ++i) {
+        if (auto entry = place(i)) {
+            return entry;
+        }
+    }
+
+    for (size_t i = 0; i < m_pages.size(); ++i) {
+        if (m_pages[i]->packer.fragmentation() >= REPACK_THRESHOLD) {
+            repack(i);
+
+            if (auto entry = place(i)) {
+                return entry;
+            }
+        }
+    }
+
+    if (m_pages.size() >= MAX_PAGES) {
+        return std::nullopt;
+    }
+
+    m_pages.push_back(create_page());
+
+    return place(m_pages.size() - 1);
+}
+
+std::unique_ptr<ImageAtlas::Page> ImageAtlas::create_page() {
+    auto page = std::make_unique<Page>();
+    auto props = D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_NONE, D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
+
+    if (FAILED(m_context->CreateBitmap(D2D1::SizeU(PAGE_SIZE, PAGE_SIZE), nullptr, 0, props, &page->bitmap))) {
+        throw std::runtime_error{"Failed to create D2D atlas page"};
+    }
+
+    return page;
+}
+
+void ImageAtlas::repack(size_t page_index) {
+    auto& old_page = m_pages[page_index];
+    auto new_page = create_page();
+    std::vector<std::pair<const D2DImage*, Entry*>> live{};
+    std::vector<const D2DImage*> dropped{};
+
+    for (auto& [key, entry] : m_entries) {
+        if (entry.page == page_index) {
+            live.emplace_back(key, &entry);
+        }
+    }
+
+    // Tallest first packs noticeably tighter with a skyline packer.
+    std::sort(live.begin(), live.end(), [](const auto& a, const auto& b) { return a.second->rect.h > b.second->rect.h; });
+
+    for (auto& [key, entry] : live) {
+        auto& r = entry->rect;
+        auto rect = new_page->packer.insert(r.w, r.h);
+
+        // Insertion order differs from the original so this can fail in theory, the image just gets re-added on its next draw.
+        if (!rect) {
+            dropped.push_back(key);
+            continue;
+        }
+
+        D2D1_POINT_2U dst{(UINT32)rect->x, (UINT32)rect->y};
+        D2D1_RECT_U src{(UINT32)r.x, (UINT32)r.y, (UINT32)(r.x + r.w), (UINT32)(r.y + r.h)};
+        new_page->bitmap->CopyFromBitmap(&dst, old_page->bitmap.Get(), &src);
+        r = *rect;
+    }
+
+    for (auto key : dropped) {
+        m_entries.erase(key);
+    }
+
+    old_page = std::move(new_page);
+}
+
+void ImageAtlas::copy(ID2D1Bitmap* dst, const RectPacker::Rect& dst_rect, const uint8_t* pixels, UINT32 w, UINT32 h) {
+    auto x = (UINT32)(dst_rect.x + GUTTER);
+    auto y = (UINT32)(dst_rect.y + GUTTER);
+    auto pitch = w * 4;
+
+    D2D1_RECT_U rect{x, y, x + w, y + h};
+    dst->CopyFromMemory(&rect, pixels, pitch);
+
+    // Extrude the edges into the gutter.
+    D2D1_RECT_U top{x, y - 1, x + w, y};
+    dst->CopyFromMemory(&top, pixels, pitch);
+
+    D2D1_RECT_U bottom{x, y + h, x + w, y + h + 1};
+    dst->CopyFromMemory(&bottom, pixels + (size_t)(h - 1) * pitch, pitch);
+
+    D2D1_RECT_U left{x - 1, y, x, y + h};
+    dst->CopyFromMemory(&left, pixels, pitch);
+
+    D2D1_RECT_U right{x + w, y, x + w + 1, y + h};
+    dst->CopyFromMemory(&right, pixels + (size_t)(w - 1) * 4, pitch);
+}
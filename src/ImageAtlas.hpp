@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <d2d1_3.h>
+#include <wrl.h>
+
+#include "D2DImage.hpp"
+#include "RectPacker.hpp"
+
+// Packs small images into a handful of shared page bitmaps the first time they're drawn so runs of icon draws hit the same bitmap.
+// Entries are keyed by image and dropped once the image is destroyed, pages that fill up with dead entries get repacked.
+class ImageAtlas {
+public:
+    template <typename T> using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+    static constexpr int PAGE_SIZE = 2048;
+    static constexpr size_t MAX_PAGES = 4;
+    static constexpr UINT32 MAX_IMAGE_SIZE = 128;
+
+    struct Slot {
+        ID2D1Bitmap* bitmap{};
+        D2D1_RECT_F rect{};
+    };
+
+    ImageAtlas(ComPtr<ID2D1DeviceContext> context);
+
+    // Returns where the image lives in the atlas, packing it first if needed. Returns nothing for images that aren't eligible
+    // (too big, compressed, dynamic) or when there is no room left.
+    std::optional<Slot> resolve(const std::shared_ptr<D2DImage>& image);
+
+    // Releases the space of entries whose images have been destroyed.
+    void collect();
+
+    auto page_count() const { return m_pages.size(); }
+    auto entry_count() const { return m_entries.size(); }
+
+private:
+    // Each entry is surrounded by a 1 pixel gutter holding a copy of its edge pixels so linear filtering doesn't bleed neighbours in.
+    static constexpr int GUTTER = 1;
+
+    // Pages with at least this much dead space get repacked before we give up on an insert.
+    static constexpr float REPACK_THRESHOLD = 0.25f;
+
+    struct Page {
+        ComPtr<ID2D1Bitmap1> bitmap{};
+        RectPacker packer{PAGE_SIZE, PAGE_SIZE};
+    };
+
+    struct Entry {
+        std::weak_ptr<D2DImage> image{};
+        size_t page{};
+        RectPacker::Rect rect{};
+    };
+
+    ComPtr<ID2D1DeviceContext> m_context{};
+    std::vector<std::unique_ptr<Page>> m_pages{};
+    std::unordered_map<const D2DImage*, Entry> m_entries{};
+
+    bool is_eligible(const D2DImage& image) const;
+    std::optional<Entry> insert(const std::shared_ptr<D2DImage>& image);
+    std::unique_ptr<Page> create_page();
+    void repack(size_t page_index);
+    void copy(ID2D1Bitmap* dst, const RectPacker::Rect& dst_rect, const uint8_t* pixels, UINT32 w, UINT32 h);
+};
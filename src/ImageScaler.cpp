@@ -0,0 +1,87 @@
+// Define IMAGESCALER_SCALAR to use the scalar fallback even where SSE2 is available.
+#if !defined(IMAGESCALER_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define IMAGESCALER_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "ImageScaler.hpp"
+
+namespace {
+void downsample_row_scalar(const uint8_t* r0, const uint8_t* r1, uint32_t x_begin, uint32_t w, uint8_t* out) {
+    auto dst_w = ImageScaler::half(w);
+
+    for (auto x = x_begin; x < dst_w; ++x) {
+        auto x0 = x * 2;
+        auto x1 = x0 + 1 < w ? x0 + 1 : x0;
+
+        for (auto c = 0; c < 4; ++c) {
+            auto sum = r0[x0 * 4 + c] + r0[x1 * 4 + c] + r1[x0 * 4 + c] + r1[x1 * 4 + c];
+            out[x * 4 + c] = (uint8_t)((sum + 2) >> 2);
+        }
+    }
+}
+
+#ifdef IMAGESCALER_SSE2
+// Produces 2 destination pixels from 4 source pixels of each row.
+__m128i downsample_4px(__m128i a, __m128i b) {
+    auto zero = _mm_setzero_si128();
+
+    // Vertical sums, 16 bits per channel: {p0, p1} and {p2, p3}.
+    auto s01 = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+    auto s23 = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+    // Horizontal sums land in the low 64 bits of each.
+    auto h01 = _mm_add_epi16(s01, _mm_srli_si128(s01, 8));
+    auto h23 = _mm_add_epi16(s23, _mm_srli_si128(s23, 8));
+
+    auto sum = _mm_unpacklo_epi64(h01, h23);
+    return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+}
+
+uint32_t downsample_row_sse2(const uint8_t* r0, const uint8_t* r1, uint32_t w, uint8_t* out) {
+    // Only full pairs of source pixels go through SSE, an odd trailing column is left to the scalar path.
+    auto pairs = w / 2;
+    auto x = 0u;
+
+    for (; x + 4 <= pairs; x += 4) {
+        auto a0 = _mm_loadu_si128((const __m128i*)(r0 + x * 8));
+        auto a1 = _mm_loadu_si128((const __m128i*)(r0 + x * 8 + 16));
+        auto b0 = _mm_loadu_si128((const __m128i*)(r1 + x * 8));
+        auto b1 = _mm_loadu_si128((const __m128i*)(r1 + x * 8 + 16));
+
+        auto lo = downsample_4px(a0, b0);
+        auto hi = downsample_4px(a1, b1);
+        _mm_storeu_si128((__m128i*)(out + x * 4), _mm_packus_epi16(lo, hi));
+    }
+
+    for (; x + 2 <= pairs; x += 2) {
+        auto a = _mm_loadu_si128((const __m128i*)(r0 + x * 8));
+        auto b = _mm_loadu_si128((const __m128i*)(r1 + x * 8));
+        _mm_storel_epi64((__m128i*)(out + x * 4), _mm_packus_epi16(downsample_4px(a, b), _mm_setzero_si128()));
+    }
+
+    return x;
+}
+#endif
+} // namespace
+
+namespace ImageScaler {
+void downsample_2x(const uint8_t* src, uint32_t w, uint32_t h, size_t src_pitch, uint8_t* dst, size_t dst_pitch) {
+    auto dst_h = half(h);
+
+    for (auto y = 0u; y < dst_h; ++y) {
+        auto y0 = y * 2;
+        auto y1 = y0 + 1 < h ? y0 + 1 : y0;
+        auto r0 = src + y0 * src_pitch;
+        auto r1 = src + y1 * src_pitch;
+        auto out = dst + y * dst_pitch;
+        auto x = 0u;
+
+#ifdef IMAGESCALER_SSE2
+        x = downsample_row_sse2(r0, r1, w, out);
+#endif
+
+        downsample_row_scalar(r0, r1, x, w, out);
+    }
+}
+} // namespace ImageScaler
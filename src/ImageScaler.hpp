@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CPU image reduction used to build mip levels of 32bpp premultiplied images.
+namespace ImageScaler {
+// Size of the next level down, (n + 1) / 2 in each dimension so odd edges are kept.
+constexpr uint32_t half(uint32_t n) {
+    return n > 1 ? (n + 1) / 2 : 1;
+}
+
+// 2x2 box filter from src (w x h) into dst (half(w) x half(h)). An odd last row/column is averaged with itself. Uses SSE2 when
+// available with a scalar fallback, both produce identical results.
+void downsample_2x(const uint8_t* src, uint32_t w, uint32_t h, size_t src_pitch, uint8_t* dst, size_t dst_pitch);
+} // namespace ImageScaler
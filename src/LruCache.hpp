@@ -1,11 +1,13 @@
 #pragma once
 
+#include <functional>
 #include <list>
 #include <optional>
 #include <tuple>
 #include <unordered_map>
 
-template <typename KeyT, typename ValueT> class LruCache {
+// Hash and KeyEqual can be transparent, get and has then take anything they accept, without constructing a KeyT.
+template <typename KeyT, typename ValueT, typename Hash = std::hash<KeyT>, typename KeyEqual = std::equal_to<KeyT>> class LruCache {
 public:
     LruCache(size_t max_size)
         : m_max_size{max_size} {}
@@ -29,7 +31,7 @@ public:
         }
     }
 
-    std::optional<std::reference_wrapper<const ValueT>> get(const KeyT& key) {
+    template <typename K = KeyT> std::optional<std::reference_wrapper<const ValueT>> get(const K& key) {
         auto it = m_cache.find(key);
 
         if (it == m_cache.end()) {
@@ -41,7 +43,7 @@ public:
         return std::cref(std::get<1>(*(it->second)));
     }
 
-    auto has(const KeyT& key) { return m_cache.find(key) != m_cache.end(); }
+    template <typename K = KeyT> auto has(const K& key) { return m_cache.find(key) != m_cache.end(); }
 
     auto size() const { return m_cache.size(); }
 
@@ -50,6 +52,6 @@ private:
     using ListIterator = typename std::list<KeyValue>::iterator;
 
     std::list<KeyValue> m_lru{};
-    std::unordered_map<KeyT, ListIterator> m_cache{};
+    std::unordered_map<KeyT, ListIterator, Hash, KeyEqual> m_cache{};
     size_t m_max_size{};
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <exception>
+#include <memory>
+
+#include "sol/sol.hpp"
+
+// Helpers for bindings written directly against the Lua C API, for the calls scripts make many times a frame where sol2's per call
+// overhead shows: optional arguments taken as sol::object take a registry reference each, and sol::variadic_results allocates.
+//
+// The readers raise Lua errors on bad arguments. Lua is built as C so those longjmp, read every argument before anything with a
+// destructor is alive and do the rest in protect.
+namespace lua_stack {
+inline float number(lua_State* l, int idx) {
+    return (float)luaL_checknumber(l, idx);
+}
+
+// Colors are usually integers but any number is accepted, like sol2 does.
+inline unsigned int color(lua_State* l, int idx) {
+    if (lua_isinteger(l, idx)) {
+        return (unsigned int)lua_tointeger(l, idx);
+    }
+
+    return (unsigned int)(lua_Integer)luaL_checknumber(l, idx);
+}
+
+// Arguments of any other type count as missing, like the sol::object::is checks they replace.
+inline float opt_number(lua_State* l, int idx, float fallback) {
+    return lua_type(l, idx) == LUA_TNUMBER ? (float)lua_tonumber(l, idx) : fallback;
+}
+
+inline bool opt_bool(lua_State* l, int idx, bool fallback) {
+    return lua_type(l, idx) == LUA_TBOOLEAN ? lua_toboolean(l, idx) != 0 : fallback;
+}
+
+// A usertype held by shared_ptr, the way sol2 would pass it to a std::shared_ptr<T>& parameter. name is used in the error message.
+template <typename T> std::shared_ptr<T>& shared(lua_State* l, int idx, const char* name) {
+    if (!sol::stack::check<std::shared_ptr<T>>(l, idx, &sol::no_panic)) {
+        luaL_typeerror(l, idx, name);
+    }
+
+    return sol::stack::get<std::shared_ptr<T>&>(l, idx);
+}
+
+// Runs fn, returning its number of results. Exceptions become Lua errors once fn's frame and the exception are gone.
+template <typename Fn> int protect(lua_State* l, Fn&& fn) {
+    try {
+        return fn();
+    } catch (const std::exception& e) {
+        lua_pushstring(l, e.what());
+    }
+
+    return lua_error(l);
+}
+} // namespace lua_stack
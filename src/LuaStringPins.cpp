@@ -0,0 +1,57 @@
+#include "LuaStringPins.hpp"
+
+LuaStringPins::Table::~Table() {
+    if (ref == LUA_NOREF) {
+        return;
+    }
+
+    std::scoped_lock _{released->mtx};
+
+    if (!released->closed) {
+        released->refs.push_back(ref);
+    }
+}
+
+LuaStringPins::LuaStringPins(lua_State* l)
+    : m_lua{l} {
+    begin_update();
+}
+
+LuaStringPins::~LuaStringPins() {
+    std::scoped_lock _{m_released->mtx};
+    m_released->closed = true;
+}
+
+void LuaStringPins::begin_update() {
+    auto table = std::make_shared<Table>();
+    table->released = m_released;
+    m_table = table.get();
+    m_owner = std::move(table);
+
+    std::vector<int> refs{};
+    {
+        std::scoped_lock _{m_released->mtx};
+        refs.swap(m_released->refs);
+    }
+
+    for (auto ref : refs) {
+        luaL_unref(m_lua, LUA_REGISTRYINDEX, ref);
+    }
+}
+
+void LuaStringPins::pin(int idx) {
+    idx = lua_absindex(m_lua, idx);
+
+    if (m_table->ref == LUA_NOREF) {
+        lua_newtable(m_lua);
+        m_table->ref = luaL_ref(m_lua, LUA_REGISTRYINDEX);
+    }
+
+    // Keyed by the string object rather than its contents. Long strings compare by content, so an equal string that's already pinned
+    // wouldn't keep this one alive. Scripts tend to draw the same strings over and over, those are only stored once.
+    lua_rawgeti(m_lua, LUA_REGISTRYINDEX, m_table->ref);
+    lua_pushlightuserdata(m_lua, const_cast<void*>(lua_topointer(m_lua, idx)));
+    lua_pushvalue(m_lua, idx);
+    lua_rawset(m_lua, -3);
+    lua_pop(m_lua, 1);
+}
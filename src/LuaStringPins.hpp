@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "sol/sol.hpp"
+
+// Keeps Lua strings alive while draw commands point at their bytes, so text doesn't have to be copied into every command. Lua strings
+// never change, pinning one is enough. Strings are pinned in a registry table per update, which is released once the last command
+// recorded in that update is gone, from whichever thread that happens on.
+//
+// Everything but destroying the owners is for the thread holding the Lua lock.
+class LuaStringPins {
+public:
+    explicit LuaStringPins(lua_State* l);
+    LuaStringPins(const LuaStringPins&) = delete;
+    LuaStringPins& operator=(const LuaStringPins&) = delete;
+    // Doesn't touch the Lua state, it's about to be closed. Commands still holding an owner must not be drawn after this.
+    ~LuaStringPins();
+
+    // Starts pinning into a new table, and releases the tables of earlier updates that no command holds anymore.
+    void begin_update();
+
+    // Pins the string at idx for as long as owner() of this update is held. Raises a Lua error if it runs out of memory.
+    void pin(int idx);
+    const std::shared_ptr<const void>& owner() const { return m_owner; }
+
+private:
+    // Registry references whose commands are gone, waiting for the Lua thread to release them.
+    struct Released {
+        std::mutex mtx{};
+        std::vector<int> refs{};
+        bool closed{};
+    };
+
+    struct Table {
+        std::shared_ptr<Released> released{};
+        int ref{LUA_NOREF};
+
+        ~Table();
+    };
+
+    lua_State* m_lua{};
+    std::shared_ptr<Released> m_released{std::make_shared<Released>()};
+    std::shared_ptr<const void> m_owner{};
+    // The table behind m_owner, only created once something is pinned.
+    Table* m_table{};
+};
@@ -0,0 +1,374 @@
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+#include "utf8.h"
+
+#include "reframework-d2d/API.h"
+
+#include "NativeApi.hpp"
+
+struct REFD2DLayer_ {
+    std::shared_ptr<DrawList::Producer> producer{};
+    std::string name{};
+};
+
+struct REFD2DFont_ {
+    std::shared_ptr<D2DFont> font{};
+};
+
+struct REFD2DImage_ {
+    std::shared_ptr<D2DImage> image{};
+};
+
+namespace {
+DrawList* g_drawlist{};
+std::function<const D2DPainter::Factories&()> g_factories{};
+std::atomic<uint64_t> g_surface_size{};
+
+thread_local std::string t_last_error{};
+
+std::filesystem::path to_path(const char* utf8_path) {
+    if (utf8_path == nullptr) {
+        throw std::runtime_error{"Null path"};
+    }
+
+    std::string narrow{utf8_path};
+    std::wstring wide{};
+    utf8::utf8to16(narrow.begin(), narrow.end(), std::back_inserter(wide));
+    return wide;
+}
+
+// Nothing may throw across the C boundary. Failures are kept for last_error and the function returns fallback instead.
+template <typename Fn, typename Result = std::invoke_result_t<Fn>> Result guarded(Fn&& fn, Result fallback = {}) {
+    try {
+        return fn();
+    } catch (const std::exception& e) {
+        t_last_error = e.what();
+    } catch (...) {
+        t_last_error = "Unknown error";
+    }
+
+    return fallback;
+}
+
+template <typename Fn> void record(REFD2DLayerHandle layer, Fn&& fn) {
+    if (layer == nullptr) {
+        t_last_error = "Null layer";
+        return;
+    }
+
+    guarded([&] {
+        DrawList::Recorder cmds{*layer->producer};
+        fn(cmds);
+        return true;
+    }, false);
+}
+
+const char* last_error() { return t_last_error.c_str(); }
+
+void surface_size(uint32_t* width, uint32_t* height) {
+    if (width == nullptr || height == nullptr) {
+        t_last_error = "Null width or height";
+        return;
+    }
+
+    std::tie(*width, *height) = NativeApi::surface_size();
+}
+
+REFD2DLayerHandle create_layer(const char* name, int order) {
+    return guarded([&]() -> REFD2DLayerHandle {
+        if (g_drawlist == nullptr) {
+            throw std::runtime_error{"reframework-d2d isn't initialized"};
+        }
+
+        return new REFD2DLayer_{g_drawlist->create_producer(order), name != nullptr ? name : ""};
+    });
+}
+
+void destroy_layer(REFD2DLayerHandle layer) { delete layer; }
+
+void begin(REFD2DLayerHandle layer) {
+    if (layer != nullptr) {
+        layer->producer->reset();
+    }
+}
+
+void submit(REFD2DLayerHandle layer) {
+    if (layer != nullptr) {
+        guarded([&] {
+            layer->producer->submit();
+            return true;
+        }, false);
+    }
+}
+
+REFD2DFontHandle create_font(const char* family, int size, bool bold, bool italic) {
+    if (family == nullptr) {
+        t_last_error = "Null family";
+        return nullptr;
+    }
+
+    return guarded([&]() -> REFD2DFontHandle {
+        auto font = std::make_shared<D2DFont>(g_factories().dwrite, family, size, bold, italic);
+        return new REFD2DFont_{std::move(font)};
+    });
+}
+
+REFD2DFontHandle load_font(const char* filepath, const char* family, int size, bool bold, bool italic) {
+    return guarded([&]() -> REFD2DFontHandle {
+        auto path = to_path(filepath);
+
+        if (!std::filesystem::is_regular_file(path)) {
+            throw std::runtime_error{"Font file not found"};
+        }
+
+        auto font = std::make_shared<D2DFont>(g_factories().dwrite, path, family != nullptr ? family : "", size, bold, italic);
+        return new REFD2DFont_{std::move(font)};
+    });
+}
+
+void destroy_font(REFD2DFontHandle font) { delete font; }
+
+bool measure_text(REFD2DFontHandle font, const char* text, float* width, float* height) {
+    if (font == nullptr || text == nullptr) {
+        t_last_error = "Null font or text";
+        return false;
+    }
+
+    if (width == nullptr || height == nullptr) {
+        t_last_error = "Null width or height";
+        return false;
+    }
+
+    return guarded([&] {
+        std::tie(*width, *height) = font->font->measure(text);
+        return true;
+    }, false);
+}
+
+REFD2DImageHandle load_image(const char* filepath) {
+    return guarded([&]() -> REFD2DImageHandle {
+        auto path = to_path(filepath);
+
+        if (!std::filesystem::is_regular_file(path)) {
+            throw std::runtime_error{"Image file not found"};
+        }
+
+        return new REFD2DImage_{std::make_shared<D2DImage>(g_factories().wic, path)};
+    });
+}
+
+void destroy_image(REFD2DImageHandle image) { delete image; }
+
+void image_size(REFD2DImageHandle image, uint32_t* width, uint32_t* height) {
+    if (width == nullptr || height == nullptr) {
+        t_last_error = "Null width or height";
+        return;
+    }
+
+    if (image == nullptr) {
+        *width = *height = 0;
+        return;
+    }
+
+    std::tie(*width, *height) = image->image->size();
+}
+
+void text(REFD2DLayerHandle layer, REFD2DFontHandle font, const char* text, float x, float y, uint32_t color) {
+    if (font == nullptr || text == nullptr) {
+        t_last_error = "Null font or text";
+        return;
+    }
+
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.text(font->font, text, x, y, color); });
+}
+
+void fill_rect(REFD2DLayerHandle layer, float x, float y, float w, float h, uint32_t color) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.fill_rect(x, y, w, h, color); });
+}
+
+void outline_rect(REFD2DLayerHandle layer, float x, float y, float w, float h, float thickness, uint32_t color) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.outline_rect(x, y, w, h, thickness, color); });
+}
+
+void rounded_rect(REFD2DLayerHandle layer, float x, float y, float w, float h, float rx, float ry, float thickness, uint32_t color) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.rounded_rect(x, y, w, h, rx, ry, thickness, color); });
+}
+
+void fill_rounded_rect(REFD2DLayerHandle layer, float x, float y, float w, float h, float rx, float ry, uint32_t color) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.fill_rounded_rect(x, y, w, h, rx, ry, color); });
+}
+
+void quad(REFD2DLayerHandle layer, float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, float thickness,
+    uint32_t color) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.quad(x1, y1, x2, y2, x3, y3, x4, y4, thickness, color); });
+}
+
+void fill_quad(REFD2DLayerHandle layer, float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, uint32_t color) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.fill_quad(x1, y1, x2, y2, x3, y3, x4, y4, color); });
+}
+
+void line(REFD2DLayerHandle layer, float x1, float y1, float x2, float y2, float thickness, uint32_t color) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.line(x1, y1, x2, y2, thickness, color); });
+}
+
+void image(REFD2DLayerHandle layer, REFD2DImageHandle image, float x, float y, float w, float h, float alpha) {
+    if (image == nullptr) {
+        t_last_error = "Null image";
+        return;
+    }
+
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.image(image->image, x, y, w, h, alpha); });
+}
+
+void image_rect(REFD2DLayerHandle layer, REFD2DImageHandle image, float sx, float sy, float sw, float sh, float x, float y, float w,
+    float h, float alpha) {
+    if (image == nullptr) {
+        t_last_error = "Null image";
+        return;
+    }
+
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.image_rect(image->image, sx, sy, sw, sh, x, y, w, h, alpha); });
+}
+
+void fill_circle(REFD2DLayerHandle layer, float x, float y, float rx, float ry, uint32_t color) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.fill_circle(x, y, rx, ry, color); });
+}
+
+void circle(REFD2DLayerHandle layer, float x, float y, float rx, float ry, float thickness, uint32_t color) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.circle(x, y, rx, ry, thickness, color); });
+}
+
+void pie(REFD2DLayerHandle layer, float x, float y, float r, float start_angle, float sweep_angle, uint32_t color, bool clockwise) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.pie(x, y, r, start_angle, sweep_angle, color, clockwise); });
+}
+
+void outline_pie(REFD2DLayerHandle layer, float x, float y, float r, float start_angle, float sweep_angle, float thickness,
+    uint32_t color, bool clockwise) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.outline_pie(x, y, r, start_angle, sweep_angle, thickness, color, clockwise); });
+}
+
+void ring(REFD2DLayerHandle layer, float x, float y, float outer_radius, float inner_radius, float start_angle, float sweep_angle,
+    uint32_t color, bool clockwise) {
+    record(layer,
+        [&](DrawList::Recorder& cmds) { cmds.ring(x, y, outer_radius, inner_radius, start_angle, sweep_angle, color, clockwise); });
+}
+
+void outline_ring(REFD2DLayerHandle layer, float x, float y, float outer_radius, float inner_radius, float start_angle,
+    float sweep_angle, float thickness, uint32_t color, bool clockwise) {
+    record(layer, [&](DrawList::Recorder& cmds) {
+        cmds.outline_ring(x, y, outer_radius, inner_radius, start_angle, sweep_angle, thickness, color, clockwise);
+    });
+}
+
+void polyline(REFD2DLayerHandle layer, const float* points, uint32_t point_count, float thickness, uint32_t color, bool closed) {
+    if (points == nullptr && point_count != 0) {
+        t_last_error = "Null points";
+        return;
+    }
+
+    record(layer, [&](DrawList::Recorder& cmds) {
+        cmds.polyline(std::string{(const char*)points, point_count * 2 * sizeof(float)}, thickness, color, closed);
+    });
+}
+
+void fill_polygon(REFD2DLayerHandle layer, const float* points, uint32_t point_count, uint32_t color) {
+    if (points == nullptr && point_count != 0) {
+        t_last_error = "Null points";
+        return;
+    }
+
+    record(layer, [&](DrawList::Recorder& cmds) {
+        cmds.fill_polygon(std::string{(const char*)points, point_count * 2 * sizeof(float)}, color);
+    });
+}
+
+void push_transform(REFD2DLayerHandle layer, float m11, float m12, float m21, float m22, float dx, float dy) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.push_transform({m11, m12, m21, m22, dx, dy}); });
+}
+
+void pop_transform(REFD2DLayerHandle layer) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.pop_transform(); });
+}
+
+void push_clip(REFD2DLayerHandle layer, float x, float y, float w, float h) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.push_clip(x, y, w, h); });
+}
+
+void pop_clip(REFD2DLayerHandle layer) {
+    record(layer, [&](DrawList::Recorder& cmds) { cmds.pop_clip(); });
+}
+
+// Designated so that the compiler checks the order against API.h.
+const REFD2DApi g_api{
+    .size = sizeof(REFD2DApi),
+    .version_major = REFD2D_API_VERSION_MAJOR,
+    .version_minor = REFD2D_API_VERSION_MINOR,
+    .last_error = last_error,
+    .surface_size = surface_size,
+    .create_layer = create_layer,
+    .destroy_layer = destroy_layer,
+    .begin = begin,
+    .submit = submit,
+    .create_font = create_font,
+    .load_font = load_font,
+    .destroy_font = destroy_font,
+    .measure_text = measure_text,
+    .load_image = load_image,
+    .destroy_image = destroy_image,
+    .image_size = image_size,
+    .text = text,
+    .fill_rect = fill_rect,
+    .outline_rect = outline_rect,
+    .rounded_rect = rounded_rect,
+    .fill_rounded_rect = fill_rounded_rect,
+    .quad = quad,
+    .fill_quad = fill_quad,
+    .line = line,
+    .image = image,
+    .image_rect = image_rect,
+    .fill_circle = fill_circle,
+    .circle = circle,
+    .pie = pie,
+    .outline_pie = outline_pie,
+    .ring = ring,
+    .outline_ring = outline_ring,
+    .push_transform = push_transform,
+    .pop_transform = pop_transform,
+    .push_clip = push_clip,
+    .pop_clip = pop_clip,
+    .polyline = polyline,
+    .fill_polygon = fill_polygon,
+};
+} // namespace
+
+static_assert(DrawList::LUA_ORDER == REFD2D_LUA_LAYER_ORDER);
+// Fails once API.h gains a field after fill_polygon, so that g_api gets updated with it.
+static_assert(offsetof(REFD2DApi, fill_polygon) + sizeof(REFD2DApi::fill_polygon) == sizeof(REFD2DApi));
+
+void NativeApi::init(DrawList& drawlist, std::function<const D2DPainter::Factories&()> factories) {
+    g_drawlist = &drawlist;
+    g_factories = std::move(factories);
+}
+
+void NativeApi::set_surface_size(uint32_t width, uint32_t height) {
+    g_surface_size.store(((uint64_t)width << 32) | height, std::memory_order_relaxed);
+}
+
+std::tuple<uint32_t, uint32_t> NativeApi::surface_size() {
+    auto size = g_surface_size.load(std::memory_order_relaxed);
+    return {(uint32_t)(size >> 32), (uint32_t)size};
+}
+
+extern "C" __declspec(dllexport) const REFD2DApi* refd2d_get_api(uint32_t version_major) {
+    return version_major == REFD2D_API_VERSION_MAJOR ? &g_api : nullptr;
+}
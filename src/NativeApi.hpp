@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <tuple>
+
+#include "D2DPainter.hpp"
+#include "DrawList.hpp"
+
+// Implements the C API from include/reframework-d2d/API.h. Native plugins record into their own DrawList producers, so they never
+// wait on Lua or on each other.
+namespace NativeApi {
+// Called once on load, before any plugin can ask for the API. factories is called from whichever thread first needs a font or image.
+void init(DrawList& drawlist, std::function<const D2DPainter::Factories&()> factories);
+
+// Whenever the renderer is created or goes away, 0 x 0 while there is none.
+void set_surface_size(uint32_t width, uint32_t height);
+// What was last set, from any thread.
+std::tuple<uint32_t, uint32_t> surface_size();
+} // namespace NativeApi
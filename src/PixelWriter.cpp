@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cstring>
+
+#include "PixelWriter.hpp"
+
+namespace {
+uint8_t premultiply(uint32_t c, uint32_t a) {
+    return (uint8_t)((c * a + 127) / 255);
+}
+
+void store(uint8_t* out, uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+    out[0] = premultiply(b, a);
+    out[1] = premultiply(g, a);
+    out[2] = premultiply(r, a);
+    out[3] = (uint8_t)a;
+}
+} // namespace
+
+namespace PixelWriter {
+bool clip(int x, int y, uint32_t w, uint32_t h, uint32_t width, uint32_t height, Clip& out) {
+    auto left = std::max<int64_t>(x, 0);
+    auto top = std::max<int64_t>(y, 0);
+    auto right = std::min<int64_t>((int64_t)x + w, width);
+    auto bottom = std::min<int64_t>((int64_t)y + h, height);
+
+    if (right <= left || bottom <= top) {
+        return false;
+    }
+
+    out = {(uint32_t)left, (uint32_t)top, (uint32_t)(right - left), (uint32_t)(bottom - top), (uint32_t)(left - x), (uint32_t)(top - y)};
+    return true;
+}
+
+void write_rgba(uint8_t* dst, size_t dst_pitch, const uint8_t* src, size_t src_pitch, uint32_t w, uint32_t h) {
+    for (auto y = 0u; y < h; ++y) {
+        auto in = src + (size_t)y * src_pitch;
+        auto out = dst + (size_t)y * dst_pitch;
+
+        for (auto x = 0u; x < w; ++x, in += 4, out += 4) {
+            store(out, in[0], in[1], in[2], in[3]);
+        }
+    }
+}
+
+void write_argb(uint8_t* dst, size_t dst_pitch, const uint32_t* src, size_t src_pitch, uint32_t w, uint32_t h) {
+    for (auto y = 0u; y < h; ++y) {
+        auto in = (const uint32_t*)((const uint8_t*)src + (size_t)y * src_pitch);
+        auto out = dst + (size_t)y * dst_pitch;
+
+        for (auto x = 0u; x < w; ++x, out += 4) {
+            auto c = in[x];
+            store(out, (c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF, c >> 24);
+        }
+    }
+}
+
+void fill_argb(uint8_t* dst, size_t dst_pitch, uint32_t color, uint32_t w, uint32_t h) {
+    auto pixel = premultiply_argb(color);
+
+    for (auto y = 0u; y < h; ++y) {
+        auto out = dst + (size_t)y * dst_pitch;
+
+        for (auto x = 0u; x < w; ++x, out += 4) {
+            std::memcpy(out, &pixel, 4);
+        }
+    }
+}
+
+uint32_t premultiply_argb(uint32_t color) {
+    uint8_t out[4]{};
+    store(out, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, color >> 24);
+
+    uint32_t pixel{};
+    std::memcpy(&pixel, out, 4);
+    return pixel;
+}
+} // namespace PixelWriter
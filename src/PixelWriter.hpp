@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Conversions used to write script supplied pixels into a 32bpp premultiplied BGRA buffer. Rows are addressed by pitch in bytes for
+// both the source and the destination.
+namespace PixelWriter {
+// The part of a w x h write at x, y that lands inside the image, and where that part starts in the source.
+struct Clip {
+    uint32_t x{};
+    uint32_t y{};
+    uint32_t w{};
+    uint32_t h{};
+    uint32_t src_x{};
+    uint32_t src_y{};
+};
+
+// Clips a write to a width x height image. Returns false if none of it is inside.
+bool clip(int x, int y, uint32_t w, uint32_t h, uint32_t width, uint32_t height, Clip& out);
+
+// Straight alpha RGBA bytes, as found in packed strings.
+void write_rgba(uint8_t* dst, size_t dst_pitch, const uint8_t* src, size_t src_pitch, uint32_t w, uint32_t h);
+
+// Straight alpha 0xAARRGGBB values, the same packing the rest of the API uses for colors.
+void write_argb(uint8_t* dst, size_t dst_pitch, const uint32_t* src, size_t src_pitch, uint32_t w, uint32_t h);
+
+// Fills every pixel with a single 0xAARRGGBB color.
+void fill_argb(uint8_t* dst, size_t dst_pitch, uint32_t color, uint32_t w, uint32_t h);
+
+// A single 0xAARRGGBB color as premultiplied BGRA.
+uint32_t premultiply_argb(uint32_t color);
+} // namespace PixelWriter
@@ -1,17 +1,40 @@
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "reframework/API.hpp"
 #include "sol/sol.hpp"
 
+#include "D2DPixelImage.hpp"
 #include "D3D12Renderer.hpp"
+#include "DrawCapture.hpp"
 #include "DrawList.hpp"
+#include "FramePacer.hpp"
+#include "LuaStack.hpp"
+#include "LuaStringPins.hpp"
+#include "NativeApi.hpp"
+#include "PixelWriter.hpp"
+#include "SharedChannel.hpp"
+#include "SpriteSheet.hpp"
 
 using API = reframework::API;
-using Clock = std::chrono::high_resolution_clock;
+using Clock = FramePacer::Clock;
 
 struct Plugin {
+    // Device independent, kept across device resets along with the fonts and images scripts made from them. Created by whichever comes
+    // first, the renderer or a native plugin making a font or image.
+    D2DPainter::Factories factories{};
+    std::mutex factories_mtx{};
     std::unique_ptr<D3D12Renderer> d3d12{};
     D2DPainter* d2d{};
     std::vector<sol::protected_function> draw_fns{};
@@ -19,19 +42,51 @@ struct Plugin {
     lua_State* lua{};
     bool needs_init{};
     DrawList drawlist{};
-    DrawList::CommandLock* cmds{};
-    Clock::time_point d2d_next_frame_time{Clock::now()};
-    const std::chrono::duration<double> DEFAULT_UPDATE_INTERVAL{1.0 / 60.0};
-    std::chrono::duration<double> d2d_update_interval{DEFAULT_UPDATE_INTERVAL};
-    bool update_d2d{};
+    // Only used with the Lua lock held.
+    std::shared_ptr<DrawList::Producer> lua_producer{drawlist.create_producer()};
+    DrawList::Recorder* cmds{};
+    // Text commands recorded by scripts point into Lua strings pinned here. Only used with the Lua lock held.
+    std::unique_ptr<LuaStringPins> lua_strings{};
+    // Held by the render worker while it reads commands, so the Lua state isn't closed under it.
+    std::mutex replay_mtx{};
+    // The render worker's, with replay_mtx held.
+    DrawList::Prepared prepared{};
+    FramePacer pacer{};
+    // Counted in on_ref_frame for the pacer, scripts run from on_begin_rendering which doesn't happen exactly once per present.
+    std::atomic<uint64_t> presents{};
+    // DrawList submissions as of the last update handed to the renderer, unset when the renderer needs a full redraw.
+    std::optional<uint64_t> queued_submissions{};
     std::string last_script_error{};
+    // Set by scripts, handed to the painter on the next frame.
+    std::atomic<uint64_t> image_budget{D2DPainter::DEFAULT_IMAGE_BUDGET};
+    bool composite_tiling{};
+    float render_scale{D3D12Renderer::MAX_RENDER_SCALE};
+    // Null if the channel couldn't be created.
+    std::unique_ptr<SharedChannel> channel{};
+    // Set while frames are being captured, written by the render worker.
+    std::mutex capture_mtx{};
+    std::unique_ptr<DrawCapture> capture{};
+    // Copied from the painter by the render worker so scripts never touch it, it goes away whenever the renderer is recreated.
+    std::mutex image_stats_mtx{};
+    D2DPainter::ImageStats image_stats{D2DPainter::DEFAULT_IMAGE_BUDGET};
 };
 
 Plugin* g_plugin{};
 
+const D2DPainter::Factories& get_factories() {
+    std::scoped_lock _{g_plugin->factories_mtx};
+
+    if (g_plugin->factories.d2d1 == nullptr) {
+        g_plugin->factories = D2DPainter::Factories::create();
+    }
+
+    return g_plugin->factories;
+}
+
 BOOL APIENTRY DllMain(HMODULE, DWORD reason, LPVOID) {
     if (reason == DLL_PROCESS_ATTACH) {
         g_plugin = new Plugin{};
+        NativeApi::init(g_plugin->drawlist, get_factories);
     }
 
     return TRUE;
@@ -43,15 +98,441 @@ void handle_error_message(const std::string& msg) {
     g_plugin->last_script_error = msg;
 }
 
+std::shared_ptr<D2DFont> load_font_file(const std::filesystem::path& path, const std::string& family, int size, bool bold, bool italic) {
+    auto font = std::make_shared<D2DFont>(get_factories().dwrite, path, family, size, bold, italic);
+    API::get()->log_info("[reframework-d2d] [D2DFont] Chose family %S for font %S", font->family_name().c_str(), path.filename().c_str());
+    return font;
+}
+
+// Frames are addressed by name or by 1 based index from Lua.
+std::optional<SpriteSheet::Frame> find_sprite_frame(const SpriteSheet& sheet, sol::object frame) {
+    if (frame.is<std::string>()) {
+        return sheet.frame(frame.as<std::string>());
+    }
+
+    if (frame.is<int>()) {
+        auto index = frame.as<int>();
+        return index >= 1 ? sheet.frame((size_t)index - 1) : std::nullopt;
+    }
+
+    return std::nullopt;
+}
+
+// Accepts TexturePacker style atlas JSON (the "hash" and "array" flavours) as loaded by json.load_file, or a plain table mapping frame
+// names to {x=, y=, w=, h=}.
+std::shared_ptr<SpriteSheet> make_sprite_sheet(std::shared_ptr<D2DImage> image, sol::table atlas) {
+    auto sheet = std::make_shared<SpriteSheet>(std::move(image));
+    auto frames = atlas.get_or<sol::table>("frames", atlas);
+
+    auto read_frame = [](sol::table entry) {
+        auto rect = entry.get_or<sol::table>("frame", entry);
+        return SpriteSheet::Frame{rect.get_or("x", 0.0f), rect.get_or("y", 0.0f), rect.get_or("w", 0.0f), rect.get_or("h", 0.0f)};
+    };
+
+    if (auto n = frames.size(); n > 0) {
+        for (auto i = 1u; i <= n; ++i) {
+            sol::table entry = frames[i];
+            sheet->add_frame(entry.get_or<std::string>("filename", std::to_string(i)), read_frame(entry));
+        }
+    } else {
+        for (auto& [key, value] : frames) {
+            if (key.is<std::string>() && value.get_type() == sol::type::table) {
+                sheet->add_frame(key.as<std::string>(), read_frame(value.as<sol::table>()));
+            }
+        }
+    }
+
+    return sheet;
+}
+
+// Pixels come either as a string of packed RGBA bytes or as an array of 0xAARRGGBB numbers, row major, w per row.
+void write_pixel_image(D2DPixelImage& image, int x, int y, int w, int h, sol::object data) {
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    auto count = (size_t)w * h;
+
+    if (data.is<std::string_view>()) {
+        auto bytes = data.as<std::string_view>();
+
+        if (bytes.size() < count * 4) {
+            throw std::runtime_error{"PixelImage:write string is too short for the given size"};
+        }
+
+        image.write_rgba(x, y, (uint32_t)w, (uint32_t)h, (const uint8_t*)bytes.data(), (size_t)w * 4);
+        return;
+    }
+
+    if (data.is<sol::table>()) {
+        // Only the part that lands on the image is read, a write mostly off the image shouldn't cost its full size.
+        auto [width, height] = image.size();
+        PixelWriter::Clip c{};
+
+        if (!PixelWriter::clip(x, y, (uint32_t)w, (uint32_t)h, width, height, c)) {
+            return;
+        }
+
+        auto table = data.as<sol::table>();
+        std::vector<uint32_t> pixels((size_t)c.w * c.h);
+
+        for (uint32_t row = 0; row < c.h; ++row) {
+            auto src = (size_t)(c.src_y + row) * w + c.src_x;
+
+            for (uint32_t col = 0; col < c.w; ++col) {
+                pixels[(size_t)row * c.w + col] = table.raw_get_or<uint32_t>(src + col + 1, 0);
+            }
+        }
+
+        image.write_argb((int)c.x, (int)c.y, c.w, c.h, pixels.data());
+        return;
+    }
+
+    throw std::runtime_error{"PixelImage:write expects a string or a table"};
+}
+
+// The d2d functions scripts call every frame, written against the Lua C API (see LuaStack.hpp). They take the same arguments as the
+// sol2 bindings they replace.
+namespace lua_draw {
+using namespace lua_stack;
+
+int text(lua_State* l) {
+    auto& font = shared<D2DFont>(l, 1, "d2d.Font");
+    size_t length{};
+    auto str = luaL_checklstring(l, 2, &length);
+    auto x = number(l, 3);
+    auto y = number(l, 4);
+    auto c = color(l, 5);
+
+    // luaL_checklstring turns numbers into strings in place, so what's at 2 now is the string str points into.
+    g_plugin->lua_strings->pin(2);
+
+    return protect(l, [&] {
+        g_plugin->cmds->text(font, std::string_view{str, length}, g_plugin->lua_strings->owner(), x, y, c);
+        return 0;
+    });
+}
+
+int measure_text(lua_State* l) {
+    auto& font = shared<D2DFont>(l, 1, "d2d.Font");
+    size_t length{};
+    auto str = luaL_checklstring(l, 2, &length);
+
+    return protect(l, [&] {
+        auto [w, h] = font->measure(std::string_view{str, length});
+        lua_pushnumber(l, w);
+        lua_pushnumber(l, h);
+        return 2;
+    });
+}
+
+int fill_rect(lua_State* l) {
+    auto x = number(l, 1);
+    auto y = number(l, 2);
+    auto w = number(l, 3);
+    auto h = number(l, 4);
+    auto c = color(l, 5);
+
+    return protect(l, [&] {
+        g_plugin->cmds->fill_rect(x, y, w, h, c);
+        return 0;
+    });
+}
+
+int outline_rect(lua_State* l) {
+    auto x = number(l, 1);
+    auto y = number(l, 2);
+    auto w = number(l, 3);
+    auto h = number(l, 4);
+    auto thickness = number(l, 5);
+    auto c = color(l, 6);
+
+    return protect(l, [&] {
+        g_plugin->cmds->outline_rect(x, y, w, h, thickness, c);
+        return 0;
+    });
+}
+
+int line(lua_State* l) {
+    auto x1 = number(l, 1);
+    auto y1 = number(l, 2);
+    auto x2 = number(l, 3);
+    auto y2 = number(l, 4);
+    auto thickness = number(l, 5);
+    auto c = color(l, 6);
+
+    return protect(l, [&] {
+        g_plugin->cmds->line(x1, y1, x2, y2, thickness, c);
+        return 0;
+    });
+}
+
+int image(lua_State* l) {
+    auto& img = shared<D2DImage>(l, 1, "d2d.Image");
+    auto x = number(l, 2);
+    auto y = number(l, 3);
+    auto [image_w, image_h] = img->size();
+    auto w = opt_number(l, 4, (float)image_w);
+    auto h = opt_number(l, 5, (float)image_h);
+    auto alpha = opt_number(l, 6, 1.0f);
+
+    return protect(l, [&] {
+        g_plugin->cmds->image(img, x, y, w, h, alpha);
+        return 0;
+    });
+}
+
+int image_rect(lua_State* l) {
+    auto& img = shared<D2DImage>(l, 1, "d2d.Image");
+    auto sx = number(l, 2);
+    auto sy = number(l, 3);
+    auto sw = number(l, 4);
+    auto sh = number(l, 5);
+    auto x = number(l, 6);
+    auto y = number(l, 7);
+    auto w = number(l, 8);
+    auto h = number(l, 9);
+    auto alpha = opt_number(l, 10, 1.0f);
+
+    return protect(l, [&] {
+        g_plugin->cmds->image_rect(img, sx, sy, sw, sh, x, y, w, h, alpha);
+        return 0;
+    });
+}
+
+int fill_circle(lua_State* l) {
+    auto x = number(l, 1);
+    auto y = number(l, 2);
+    auto r = number(l, 3);
+    auto c = color(l, 4);
+
+    return protect(l, [&] {
+        g_plugin->cmds->fill_circle(x, y, r, r, c);
+        return 0;
+    });
+}
+
+int circle(lua_State* l) {
+    auto x = number(l, 1);
+    auto y = number(l, 2);
+    auto r = number(l, 3);
+    auto thickness = number(l, 4);
+    auto c = color(l, 5);
+
+    return protect(l, [&] {
+        g_plugin->cmds->circle(x, y, r, r, thickness, c);
+        return 0;
+    });
+}
+
+int pie(lua_State* l) {
+    auto x = number(l, 1);
+    auto y = number(l, 2);
+    auto r = number(l, 3);
+    auto start_angle = number(l, 4);
+    auto sweep_angle = number(l, 5);
+    auto c = color(l, 6);
+    auto clockwise = opt_bool(l, 7, true);
+
+    return protect(l, [&] {
+        g_plugin->cmds->pie(x, y, r, start_angle, sweep_angle, c, clockwise);
+        return 0;
+    });
+}
+
+int outline_pie(lua_State* l) {
+    auto x = number(l, 1);
+    auto y = number(l, 2);
+    auto r = number(l, 3);
+    auto start_angle = number(l, 4);
+    auto sweep_angle = number(l, 5);
+    auto thickness = number(l, 6);
+    auto c = color(l, 7);
+    auto clockwise = opt_bool(l, 8, true);
+
+    return protect(l, [&] {
+        g_plugin->cmds->outline_pie(x, y, r, start_angle, sweep_angle, thickness, c, clockwise);
+        return 0;
+    });
+}
+
+int ring(lua_State* l) {
+    auto x = number(l, 1);
+    auto y = number(l, 2);
+    auto outer_r = number(l, 3);
+    auto inner_r = number(l, 4);
+    auto start_angle = number(l, 5);
+    auto sweep_angle = number(l, 6);
+    auto c = color(l, 7);
+    auto clockwise = opt_bool(l, 8, true);
+
+    return protect(l, [&] {
+        g_plugin->cmds->ring(x, y, outer_r, inner_r, start_angle, sweep_angle, c, clockwise);
+        return 0;
+    });
+}
+
+int outline_ring(lua_State* l) {
+    auto x = number(l, 1);
+    auto y = number(l, 2);
+    auto outer_r = number(l, 3);
+    auto inner_r = number(l, 4);
+    auto start_angle = number(l, 5);
+    auto sweep_angle = number(l, 6);
+    auto thickness = number(l, 7);
+    auto c = color(l, 8);
+    auto clockwise = opt_bool(l, 9, true);
+
+    return protect(l, [&] {
+        g_plugin->cmds->outline_ring(x, y, outer_r, inner_r, start_angle, sweep_angle, thickness, c, clockwise);
+        return 0;
+    });
+}
+
+// Points are a table of x, y numbers or a string of packed floats (string.pack with "f"s). Strings are borrowed like text, tables are
+// read with table_points from within protect. Raises a Lua error for anything else.
+bool packed_points(lua_State* l, int idx) {
+    if (lua_type(l, idx) == LUA_TSTRING) {
+        return true;
+    }
+
+    luaL_checktype(l, idx, LUA_TTABLE);
+    return false;
+}
+
+std::string_view packed_string(lua_State* l, int idx) {
+    size_t length{};
+    auto str = lua_tolstring(l, idx, &length);
+    return {str, length};
+}
+
+// Raw access never raises Lua errors, so this is safe to use with destructors around.
+std::string table_points(lua_State* l, int idx) {
+    auto count = (size_t)lua_rawlen(l, idx);
+    std::string points(count * sizeof(float), '\0');
+
+    for (size_t i = 0; i < count; ++i) {
+        lua_rawgeti(l, idx, (lua_Integer)i + 1);
+        int is_number{};
+        auto value = (float)lua_tonumberx(l, -1, &is_number);
+        lua_pop(l, 1);
+
+        if (is_number == 0) {
+            throw std::runtime_error{"Points must be numbers"};
+        }
+
+        std::memcpy(points.data() + i * sizeof(float), &value, sizeof(float));
+    }
+
+    return points;
+}
+
+int polyline(lua_State* l) {
+    auto packed = packed_points(l, 1);
+    auto thickness = number(l, 2);
+    auto c = color(l, 3);
+    auto closed = opt_bool(l, 4, false);
+
+    if (packed) {
+        g_plugin->lua_strings->pin(1);
+    }
+
+    return protect(l, [&] {
+        if (packed) {
+            g_plugin->cmds->polyline(packed_string(l, 1), g_plugin->lua_strings->owner(), thickness, c, closed);
+        } else {
+            g_plugin->cmds->polyline(table_points(l, 1), thickness, c, closed);
+        }
+
+        return 0;
+    });
+}
+
+int fill_polygon(lua_State* l) {
+    auto packed = packed_points(l, 1);
+    auto c = color(l, 2);
+
+    if (packed) {
+        g_plugin->lua_strings->pin(1);
+    }
+
+    return protect(l, [&] {
+        if (packed) {
+            g_plugin->cmds->fill_polygon(packed_string(l, 1), g_plugin->lua_strings->owner(), c);
+        } else {
+            g_plugin->cmds->fill_polygon(table_points(l, 1), c);
+        }
+
+        return 0;
+    });
+}
+
+int push_transform(lua_State* l) {
+    auto x = number(l, 1);
+    auto y = number(l, 2);
+    auto rotation = opt_number(l, 3, 0.0f);
+    auto scale_x = opt_number(l, 4, 1.0f);
+    auto scale_y = opt_number(l, 5, scale_x);
+
+    return protect(l, [&] {
+        g_plugin->cmds->push_transform(DrawPrepass::Transform::make(x, y, rotation, scale_x, scale_y));
+        return 0;
+    });
+}
+
+int pop_transform(lua_State* l) {
+    return protect(l, [&] {
+        g_plugin->cmds->pop_transform();
+        return 0;
+    });
+}
+
+int push_clip(lua_State* l) {
+    auto x = number(l, 1);
+    auto y = number(l, 2);
+    auto w = number(l, 3);
+    auto h = number(l, 4);
+
+    return protect(l, [&] {
+        g_plugin->cmds->push_clip(x, y, w, h);
+        return 0;
+    });
+}
+
+int pop_clip(lua_State* l) {
+    return protect(l, [&] {
+        g_plugin->cmds->pop_clip();
+        return 0;
+    });
+}
+
+// Scripts can ask before the renderer exists or while it's being recreated, the size is 0 x 0 then.
+int surface_size(lua_State* l) {
+    auto [w, h] = NativeApi::surface_size();
+    lua_pushinteger(l, w);
+    lua_pushinteger(l, h);
+    return 2;
+}
+} // namespace lua_draw
+
 auto get_d2d_max_updaterate() {
-    return 1.0 / g_plugin->d2d_update_interval.count();
+    return g_plugin->pacer.rate();
 }
 auto set_d2d_max_updaterate(double hz) {
-    g_plugin->d2d_update_interval = std::chrono::duration<double>{1.0 / hz};
+    g_plugin->pacer.set_rate(hz);
+}
+
+// The budget is exposed to Lua in megabytes.
+auto get_d2d_image_budget() {
+    return (double)g_plugin->image_budget / (1024.0 * 1024.0);
+}
+auto set_d2d_image_budget(double mb) {
+    g_plugin->image_budget = (uint64_t)(std::max(mb, 0.0) * 1024.0 * 1024.0);
 }
 
 void on_ref_lua_state_created(lua_State* l) try {
     g_plugin->lua = l;
+    g_plugin->lua_strings = std::make_unique<LuaStringPins>(l);
     sol::state_view lua{l};
 
     auto d2d = lua.create_table();
@@ -90,7 +571,7 @@ void on_ref_lua_state_created(lua_State* l) try {
                     return std::shared_ptr<D2DFont>{nullptr};
                 }
 
-                return std::make_shared<D2DFont>(g_plugin->d2d->dwrite(), font_path, family, size, bold, italic);
+                return load_font_file(font_path, family, size, bold, italic);
             } else {
                 size = secondparm.as<int>();
 
@@ -112,10 +593,10 @@ void on_ref_lua_state_created(lua_State* l) try {
                         return std::shared_ptr<D2DFont>{nullptr};
                     }
 
-                    return std::make_shared<D2DFont>(g_plugin->d2d->dwrite(), font_path, "", size, bold, italic);
+                    return load_font_file(font_path, "", size, bold, italic);
                 }
 
-                return std::make_shared<D2DFont>(g_plugin->d2d->dwrite(), firstparm, size, bold, italic);
+                return std::make_shared<D2DFont>(get_factories().dwrite, firstparm, size, bold, italic);
             }
         },
         "measure", &D2DFont::measure);
@@ -131,12 +612,216 @@ void on_ref_lua_state_created(lua_State* l) try {
                 return std::shared_ptr<D2DImage>{nullptr};
             }
 
-            return std::make_shared<D2DImage>(g_plugin->d2d->wic(), g_plugin->d2d->context(), image_path);
+            return std::make_shared<D2DImage>(get_factories().wic, image_path);
         },
         "size", &D2DImage::size);
 
+    d2d.new_usertype<D2DPixelImage>(
+        "PixelImage", sol::meta_function::construct,
+        [](int w, int h) {
+            if (w <= 0 || h <= 0) {
+                throw std::runtime_error{"PixelImage size must be positive"};
+            }
+
+            return std::make_shared<D2DPixelImage>((UINT32)w, (UINT32)h);
+        },
+        sol::base_classes, sol::bases<D2DImage>(),
+        "size", &D2DImage::size,
+        "write", [](D2DPixelImage& image, int x, int y, int w, int h, sol::object data) { write_pixel_image(image, x, y, w, h, data); },
+        "set_pixel", &D2DPixelImage::set_pixel,
+        "fill",
+        [](D2DPixelImage& image, int x, int y, int w, int h, unsigned int color) {
+            if (w > 0 && h > 0) {
+                image.fill(x, y, (uint32_t)w, (uint32_t)h, color);
+            }
+        },
+        "clear",
+        [](D2DPixelImage& image, sol::object color_obj) {
+            auto [w, h] = image.size();
+            image.fill(0, 0, w, h, color_obj.is<unsigned int>() ? color_obj.as<unsigned int>() : 0);
+        });
+
+    d2d.new_usertype<SpriteSheet>(
+        "SpriteSheet", sol::meta_function::construct,
+        [](std::shared_ptr<D2DImage> image, sol::object second, sol::object cell_h_obj, sol::object margin_obj, sol::object spacing_obj) {
+            if (image == nullptr) {
+                return std::shared_ptr<SpriteSheet>{nullptr};
+            }
+
+            if (second.is<sol::table>()) {
+                return make_sprite_sheet(std::move(image), second.as<sol::table>());
+            }
+
+            auto cell_w = second.as<float>();
+            auto cell_h = cell_h_obj.is<float>() ? cell_h_obj.as<float>() : cell_w;
+            auto margin = margin_obj.is<float>() ? margin_obj.as<float>() : 0.0f;
+            auto spacing = spacing_obj.is<float>() ? spacing_obj.as<float>() : 0.0f;
+
+            return std::make_shared<SpriteSheet>(std::move(image), cell_w, cell_h, margin, spacing);
+        },
+        "draw",
+        [](SpriteSheet& sheet, sol::object frame_obj, float x, float y, sol::object w_obj, sol::object h_obj, sol::object alpha_obj) {
+            auto frame = find_sprite_frame(sheet, frame_obj);
+
+            if (!frame) {
+                throw std::runtime_error{"Unknown sprite sheet frame"};
+            }
+
+            auto w = frame->w;
+            auto h = frame->h;
+            float alpha = 1.0f;
+
+            if (w_obj.is<float>()) {
+                w = w_obj.as<float>();
+            }
+
+            if (h_obj.is<float>()) {
+                h = h_obj.as<float>();
+            }
+
+            if (alpha_obj.is<float>()) {
+                alpha = alpha_obj.as<float>();
+            }
+
+            g_plugin->cmds->image_rect(sheet.image(), frame->x, frame->y, frame->w, frame->h, x, y, w, h, alpha);
+        },
+        "frame",
+        [](sol::this_state s, SpriteSheet& sheet, sol::object frame_obj) {
+            sol::variadic_results results{};
+
+            if (auto frame = find_sprite_frame(sheet, frame_obj)) {
+                results.push_back(sol::make_object(s, frame->x));
+                results.push_back(sol::make_object(s, frame->y));
+                results.push_back(sol::make_object(s, frame->w));
+                results.push_back(sol::make_object(s, frame->h));
+            } else {
+                results.push_back(sol::make_object(s, sol::lua_nil));
+            }
+
+            return results;
+        },
+        "count", &SpriteSheet::count);
+
     detail["get_max_updaterate"] = []() { return get_d2d_max_updaterate(); };
     detail["set_max_updaterate"] = [](double fps) { set_d2d_max_updaterate(fps); };
+    detail["get_effective_updaterate"] = []() { return g_plugin->pacer.effective_rate(); };
+    detail["get_present_interval"] = []() { return g_plugin->pacer.present_interval(); };
+    detail["set_present_interval"] = [](int n) { g_plugin->pacer.set_present_interval((uint32_t)std::max(n, 0)); };
+    detail["get_update_budget"] = []() { return std::chrono::duration<double, std::milli>{g_plugin->pacer.budget()}.count(); };
+    detail["set_update_budget"] = [](double ms) {
+        g_plugin->pacer.set_budget(std::chrono::duration<double, std::milli>{std::max(ms, 0.0)});
+    };
+    detail["get_update_stats"] = [](sol::this_state s) {
+        auto t = sol::state_view{s}.create_table();
+        t["updates"] = g_plugin->pacer.updates();
+        t["dropped"] = g_plugin->pacer.dropped();
+        t["average_cost"] = std::chrono::duration<double, std::milli>{g_plugin->pacer.average_cost()}.count();
+        t["effective_rate"] = g_plugin->pacer.effective_rate();
+        return t;
+    };
+    detail["get_render_stats"] = [](sol::this_state s) {
+        auto t = sol::state_view{s}.create_table();
+
+        if (g_plugin->d3d12 != nullptr) {
+            auto stats = g_plugin->d3d12->stats();
+            t["frames_rendered"] = stats.frames_rendered;
+            t["frames_superseded"] = stats.frames_superseded;
+            t["last_render_ms"] = stats.last_render_ms;
+            t["average_render_ms"] = stats.average_render_ms;
+            t["last_composite_ms"] = stats.last_composite_ms;
+            t["overlay_waits"] = stats.overlay_waits;
+            t["overlay_wait_ms"] = stats.overlay_wait_ms;
+            t["composite_waits"] = stats.composite_waits;
+            t["command_stalls"] = stats.command_stalls;
+            t["command_stall_ms"] = stats.command_stall_ms;
+            t["command_ring_depth"] = stats.command_ring_depth;
+            t["composites_skipped"] = stats.composites_skipped;
+            t["last_composite_coverage"] = stats.last_composite_coverage;
+            t["gpu_composite_ms"] = stats.gpu_composite_ms;
+            t["gpu_composite_avg_ms"] = stats.gpu_composite_avg_ms;
+            t["gpu_composite_max_ms"] = stats.gpu_composite_max_ms;
+            t["gpu_d2d_ms"] = stats.gpu_d2d_ms;
+            t["gpu_d2d_avg_ms"] = stats.gpu_d2d_avg_ms;
+            t["gpu_d2d_max_ms"] = stats.gpu_d2d_max_ms;
+            t["gpu_samples_dropped"] = stats.gpu_samples_dropped;
+        }
+
+        return t;
+    };
+    detail["get_composite_tiling"] = []() { return g_plugin->composite_tiling; };
+    detail["set_composite_tiling"] = [](bool enabled) {
+        g_plugin->composite_tiling = enabled;
+
+        if (g_plugin->d3d12 != nullptr) {
+            g_plugin->d3d12->set_composite_tiling(enabled);
+        }
+    };
+    // Takes effect on the next frame, the renderer gets recreated at the new scale.
+    detail["get_render_scale"] = []() { return g_plugin->render_scale; };
+    detail["set_render_scale"] = [](float scale) {
+        g_plugin->render_scale = std::clamp(scale, D3D12Renderer::MIN_RENDER_SCALE, D3D12Renderer::MAX_RENDER_SCALE);
+    };
+    detail["get_image_budget"] = []() { return get_d2d_image_budget(); };
+    detail["set_image_budget"] = [](double mb) { set_d2d_image_budget(mb); };
+    detail["get_image_stats"] = [](sol::this_state s) {
+        D2DPainter::ImageStats stats{};
+
+        {
+            std::scoped_lock _{g_plugin->image_stats_mtx};
+            stats = g_plugin->image_stats;
+        }
+
+        auto t = sol::state_view{s}.create_table();
+        // The painter only picks up a new budget on the next frame.
+        t["budget"] = g_plugin->image_budget.load();
+        t["resident"] = stats.resident;
+        t["evictions"] = stats.evictions;
+        t["images"] = stats.images;
+        return t;
+    };
+    detail["get_channel_stats"] = [](sol::this_state s) {
+        auto t = sol::state_view{s}.create_table();
+
+        if (g_plugin->channel != nullptr) {
+            auto stats = g_plugin->channel->stats();
+            t["frames"] = stats.frames;
+            t["skipped"] = stats.skipped;
+            t["dropped"] = stats.dropped;
+            t["corrupt"] = stats.corrupt;
+        }
+
+        return t;
+    };
+    detail["start_capture"] = [modpath](int frames) {
+        auto captures_path = std::filesystem::path{modpath}.parent_path() / "reframework" / "data" / "d2d_captures";
+        std::filesystem::create_directories(captures_path);
+
+        auto now = std::time(nullptr);
+        std::tm local{};
+        localtime_s(&local, &now);
+        char name[64]{};
+        std::strftime(name, sizeof(name), "capture_%Y%m%d_%H%M%S.r2dc", &local);
+
+        auto path = captures_path / name;
+        auto capture = std::make_unique<DrawCapture>(path, (uint32_t)std::max(frames, 1));
+
+        std::scoped_lock _{g_plugin->capture_mtx};
+        g_plugin->capture = std::move(capture);
+        return path.string();
+    };
+    detail["get_capture_status"] = [](sol::this_state s) {
+        auto t = sol::state_view{s}.create_table();
+        std::scoped_lock _{g_plugin->capture_mtx};
+
+        if (g_plugin->capture != nullptr) {
+            t["captured"] = g_plugin->capture->captured();
+            t["frames"] = g_plugin->capture->frames();
+            t["path"] = g_plugin->capture->path().string();
+            t["skipped_images"] = g_plugin->capture->skipped_images();
+        }
+
+        return t;
+    };
     detail["get_last_error"] = []() {
         return g_plugin->last_script_error;
     };
@@ -158,23 +843,13 @@ void on_ref_lua_state_created(lua_State* l) try {
             italic = italic_obj.as<bool>();
         }
 
-        return std::make_shared<D2DFont>(g_plugin->d2d->dwrite(), name, size, bold, italic);
+        return std::make_shared<D2DFont>(get_factories().dwrite, name, size, bold, italic);
     };
-    d2d["text"] = [](std::shared_ptr<D2DFont>& font, const char* text, float x, float y, unsigned int color) {
-        g_plugin->cmds->text(font, text, x, y, color);
-    };
-    d2d["measure_text"] = [](sol::this_state s, std::shared_ptr<D2DFont>& font, const char* text) {
-        auto [w, h] = font->measure(text);
-        sol::variadic_results results{};
-        results.push_back(sol::make_object(s, w));
-        results.push_back(sol::make_object(s, h));
-        return results;
-    };
-    d2d["fill_rect"] = [](float x, float y, float w, float h, unsigned int color) { g_plugin->cmds->fill_rect(x, y, w, h, color); };
+    d2d["text"] = &lua_draw::text;
+    d2d["measure_text"] = &lua_draw::measure_text;
+    d2d["fill_rect"] = &lua_draw::fill_rect;
     d2d["filled_rect"] = d2d["fill_rect"];
-    d2d["outline_rect"] = [](float x, float y, float w, float h, float thickness, unsigned int color) {
-        g_plugin->cmds->outline_rect(x, y, w, h, thickness, color);
-    };
+    d2d["outline_rect"] = &lua_draw::outline_rect;
     d2d["rounded_rect"] = [](float x, float y, float w, float h, float rX, float rY, float thickness, unsigned int color) {
         g_plugin->cmds->rounded_rect(x, y, w, h, rX, rY, thickness, color);
     };
@@ -187,78 +862,26 @@ void on_ref_lua_state_created(lua_State* l) try {
     d2d["fill_quad"] = [](float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, unsigned int color) {
         g_plugin->cmds->fill_quad(x1, y1, x2, y2, x3, y3, x4, y4, color);
     };
-    d2d["line"] = [](float x1, float y1, float x2, float y2, float thickness, unsigned int color) {
-        g_plugin->cmds->line(x1, y1, x2, y2, thickness, color);
-    };
-	d2d["image"] = [](std::shared_ptr<D2DImage>& image, float x, float y, sol::object w_obj, sol::object h_obj, sol::object alpha_obj) {
-		auto [w, h] = image->size();
-		float alpha = 1.0f;
-
-		if (w_obj.is<float>()) {
-			w = w_obj.as<float>();
-		}
-
-		if (h_obj.is<float>()) {
-			h = h_obj.as<float>();
-		}
-
-		if (alpha_obj.is<float>()) {
-			alpha = alpha_obj.as<float>();
-		}
-
-		g_plugin->cmds->image(image, x, y, w, h, alpha);
-	};
-    d2d["fill_circle"] = [](float x, float y, float r, unsigned int color) { g_plugin->cmds->fill_circle(x, y, r, r, color); };
-    d2d["circle"] = [](float x, float y, float r, float thickness, unsigned int color) {
-        g_plugin->cmds->circle(x, y, r, r, thickness, color);
-    };
+    d2d["line"] = &lua_draw::line;
+    d2d["image"] = &lua_draw::image;
+    d2d["image_rect"] = &lua_draw::image_rect;
+    d2d["fill_circle"] = &lua_draw::fill_circle;
+    d2d["circle"] = &lua_draw::circle;
     d2d["fill_oval"] = [](float x, float y, float rX, float rY, unsigned int color) { g_plugin->cmds->fill_circle(x, y, rX, rY, color); };
     d2d["oval"] = [](float x, float y, float rX, float rY, float thickness, unsigned int color) {
         g_plugin->cmds->circle(x, y, rX, rY, thickness, color);
     };
-    d2d["pie"] = [](float x, float y, float r, float startAngle, float sweepAngle, unsigned int color, sol::object clockwise_obj) {
-        auto clockwise = true;
-
-        if (clockwise_obj.is<bool>()) {
-            clockwise = clockwise_obj.as<bool>();
-        }
-        g_plugin->cmds->pie(x, y, r, startAngle, sweepAngle, color, clockwise);
-    };
-    d2d["outline_pie"] = [](float x, float y, float r, float startAngle, float sweepAngle, float thickness, unsigned int color,
-                             sol::object clockwise_obj) {
-        auto clockwise = true;
-
-        if (clockwise_obj.is<bool>()) {
-            clockwise = clockwise_obj.as<bool>();
-        }
-        g_plugin->cmds->outline_pie(x, y, r, startAngle, sweepAngle, thickness, color, clockwise);
-    };
-    d2d["ring"] = [](float x, float y, float outerR, float innerR, float startAngle, float sweepAngle, unsigned int color,
-                      sol::object clockwise_obj) {
-        auto clockwise = true;
-
-        if (clockwise_obj.is<bool>()) {
-            clockwise = clockwise_obj.as<bool>();
-        }
-        g_plugin->cmds->ring(x, y, outerR, innerR, startAngle, sweepAngle, color, clockwise);
-    };
-    d2d["outline_ring"] = [](float x, float y, float outerR, float innerR, float startAngle, float sweepAngle, float thickness,
-                              unsigned int color,
-                      sol::object clockwise_obj) {
-        auto clockwise = true;
-
-        if (clockwise_obj.is<bool>()) {
-            clockwise = clockwise_obj.as<bool>();
-        }
-        g_plugin->cmds->outline_ring(x, y, outerR, innerR, startAngle, sweepAngle, thickness, color, clockwise);
-    };
-    d2d["surface_size"] = [](sol::this_state s) {
-        auto [w, h] = g_plugin->d2d->surface_size();
-        sol::variadic_results results{};
-        results.push_back(sol::make_object(s, w));
-        results.push_back(sol::make_object(s, h));
-        return results;
-    };
+    d2d["pie"] = &lua_draw::pie;
+    d2d["outline_pie"] = &lua_draw::outline_pie;
+    d2d["ring"] = &lua_draw::ring;
+    d2d["outline_ring"] = &lua_draw::outline_ring;
+    d2d["polyline"] = &lua_draw::polyline;
+    d2d["fill_polygon"] = &lua_draw::fill_polygon;
+    d2d["push_transform"] = &lua_draw::push_transform;
+    d2d["pop_transform"] = &lua_draw::pop_transform;
+    d2d["push_clip"] = &lua_draw::push_clip;
+    d2d["pop_clip"] = &lua_draw::pop_clip;
+    d2d["surface_size"] = &lua_draw::surface_size;
     lua["d2d"] = d2d;
     g_plugin->needs_init = true;
 } catch (const std::exception& e) {
@@ -267,7 +890,15 @@ void on_ref_lua_state_created(lua_State* l) try {
 }
 
 void on_ref_lua_state_destroyed(lua_State* l) try {
-    g_plugin->drawlist.acquire().commands.clear();
+    g_plugin->lua_producer->reset();
+    g_plugin->lua_producer->submit();
+
+    // Once the worker is done with what it's drawing, it picks up the empty batch before reading commands again.
+    {
+        std::scoped_lock _{g_plugin->replay_mtx};
+        g_plugin->lua_strings.reset();
+    }
+
     g_plugin->draw_fns.clear();
     g_plugin->init_fns.clear();
     g_plugin->last_script_error.clear();
@@ -278,112 +909,104 @@ void on_ref_lua_state_destroyed(lua_State* l) try {
 }
 
 void on_ref_device_reset() try {
-    g_plugin->drawlist.acquire().commands.clear();
     g_plugin->d2d = nullptr;
     g_plugin->d3d12.reset();
+    NativeApi::set_surface_size(0, 0);
+
+    {
+        std::scoped_lock _{g_plugin->image_stats_mtx};
+        g_plugin->image_stats = D2DPainter::ImageStats{g_plugin->image_budget};
+    }
 } catch (const std::exception& e) {
     handle_error_message(e.what());
     API::get()->log_error("[reframework-d2d] [on_ref_lua_device_reset] %s", e.what());
 }
 
 void on_ref_frame() try {
-    if (g_plugin->draw_fns.empty()) {
+    ++g_plugin->presents;
+
+    if (g_plugin->channel != nullptr) {
+        g_plugin->channel->update();
+    }
+
+    // The Lua producer always exists, anything beyond it is a native plugin's layer or the channel.
+    if (g_plugin->draw_fns.empty() && g_plugin->drawlist.producer_count() <= 1) {
         return;
     }
 
+    if (g_plugin->d3d12 != nullptr && g_plugin->d3d12->render_scale() != g_plugin->render_scale) {
+        on_ref_device_reset();
+    }
+
+    // After a device reset only the renderer is recreated. Fonts and images scripts already made keep working, images recreate their
+    // bitmaps on the new device the next time they're drawn, so the init functions don't run again.
     if (g_plugin->d3d12 == nullptr) {
+        auto& factories = get_factories();
         auto renderer_data = API::get()->param()->renderer_data;
         g_plugin->d3d12 = std::make_unique<D3D12Renderer>((IDXGISwapChain*)renderer_data->swapchain, (ID3D12Device*)renderer_data->device,
-            (ID3D12CommandQueue*)renderer_data->command_queue);
+            (ID3D12CommandQueue*)renderer_data->command_queue, factories, D3D12Renderer::DEFAULT_OVERLAY_COUNT,
+            g_plugin->render_scale);
         g_plugin->d2d = g_plugin->d3d12->get_d2d().get();
-        g_plugin->needs_init = true;
+        g_plugin->d3d12->set_composite_tiling(g_plugin->composite_tiling);
+        g_plugin->queued_submissions.reset();
+
+        auto [surface_w, surface_h] = g_plugin->d2d->surface_size();
+        NativeApi::set_surface_size(surface_w, surface_h);
     }
 
+    g_plugin->d2d->set_image_budget(g_plugin->image_budget);
+
     // Just return if we need init since its not ready yet.
     if (g_plugin->needs_init) {
         return;
     }
 
+    auto submissions = g_plugin->drawlist.submissions();
+    auto update_d2d = submissions != g_plugin->queued_submissions;
+    g_plugin->queued_submissions = submissions;
+
     g_plugin->d3d12->render(
         [](D2DPainter& d2d) {
-            auto cmds_lock = g_plugin->drawlist.acquire();
-
-            for (auto&& cmd : cmds_lock.commands) {
-                switch (cmd.type) {
-                case DrawList::CommandType::TEXT:
-                    g_plugin->d2d->text(cmd.font_resource, cmd.str, cmd.text.x, cmd.text.y, cmd.text.color);
-                    break;
-
-                case DrawList::CommandType::FILL_RECT:
-                    g_plugin->d2d->fill_rect(cmd.fill_rect.x, cmd.fill_rect.y, cmd.fill_rect.w, cmd.fill_rect.h, cmd.fill_rect.color);
-                    break;
-
-                case DrawList::CommandType::OUTLINE_RECT:
-                    g_plugin->d2d->outline_rect(cmd.outline_rect.x, cmd.outline_rect.y, cmd.outline_rect.w, cmd.outline_rect.h,
-                        cmd.outline_rect.thickness, cmd.outline_rect.color);
-                    break;
-
-                case DrawList::CommandType::ROUNDED_RECT:
-                    g_plugin->d2d->rounded_rect(cmd.rounded_rect.x, cmd.rounded_rect.y, cmd.rounded_rect.w, cmd.rounded_rect.h,
-                        cmd.rounded_rect.rX, cmd.rounded_rect.rY, cmd.rounded_rect.thickness, cmd.rounded_rect.color);
-                    break;
-
-                case DrawList::CommandType::FILL_ROUNDED_RECT:
-                    g_plugin->d2d->fill_rounded_rect(cmd.rounded_rect.x, cmd.rounded_rect.y, cmd.rounded_rect.w, cmd.rounded_rect.h,
-                        cmd.rounded_rect.rX, cmd.rounded_rect.rY, cmd.rounded_rect.color);
-                    break;
-
-                case DrawList::CommandType::QUAD:
-                    g_plugin->d2d->quad(cmd.quad.x1, cmd.quad.y1, cmd.quad.x2, cmd.quad.y2, cmd.quad.x3, cmd.quad.y3, 
-                        cmd.quad.x4, cmd.quad.y4, cmd.quad.thickness, cmd.quad.color);
-                    break;
-
-                case DrawList::CommandType::FILL_QUAD:
-                    g_plugin->d2d->fill_quad(cmd.fill_quad.x1, cmd.fill_quad.y1, cmd.fill_quad.x2, cmd.fill_quad.y2, 
-                        cmd.fill_quad.x3, cmd.fill_quad.y3, cmd.fill_quad.x4, cmd.fill_quad.y4, cmd.fill_quad.color);
-                    break;
-
-                case DrawList::CommandType::LINE:
-                    g_plugin->d2d->line(cmd.line.x1, cmd.line.y1, cmd.line.x2, cmd.line.y2, cmd.line.thickness, cmd.line.color);
-                    break;
-
-                case DrawList::CommandType::IMAGE:
-                    g_plugin->d2d->image(cmd.image_resource, cmd.image.x, cmd.image.y, cmd.image.w, cmd.image.h, cmd.image.alpha);
-                    break;
-
-                case DrawList::CommandType::FILL_CIRCLE:
-                    g_plugin->d2d->fill_circle(
-                        cmd.fill_circle.x, cmd.fill_circle.y, cmd.fill_circle.radiusX, cmd.fill_circle.radiusY, cmd.fill_circle.color);
-                    break;
-
-                case DrawList::CommandType::CIRCLE:
-                    g_plugin->d2d->circle(cmd.circle.x, cmd.circle.y, cmd.circle.radiusX, cmd.circle.radiusY, cmd.circle.thickness, cmd.circle.color);
-                    break;
-
-                case DrawList::CommandType::PIE:
-                    g_plugin->d2d->pie(cmd.pie.x, cmd.pie.y, cmd.pie.r, cmd.pie.startAngle, cmd.pie.sweepAngle, 0, cmd.pie.color, cmd.pie.clockwise);
-                    break;
-
-                case DrawList::CommandType::OUTLINE_PIE:
-                    g_plugin->d2d->pie(cmd.outline_pie.x, cmd.outline_pie.y, cmd.outline_pie.r, cmd.outline_pie.startAngle,
-                        cmd.outline_pie.sweepAngle, cmd.outline_pie.thickness, cmd.outline_pie.color, cmd.outline_pie.clockwise);
-                    break;
-
-                case DrawList::CommandType::RING:
-                    g_plugin->d2d->ring(cmd.ring.x, cmd.ring.y, cmd.ring.outerRadius, cmd.ring.innerRadius, cmd.ring.startAngle, cmd.ring.sweepAngle,
-                        0, cmd.ring.color, cmd.ring.clockwise);
-                    break;
-
-                case DrawList::CommandType::OUTLINE_RING:
-                    g_plugin->d2d->ring(cmd.outline_ring.x, cmd.outline_ring.y, cmd.outline_ring.outerRadius, cmd.outline_ring.innerRadius,
-                        cmd.outline_ring.startAngle, cmd.outline_ring.sweepAngle, cmd.outline_ring.thickness, cmd.outline_ring.color, cmd.outline_ring.clockwise);
-                    break;
+            // Runs on the render worker. Producers keep recording their next batches while these are being replayed.
+            std::scoped_lock replay_lock{g_plugin->replay_mtx};
+            auto& batches = g_plugin->drawlist.publish();
+
+            for (auto batch : batches) {
+                DrawList::replay(d2d, *batch, g_plugin->prepared);
+            }
+
+            {
+                auto stats = d2d.image_stats();
+                std::scoped_lock _{g_plugin->image_stats_mtx};
+                g_plugin->image_stats = stats;
+            }
+
+            // Only updates are captured, a frame the renderer skips drawing isn't a frame of the capture either.
+            std::scoped_lock _{g_plugin->capture_mtx};
+
+            if (g_plugin->capture == nullptr) {
+                return;
+            }
+
+            try {
+                auto [w, h] = d2d.surface_size();
+
+                if (!g_plugin->capture->add(batches, w, h)) {
+                    API::get()->log_info("[reframework-d2d] [capture] Wrote %u frames to %s", g_plugin->capture->captured(),
+                        g_plugin->capture->path().string().c_str());
+
+                    if (auto skipped = g_plugin->capture->skipped_images()) {
+                        API::get()->log_warn("[reframework-d2d] [capture] Left out %u draws of images made in memory", skipped);
+                    }
+
+                    g_plugin->capture.reset();
                 }
+            } catch (const std::exception& e) {
+                API::get()->log_error("[reframework-d2d] [capture] %s", e.what());
+                g_plugin->capture.reset();
             }
         },
-        g_plugin->update_d2d);
-
-    g_plugin->update_d2d = false;
+        update_d2d);
 } catch (const std::exception& e) {
     handle_error_message(e.what());
     // g_plugin->ref->functions->log_plugin->error(e.what());
@@ -414,30 +1037,33 @@ void on_begin_rendering() try {
         g_plugin->needs_init = false;
     }
 
-    auto now = Clock::now();
-
-    if (now >= g_plugin->d2d_next_frame_time) {
+    if (g_plugin->pacer.begin_update(Clock::now(), g_plugin->presents.load())) {
         auto lua_lock = API::LuaLock{};
-        auto cmds_lock = g_plugin->drawlist.acquire();
-        g_plugin->cmds = &cmds_lock;
+        auto recorder = DrawList::Recorder{*g_plugin->lua_producer};
+        g_plugin->cmds = &recorder;
 
-        cmds_lock.commands.clear();
+        g_plugin->lua_producer->reset();
 
-        for (const auto& draw_fn : g_plugin->draw_fns) {
-            try {
-                auto result = draw_fn();
+        // Between Lua states there are no scripts to run, and nowhere to pin their strings.
+        if (g_plugin->lua_strings != nullptr) {
+            g_plugin->lua_strings->begin_update();
 
-                if (!result.valid()) {
-                    sol::script_throw_on_error(g_plugin->lua, std::move(result));
+            for (const auto& draw_fn : g_plugin->draw_fns) {
+                try {
+                    auto result = draw_fn();
+
+                    if (!result.valid()) {
+                        sol::script_throw_on_error(g_plugin->lua, std::move(result));
+                    }
+                } catch (const std::exception& e) {
+                    handle_error_message(e.what());
                 }
-            } catch (const std::exception& e) {
-                handle_error_message(e.what());
             }
         }
 
         g_plugin->cmds = nullptr;
-        g_plugin->d2d_next_frame_time = now + std::chrono::duration_cast<std::chrono::milliseconds>(g_plugin->d2d_update_interval);
-        g_plugin->update_d2d = true;
+        g_plugin->lua_producer->submit();
+        g_plugin->pacer.end_update(Clock::now());
     }
 } catch (const std::exception& e) {
     handle_error_message(e.what());
@@ -457,6 +1083,12 @@ extern "C" __declspec(dllexport) bool reframework_plugin_initialize(const REFram
 
     reframework::API::initialize(param);
 
+    try {
+        g_plugin->channel = std::make_unique<SharedChannel>(g_plugin->drawlist, get_factories);
+    } catch (const std::exception& e) {
+        API::get()->log_error("[reframework-d2d] [channel] %s", e.what());
+    }
+
     param->functions->on_lua_state_created(on_ref_lua_state_created);
     param->functions->on_lua_state_destroyed(on_ref_lua_state_destroyed);
     param->functions->on_present(on_ref_frame);
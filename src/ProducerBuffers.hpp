@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+// Lets any number of threads record batches of T side by side for a single consumer. Every producer records into a buffer only it
+// touches and hands finished batches over with one atomic exchange, so producers never wait on each other or on the consumer.
+// The consumer keeps each producer's newest batch until it's replaced and sees them in a fixed order: by the order the producer was
+// created with, then by creation. A producer's batch goes away with the producer.
+//
+// Each producer also keeps a State for its thread to track what it has recorded so far. It's cleared along with the batch by its clear(),
+// if it has one.
+template <typename T, typename State = std::tuple<>> class ProducerBuffers {
+public:
+    using Batch = std::vector<T>;
+
+    class Producer {
+    public:
+        Producer(const Producer&) = delete;
+        Producer& operator=(const Producer&) = delete;
+
+        ~Producer() {
+            delete m_mailbox.exchange(nullptr);
+            delete m_recycled.exchange(nullptr);
+
+            // So the consumer notices this producer's batch is gone.
+            m_shared->submissions.fetch_add(1, std::memory_order_release);
+        }
+
+        // Everything below is only for the thread that owns the producer.
+
+        // The batch being recorded.
+        Batch& batch() { return *m_recording; }
+        State& state() { return m_state; }
+
+        // Throws away what was recorded since the last submit.
+        void reset() {
+            m_recording->clear();
+            clear_state();
+        }
+
+        // Hands the recorded batch to the consumer, replacing whatever this producer submitted before, and starts a new one.
+        void submit() {
+            auto unclaimed = m_mailbox.exchange(m_recording.release(), std::memory_order_acq_rel);
+            m_shared->submissions.fetch_add(1, std::memory_order_release);
+
+            // Reuse a batch the consumer never picked up or one it's done with before allocating.
+            auto next = unclaimed != nullptr ? unclaimed : m_recycled.exchange(nullptr, std::memory_order_acquire);
+
+            if (next != nullptr) {
+                next->clear();
+                m_recording.reset(next);
+            } else {
+                m_recording = std::make_unique<Batch>();
+            }
+
+            clear_state();
+        }
+
+        int order() const { return m_order; }
+
+    private:
+        friend class ProducerBuffers;
+
+        struct Shared {
+            std::atomic<uint64_t> submissions{};
+        };
+
+        Producer(std::shared_ptr<Shared> shared, int order)
+            : m_shared{std::move(shared)}
+            , m_order{order} {}
+
+        std::shared_ptr<Shared> m_shared{};
+        int m_order{};
+        std::unique_ptr<Batch> m_recording{std::make_unique<Batch>()};
+        std::atomic<Batch*> m_mailbox{};
+        std::atomic<Batch*> m_recycled{};
+        State m_state{};
+
+        void clear_state() {
+            if constexpr (requires { m_state.clear(); }) {
+                m_state.clear();
+            }
+        }
+    };
+
+    // Producers can be created from any thread.
+    std::shared_ptr<Producer> create_producer(int order = 0) {
+        auto producer = std::shared_ptr<Producer>{new Producer{m_shared, order}};
+        std::scoped_lock _{m_entries_mtx};
+
+        auto it = std::upper_bound(m_entries.begin(), m_entries.end(), order, [](int o, const Entry& e) { return o < e.order; });
+        m_entries.insert(it, Entry{producer, order});
+
+        return producer;
+    }
+
+    // Bumped by every submit and every producer going away. A consumer that remembers the value can tell if publish() would return
+    // anything new.
+    uint64_t submissions() const { return m_shared->submissions.load(std::memory_order_acquire); }
+
+    // Consumer only. Picks up the newest submission of every producer and returns their batches in order, skipping empty ones.
+    // The batches stay valid until the next publish.
+    const std::vector<Batch*>& publish() {
+        std::scoped_lock _{m_entries_mtx};
+        m_published.clear();
+
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            auto producer = it->producer.lock();
+
+            if (producer == nullptr) {
+                it = m_entries.erase(it);
+                continue;
+            }
+
+            if (auto submitted = producer->m_mailbox.exchange(nullptr, std::memory_order_acq_rel)) {
+                if (it->latest != nullptr) {
+                    delete producer->m_recycled.exchange(it->latest.release(), std::memory_order_acq_rel);
+                }
+
+                it->latest.reset(submitted);
+            }
+
+            if (it->latest != nullptr && !it->latest->empty()) {
+                m_published.push_back(it->latest.get());
+            }
+
+            ++it;
+        }
+
+        return m_published;
+    }
+
+    size_t producer_count() {
+        std::scoped_lock _{m_entries_mtx};
+        return m_entries.size();
+    }
+
+private:
+    struct Entry {
+        std::weak_ptr<Producer> producer{};
+        int order{};
+        std::unique_ptr<Batch> latest{};
+    };
+
+    std::shared_ptr<typename Producer::Shared> m_shared{std::make_shared<typename Producer::Shared>()};
+
+    // Only contended by create_producer, never by recording.
+    std::mutex m_entries_mtx{};
+    std::vector<Entry> m_entries{};
+    std::vector<Batch*> m_published{};
+};
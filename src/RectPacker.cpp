@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <limits>
+
+#include "RectPacker.hpp"
+
+RectPacker::RectPacker(int width, int height)
+    : m_width{width}
+    , m_height{height} {
+    clear();
+}
+
+void RectPacker::clear() {
+    m_skyline.clear();
+    m_skyline.push_back({0, 0, m_width});
+    m_used_area = 0;
+    m_released_area = 0;
+}
+
+std::optional<int> RectPacker::fit(size_t index, int w, int h) const {
+    auto x = m_skyline[index].x;
+
+    if (x + w > m_width) {
+        return std::nullopt;
+    }
+
+    auto remaining = w;
+    auto y = 0;
+
+    for (auto i = index; remaining > 0; ++i) {
+        if (i >= m_skyline.size()) {
+            return std::nullopt;
+        }
+
+        y = std::max(y, m_skyline[i].y);
+
+        if (y + h > m_height) {
+            return std::nullopt;
+        }
+
+        remaining -= m_skyline[i].w;
+    }
+
+    return y;
+}
+
+std::optional<RectPacker::Rect> RectPacker::insert(int w, int h) {
+    if (w <= 0 || h <= 0) {
+        return std::nullopt;
+    }
+
+    auto best_index = m_skyline.size();
+    auto best_bottom = std::numeric_limits<int>::max();
+    auto best_width = std::numeric_limits<int>::max();
+    auto best_y = 0;
+
+    for (size_t i = 0; i < m_skyline.size(); ++i) {
+        auto y = fit(i, w, h);
+
+        if (!y) {
+            continue;
+        }
+
+        auto bottom = *y + h;
+
+        if (bottom < best_bottom || (bottom == best_bottom && m_skyline[i].w < best_width)) {
+            best_index = i;
+            best_bottom = bottom;
+            best_width = m_skyline[i].w;
+            best_y = *y;
+        }
+    }
+
+    if (best_index == m_skyline.size()) {
+        return std::nullopt;
+    }
+
+    Rect rect{m_skyline[best_index].x, best_y, w, h};
+
+    // Raise the skyline over the new rectangle and trim or drop the segments it now shadows.
+    m_skyline.insert(m_skyline.begin() + best_index, {rect.x, rect.y + h, w});
+
+    for (auto i = best_index + 1; i < m_skyline.size();) {
+        auto& prev = m_skyline[i - 1];
+        auto& node = m_skyline[i];
+
+        if (node.x >= prev.x + prev.w) {
+            break;
+        }
+
+        auto shrink = prev.x + prev.w - node.x;
+        node.x += shrink;
+        node.w -= shrink;
+
+        if (node.w > 0) {
+            break;
+        }
+
+        m_skyline.erase(m_skyline.begin() + i);
+    }
+
+    for (size_t i = 0; i + 1 < m_skyline.size();) {
+        if (m_skyline[i].y == m_skyline[i + 1].y) {
+            m_skyline[i].w += m_skyline[i + 1].w;
+            m_skyline.erase(m_skyline.begin() + i + 1);
+        } else {
+            ++i;
+        }
+    }
+
+    m_used_area += (int64_t)w * h;
+
+    return rect;
+}
+
+void RectPacker::release(const Rect& rect) {
+    auto area = (int64_t)rect.w * rect.h;
+    m_used_area -= area;
+    m_released_area += area;
+}
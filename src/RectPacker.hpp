@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Skyline bottom-left rectangle packer. Rectangles can't be individually reclaimed, released area is only tracked so the owner can
+// decide when a page has become fragmented enough to be worth repacking from scratch.
+class RectPacker {
+public:
+    struct Rect {
+        int x{};
+        int y{};
+        int w{};
+        int h{};
+    };
+
+    RectPacker(int width, int height);
+
+    std::optional<Rect> insert(int w, int h);
+    void release(const Rect& rect);
+    void clear();
+
+    auto width() const { return m_width; }
+    auto height() const { return m_height; }
+
+    // Fraction of the page covered by live rectangles.
+    float occupancy() const { return (float)m_used_area / ((float)m_width * m_height); }
+
+    // Fraction of the page covered by released rectangles that can't be reused until the page is repacked.
+    float fragmentation() const { return (float)m_released_area / ((float)m_width * m_height); }
+
+private:
+    struct Node {
+        int x{};
+        int y{};
+        int w{};
+    };
+
+    int m_width{};
+    int m_height{};
+    int64_t m_used_area{};
+    int64_t m_released_area{};
+    std::vector<Node> m_skyline{};
+
+    std::optional<int> fit(size_t index, int w, int h) const;
+};
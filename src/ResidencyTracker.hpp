@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// Keeps track of how many bytes a set of resources has resident and in which order they were last used, so the coldest ones can be
+// evicted once a budget is exceeded. Holds no resources itself, the owner evicts whatever keys it's handed back.
+template <typename KeyT> class ResidencyTracker {
+public:
+    ResidencyTracker(uint64_t budget)
+        : m_budget{budget} {}
+
+    // Marks the key as used during frame with the given number of resident bytes.
+    void touch(const KeyT& key, uint64_t bytes, uint64_t frame) {
+        auto it = m_entries.find(key);
+
+        if (it == m_entries.end()) {
+            m_lru.emplace_front(key, bytes, frame);
+            m_entries.emplace(key, m_lru.begin());
+            m_resident += bytes;
+            return;
+        }
+
+        auto& [_, old_bytes, last_frame] = *it->second;
+        m_resident = m_resident - old_bytes + bytes;
+        old_bytes = bytes;
+        last_frame = frame;
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+    }
+
+    void remove(const KeyT& key) {
+        auto it = m_entries.find(key);
+
+        if (it == m_entries.end()) {
+            return;
+        }
+
+        m_resident -= std::get<1>(*it->second);
+        m_lru.erase(it->second);
+        m_entries.erase(it);
+    }
+
+    // Removes and returns the least recently used keys until the resident total fits the budget. Anything used during the current
+    // frame is never returned since it's still needed.
+    std::vector<KeyT> evict(uint64_t current_frame) {
+        std::vector<KeyT> evicted{};
+
+        while (m_resident > m_budget && !m_lru.empty()) {
+            auto& [key, bytes, last_frame] = m_lru.back();
+
+            if (last_frame >= current_frame) {
+                break;
+            }
+
+            evicted.push_back(key);
+            m_resident -= bytes;
+            m_entries.erase(key);
+            m_lru.pop_back();
+            ++m_evictions;
+        }
+
+        return evicted;
+    }
+
+    template <typename Pred> void remove_if(Pred pred) {
+        for (auto it = m_lru.begin(); it != m_lru.end();) {
+            if (pred(std::get<0>(*it))) {
+                m_resident -= std::get<1>(*it);
+                m_entries.erase(std::get<0>(*it));
+                it = m_lru.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void set_budget(uint64_t budget) { m_budget = budget; }
+
+    auto budget() const { return m_budget; }
+    auto resident() const { return m_resident; }
+    auto evictions() const { return m_evictions; }
+    auto size() const { return m_entries.size(); }
+
+private:
+    using Entry = std::tuple<KeyT, uint64_t, uint64_t>;
+    using ListIterator = typename std::list<Entry>::iterator;
+
+    std::list<Entry> m_lru{};
+    std::unordered_map<KeyT, ListIterator> m_entries{};
+    uint64_t m_budget{};
+    uint64_t m_resident{};
+    uint64_t m_evictions{};
+};
@@ -0,0 +1,52 @@
+#include <stdexcept>
+
+#include "reframework/API.hpp"
+
+#include "SharedChannel.hpp"
+
+SharedChannel::SharedChannel(DrawList& drawlist, std::function<const D2DPainter::Factories&()> factories, uint32_t capacity)
+    : m_recorder{drawlist, ORDER, std::move(factories), [](const std::string& msg) {
+        API::get()->log_error("[reframework-d2d] [channel] %s", msg.c_str());
+    }} {
+    auto size = (uint64_t)ChannelReader::memory_size(capacity);
+    m_mapping = CreateFileMappingA(
+        INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, REFD2D_CHANNEL_NAME);
+
+    if (m_mapping == nullptr) {
+        throw std::runtime_error{"Failed to create the channel's file mapping"};
+    }
+
+    // Another game instance in the same session already owns it.
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        CloseHandle(m_mapping);
+        throw std::runtime_error{"Channel is already in use"};
+    }
+
+    m_view = MapViewOfFile(m_mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+
+    if (m_view == nullptr) {
+        CloseHandle(m_mapping);
+        throw std::runtime_error{"Failed to map the channel"};
+    }
+
+    ChannelReader::format(m_view, capacity);
+    m_reader = std::make_unique<ChannelReader>(m_view);
+}
+
+SharedChannel::~SharedChannel() {
+    m_reader.reset();
+    UnmapViewOfFile(m_view);
+    CloseHandle(m_mapping);
+}
+
+void SharedChannel::update() {
+    m_reader->consume(m_recorder);
+
+    std::scoped_lock _{m_stats_mtx};
+    m_stats = m_reader->stats();
+}
+
+ChannelReader::Stats SharedChannel::stats() {
+    std::scoped_lock _{m_stats_mtx};
+    return m_stats;
+}
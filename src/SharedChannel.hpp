@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <windows.h>
+
+#include "ChannelReader.hpp"
+#include "ChannelRecorder.hpp"
+#include "D2DPainter.hpp"
+#include "DrawList.hpp"
+
+// The named shared memory channel other processes draw through, see include/reframework-d2d/Channel.h. Each published frame replaces
+// what the channel drew before, through its own DrawList producer.
+class SharedChannel {
+public:
+    // On top of Lua, same as native layers created with the default order.
+    static constexpr int ORDER = DrawList::LUA_ORDER + 1;
+
+    SharedChannel(DrawList& drawlist, std::function<const D2DPainter::Factories&()> factories,
+        uint32_t capacity = REFD2D_CHANNEL_DEFAULT_CAPACITY);
+    SharedChannel(const SharedChannel&) = delete;
+    SharedChannel& operator=(const SharedChannel&) = delete;
+    ~SharedChannel();
+
+    // Picks up whatever was published since the last call. Cheap when nothing was, meant to be called every frame from one thread.
+    void update();
+
+    ChannelReader::Stats stats();
+
+private:
+    HANDLE m_mapping{};
+    void* m_view{};
+    std::unique_ptr<ChannelReader> m_reader{};
+
+    ChannelRecorder m_recorder;
+
+    std::mutex m_stats_mtx{};
+    ChannelReader::Stats m_stats{};
+};
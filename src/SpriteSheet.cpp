@@ -0,0 +1,72 @@
+#include <cmath>
+#include <stdexcept>
+
+#include "SpriteSheet.hpp"
+
+SpriteSheet::SpriteSheet(std::shared_ptr<D2DImage> image)
+    : m_image{std::move(image)} {
+    if (m_image == nullptr) {
+        throw std::runtime_error{"SpriteSheet requires an image"};
+    }
+}
+
+SpriteSheet::SpriteSheet(std::shared_ptr<D2DImage> image, float cell_w, float cell_h, float margin, float spacing)
+    : SpriteSheet{std::move(image)} {
+    // Written so NaNs fail too, any of these would keep the grid below from ever reaching the edge of the image.
+    if (!(cell_w > 0.0f && cell_h > 0.0f && std::isfinite(cell_w) && std::isfinite(cell_h))) {
+        throw std::runtime_error{"SpriteSheet cell size must be positive"};
+    }
+
+    if (!(margin >= 0.0f && spacing >= 0.0f && std::isfinite(margin) && std::isfinite(spacing))) {
+        throw std::runtime_error{"SpriteSheet margin and spacing can't be negative"};
+    }
+
+    auto [w, h] = m_image->size();
+
+    // Cells are placed by index, repeatedly adding a cell much smaller than the position wouldn't move it.
+    for (auto row = 0;; ++row) {
+        auto y = margin + row * (cell_h + spacing);
+
+        if (!(y + cell_h <= h - margin)) {
+            break;
+        }
+
+        for (auto col = 0;; ++col) {
+            auto x = margin + col * (cell_w + spacing);
+
+            if (!(x + cell_w <= w - margin)) {
+                break;
+            }
+
+            m_frames.push_back({x, y, cell_w, cell_h});
+        }
+    }
+}
+
+void SpriteSheet::add_frame(const std::string& name, const Frame& frame) {
+    if (auto it = m_names.find(name); it != m_names.end()) {
+        m_frames[it->second] = frame;
+        return;
+    }
+
+    m_names.emplace(name, m_frames.size());
+    m_frames.push_back(frame);
+}
+
+std::optional<SpriteSheet::Frame> SpriteSheet::frame(size_t index) const {
+    if (index >= m_frames.size()) {
+        return std::nullopt;
+    }
+
+    return m_frames[index];
+}
+
+std::optional<SpriteSheet::Frame> SpriteSheet::frame(const std::string& name) const {
+    auto it = m_names.find(name);
+
+    if (it == m_names.end()) {
+        return std::nullopt;
+    }
+
+    return m_frames[it->second];
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "D2DImage.hpp"
+
+// A set of named sub-rectangles (frames) of a single D2DImage. Frames either come from a uniform grid or from an atlas description
+// handed to us by Lua, and are drawn via the source rectangle overload of DrawBitmap.
+class SpriteSheet {
+public:
+    struct Frame {
+        float x{};
+        float y{};
+        float w{};
+        float h{};
+    };
+
+    SpriteSheet(std::shared_ptr<D2DImage> image);
+    SpriteSheet(std::shared_ptr<D2DImage> image, float cell_w, float cell_h, float margin = 0.0f, float spacing = 0.0f);
+
+    void add_frame(const std::string& name, const Frame& frame);
+
+    // Frames are addressed either by 0 based index (in the order they were added) or by name.
+    std::optional<Frame> frame(size_t index) const;
+    std::optional<Frame> frame(const std::string& name) const;
+
+    auto& image() { return m_image; }
+    auto count() const { return m_frames.size(); }
+
+private:
+    std::shared_ptr<D2DImage> m_image{};
+    std::vector<Frame> m_frames{};
+    std::unordered_map<std::string, size_t> m_names{};
+};
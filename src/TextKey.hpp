@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+
+// How text is keyed, by D2DFont's layout cache and by the text commands that carry their hash to it.
+namespace TextKey {
+inline size_t hash(std::string_view text) {
+    return std::hash<std::string_view>{}(text);
+}
+
+// A view with its hash computed up front, so looking text up neither copies nor rehashes it.
+struct Hashed {
+    std::string_view text{};
+    size_t hash{};
+};
+
+// Transparent hash and equality for containers keyed by std::string that are looked up by view or Hashed.
+struct Hash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view text) const { return TextKey::hash(text); }
+    size_t operator()(const Hashed& key) const { return key.hash; }
+};
+
+struct Equal {
+    using is_transparent = void;
+
+    static std::string_view view(std::string_view text) { return text; }
+    static std::string_view view(const Hashed& key) { return key.text; }
+    bool operator()(const auto& a, const auto& b) const { return view(a) == view(b); }
+};
+} // namespace TextKey
@@ -0,0 +1,12 @@
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float4 color : COLOR;
+    float2 uv : TEXCOORD;
+};
+
+SamplerState sampler0 : register(s0);
+Texture2D texture0 : register(t0);
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    return input.color * texture0.Sample(sampler0, input.uv);
+}
@@ -0,0 +1,23 @@
+cbuffer vert_buffer : register(b0) {
+    float4x4 mvp;
+};
+
+struct VS_INPUT {
+    float2 pos : POSITION;
+    float4 color : COLOR;
+    float2 uv : TEXCOORD;
+};
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float4 color : COLOR;
+    float2 uv : TEXCOORD;
+};
+
+PS_INPUT main(VS_INPUT input) {
+    PS_INPUT output;
+    output.pos = mul(mvp, float4(input.pos.xy, 0.0f, 1.0f));
+    output.color = input.color;
+    output.uv = input.uv;
+    return output;
+}
@@ -0,0 +1,7 @@
+// The public headers have to stay usable from C.
+#include "reframework-d2d/API.h"
+#include "reframework-d2d/Channel.h"
+
+uint32_t api_c_version_major(void) {
+    return REFD2D_API_VERSION_MAJOR;
+}
@@ -0,0 +1,232 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "reframework-d2d/API.hpp"
+
+#include "Check.hpp"
+
+// In ApiC.c, which includes the C headers as C.
+extern "C" uint32_t api_c_version_major();
+
+// The C++ wrapper in API.hpp against a stub function table. The DLL's side of the table needs D2D, this covers what native plugins
+// compile into themselves: handle ownership, errors turned into exceptions and arguments passed through.
+namespace {
+struct Call {
+    std::string name{};
+    uintptr_t handle{};
+    std::vector<float> args{};
+};
+
+std::vector<Call> g_calls{};
+uintptr_t g_next_handle{1};
+std::string g_error{};
+
+template <typename Handle> Handle make_handle() {
+    return (Handle)g_next_handle++;
+}
+
+void log(const char* name, const void* handle, std::vector<float> args = {}) {
+    g_calls.push_back({name, (uintptr_t)handle, std::move(args)});
+}
+
+REFD2DApi make_api() {
+    REFD2DApi api{};
+    api.size = sizeof(REFD2DApi);
+    api.version_major = REFD2D_API_VERSION_MAJOR;
+    api.version_minor = REFD2D_API_VERSION_MINOR;
+    api.last_error = [] { return g_error.c_str(); };
+    api.surface_size = [](uint32_t* w, uint32_t* h) {
+        *w = 1920;
+        *h = 1080;
+    };
+
+    // Names starting with "fail" fail, like a missing file or an uninitialized plugin would.
+    api.create_layer = [](const char* name, int order) -> REFD2DLayerHandle {
+        if (std::strncmp(name, "fail", 4) == 0) {
+            g_error = "No layer for you";
+            return nullptr;
+        }
+
+        auto layer = make_handle<REFD2DLayerHandle>();
+        log("create_layer", layer, {(float)order});
+        return layer;
+    };
+    api.destroy_layer = [](REFD2DLayerHandle layer) { log("destroy_layer", layer); };
+    api.begin = [](REFD2DLayerHandle layer) { log("begin", layer); };
+    api.submit = [](REFD2DLayerHandle layer) { log("submit", layer); };
+
+    api.create_font = [](const char* family, int size, bool bold, bool italic) -> REFD2DFontHandle {
+        if (std::strncmp(family, "fail", 4) == 0) {
+            g_error = "No such font";
+            return nullptr;
+        }
+
+        auto font = make_handle<REFD2DFontHandle>();
+        log("create_font", font, {(float)size, (float)bold, (float)italic});
+        return font;
+    };
+    api.destroy_font = [](REFD2DFontHandle font) { log("destroy_font", font); };
+    api.measure_text = [](REFD2DFontHandle, const char* text, float* w, float* h) {
+        if (*text == '\0') {
+            g_error = "Nothing to measure";
+            return false;
+        }
+
+        *w = (float)std::strlen(text) * 10.0f;
+        *h = 20.0f;
+        return true;
+    };
+
+    api.load_image = [](const char*) { return make_handle<REFD2DImageHandle>(); };
+    api.destroy_image = [](REFD2DImageHandle image) { log("destroy_image", image); };
+    api.image_size = [](REFD2DImageHandle, uint32_t* w, uint32_t* h) {
+        *w = 64;
+        *h = 32;
+    };
+
+    api.fill_rect = [](REFD2DLayerHandle layer, float x, float y, float w, float h, uint32_t color) {
+        log("fill_rect", layer, {x, y, w, h, (float)(color >> 24)});
+    };
+    api.image = [](REFD2DLayerHandle layer, REFD2DImageHandle, float x, float y, float w, float h, float alpha) {
+        log("image", layer, {x, y, w, h, alpha});
+    };
+    api.fill_circle = [](REFD2DLayerHandle layer, float x, float y, float rx, float ry, uint32_t) {
+        log("fill_circle", layer, {x, y, rx, ry});
+    };
+    api.pie = [](REFD2DLayerHandle layer, float, float, float, float, float, uint32_t, bool clockwise) {
+        log("pie", layer, {(float)clockwise});
+    };
+    api.push_transform = [](REFD2DLayerHandle layer, float m11, float m12, float m21, float m22, float dx, float dy) {
+        log("push_transform", layer, {m11, m12, m21, m22, dx, dy});
+    };
+    api.push_clip = [](REFD2DLayerHandle layer, float x, float y, float w, float h) { log("push_clip", layer, {x, y, w, h}); };
+    api.polyline = [](REFD2DLayerHandle layer, const float* points, uint32_t count, float, uint32_t, bool closed) {
+        log("polyline", layer, {points[0], points[count * 2 - 1], (float)count, (float)closed});
+    };
+
+    return api;
+}
+
+int count(const char* name, uintptr_t handle) {
+    auto n = 0;
+
+    for (const auto& call : g_calls) {
+        n += call.name == name && call.handle == handle;
+    }
+
+    return n;
+}
+
+void ownership() {
+    auto api = make_api();
+    g_calls.clear();
+
+    uintptr_t first{};
+    uintptr_t second{};
+
+    {
+        refd2d::Layer layer{&api, "overlay"};
+        first = (uintptr_t)layer.handle();
+        CHECK(layer && g_calls.back().args == std::vector<float>{REFD2D_LUA_LAYER_ORDER + 1});
+
+        // Moving hands the handle over, it's destroyed once by whoever has it last.
+        refd2d::Layer moved{std::move(layer)};
+        CHECK(!layer && (uintptr_t)moved.handle() == first);
+
+        refd2d::Layer other{&api, "other", -5};
+        second = (uintptr_t)other.handle();
+        CHECK(g_calls.back().args == std::vector<float>{-5.0f});
+
+        // Assigning over a handle destroys it first.
+        other = std::move(moved);
+        CHECK(count("destroy_layer", second) == 1);
+        CHECK(count("destroy_layer", first) == 0);
+    }
+
+    CHECK(count("destroy_layer", first) == 1);
+    CHECK(count("destroy_layer", second) == 1);
+
+    // Nothing to destroy.
+    auto calls = g_calls.size();
+    refd2d::Layer empty{};
+    CHECK(!empty);
+    empty.reset();
+    CHECK(g_calls.size() == calls);
+}
+
+void errors() {
+    auto api = make_api();
+    g_calls.clear();
+
+    // Failures throw with last_error's message.
+    std::string message{};
+
+    try {
+        refd2d::Layer layer{&api, "fail"};
+    } catch (const std::runtime_error& e) {
+        message = e.what();
+    }
+
+    CHECK(message == "No layer for you");
+
+    CHECK_THROWS((refd2d::Font{&api, "fail", 12}));
+    CHECK(g_calls.empty());
+
+    refd2d::Font font{&api, "Consolas", 12, true};
+    CHECK(g_calls.back().args == (std::vector<float>{12.0f, 1.0f, 0.0f}));
+
+    auto [w, h] = font.measure("abc");
+    CHECK(w == 30.0f && h == 20.0f);
+    CHECK_THROWS(font.measure(""));
+}
+
+void drawing() {
+    auto api = make_api();
+    refd2d::Layer layer{&api, "overlay"};
+    refd2d::Image image{&api, "image.png"};
+    g_calls.clear();
+
+    layer.begin();
+    layer.fill_rect(1, 2, 3, 4, 0x80FFFFFF);
+    // Without a size, the image's own.
+    layer.image(image, 5, 6);
+    layer.image(image, 5, 6, 7, 8, 0.5f);
+    layer.fill_circle(10, 20, 5, 0xFFFFFFFF);
+    layer.pie(0, 0, 1, 0, 90, 0xFFFFFFFF);
+    layer.push_transform(1, 0, 0, 1, 30, 40);
+    layer.push_clip(0, 0, 100, 50);
+    const float points[]{1, 2, 3, 4, 5, 6};
+    layer.polyline(points, 3, 1, 0xFFFFFFFF, true);
+    layer.submit();
+
+    std::vector<std::string> names{};
+
+    for (const auto& call : g_calls) {
+        names.push_back(call.name);
+        CHECK(call.handle == (uintptr_t)layer.handle());
+    }
+
+    CHECK((names == std::vector<std::string>{"begin", "fill_rect", "image", "image", "fill_circle", "pie", "push_transform", "push_clip",
+                        "polyline", "submit"}));
+    CHECK((g_calls[1].args == std::vector<float>{1, 2, 3, 4, 0x80}));
+    CHECK((g_calls[2].args == std::vector<float>{5, 6, 64, 32, 1}));
+    CHECK((g_calls[3].args == std::vector<float>{5, 6, 7, 8, 0.5f}));
+    CHECK((g_calls[4].args == std::vector<float>{10, 20, 5, 5}));
+    CHECK((g_calls[5].args == std::vector<float>{1}));
+    CHECK((g_calls[6].args == std::vector<float>{1, 0, 0, 1, 30, 40}));
+    CHECK((g_calls[7].args == std::vector<float>{0, 0, 100, 50}));
+    CHECK((g_calls[8].args == std::vector<float>{1, 6, 3, 1}));
+
+    auto [sw, sh] = refd2d::surface_size(&api);
+    CHECK(sw == 1920 && sh == 1080);
+}
+} // namespace
+
+int main() {
+    CHECK(api_c_version_major() == REFD2D_API_VERSION_MAJOR);
+    ownership();
+    errors();
+    drawing();
+    return check::result();
+}
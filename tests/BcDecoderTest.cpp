@@ -0,0 +1,143 @@
+#include <cstring>
+
+#include "BcDecoder.hpp"
+
+#include "Check.hpp"
+
+// Hand encoded blocks, the expected texels were worked out from the format descriptions in the D3D functional spec.
+namespace {
+using Texels = uint8_t[16][4];
+
+bool texel_is(const Texels& texels, int i, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    return texels[i][0] == r && texels[i][1] == g && texels[i][2] == b && texels[i][3] == a;
+}
+
+void bc1_four_colors() {
+    // Red and blue endpoints, c0 > c1. Each row picks palette entries 0, 1, 2, 3 from left to right.
+    const uint8_t block[8]{0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4};
+    Texels texels{};
+    BcDecoder::decode_bc1(block, texels);
+
+    for (auto row = 0; row < 4; ++row) {
+        CHECK(texel_is(texels, row * 4 + 0, 255, 0, 0, 255));
+        CHECK(texel_is(texels, row * 4 + 1, 0, 0, 255, 255));
+        CHECK(texel_is(texels, row * 4 + 2, 170, 0, 85, 255));
+        CHECK(texel_is(texels, row * 4 + 3, 85, 0, 170, 255));
+    }
+}
+
+void bc1_punchthrough() {
+    // Same endpoints swapped, c0 <= c1 selects three colors and transparent black.
+    const uint8_t block[8]{0x1F, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4};
+    Texels texels{};
+    BcDecoder::decode_bc1(block, texels);
+
+    CHECK(texel_is(texels, 0, 0, 0, 255, 255));
+    CHECK(texel_is(texels, 1, 255, 0, 0, 255));
+    CHECK(texel_is(texels, 2, 127, 0, 127, 255));
+    CHECK(texel_is(texels, 3, 0, 0, 0, 0));
+}
+
+void bc1_expands_565() {
+    // White and black, the 5 and 6 bit channels have to replicate their high bits to reach 255.
+    const uint8_t block[8]{0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x55};
+    Texels texels{};
+    BcDecoder::decode_bc1(block, texels);
+
+    CHECK(texel_is(texels, 0, 255, 255, 255, 255));
+    CHECK(texel_is(texels, 12, 0, 0, 0, 255));
+    CHECK(texel_is(texels, 15, 0, 0, 0, 255));
+}
+
+void bc2_explicit_alpha() {
+    // Texel i has alpha nibble i. The color half has c0 <= c1, which BC2 still decodes with four colors.
+    uint8_t block[16]{0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE, 0x1F, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4};
+    Texels texels{};
+    BcDecoder::decode_bc2(block, texels);
+
+    for (auto i = 0; i < 16; ++i) {
+        CHECK(texels[i][3] == i * 17);
+    }
+
+    CHECK(texel_is(texels, 3, 170, 0, 85, 51));
+}
+
+void bc3_alpha() {
+    // Texel i uses alpha index i % 8.
+    const uint8_t indices[6]{0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA};
+    uint8_t block[16]{255, 0};
+    std::memcpy(block + 2, indices, 6);
+    std::memcpy(block + 8, "\x00\xF8\x1F\x00\x00\x00\x00\x00", 8);
+    Texels texels{};
+
+    // alpha0 > alpha1, eight interpolated alphas.
+    BcDecoder::decode_bc3(block, texels);
+    const uint8_t eight[8]{255, 0, 219, 182, 146, 109, 73, 36};
+
+    for (auto i = 0; i < 16; ++i) {
+        CHECK(texels[i][3] == eight[i % 8]);
+        CHECK(texels[i][0] == 255 && texels[i][2] == 0);
+    }
+
+    // alpha0 <= alpha1, six interpolated alphas plus 0 and 255.
+    block[0] = 0;
+    block[1] = 255;
+    BcDecoder::decode_bc3(block, texels);
+    const uint8_t six[8]{0, 255, 51, 102, 153, 204, 0, 255};
+
+    for (auto i = 0; i < 16; ++i) {
+        CHECK(texels[i][3] == six[i % 8]);
+    }
+}
+
+void bc7_mode6() {
+    // Mode 6: a single subset with 7 bit RGBA endpoints, one p-bit each and 4 bit indices. Endpoint 0 is (0, 127, 64, 127) with
+    // p-bit 0, endpoint 1 (127, 0, 64, 127) with p-bit 1, and texel i has index i.
+    const uint8_t block[16]{0x40, 0xC0, 0xFF, 0x0F, 0x00, 0x02, 0xFF, 0x7F, 0x11, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE};
+    const uint8_t expected[16][4]{
+        {0, 254, 128, 254},
+        {16, 238, 128, 254},
+        {36, 218, 128, 254},
+        {52, 203, 128, 254},
+        {68, 187, 128, 254},
+        {84, 171, 128, 254},
+        {104, 151, 128, 254},
+        {120, 135, 128, 254},
+        {135, 120, 129, 255},
+        {151, 104, 129, 255},
+        {171, 84, 129, 255},
+        {187, 68, 129, 255},
+        {203, 52, 129, 255},
+        {219, 37, 129, 255},
+        {239, 17, 129, 255},
+        {255, 1, 129, 255},
+    };
+    Texels texels{};
+    BcDecoder::decode_bc7(block, texels);
+
+    CHECK(std::memcmp(texels, expected, sizeof(expected)) == 0);
+}
+
+void bc7_reserved_mode() {
+    // No mode bit set within the first byte is the reserved mode 8, decoded as transparent black.
+    const uint8_t block[16]{};
+    Texels texels{};
+    std::memset(texels, 0xCD, sizeof(texels));
+    BcDecoder::decode_bc7(block, texels);
+
+    for (auto i = 0; i < 16; ++i) {
+        CHECK(texel_is(texels, i, 0, 0, 0, 0));
+    }
+}
+} // namespace
+
+int main() {
+    bc1_four_colors();
+    bc1_punchthrough();
+    bc1_expands_565();
+    bc2_explicit_alpha();
+    bc3_alpha();
+    bc7_mode6();
+    bc7_reserved_mode();
+    return check::result();
+}
@@ -0,0 +1,177 @@
+// The channel across two processes, the way the plugin and a companion process use it: a producer process writing frames as fast as
+// it can into shared memory and a slower consumer process reading them. POSIX only, the plugin maps the same layout on Windows.
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ChannelReader.hpp"
+#include "reframework-d2d/Channel.hpp"
+
+#include "Check.hpp"
+
+namespace {
+constexpr uint32_t CAPACITY = 4096;
+constexpr int FRAMES = 20000;
+constexpr uint32_t POINTS = 5;
+// The last frame, drawn at this x.
+constexpr float DONE = -1.0f;
+
+// What the producer process reports back.
+struct Produced {
+    uint64_t frames{};
+    uint64_t dropped{};
+};
+
+// Every frame draws the same value everywhere, a frame mixing values was torn.
+struct Sink : ChannelSink {
+    std::vector<float> drawn{};
+    float value{};
+    bool consistent{true};
+    int draws{};
+
+    void define_font(uint32_t, std::string_view, std::string_view, int, bool, bool) override {}
+    void define_image(uint32_t, std::string_view) override {}
+
+    void begin_frame() override { draws = 0; }
+
+    void draw(const ChannelDraw& draw) override {
+        // FILL_RECT's args are x, y, w, h, the polyline's the thickness then the points.
+        auto first = draw.type == REFD2D_CHANNEL_POLYLINE ? 1u : 0u;
+
+        if (draws == 0) {
+            value = draw.args[first];
+        }
+
+        for (auto i = first; i < draw.arg_count; ++i) {
+            consistent &= draw.args[i] == value;
+        }
+
+        ++draws;
+    }
+
+    void end_frame() override {
+        consistent &= draws == 3;
+        drawn.push_back(value);
+    }
+};
+
+// Writes frames into the channel until FRAMES of them made it, then one that says it's done.
+Produced produce(void* memory) {
+    refd2d::ChannelWriter writer{memory};
+    Produced produced{};
+    float points[POINTS * 2]{};
+
+    auto frame = [&](float value) {
+        for (auto& p : points) {
+            p = value;
+        }
+
+        writer.begin_frame();
+        writer.fill_rect(value, value, value, value, 0xFFFFFFFF);
+        writer.polyline(points, POINTS, value, 0xFFFFFFFF);
+        writer.fill_rect(value, value, value, value, 0xFFFFFFFF);
+        ++produced.frames;
+
+        if (writer.end_frame()) {
+            return true;
+        }
+
+        ++produced.dropped;
+        return false;
+    };
+
+    for (auto i = 0; i < FRAMES; ++i) {
+        frame((float)i);
+    }
+
+    // This one has to arrive, the consumer waits for it.
+    while (!frame(DONE)) {
+        usleep(100);
+    }
+
+    return produced;
+}
+
+void two_processes() {
+    auto name = "/refd2d-channel-test-" + std::to_string(getpid());
+    auto fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    CHECK(fd >= 0);
+
+    if (fd < 0) {
+        return;
+    }
+
+    // Like the plugin's file mapping, created zeroed and formatted by the consumer before anyone writes.
+    auto size = ChannelReader::memory_size(CAPACITY);
+    CHECK(ftruncate(fd, (off_t)size) == 0);
+    auto memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    shm_unlink(name.c_str());
+    CHECK(memory != MAP_FAILED);
+
+    if (memory == MAP_FAILED) {
+        return;
+    }
+
+    ChannelReader::format(memory, CAPACITY);
+
+    int report[2]{};
+    CHECK(pipe(report) == 0);
+    auto pid = fork();
+
+    if (pid == 0) {
+        close(report[0]);
+        auto produced = produce(memory);
+        auto ok = write(report[1], &produced, sizeof(produced)) == sizeof(produced);
+        _exit(ok ? 0 : 1);
+    }
+
+    close(report[1]);
+    CHECK(pid > 0);
+
+    // Slower than the producer, so it falls behind and frames get dropped.
+    ChannelReader reader{memory};
+    Sink sink{};
+
+    while (sink.drawn.empty() || sink.drawn.back() != DONE) {
+        reader.consume(sink);
+        usleep(50);
+    }
+
+    Produced produced{};
+    CHECK(read(report[0], &produced, sizeof(produced)) == sizeof(produced));
+    close(report[0]);
+
+    int status{};
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // Every frame the producer wrote was drawn, superseded by a newer one, or dropped, and only the producer knows which it dropped.
+    auto& stats = reader.stats();
+    CHECK(stats.corrupt == 0);
+    CHECK(stats.dropped == produced.dropped);
+    CHECK(stats.frames + stats.skipped + stats.dropped == produced.frames);
+    CHECK(stats.frames == sink.drawn.size());
+    CHECK(produced.dropped > 0 && stats.skipped > 0);
+
+    // Whole frames only, newest first and never going back.
+    CHECK(sink.consistent);
+    auto ordered = true;
+
+    for (size_t i = 1; i + 1 < sink.drawn.size(); ++i) {
+        ordered &= sink.drawn[i] > sink.drawn[i - 1];
+    }
+
+    CHECK(ordered);
+    munmap(memory, size);
+}
+} // namespace
+
+int main() {
+    two_processes();
+    return check::result();
+}
@@ -0,0 +1,264 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ChannelReader.hpp"
+#include "reframework-d2d/Channel.hpp"
+
+#include "Check.hpp"
+
+namespace {
+// A formatted channel in ordinary memory, the way the plugin maps it.
+struct Memory {
+    explicit Memory(uint32_t capacity)
+        : words((ChannelReader::memory_size(capacity) + 7) / 8) {
+        ChannelReader::format(data(), capacity);
+    }
+
+    std::vector<uint64_t> words{};
+
+    void* data() { return words.data(); }
+    REFD2DChannelHeader* header() { return (REFD2DChannelHeader*)data(); }
+    uint8_t* ring() { return (uint8_t*)data() + sizeof(REFD2DChannelHeader); }
+};
+
+struct Sink : ChannelSink {
+    std::vector<std::string> events{};
+
+    void define_font(uint32_t id, std::string_view path, std::string_view family, int size, bool, bool) override {
+        events.push_back("font " + std::to_string(id) + " " + std::string{path} + ":" + std::string{family} + " " + std::to_string(size));
+    }
+    void define_image(uint32_t id, std::string_view path) override {
+        events.push_back("image " + std::to_string(id) + " " + std::string{path});
+    }
+    void begin_frame() override { events.push_back("begin"); }
+    void draw(const ChannelDraw& draw) override {
+        auto first = draw.arg_count > 0 ? std::to_string((int)draw.args[0]) : std::string{};
+        events.push_back("draw " + std::to_string(draw.type) + " " + first + (draw.text.empty() ? "" : " " + std::string{draw.text}));
+    }
+    void end_frame() override { events.push_back("end"); }
+};
+
+using Events = std::vector<std::string>;
+
+// A frame with a single rectangle at x.
+bool rect_frame(refd2d::ChannelWriter& writer, float x) {
+    writer.begin_frame();
+    writer.fill_rect(x, 0, 10, 10, 0xFFFFFFFF);
+    return writer.end_frame();
+}
+
+std::string rect_event(float x) {
+    return "draw " + std::to_string(REFD2D_CHANNEL_FILL_RECT) + " " + std::to_string((int)x);
+}
+
+void basic() {
+    Memory memory{4096};
+    refd2d::ChannelWriter writer{memory.data()};
+    ChannelReader reader{memory.data()};
+    Sink sink{};
+
+    CHECK(!reader.consume(sink));
+
+    writer.begin_frame();
+    writer.define_font(1, "Consolas", 16);
+    writer.define_image(2, "C:/image.png");
+    writer.fill_rect(5, 6, 7, 8, 0xFF00FF00);
+    writer.text(1, "hi", 3, 4, 0xFFFFFFFF);
+    CHECK(writer.end_frame());
+
+    CHECK(reader.consume(sink));
+    CHECK((sink.events == Events{"begin", "font 1 :Consolas 16", "image 2 C:/image.png", rect_event(5),
+                              "draw " + std::to_string(REFD2D_CHANNEL_TEXT) + " 3 hi", "end"}));
+    CHECK(reader.stats().frames == 1 && reader.stats().corrupt == 0);
+    CHECK(memory.header()->read_pos == memory.header()->write_pos);
+
+    // Nothing new.
+    sink.events.clear();
+    CHECK(!reader.consume(sink));
+    CHECK(sink.events.empty());
+}
+
+void newest_only() {
+    Memory memory{4096};
+    refd2d::ChannelWriter writer{memory.data()};
+    ChannelReader reader{memory.data()};
+    Sink sink{};
+
+    // Definitions from the older frames still apply, their draws don't.
+    writer.begin_frame();
+    writer.define_font(1, "Arial", 12);
+    writer.fill_rect(1, 0, 1, 1, 0xFFFFFFFF);
+    CHECK(writer.end_frame());
+    CHECK(rect_frame(writer, 2));
+    CHECK(rect_frame(writer, 3));
+
+    CHECK(reader.consume(sink));
+    CHECK((sink.events == Events{"font 1 :Arial 12", "begin", rect_event(3), "end"}));
+    CHECK(reader.stats().frames == 1 && reader.stats().skipped == 2 && reader.stats().dropped == 0);
+}
+
+void wrapping() {
+    // Small enough that frames keep landing across the end of the ring and need padding.
+    Memory memory{160};
+    refd2d::ChannelWriter writer{memory.data()};
+    ChannelReader reader{memory.data()};
+    Sink sink{};
+    auto drawn = true;
+
+    for (auto i = 0; i < 50; ++i) {
+        CHECK(rect_frame(writer, (float)i));
+        sink.events.clear();
+        drawn &= reader.consume(sink) && sink.events == Events{"begin", rect_event((float)i), "end"};
+    }
+
+    CHECK(drawn);
+    CHECK(memory.header()->write_pos > 10 * 160);
+    CHECK(reader.stats().frames == 50 && reader.stats().corrupt == 0);
+}
+
+void dropped() {
+    Memory memory{160};
+    refd2d::ChannelWriter writer{memory.data()};
+    ChannelReader reader{memory.data()};
+    Sink sink{};
+
+    // Two 56 byte frames fill the ring. The consumer is behind, so the next ones don't fit and are dropped whole.
+    CHECK(rect_frame(writer, 1));
+    CHECK(rect_frame(writer, 2));
+    CHECK(!rect_frame(writer, 3));
+    CHECK(!rect_frame(writer, 4));
+    CHECK(reader.consume(sink));
+    CHECK((sink.events == Events{"begin", rect_event(2), "end"}));
+
+    CHECK(rect_frame(writer, 5));
+    sink.events.clear();
+    CHECK(reader.consume(sink));
+    CHECK((sink.events == Events{"begin", rect_event(5), "end"}));
+    CHECK(reader.stats().dropped == 2);
+
+    // A restarted producer carries on from next_sequence, no gap.
+    refd2d::ChannelWriter restarted{memory.data()};
+    CHECK(rect_frame(restarted, 5));
+    CHECK(reader.consume(sink));
+    CHECK(reader.stats().dropped == 2);
+
+    // Starting over from 0 isn't counted either.
+    memory.header()->next_sequence = 0;
+    refd2d::ChannelWriter reset{memory.data()};
+    CHECK(rect_frame(reset, 6));
+    CHECK(reader.consume(sink));
+    CHECK(reader.stats().dropped == 2 && reader.stats().corrupt == 0);
+}
+
+// Publishes a frame, lets corrupt mess with the ring or header, and returns what the reader made of it.
+template <typename Fn> Events corrupted(Fn&& corrupt, uint64_t* corrupt_count = nullptr) {
+    Memory memory{1024};
+    refd2d::ChannelWriter writer{memory.data()};
+    ChannelReader reader{memory.data()};
+    Sink sink{};
+
+    writer.begin_frame();
+    writer.define_font(1, "Arial", 12);
+    writer.fill_rect(1, 0, 1, 1, 0xFFFFFFFF);
+    writer.fill_rect(2, 0, 1, 1, 0xFFFFFFFF);
+    CHECK(writer.end_frame());
+
+    corrupt(memory);
+    CHECK(!reader.consume(sink));
+
+    if (corrupt_count != nullptr) {
+        *corrupt_count = reader.stats().corrupt;
+    }
+
+    // Whatever was there is skipped, the reader carries on from where the producer is.
+    CHECK(memory.header()->read_pos == memory.header()->write_pos);
+    auto events = sink.events;
+    memory.header()->write_pos = memory.header()->read_pos;
+    refd2d::ChannelWriter recovered{memory.data()};
+    recovered.begin_frame();
+    recovered.fill_rect(9, 0, 1, 1, 0xFFFFFFFF);
+    CHECK(recovered.end_frame());
+    sink.events.clear();
+    CHECK(reader.consume(sink));
+    CHECK((sink.events == Events{"begin", rect_event(9), "end"}));
+
+    return events;
+}
+
+void corrupt() {
+    // Records are FRAME_BEGIN (16 bytes), DEFINE_FONT (32), FILL_RECT (32) twice and FRAME_END (8).
+    constexpr uint64_t font = 16;
+    constexpr uint64_t rect = 48;
+    constexpr uint64_t end = 112;
+    uint64_t count{};
+
+    // write_pos further ahead than the ring is long.
+    CHECK(corrupted([](Memory& m) { m.header()->write_pos = 1024 + 8; }, &count).empty());
+    CHECK(count == 1);
+
+    // Cut off in the middle of a frame: without its FRAME_END, and inside a record.
+    CHECK(corrupted([](Memory& m) { m.header()->write_pos = end; }).empty());
+    CHECK(corrupted([](Memory& m) { m.header()->write_pos = rect + 8; }).empty());
+
+    // Sizes that are too small, unaligned or past what was published.
+    CHECK(corrupted([](Memory& m) { ((REFD2DChannelRecord*)(m.ring() + rect))->size = 4; }).empty());
+    CHECK(corrupted([](Memory& m) { ((REFD2DChannelRecord*)(m.ring() + rect))->size = 28; }).empty());
+    CHECK(corrupted([](Memory& m) { ((REFD2DChannelRecord*)(m.ring() + rect))->size = 1000; }).empty());
+
+    // A string longer than its record, an unknown type, and a draw outside of a frame.
+    CHECK(corrupted([](Memory& m) { ((REFD2DChannelDefineFont*)(m.ring() + font))->family_length = 100; }).empty());
+    CHECK(corrupted([](Memory& m) { ((REFD2DChannelRecord*)(m.ring() + rect))->type = 999; }).empty());
+    CHECK(corrupted([](Memory& m) { ((REFD2DChannelRecord*)(m.ring()))->type = REFD2D_CHANNEL_PAD; }).empty());
+
+    // A second FRAME_BEGIN before the first one ended.
+    CHECK(corrupted([](Memory& m) {
+        auto rec = (REFD2DChannelFrameBegin*)(m.ring() + rect);
+        rec->record.type = REFD2D_CHANNEL_FRAME_BEGIN;
+        rec->record.size = 32;
+    }).empty());
+}
+
+void backwards() {
+    Memory memory{1024};
+    refd2d::ChannelWriter writer{memory.data()};
+    ChannelReader reader{memory.data()};
+    Sink sink{};
+
+    CHECK(rect_frame(writer, 1));
+    CHECK(rect_frame(writer, 2));
+    CHECK(reader.consume(sink));
+
+    // write_pos behind what was already read.
+    memory.header()->write_pos -= 56;
+    CHECK(!reader.consume(sink));
+    CHECK(reader.stats().corrupt == 1);
+    CHECK(memory.header()->read_pos == memory.header()->write_pos);
+}
+
+void unformatted() {
+    std::vector<uint64_t> zeroed(ChannelReader::memory_size(1024) / 8);
+    CHECK_THROWS(ChannelReader{zeroed.data()});
+
+    Memory memory{1024};
+    memory.header()->capacity = 12;
+    CHECK_THROWS(ChannelReader{memory.data()});
+    memory.header()->capacity = 0;
+    CHECK_THROWS(ChannelReader{memory.data()});
+
+    // format rounds the capacity down to whole records.
+    Memory odd{1001};
+    CHECK(odd.header()->capacity == 1000);
+}
+} // namespace
+
+int main() {
+    basic();
+    newest_only();
+    wrapping();
+    dropped();
+    corrupt();
+    backwards();
+    unformatted();
+    return check::result();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdio>
+#include <exception>
+
+// Just enough of a test framework for the portable parts of the plugin. Every test is an executable whose main runs its cases and
+// returns check::result(), ctest runs them.
+namespace check {
+inline int g_failures{};
+
+inline void fail(const char* file, int line, const char* expr) {
+    std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expr);
+    ++g_failures;
+}
+
+inline int result() {
+    if (g_failures > 0) {
+        std::fprintf(stderr, "%d checks failed\n", g_failures);
+    }
+
+    return g_failures == 0 ? 0 : 1;
+}
+} // namespace check
+
+#define CHECK(...) ((__VA_ARGS__) ? (void)0 : check::fail(__FILE__, __LINE__, #__VA_ARGS__))
+
+#define CHECK_THROWS(...)                                                                                                              \
+    do {                                                                                                                               \
+        auto thrown_ = false;                                                                                                          \
+        try {                                                                                                                          \
+            (void)(__VA_ARGS__);                                                                                                       \
+        } catch (const std::exception&) {                                                                                              \
+            thrown_ = true;                                                                                                            \
+        }                                                                                                                              \
+        if (!thrown_) {                                                                                                                \
+            check::fail(__FILE__, __LINE__, "throws " #__VA_ARGS__);                                                                   \
+        }                                                                                                                              \
+    } while (false)
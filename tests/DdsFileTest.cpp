@@ -0,0 +1,261 @@
+#include <cstring>
+#include <vector>
+
+#include "DdsFile.hpp"
+
+#include "Check.hpp"
+
+namespace {
+constexpr uint32_t DDPF_ALPHAPIXELS = 0x1;
+constexpr uint32_t DDPF_FOURCC = 0x4;
+constexpr uint32_t DDPF_RGB = 0x40;
+
+constexpr uint32_t DXGI_FORMAT_R8G8B8A8_UNORM = 28;
+constexpr uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+constexpr uint32_t DXGI_FORMAT_R32_FLOAT = 41;
+
+void put_u32(std::vector<uint8_t>& file, size_t offset, uint32_t value) {
+    std::memcpy(file.data() + offset, &value, 4);
+}
+
+// The magic and DDS_HEADER, with the pixel format left to the caller. Offsets are from the start of the file.
+std::vector<uint8_t> header(uint32_t width, uint32_t height) {
+    std::vector<uint8_t> file(128);
+    std::memcpy(file.data(), "DDS ", 4);
+    put_u32(file, 4, 124);
+    put_u32(file, 12, height);
+    put_u32(file, 16, width);
+    put_u32(file, 76, 32);
+    return file;
+}
+
+std::vector<uint8_t> bgra8(uint32_t width, uint32_t height, bool alpha) {
+    auto file = header(width, height);
+    put_u32(file, 80, DDPF_RGB | (alpha ? DDPF_ALPHAPIXELS : 0));
+    put_u32(file, 88, 32);
+    put_u32(file, 92, 0x00FF0000);
+    put_u32(file, 96, 0x0000FF00);
+    put_u32(file, 100, 0x000000FF);
+    put_u32(file, 104, alpha ? 0xFF000000 : 0);
+    return file;
+}
+
+std::vector<uint8_t> fourcc(uint32_t width, uint32_t height, const char* code) {
+    auto file = header(width, height);
+    put_u32(file, 80, DDPF_FOURCC);
+    std::memcpy(file.data() + 84, code, 4);
+    return file;
+}
+
+std::vector<uint8_t> dx10(uint32_t width, uint32_t height, uint32_t format, uint32_t alpha_mode = 0, uint32_t dimension = 3) {
+    auto file = fourcc(width, height, "DX10");
+    file.resize(file.size() + 20);
+    put_u32(file, 128, format);
+    put_u32(file, 132, dimension);
+    put_u32(file, 144, alpha_mode);
+    return file;
+}
+
+void append(std::vector<uint8_t>& file, const std::vector<uint8_t>& data) {
+    file.insert(file.end(), data.begin(), data.end());
+}
+
+void uncompressed() {
+    // 2x1, straight alpha BGRA: half transparent, then opaque.
+    auto file = bgra8(2, 1, true);
+    append(file, {200, 100, 50, 128, 1, 2, 3, 255});
+    DdsFile dds{file};
+
+    CHECK(dds.format() == DdsFile::Format::BGRA8);
+    CHECK(dds.alpha_mode() == DdsFile::AlphaMode::STRAIGHT);
+    CHECK(dds.pitch() == 8);
+    CHECK(dds.data_size() == 8);
+
+    uint8_t out[8]{};
+    dds.decode_bgra(out, sizeof(out));
+    const uint8_t expected[8]{100, 50, 25, 128, 1, 2, 3, 255};
+    CHECK(std::memcmp(out, expected, sizeof(out)) == 0);
+}
+
+void opaque_without_alpha_mask() {
+    auto file = bgra8(1, 1, false);
+    append(file, {10, 20, 30, 0});
+    DdsFile dds{file};
+    CHECK(dds.alpha_mode() == DdsFile::AlphaMode::OPAQUE);
+
+    uint8_t out[4]{};
+    dds.decode_bgra(out, sizeof(out));
+    const uint8_t expected[4]{10, 20, 30, 255};
+    CHECK(std::memcmp(out, expected, sizeof(out)) == 0);
+}
+
+void dx10_premultiplied_rgba() {
+    // Already premultiplied, only the channels get swapped.
+    auto file = dx10(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, 2);
+    append(file, {10, 20, 30, 40});
+    DdsFile dds{file};
+
+    CHECK(dds.format() == DdsFile::Format::RGBA8);
+    CHECK(dds.alpha_mode() == DdsFile::AlphaMode::PREMULTIPLIED);
+
+    uint8_t out[4]{};
+    dds.decode_bgra(out, sizeof(out));
+    const uint8_t expected[4]{30, 20, 10, 40};
+    CHECK(std::memcmp(out, expected, sizeof(out)) == 0);
+}
+
+void bc1_edges() {
+    // 5x6 is 2x2 blocks with partial ones along the right and bottom. Block x is solid red on the left, blue on the right.
+    auto file = fourcc(5, 6, "DXT1");
+    const std::vector<uint8_t> red{0x00, 0xF8, 0x00, 0xF8, 0, 0, 0, 0};
+    const std::vector<uint8_t> blue{0x1F, 0x00, 0x1F, 0x00, 0, 0, 0, 0};
+
+    for (auto by = 0; by < 2; ++by) {
+        append(file, red);
+        append(file, blue);
+    }
+
+    DdsFile dds{file};
+    CHECK(dds.format() == DdsFile::Format::BC1);
+    CHECK(dds.is_block_compressed());
+    CHECK(dds.pitch() == 16);
+    CHECK(dds.data_size() == 32);
+
+    // A wider destination than the image, the padding must be left alone.
+    constexpr size_t pitch = 8 * 4;
+    std::vector<uint8_t> out(pitch * 6, 0xCD);
+    dds.decode_bgra(out.data(), pitch);
+
+    for (auto y = 0; y < 6; ++y) {
+        auto row = out.data() + y * pitch;
+
+        for (auto x = 0; x < 8; ++x) {
+            auto px = row + x * 4;
+
+            if (x < 4) {
+                CHECK(px[0] == 0 && px[1] == 0 && px[2] == 255 && px[3] == 255);
+            } else if (x == 4) {
+                CHECK(px[0] == 255 && px[1] == 0 && px[2] == 0 && px[3] == 255);
+            } else {
+                CHECK(px[0] == 0xCD && px[1] == 0xCD && px[2] == 0xCD && px[3] == 0xCD);
+            }
+        }
+    }
+}
+
+void bc7_block() {
+    auto file = dx10(4, 4, DXGI_FORMAT_BC7_UNORM);
+    append(file, {0x40, 0xC0, 0xFF, 0x0F, 0x00, 0x02, 0xFF, 0x7F, 0x11, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE});
+    DdsFile dds{file};
+    CHECK(dds.format() == DdsFile::Format::BC7);
+
+    // Texel 15 is (255, 1, 129, 255), opaque so premultiplying leaves it be. Texel 0 is (0, 254, 128, 254) and gets premultiplied.
+    uint8_t out[4 * 4 * 4]{};
+    dds.decode_bgra(out, 16);
+    CHECK(out[60] == 129 && out[61] == 1 && out[62] == 255 && out[63] == 255);
+    CHECK(out[0] == 127 && out[1] == 253 && out[2] == 0 && out[3] == 254);
+}
+
+void legacy_fourccs() {
+    struct {
+        const char* code;
+        DdsFile::Format format;
+        DdsFile::AlphaMode alpha;
+    } cases[]{
+        {"DXT1", DdsFile::Format::BC1, DdsFile::AlphaMode::STRAIGHT},
+        {"DXT2", DdsFile::Format::BC2, DdsFile::AlphaMode::PREMULTIPLIED},
+        {"DXT3", DdsFile::Format::BC2, DdsFile::AlphaMode::STRAIGHT},
+        {"DXT4", DdsFile::Format::BC3, DdsFile::AlphaMode::PREMULTIPLIED},
+        {"DXT5", DdsFile::Format::BC3, DdsFile::AlphaMode::STRAIGHT},
+    };
+
+    for (const auto& c : cases) {
+        auto file = fourcc(4, 4, c.code);
+        file.resize(file.size() + 16);
+        DdsFile dds{file};
+        CHECK(dds.format() == c.format);
+        CHECK(dds.alpha_mode() == c.alpha);
+    }
+}
+
+void malformed() {
+    // Too short for a header, or not a DDS at all.
+    CHECK_THROWS(DdsFile{std::vector<uint8_t>(64)});
+
+    auto bad_magic = bgra8(1, 1, true);
+    bad_magic[0] = 'X';
+    bad_magic.resize(132);
+    CHECK_THROWS(DdsFile{bad_magic});
+
+    auto bad_size = bgra8(1, 1, true);
+    put_u32(bad_size, 4, 100);
+    bad_size.resize(132);
+    CHECK_THROWS(DdsFile{bad_size});
+
+    // One byte of pixel data missing.
+    auto truncated = bgra8(2, 2, true);
+    truncated.resize(truncated.size() + 15);
+    CHECK_THROWS(DdsFile{truncated});
+
+    auto truncated_bc = fourcc(8, 8, "DXT5");
+    truncated_bc.resize(truncated_bc.size() + 63);
+    CHECK_THROWS(DdsFile{truncated_bc});
+
+    // The DX10 header cut short.
+    auto truncated_dx10 = fourcc(1, 1, "DX10");
+    truncated_dx10.resize(truncated_dx10.size() + 19);
+    CHECK_THROWS(DdsFile{truncated_dx10});
+
+    auto volume = dx10(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 4);
+    volume.resize(volume.size() + 4);
+    CHECK_THROWS(DdsFile{volume});
+
+    auto unsupported = dx10(1, 1, DXGI_FORMAT_R32_FLOAT);
+    unsupported.resize(unsupported.size() + 4);
+    CHECK_THROWS(DdsFile{unsupported});
+
+    auto unknown_fourcc = fourcc(4, 4, "ATI2");
+    unknown_fourcc.resize(unknown_fourcc.size() + 16);
+    CHECK_THROWS(DdsFile{unknown_fourcc});
+}
+
+void oversized() {
+    auto empty = bgra8(0, 1, true);
+    empty.resize(empty.size() + 4);
+    CHECK_THROWS(DdsFile{empty});
+
+    // The largest accepted size is fine as long as the data is there.
+    auto widest = fourcc(DdsFile::MAX_DIMENSION, 4, "DXT1");
+    widest.resize(widest.size() + DdsFile::MAX_DIMENSION / 4 * 8);
+    CHECK(DdsFile{widest}.data_size() == DdsFile::MAX_DIMENSION / 4 * 8);
+
+    auto too_wide = fourcc(DdsFile::MAX_DIMENSION + 1, 4, "DXT1");
+    too_wide.resize(too_wide.size() + (DdsFile::MAX_DIMENSION / 4 + 1) * 8);
+    CHECK_THROWS(DdsFile{too_wide});
+
+    auto too_tall = bgra8(1, DdsFile::MAX_DIMENSION + 1, true);
+    too_tall.resize(too_tall.size() + (DdsFile::MAX_DIMENSION + 1) * 4);
+    CHECK_THROWS(DdsFile{too_tall});
+
+    // 2^30 pixels wide wraps a 32 bit pitch to 0, which used to make a few bytes look like enough data.
+    auto wrapping = bgra8(1u << 30, 1, true);
+    wrapping.resize(wrapping.size() + 4);
+    CHECK_THROWS(DdsFile{wrapping});
+
+    auto huge = fourcc(0xFFFFFFFF, 0xFFFFFFFF, "DXT1");
+    huge.resize(huge.size() + 8);
+    CHECK_THROWS(DdsFile{huge});
+}
+} // namespace
+
+int main() {
+    uncompressed();
+    opaque_without_alpha_mask();
+    dx10_premultiplied_rgba();
+    bc1_edges();
+    bc7_block();
+    legacy_fourccs();
+    malformed();
+    oversized();
+    return check::result();
+}
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "DeviceGeneration.hpp"
+
+#include "Check.hpp"
+
+namespace {
+// Stands in for D2DImage: a device dependent part that has to go when the device changes, next to state that stays.
+struct Resource {
+    DeviceTag device{};
+    int bitmaps_created{};
+    bool has_bitmap{};
+    int pixels{42};
+
+    void draw(uint64_t generation) {
+        if (device.rebind(generation)) {
+            has_bitmap = false;
+        }
+
+        if (!has_bitmap) {
+            has_bitmap = true;
+            ++bitmaps_created;
+        }
+    }
+};
+
+void generations() {
+    auto a = DeviceGeneration::next();
+    auto b = DeviceGeneration::next();
+    CHECK(a != 0 && b != 0 && a != b);
+
+    // Never repeated, even when devices are created on several threads at once.
+    std::vector<std::vector<uint64_t>> per_thread(4);
+    std::vector<std::thread> threads{};
+
+    for (auto& generations : per_thread) {
+        threads.emplace_back([&generations] {
+            for (auto i = 0; i < 1000; ++i) {
+                generations.push_back(DeviceGeneration::next());
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<uint64_t> all{a, b};
+
+    for (const auto& generations : per_thread) {
+        all.insert(all.end(), generations.begin(), generations.end());
+    }
+
+    std::sort(all.begin(), all.end());
+    CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+    CHECK(all.front() != 0);
+}
+
+void rebind() {
+    DeviceTag tag{};
+    CHECK(tag.generation() == 0);
+
+    // Nothing was created for any device yet, so there's nothing stale.
+    CHECK(!tag.rebind(5));
+    CHECK(tag.bound_to(5) && tag.generation() == 5);
+    CHECK(!tag.rebind(5));
+
+    CHECK(tag.rebind(6));
+    CHECK(tag.bound_to(6) && !tag.bound_to(5));
+
+    // Unbound after dropping its parts by itself, the next device isn't a change either.
+    tag.unbind();
+    CHECK(tag.generation() == 0 && !tag.bound_to(6));
+    CHECK(!tag.rebind(7));
+}
+
+void device_reset() {
+    Resource resource{};
+    auto first = DeviceGeneration::next();
+
+    resource.draw(first);
+    resource.draw(first);
+    CHECK(resource.bitmaps_created == 1);
+
+    // A new device: the bitmap is recreated once, the pixels are kept.
+    auto second = DeviceGeneration::next();
+    resource.draw(second);
+    resource.draw(second);
+    CHECK(resource.bitmaps_created == 2);
+    CHECK(resource.pixels == 42);
+}
+} // namespace
+
+int main() {
+    generations();
+    rebind();
+    device_reset();
+    return check::result();
+}
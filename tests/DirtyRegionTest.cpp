@@ -0,0 +1,100 @@
+#include "DirtyRegion.hpp"
+
+#include "Check.hpp"
+
+namespace {
+bool rect_is(const DirtyRegion::Rect& r, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+    return r.x == x && r.y == y && r.w == w && r.h == h;
+}
+
+void clipping() {
+    DirtyRegion region{100, 50};
+    region.add(-10, -10, 20, 20);
+    CHECK(region.rects().size() == 1 && rect_is(region.rects()[0], 0, 0, 10, 10));
+
+    region.clear();
+    region.add(90, 40, 1000, 1000);
+    CHECK(region.rects().size() == 1 && rect_is(region.rects()[0], 90, 40, 10, 10));
+
+    // Nothing left after clipping, or nothing to begin with.
+    region.clear();
+    region.add(100, 0, 10, 10);
+    region.add(-20, 0, 20, 10);
+    region.add(0, 50, 10, 10);
+    region.add(10, 10, 0, 10);
+    region.add(10, 10, -5, 10);
+    CHECK(region.empty());
+    CHECK(region.area() == 0 && rect_is(region.bounds(), 0, 0, 0, 0));
+
+    region.add(-1000000000000, -1000000000000, 2000000000000, 2000000000000);
+    CHECK(region.rects().size() == 1 && rect_is(region.rects()[0], 0, 0, 100, 50));
+
+    region.clear();
+    region.add_all();
+    CHECK(region.area() == 5000);
+}
+
+void merging() {
+    DirtyRegion region{1000, 1000};
+
+    // Touching, the union wastes nothing.
+    region.add(0, 0, 10, 10);
+    region.add(10, 0, 10, 10);
+    CHECK(region.rects().size() == 1 && rect_is(region.rects()[0], 0, 0, 20, 10));
+
+    // Inside what's already there.
+    region.add(5, 5, 2, 2);
+    CHECK(region.rects().size() == 1 && region.area() == 200);
+
+    // Far apart, the union would be mostly empty.
+    region.add(500, 500, 10, 10);
+    CHECK(region.rects().size() == 2);
+    CHECK(region.area() == 300);
+    CHECK(rect_is(region.bounds(), 0, 0, 510, 510));
+
+    // Within MERGE_SLACK: 10x10 next to 10x10 with a 2 pixel gap is 220 of area for 200 covered.
+    region.clear();
+    region.add(0, 0, 10, 10);
+    region.add(12, 0, 10, 10);
+    CHECK(region.rects().size() == 1 && rect_is(region.rects()[0], 0, 0, 22, 10));
+
+    // Past it: a 6 pixel gap is 260 for 200.
+    region.clear();
+    region.add(0, 0, 10, 10);
+    region.add(16, 0, 10, 10);
+    CHECK(region.rects().size() == 2);
+}
+
+void chained_merges() {
+    DirtyRegion region{1000, 1000};
+    region.add(0, 0, 10, 10);
+    region.add(30, 0, 10, 10);
+    CHECK(region.rects().size() == 2);
+
+    // Filling the gap merges with the first one, and the result then absorbs the second.
+    region.add(10, 0, 20, 10);
+    CHECK(region.rects().size() == 1 && rect_is(region.rects()[0], 0, 0, 40, 10));
+}
+
+void collapse() {
+    DirtyRegion region{1000, 1000};
+
+    for (auto i = 0; i < (int)DirtyRegion::MAX_RECTS; ++i) {
+        region.add(i * 100, i * 100, 10, 10);
+    }
+
+    CHECK(region.rects().size() == DirtyRegion::MAX_RECTS);
+
+    // One too many, everything becomes the bounding box.
+    region.add(900, 900, 10, 10);
+    CHECK(region.rects().size() == 1 && rect_is(region.rects()[0], 0, 0, 910, 910));
+}
+} // namespace
+
+int main() {
+    clipping();
+    merging();
+    chained_merges();
+    collapse();
+    return check::result();
+}
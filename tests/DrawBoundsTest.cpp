@@ -0,0 +1,131 @@
+#include <cmath>
+#include <limits>
+
+#include "DrawBounds.hpp"
+
+#include "Check.hpp"
+
+namespace {
+bool rect_is(const DrawBounds::Rect& r, int left, int top, int right, int bottom) {
+    return r.left == left && r.top == top && r.right == right && r.bottom == bottom;
+}
+
+void add() {
+    DrawBounds bounds{1600, 1600};
+    CHECK(bounds.empty());
+
+    // Padded outwards to whole pixels.
+    bounds.add(10.0f, 10.0f, 20.0f, 20.0f);
+    CHECK(!bounds.empty());
+    CHECK(rect_is(bounds.bounds(), 9, 9, 21, 21));
+
+    bounds.add(100.5f, 50.0f, 110.0f, 60.25f);
+    CHECK(rect_is(bounds.bounds(), 9, 9, 111, 62));
+
+    bounds.clear();
+    CHECK(bounds.empty());
+    CHECK(bounds.tiles().empty());
+    CHECK(bounds.tile_coverage() == 0.0f);
+
+    bounds.add(500.0f, 500.0f, 501.0f, 501.0f);
+    CHECK(rect_is(bounds.bounds(), 499, 499, 502, 502));
+}
+
+void nothing_drawn() {
+    auto nan = std::numeric_limits<float>::quiet_NaN();
+    DrawBounds bounds{1600, 1600};
+
+    // Zero sized, inverted and NaN bounds don't draw anything.
+    bounds.add(10.0f, 10.0f, 10.0f, 20.0f);
+    bounds.add(10.0f, 20.0f, 20.0f, 10.0f);
+    bounds.add(nan, 0.0f, 10.0f, 10.0f);
+    bounds.add(0.0f, 0.0f, 10.0f, nan);
+    CHECK(bounds.empty());
+
+    // Neither does anything entirely off the surface.
+    bounds.add(2000.0f, 0.0f, 2100.0f, 100.0f);
+    bounds.add(-100.0f, -100.0f, -50.0f, -50.0f);
+    CHECK(bounds.empty());
+
+    DrawBounds zero{0, 0};
+    zero.add(0.0f, 0.0f, 10.0f, 10.0f);
+    CHECK(zero.empty());
+}
+
+void clamping() {
+    auto inf = std::numeric_limits<float>::infinity();
+
+    // Way past what fits in an int, the bounds stop at the surface.
+    DrawBounds huge{1600, 900};
+    huge.add(-1e10f, -1e10f, 1e10f, 1e10f);
+    CHECK(rect_is(huge.bounds(), 0, 0, 1600, 900));
+    CHECK(huge.tile_coverage() == 1.0f);
+
+    DrawBounds infinite{1600, 900};
+    infinite.add(-inf, 100.0f, inf, 200.0f);
+    CHECK(rect_is(infinite.bounds(), 0, 99, 1600, 201));
+
+    DrawBounds edge{1600, 900};
+    edge.add(1590.0f, 890.0f, 1e30f, inf);
+    CHECK(rect_is(edge.bounds(), 1589, 889, 1600, 900));
+}
+
+void tiles() {
+    // 100x100 pixel tiles.
+    DrawBounds bounds{1600, 1600};
+    bounds.add(10.0f, 10.0f, 20.0f, 20.0f);
+    bounds.add(510.0f, 10.0f, 520.0f, 20.0f);
+
+    // Two runs in the first row, trimmed to the bounds.
+    auto runs = bounds.tiles();
+    CHECK(runs.size() == 2);
+    CHECK(rect_is(runs[0], 9, 9, 100, 21));
+    CHECK(rect_is(runs[1], 500, 9, 521, 21));
+    CHECK(bounds.tile_coverage() == 112.0f / 512.0f);
+
+    // Neighbouring tiles merge into a single run per row.
+    bounds.clear();
+    bounds.add(150.0f, 150.0f, 350.0f, 160.0f);
+    bounds.add(150.0f, 250.0f, 350.0f, 260.0f);
+    runs = bounds.tiles();
+    CHECK(runs.size() == 2);
+    CHECK(rect_is(runs[0], 149, 149, 351, 200));
+    CHECK(rect_is(runs[1], 149, 200, 351, 261));
+    CHECK(bounds.tile_coverage() == 1.0f);
+
+    // Corners of the surface, the bounds are everything but only two tiles were touched.
+    bounds.clear();
+    bounds.add(0.0f, 0.0f, 10.0f, 10.0f);
+    bounds.add(1590.0f, 1590.0f, 1600.0f, 1600.0f);
+    runs = bounds.tiles();
+    CHECK(runs.size() == 2);
+    CHECK(rect_is(runs[0], 0, 0, 100, 100));
+    CHECK(rect_is(runs[1], 1500, 1500, 1600, 1600));
+    CHECK(bounds.tile_coverage() < 0.01f);
+}
+
+void uneven_tiles() {
+    // 1000 / 16 rounds up to 63 pixel tiles, the last one only has 55.
+    DrawBounds bounds{1000, 1};
+    bounds.add(950.0f, 0.0f, 1000.0f, 1.0f);
+    auto runs = bounds.tiles();
+    CHECK(runs.size() == 1);
+    CHECK(rect_is(runs[0], 949, 0, 1000, 1));
+
+    // Smaller than the grid, every pixel is a tile of its own.
+    DrawBounds small{4, 4};
+    small.add(-5.0f, -5.0f, 50.0f, 50.0f);
+    runs = small.tiles();
+    CHECK(runs.size() == 4);
+    CHECK(rect_is(runs[3], 0, 3, 4, 4));
+}
+} // namespace
+
+int main() {
+    add();
+    nothing_drawn();
+    clamping();
+    tiles();
+    uneven_tiles();
+    return check::result();
+}
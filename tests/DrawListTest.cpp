@@ -0,0 +1,139 @@
+#include "DrawList.hpp"
+
+#include "Check.hpp"
+
+// There are no fonts here, text is recorded without one.
+float DrawList::font_size(const D2DFont&) {
+    return 0.0f;
+}
+
+namespace {
+constexpr float WIDTH = 800.0f;
+constexpr float HEIGHT = 600.0f;
+
+struct Frame {
+    DrawList drawlist{};
+    std::shared_ptr<DrawList::Producer> producer{drawlist.create_producer()};
+    DrawList::Recorder cmds{*producer};
+    DrawList::Prepared prepared{};
+
+    const DrawPrepass::Draws& prepare() {
+        DrawList::prepare(producer->batch(), WIDTH, HEIGHT, prepared);
+        return prepared.draws;
+    }
+};
+
+void culling() {
+    Frame frame{};
+    frame.cmds.fill_rect(10, 10, 50, 50, 0xFFFFFFFF);
+    frame.cmds.fill_rect(-100, 10, 50, 50, 0xFFFFFFFF);
+    frame.cmds.fill_rect(WIDTH + 10, 10, 50, 50, 0xFFFFFFFF);
+    // Negative sizes extend the other way, into the surface.
+    frame.cmds.fill_rect(WIDTH + 10, 10, -50, 50, 0xFFFFFFFF);
+    // Only the stroke reaches into the surface.
+    frame.cmds.line(-20, 10, -5, 10, 2.0f, 0xFFFFFFFF);
+    frame.cmds.fill_circle(-30, -30, 20, 20, 0xFFFFFFFF);
+
+    auto& draws = frame.prepare();
+    CHECK(draws.size() == 6);
+    CHECK(!draws.culled[0] && draws.culled[1] && draws.culled[2] && !draws.culled[3] && !draws.culled[4] && draws.culled[5]);
+}
+
+void transforms() {
+    Frame frame{};
+
+    // Off the surface until moved onto it. Only draws get an entry.
+    frame.cmds.push_transform(DrawPrepass::Transform::make(200, 200, 0, 1, 1));
+    frame.cmds.fill_rect(-100, -100, 50, 50, 0xFFFFFFFF);
+    frame.cmds.push_transform(DrawPrepass::Transform::make(0, 0, 0, 10, 10));
+    frame.cmds.fill_rect(70, 0, 10, 10, 0xFFFFFFFF);
+    frame.cmds.pop_transform();
+    frame.cmds.fill_rect(70, 0, 10, 10, 0xFFFFFFFF);
+    frame.cmds.pop_transform();
+    frame.cmds.fill_rect(-100, -100, 50, 50, 0xFFFFFFFF);
+
+    auto& draws = frame.prepare();
+    CHECK(draws.size() == 4);
+    CHECK(!draws.culled[0]);
+    // 200 + 700, past the right edge.
+    CHECK(draws.culled[1]);
+    CHECK(!draws.culled[2]);
+    CHECK(draws.culled[3]);
+    CHECK(draws.left[2] == 269.0f && draws.top[2] == 199.0f);
+}
+
+void text() {
+    Frame frame{};
+    std::shared_ptr<D2DFont> font{};
+
+    // Text extends right and down from its origin.
+    frame.cmds.text(font, "left of the surface", -500, 10, 0xFFFFFFFF);
+    frame.cmds.text(font, "right of it", WIDTH + 1, 10, 0xFFFFFFFF);
+    frame.cmds.text(font, "below it", 10, HEIGHT + 1, 0xFFFFFFFF);
+
+    // A quarter turn clockwise around the origin turns right into down and down into left, all of it left of the surface.
+    frame.cmds.push_transform(DrawPrepass::Transform::make(0, 0, 90, 1, 1));
+    frame.cmds.text(font, "turned", 10, 10, 0xFFFFFFFF);
+    frame.cmds.pop_transform();
+
+    auto& draws = frame.prepare();
+    CHECK(draws.size() == 4);
+    CHECK(!draws.culled[0] && draws.culled[1] && draws.culled[2] && draws.culled[3]);
+}
+
+void colors() {
+    Frame frame{};
+    std::shared_ptr<D2DImage> image{};
+    frame.cmds.fill_rect(0, 0, 1, 1, 0x80FF0000);
+    frame.cmds.image(image, 0, 0, 1, 1);
+    frame.cmds.outline_rect(0, 0, 1, 1, 1.0f, 0xFF00FF00);
+
+    auto& draws = frame.prepare();
+    CHECK(draws.size() == 3);
+    CHECK(draws.colors[0] == 0x80FF0000 && draws.colors[2] == 0xFF00FF00);
+
+    auto& red = draws.rgba[0];
+    CHECK(red.r == 1.0f && red.g == 0.0f && red.b == 0.0f && red.a == 128.0f / 255.0f);
+    auto& green = draws.rgba[2];
+    CHECK(green.r == 0.0f && green.g == 1.0f && green.b == 0.0f && green.a == 1.0f);
+}
+
+void reuse() {
+    // Prepared is kept from batch to batch, a smaller batch mustn't see the last one's draws.
+    Frame frame{};
+
+    for (auto i = 0; i < 9; ++i) {
+        frame.cmds.fill_rect(-100, 0, 10, 10, 0xFFFFFFFF);
+    }
+
+    CHECK(frame.prepare().size() == 9);
+    frame.producer->reset();
+    frame.cmds.fill_rect(0, 0, 10, 10, 0xFFFFFFFF);
+    auto& draws = frame.prepare();
+    CHECK(draws.size() == 1 && !draws.culled[0]);
+}
+
+void recording_clip() {
+    Frame frame{};
+    frame.cmds.push_clip(0, 0, 100, 100);
+    frame.cmds.fill_rect(200, 200, 10, 10, 0xFFFFFFFF);
+    frame.cmds.fill_rect(50, 50, 10, 10, 0xFFFFFFFF);
+    frame.cmds.pop_clip();
+    frame.cmds.fill_rect(200, 200, 10, 10, 0xFFFFFFFF);
+
+    // The hidden draw was never recorded.
+    auto& batch = frame.producer->batch();
+    CHECK(batch.size() == 4);
+    CHECK(batch[1].type == DrawList::CommandType::FILL_RECT && batch[1].fill_rect.x == 50.0f);
+}
+} // namespace
+
+int main() {
+    culling();
+    transforms();
+    text();
+    colors();
+    reuse();
+    recording_clip();
+    return check::result();
+}
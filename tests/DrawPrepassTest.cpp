@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "DrawPrepass.hpp"
+#include "ProducerBuffers.hpp"
+
+#include "Check.hpp"
+
+#if defined(DRAWPREPASS_SCALAR) && defined(DRAWPREPASS_SSE2)
+#error DRAWPREPASS_SCALAR has to turn SSE2 off
+#endif
+
+namespace {
+using DrawPrepass::Rect;
+using DrawPrepass::RecordState;
+using DrawPrepass::Transform;
+
+bool near(const Rect& a, const Rect& b) {
+    return std::abs(a.left - b.left) < 1e-3f && std::abs(a.top - b.top) < 1e-3f && std::abs(a.right - b.right) < 1e-3f &&
+           std::abs(a.bottom - b.bottom) < 1e-3f;
+}
+
+void transforms() {
+    // Rotating (10, 0)-(20, 10) a quarter turn clockwise around the origin.
+    auto quarter = Transform::make(0.0f, 0.0f, 90.0f, 1.0f, 1.0f);
+    CHECK(near(DrawPrepass::transform_bounds(quarter, {10, 0, 20, 10}), {-10, 10, 0, 20}));
+
+    // Scale, then move: a then b.
+    auto t = DrawPrepass::multiply(Transform::make(0, 0, 0, 2, 3), Transform::make(5, 7, 0, 1, 1));
+    CHECK(near(DrawPrepass::transform_bounds(t, {1, 1, 2, 2}), {7, 10, 9, 13}));
+
+    CHECK(Transform{}.is_identity());
+    CHECK(Transform::make(3, 4, 0, 1, 1).is_translation());
+    CHECK(!Transform::make(3, 4, 0, 1, 1).is_identity());
+}
+
+void intersections() {
+    CHECK(near(DrawPrepass::intersect({0, 0, 100, 100}, {50, 25, 150, 75}), {50, 25, 100, 75}));
+
+    // Disjoint and merely touching rectangles leave nothing that anything could be inside of.
+    for (auto r : {DrawPrepass::intersect({0, 0, 10, 10}, {20, 20, 30, 30}), DrawPrepass::intersect({0, 0, 10, 10}, {10, 0, 20, 10})}) {
+        CHECK(DrawPrepass::outside({-1e30f, -1e30f, 1e30f, 1e30f}, r));
+        CHECK(DrawPrepass::outside({0, 0, 10, 10}, r));
+    }
+
+    // Edges that only touch the area are outside, overlapping ones aren't.
+    CHECK(DrawPrepass::outside({10, 0, 20, 10}, {0, 0, 10, 10}));
+    CHECK(!DrawPrepass::outside({9.5f, 0, 20, 10}, {0, 0, 10, 10}));
+
+    auto nan = std::nanf("");
+    CHECK(!DrawPrepass::outside({nan, nan, nan, nan}, {0, 0, 10, 10}));
+}
+
+void nested_clips() {
+    RecordState state{};
+    CHECK(!state.clipped({1000, 1000, 1001, 1001}));
+
+    state.push_clip({0, 0, 100, 100});
+    state.push_clip({50, 50, 200, 200});
+    CHECK(near(state.clip, {50, 50, 100, 100}));
+    CHECK(state.clipped({0, 0, 40, 40}));
+    CHECK(state.clipped({150, 150, 160, 160}));
+    CHECK(!state.clipped({90, 90, 110, 110}));
+
+    // Popping gives back the outer clip, popping that one clips nothing.
+    CHECK(state.pop_clip());
+    CHECK(near(state.clip, {0, 0, 100, 100}));
+    CHECK(!state.clipped({0, 0, 40, 40}));
+    CHECK(state.pop_clip());
+    CHECK(!state.clipped({150, 150, 160, 160}));
+}
+
+void empty_intersection() {
+    RecordState state{};
+    state.push_clip({0, 0, 10, 10});
+    state.push_clip({20, 20, 30, 30});
+
+    // Nothing is visible, not even what's inside either clip alone, and clipping further inside stays empty.
+    CHECK(state.clipped({0, 0, 10, 10}));
+    CHECK(state.clipped({20, 20, 30, 30}));
+    state.push_clip({0, 0, 30, 30});
+    CHECK(state.clipped({5, 5, 25, 25}));
+
+    CHECK(state.pop_clip());
+    CHECK(state.pop_clip());
+    CHECK(!state.clipped({5, 5, 6, 6}));
+}
+
+void rotated_clip() {
+    RecordState state{};
+
+    // A 45 degree turn around (100, 100): the clip becomes the rotated square's bounds.
+    state.push_transform(Transform::make(100, 100, 45, 1, 1));
+    state.push_clip({-10, -10, 10, 10});
+    auto half = 10.0f * std::sqrt(2.0f);
+    CHECK(near(state.clip, {100 - half, 100 - half, 100 + half, 100 + half}));
+
+    // Outside the square but inside its bounds is kept, bounds are conservative.
+    CHECK(!state.clipped({100 - half + 0.5f, 100 - half + 0.5f, 100 - half + 1, 100 - half + 1}));
+    CHECK(state.clipped({100 + half + 1, 100, 200, 200}));
+
+    // Popping the transform keeps the clip, it was fixed when it was pushed.
+    CHECK(state.pop_transform());
+    CHECK(state.transform.is_identity());
+    CHECK(state.clipped({100 + half + 1, 100, 200, 200}));
+
+    // A clip pushed under nested transforms sees both.
+    state.push_transform(Transform::make(0, 0, 0, 2, 2));
+    state.push_transform(Transform::make(40, 40, 0, 1, 1));
+    state.push_clip({0, 0, 5, 5});
+    CHECK(near(state.clip, {100 - half, 100 - half, 90, 90}));
+}
+
+void extra_pops() {
+    RecordState state{};
+    CHECK(!state.pop_clip());
+    CHECK(!state.pop_transform());
+
+    state.push_transform(Transform::make(5, 5, 0, 1, 1));
+    state.push_clip({0, 0, 10, 10});
+    CHECK(state.pop_clip());
+    CHECK(!state.pop_clip());
+    CHECK(state.pop_transform());
+    CHECK(!state.pop_transform());
+    CHECK(state.transform.is_identity());
+    CHECK(state.clips.empty() && state.transforms.empty());
+}
+
+// What the scalar fallback does, written out plainly. This file is built with and without DRAWPREPASS_SCALAR and both builds have
+// to match it exactly, so the SSE2 path and the fallback agree with each other.
+namespace reference {
+void unpack_color(uint32_t color, float rgba[4]) {
+    rgba[0] = (float)((color >> 16) & 0xFF) * (1.0f / 255.0f);
+    rgba[1] = (float)((color >> 8) & 0xFF) * (1.0f / 255.0f);
+    rgba[2] = (float)(color & 0xFF) * (1.0f / 255.0f);
+    rgba[3] = (float)(color >> 24) * (1.0f / 255.0f);
+}
+
+Rect point_bounds(const float* xy, size_t count, float pad) {
+    Rect r{xy[0], xy[1], xy[0], xy[1]};
+
+    for (size_t i = 1; i < count; ++i) {
+        r.left = std::min(r.left, xy[i * 2]);
+        r.top = std::min(r.top, xy[i * 2 + 1]);
+        r.right = std::max(r.right, xy[i * 2]);
+        r.bottom = std::max(r.bottom, xy[i * 2 + 1]);
+    }
+
+    return Rect{r.left - pad, r.top - pad, r.right + pad, r.bottom + pad};
+}
+
+Rect transform_bounds(const Transform& t, const Rect& r) {
+    float xy[8]{};
+    float xs[4]{r.left, r.right, r.left, r.right};
+    float ys[4]{r.top, r.top, r.bottom, r.bottom};
+
+    for (auto i = 0; i < 4; ++i) {
+        xy[i * 2] = xs[i] * t.m11 + ys[i] * t.m21 + t.dx;
+        xy[i * 2 + 1] = xs[i] * t.m12 + ys[i] * t.m22 + t.dy;
+    }
+
+    return point_bounds(xy, 4, 0.0f);
+}
+
+bool outside(const Rect& r, const Rect& area) {
+    return r.left >= area.right || r.top >= area.bottom || r.right <= area.left || r.bottom <= area.top;
+}
+} // namespace reference
+
+bool same(const Rect& a, const Rect& b) {
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+void matches_reference() {
+    for (auto color : {0x00000000u, 0xFFFFFFFFu, 0x80FF4000u, 0x01020304u, 0xFE7F3F1Fu}) {
+        float rgba[4]{};
+        float expected[4]{};
+        DrawPrepass::unpack_color(color, rgba);
+        reference::unpack_color(color, expected);
+        CHECK(rgba[0] == expected[0] && rgba[1] == expected[1] && rgba[2] == expected[2] && rgba[3] == expected[3]);
+    }
+
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<float> coord{-2000.0f, 2000.0f};
+    std::uniform_real_distribution<float> angle{0.0f, 360.0f};
+    std::uniform_real_distribution<float> scale{0.1f, 4.0f};
+    std::uniform_int_distribution<size_t> count{1, 9};
+    auto mismatches = 0;
+
+    for (auto i = 0; i < 10000; ++i) {
+        // Odd and even counts take different paths through the SSE2 loop.
+        float xy[18]{};
+        auto n = count(rng);
+
+        for (size_t j = 0; j < n * 2; ++j) {
+            xy[j] = coord(rng);
+        }
+
+        auto pad = scale(rng);
+        auto bounds = DrawPrepass::point_bounds(xy, n, pad);
+        mismatches += !same(bounds, reference::point_bounds(xy, n, pad));
+
+        auto t = Transform::make(coord(rng), coord(rng), angle(rng), scale(rng), scale(rng));
+        auto transformed = DrawPrepass::transform_bounds(t, bounds);
+        mismatches += !same(transformed, reference::transform_bounds(t, bounds));
+
+        // Snapped to a coarse grid now and then so edges touch exactly.
+        Rect area{coord(rng), coord(rng), 0.0f, 0.0f};
+        area.right = area.left + scale(rng) * 500.0f;
+        area.bottom = area.top + scale(rng) * 500.0f;
+
+        if (i % 4 == 0) {
+            area = {std::round(area.left / 100) * 100, std::round(area.top / 100) * 100, std::round(area.right / 100) * 100 + 100,
+                std::round(area.bottom / 100) * 100 + 100};
+            transformed = {std::round(transformed.left / 100) * 100, std::round(transformed.top / 100) * 100,
+                std::round(transformed.right / 100) * 100, std::round(transformed.bottom / 100) * 100};
+        }
+
+        mismatches += DrawPrepass::outside(transformed, area) != reference::outside(transformed, area);
+    }
+
+    CHECK(mismatches == 0);
+}
+
+void batch_passes() {
+    // Counts that aren't a multiple of 4 and a run that doesn't start on one, so the scalar tails get used too.
+    std::mt19937 rng{99};
+    std::uniform_real_distribution<float> coord{-3000.0f, 3000.0f};
+    std::uniform_real_distribution<float> size{0.0f, 400.0f};
+    auto mismatches = 0;
+
+    for (size_t count : {0, 1, 3, 4, 7, 16, 33}) {
+        DrawPrepass::Draws draws{};
+        draws.resize(count);
+        std::vector<Rect> rects(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            auto x = coord(rng);
+            auto y = coord(rng);
+            rects[i] = {x, y, x + size(rng), y + size(rng)};
+            draws.set(i, rects[i], (uint32_t)rng());
+        }
+
+        auto first = count / 3;
+        auto t = Transform::make(coord(rng), coord(rng), 37.0f, 1.5f, 0.75f);
+        DrawPrepass::transform_bounds(t, draws, first, count);
+        Rect area{-500.0f, -500.0f, 1500.0f, 1000.0f};
+        DrawPrepass::cull(draws, area);
+        DrawPrepass::unpack_colors(draws);
+
+        for (size_t i = 0; i < count; ++i) {
+            auto expected = i < first ? rects[i] : reference::transform_bounds(t, rects[i]);
+            mismatches += !same({draws.left[i], draws.top[i], draws.right[i], draws.bottom[i]}, expected);
+            mismatches += draws.culled[i] != reference::outside(expected, area);
+
+            float rgba[4]{};
+            reference::unpack_color(draws.colors[i], rgba);
+            auto& c = draws.rgba[i];
+            mismatches += c.r != rgba[0] || c.g != rgba[1] || c.b != rgba[2] || c.a != rgba[3];
+        }
+    }
+
+    CHECK(mismatches == 0);
+}
+
+void producer_state() {
+    // What a producer records with, the state has to start over with every batch.
+    ProducerBuffers<int, RecordState> buffers{};
+    auto producer = buffers.create_producer();
+
+    producer->state().push_transform(Transform::make(1, 2, 0, 1, 1));
+    producer->state().push_clip({0, 0, 10, 10});
+    producer->batch().push_back(1);
+    producer->submit();
+    CHECK(producer->state().clips.empty() && producer->state().transforms.empty());
+    CHECK(producer->state().transform.is_identity());
+    CHECK(!producer->state().clipped({100, 100, 101, 101}));
+
+    producer->state().push_clip({0, 0, 10, 10});
+    producer->reset();
+    CHECK(producer->state().clips.empty());
+
+    // The consumer only ever sees the batch.
+    auto& published = buffers.publish();
+    CHECK(published.size() == 1 && published[0]->size() == 1);
+}
+} // namespace
+
+int main() {
+    transforms();
+    intersections();
+    nested_clips();
+    empty_intersection();
+    rotated_clip();
+    extra_pops();
+    producer_state();
+    matches_reference();
+    batch_passes();
+    return check::result();
+}
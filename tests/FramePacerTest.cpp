@@ -0,0 +1,188 @@
+#include "FramePacer.hpp"
+
+#include "Check.hpp"
+
+namespace {
+using namespace std::chrono_literals;
+
+// The fake clock, time since an arbitrary start.
+FramePacer::Clock::time_point at(FramePacer::Clock::duration t) {
+    return FramePacer::Clock::time_point{} + 1h + t;
+}
+
+// Presents count times at hz, running updates that take cost each. Returns how many updates ran.
+int present(FramePacer& pacer, FramePacer::Clock::duration& now, double hz, int count, FramePacer::Clock::duration cost = 0ms) {
+    auto frame = std::chrono::duration_cast<FramePacer::Clock::duration>(FramePacer::Duration{1.0 / hz});
+    auto updates = 0;
+
+    for (auto i = 0; i < count; ++i, now += frame) {
+        // now only ever moves by whole frames, so it doubles as the present count.
+        if (pacer.begin_update(at(now), (uint64_t)(now / frame))) {
+            pacer.end_update(at(now + cost));
+            ++updates;
+        }
+    }
+
+    return updates;
+}
+
+void fixed_timestep() {
+    FramePacer pacer{60.0};
+    FramePacer::Clock::duration now{};
+
+    // 144 Hz presents don't line up with 60 Hz updates, the schedule mustn't drift towards either.
+    auto updates = present(pacer, now, 144.0, 1440);
+    CHECK(updates >= 599 && updates <= 601);
+    CHECK(pacer.dropped() == 0);
+
+    // Presenting slower than the rate updates on every present.
+    FramePacer slow{60.0};
+    now = {};
+    CHECK(present(slow, now, 30.0, 30) == 30);
+}
+
+void catch_up() {
+    FramePacer pacer{10.0};
+
+    CHECK(pacer.begin_update(at(0ms), 0));
+    pacer.end_update(at(0ms));
+
+    // Two and a half intervals late: the missed updates happen on consecutive presents, then the schedule resumes.
+    CHECK(pacer.begin_update(at(250ms), 0));
+    pacer.end_update(at(250ms));
+    CHECK(pacer.begin_update(at(251ms), 0));
+    pacer.end_update(at(251ms));
+    CHECK(!pacer.begin_update(at(252ms), 0));
+    CHECK(pacer.begin_update(at(300ms), 0));
+    pacer.end_update(at(300ms));
+    CHECK(pacer.dropped() == 0);
+}
+
+void catch_up_cap() {
+    FramePacer pacer{10.0};
+
+    CHECK(pacer.begin_update(at(0ms), 0));
+    pacer.end_update(at(0ms));
+
+    // A second long stall is more than MAX_CATCH_UP intervals behind. One update runs, the rest of the backlog is dropped and the
+    // schedule restarts from now.
+    CHECK(pacer.begin_update(at(1000ms), 0));
+    pacer.end_update(at(1000ms));
+    CHECK(pacer.dropped() == 8);
+    CHECK(!pacer.begin_update(at(1001ms), 0));
+    CHECK(!pacer.begin_update(at(1099ms), 0));
+    CHECK(pacer.begin_update(at(1100ms), 0));
+    pacer.end_update(at(1100ms));
+    CHECK(pacer.updates() == 3);
+}
+
+void present_mode() {
+    FramePacer pacer{60.0};
+    pacer.set_present_interval(3);
+    CHECK(pacer.mode() == FramePacer::Mode::PRESENT);
+
+    // Every third present, no matter how far apart they are.
+    auto pattern = 0u;
+
+    for (auto i = 0; i < 9; ++i) {
+        if (pacer.begin_update(at(i * 1s), (uint64_t)i + 1)) {
+            pacer.end_update(at(i * 1s));
+            pattern |= 1u << i;
+        }
+    }
+
+    CHECK(pattern == 0b100100100);
+
+    pacer.set_present_interval(0);
+    CHECK(pacer.mode() == FramePacer::Mode::TIME);
+    CHECK(pacer.begin_update(at(10s), 0));
+    pacer.end_update(at(10s));
+}
+
+void present_count() {
+    FramePacer pacer{60.0};
+    pacer.set_present_interval(2);
+
+    // The draw functions can get several chances per present, or none. Only presents count.
+    auto updates = 0;
+    uint64_t presents[] = {1, 1, 1, 2, 2, 3, 5, 5, 6, 6, 6, 7};
+
+    for (auto p : presents) {
+        if (pacer.begin_update(at(0ms), p)) {
+            pacer.end_update(at(0ms));
+            ++updates;
+        }
+    }
+
+    // At presents 2, 5 and 7.
+    CHECK(updates == 3);
+}
+
+void adaptive_scale() {
+    FramePacer pacer{60.0};
+    pacer.set_budget(5ms);
+    FramePacer::Clock::duration now{};
+
+    // Twice the budget halves the rate.
+    present(pacer, now, 60.0, 120, 10ms);
+    CHECK(pacer.effective_rate() > 29.9 && pacer.effective_rate() < 30.1);
+
+    auto updates = present(pacer, now, 60.0, 120, 10ms);
+    CHECK(updates >= 59 && updates <= 61);
+
+    // Never below MIN_ADAPTIVE_SCALE.
+    present(pacer, now, 60.0, 120, 100ms);
+    CHECK(pacer.effective_rate() == 60.0 * FramePacer::MIN_ADAPTIVE_SCALE);
+
+    // Back to the full rate once the updates fit again.
+    present(pacer, now, 60.0, 120, 1ms);
+    CHECK(pacer.effective_rate() == 60.0);
+
+    // Turning the budget off restores the rate right away.
+    present(pacer, now, 60.0, 120, 10ms);
+    CHECK(pacer.effective_rate() < 60.0);
+    pacer.set_budget(0ms);
+    CHECK(pacer.effective_rate() == 60.0);
+}
+
+void adaptive_present_mode() {
+    FramePacer pacer{60.0};
+    pacer.set_present_interval(2);
+    pacer.set_budget(5ms);
+    FramePacer::Clock::duration now{};
+
+    // At half the rate every 2 presents become every 4.
+    present(pacer, now, 60.0, 120, 10ms);
+    CHECK(present(pacer, now, 60.0, 240, 10ms) == 60);
+}
+
+void settings() {
+    FramePacer pacer{0.0};
+    CHECK(pacer.rate() == 1.0);
+
+    pacer.set_rate(10.0);
+    CHECK(pacer.begin_update(at(0ms), 0));
+    pacer.end_update(at(0ms));
+
+    // Reapplying the same rate keeps the schedule.
+    pacer.set_rate(10.0);
+    CHECK(!pacer.begin_update(at(50ms), 0));
+
+    // A new one starts over from the next present.
+    pacer.set_rate(20.0);
+    CHECK(pacer.begin_update(at(51ms), 0));
+    pacer.end_update(at(51ms));
+}
+} // namespace
+
+int main() {
+    fixed_timestep();
+    catch_up();
+    catch_up_cap();
+    present_mode();
+    present_count();
+    adaptive_scale();
+    adaptive_present_mode();
+    settings();
+    return check::result();
+}
@@ -0,0 +1,153 @@
+#include <array>
+#include <vector>
+
+#include "GpuTimerRing.hpp"
+
+#include "Check.hpp"
+
+namespace {
+// Results are whatever the test put in the slot, everything starts out still running on the GPU.
+struct FakeSource {
+    explicit FakeSource(int id)
+        : id{id} {}
+
+    int id{};
+    std::array<GpuTiming, 4> results{};
+    std::vector<size_t> begins{};
+    std::vector<size_t> ends{};
+    int polls{};
+
+    void begin(size_t slot) {
+        begins.push_back(slot);
+        results[slot] = {};
+    }
+
+    void end(size_t slot) { ends.push_back(slot); }
+
+    GpuTiming poll(size_t slot) {
+        ++polls;
+        return results[slot];
+    }
+};
+
+using Ring = GpuTimerRing<FakeSource, 4, 4>;
+
+GpuTiming ready(double ms) {
+    return {GpuTiming::State::READY, ms};
+}
+
+// Measures into the next slot and returns it.
+size_t measure(Ring& ring) {
+    CHECK(ring.begin());
+    ring.end();
+    return ring.source().ends.back();
+}
+
+void pending_then_ready() {
+    Ring ring{7};
+    CHECK(ring.source().id == 7);
+
+    auto slot = measure(ring);
+    CHECK(slot == 0 && ring.source().begins == std::vector<size_t>{0});
+    CHECK(ring.pending() == 1);
+
+    // Nothing to collect until the GPU is done.
+    ring.collect();
+    CHECK(ring.pending() == 1);
+    CHECK(ring.stats().samples == 0);
+
+    ring.source().results[slot] = ready(2.5);
+    ring.collect();
+    CHECK(ring.pending() == 0);
+    CHECK(ring.stats().samples == 1 && ring.stats().last_ms == 2.5);
+
+    // Collected slots aren't polled again.
+    auto polls = ring.source().polls;
+    ring.collect();
+    CHECK(ring.source().polls == polls);
+}
+
+void in_order() {
+    Ring ring{0};
+    auto first = measure(ring);
+    auto second = measure(ring);
+    CHECK(first == 0 && second == 1);
+
+    // Collected oldest first, a finished slot waits for the ones before it.
+    ring.source().results[second] = ready(1.0);
+    ring.collect();
+    CHECK(ring.pending() == 2 && ring.stats().samples == 0);
+
+    ring.source().results[first] = ready(3.0);
+    ring.collect();
+    CHECK(ring.pending() == 0 && ring.stats().samples == 2);
+    CHECK(ring.stats().last_ms == 1.0);
+}
+
+void invalid() {
+    Ring ring{0};
+    auto slot = measure(ring);
+    ring.source().results[slot] = {GpuTiming::State::INVALID, 100.0};
+    ring.collect();
+
+    // Dropped and freed, without touching the stats.
+    CHECK(ring.pending() == 0);
+    CHECK(ring.stats().dropped == 1 && ring.stats().samples == 0 && ring.stats().max_ms == 0.0);
+}
+
+void dropped_when_full() {
+    Ring ring{0};
+
+    for (auto i = 0; i < 4; ++i) {
+        measure(ring);
+    }
+
+    // Every slot is waiting, the next measurement is skipped instead of overwriting one or waiting.
+    CHECK(!ring.begin());
+    ring.end();
+    CHECK(ring.source().begins.size() == 4 && ring.source().ends.size() == 4);
+    CHECK(ring.stats().dropped == 1);
+    CHECK(ring.pending() == 4);
+
+    // Freeing the oldest slot makes room for exactly one more.
+    ring.source().results[0] = ready(1.0);
+    ring.collect();
+    CHECK(ring.pending() == 3);
+    CHECK(measure(ring) == 0);
+    CHECK(!ring.begin());
+    CHECK(ring.stats().dropped == 2);
+}
+
+void window() {
+    Ring ring{0};
+
+    for (auto ms : {1.0, 2.0, 3.0, 4.0, 5.0}) {
+        auto slot = measure(ring);
+        ring.source().results[slot] = ready(ms);
+        ring.collect();
+    }
+
+    // Only the last four count.
+    auto stats = ring.stats();
+    CHECK(stats.samples == 5);
+    CHECK(stats.average_ms == 3.5 && stats.max_ms == 5.0 && stats.last_ms == 5.0);
+
+    for (auto i = 0; i < 4; ++i) {
+        auto slot = measure(ring);
+        ring.source().results[slot] = ready(1.0);
+        ring.collect();
+    }
+
+    stats = ring.stats();
+    CHECK(stats.average_ms == 1.0 && stats.max_ms == 1.0);
+}
+} // namespace
+
+int main() {
+    pending_then_ready();
+    in_order();
+    invalid();
+    dropped_when_full();
+    window();
+    return check::result();
+}
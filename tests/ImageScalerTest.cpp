@@ -0,0 +1,156 @@
+#include <random>
+#include <vector>
+
+#include "ImageScaler.hpp"
+
+#include "Check.hpp"
+
+namespace {
+constexpr uint8_t PADDING = 0xCD;
+
+// The 2x2 box filter written out plainly. ImageScalerTest and ImageScalerScalarTest both have to match it exactly.
+std::vector<uint8_t> reference(const std::vector<uint8_t>& src, uint32_t w, uint32_t h, size_t pitch) {
+    auto dst_w = ImageScaler::half(w);
+    auto dst_h = ImageScaler::half(h);
+    std::vector<uint8_t> dst(dst_w * dst_h * 4);
+
+    for (auto y = 0u; y < dst_h; ++y) {
+        for (auto x = 0u; x < dst_w; ++x) {
+            auto x0 = x * 2;
+            auto y0 = y * 2;
+            auto x1 = x0 + 1 < w ? x0 + 1 : x0;
+            auto y1 = y0 + 1 < h ? y0 + 1 : y0;
+
+            for (auto c = 0; c < 4; ++c) {
+                auto sum = src[y0 * pitch + x0 * 4 + c] + src[y0 * pitch + x1 * 4 + c] + src[y1 * pitch + x0 * 4 + c] +
+                           src[y1 * pitch + x1 * 4 + c];
+                dst[(y * dst_w + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+            }
+        }
+    }
+
+    return dst;
+}
+
+// Downsamples a random w x h image with pitches padding bytes wider than the rows, and compares with the reference. Neither the
+// source's padding nor anything past the destination's rows may end up in or be changed by the result.
+bool matches(uint32_t w, uint32_t h, size_t src_padding, size_t dst_padding, std::mt19937& rng) {
+    auto src_pitch = w * 4 + src_padding;
+    std::vector<uint8_t> src(src_pitch * h, PADDING);
+
+    for (auto y = 0u; y < h; ++y) {
+        for (auto i = 0u; i < w * 4; ++i) {
+            src[y * src_pitch + i] = (uint8_t)rng();
+        }
+    }
+
+    auto dst_w = ImageScaler::half(w);
+    auto dst_h = ImageScaler::half(h);
+    auto dst_pitch = dst_w * 4 + dst_padding;
+    std::vector<uint8_t> dst(dst_pitch * dst_h, PADDING);
+    ImageScaler::downsample_2x(src.data(), w, h, src_pitch, dst.data(), dst_pitch);
+
+    auto expected = reference(src, w, h, src_pitch);
+    auto ok = true;
+
+    for (auto y = 0u; y < dst_h; ++y) {
+        for (size_t i = 0; i < dst_pitch; ++i) {
+            auto want = i < dst_w * 4 ? expected[y * dst_w * 4 + i] : PADDING;
+            ok &= dst[y * dst_pitch + i] == want;
+        }
+    }
+
+    return ok;
+}
+
+void sizes() {
+    CHECK(ImageScaler::half(0) == 1);
+    CHECK(ImageScaler::half(1) == 1);
+    CHECK(ImageScaler::half(2) == 1);
+    CHECK(ImageScaler::half(3) == 2);
+    CHECK(ImageScaler::half(512) == 256);
+}
+
+void known_values() {
+    // Rounds to nearest: (1 + 2 + 3 + 4 + 2) / 4 = 3, and 255s stay 255.
+    uint8_t src[16]{1, 255, 0, 255, 2, 255, 0, 255, 3, 255, 1, 255, 4, 255, 0, 255};
+    uint8_t dst[4]{};
+    ImageScaler::downsample_2x(src, 2, 2, 8, dst, 4);
+    CHECK(dst[0] == 3 && dst[1] == 255 && dst[2] == 0 && dst[3] == 255);
+
+    // An odd last column is averaged with itself: 1 x 1 stays what it was.
+    uint8_t one[4]{10, 20, 30, 40};
+    ImageScaler::downsample_2x(one, 1, 1, 4, dst, 4);
+    CHECK(dst[0] == 10 && dst[1] == 20 && dst[2] == 30 && dst[3] == 40);
+}
+
+void odd_sizes() {
+    std::mt19937 rng{5};
+    auto mismatches = 0;
+
+    // Widths around the 8 and 4 pixel steps the SSE2 loops take, odd heights, and single rows and columns.
+    for (uint32_t w : {1u, 2u, 3u, 5u, 7u, 8u, 9u, 15u, 16u, 17u, 31u, 33u}) {
+        for (uint32_t h : {1u, 2u, 3u, 7u, 16u}) {
+            mismatches += !matches(w, h, 0, 0, rng);
+        }
+    }
+
+    for (uint32_t n : {1u, 9u, 64u, 513u}) {
+        mismatches += !matches(1, n, 0, 0, rng);
+        mismatches += !matches(n, 1, 0, 0, rng);
+    }
+
+    CHECK(mismatches == 0);
+}
+
+void pitches() {
+    std::mt19937 rng{6};
+    auto mismatches = 0;
+
+    // Pitches that aren't a multiple of 16, or even of 4, on either side.
+    for (size_t src_padding : {1u, 4u, 13u, 64u}) {
+        for (size_t dst_padding : {0u, 3u, 12u}) {
+            mismatches += !matches(17, 9, src_padding, dst_padding, rng);
+            mismatches += !matches(48, 5, src_padding, dst_padding, rng);
+        }
+    }
+
+    CHECK(mismatches == 0);
+}
+
+void mip_chain() {
+    // Downsampling repeatedly down to 1 x 1, the way D2DImage builds its levels.
+    std::mt19937 rng{7};
+    uint32_t w = 300;
+    uint32_t h = 77;
+    std::vector<uint8_t> level(w * h * 4);
+
+    for (auto& b : level) {
+        b = (uint8_t)rng();
+    }
+
+    auto mismatches = 0;
+
+    while (w > 1 || h > 1) {
+        auto expected = reference(level, w, h, w * 4);
+        std::vector<uint8_t> next(expected.size());
+        ImageScaler::downsample_2x(level.data(), w, h, w * 4, next.data(), ImageScaler::half(w) * 4);
+        mismatches += next != expected;
+        level = std::move(next);
+        w = ImageScaler::half(w);
+        h = ImageScaler::half(h);
+    }
+
+    CHECK(mismatches == 0);
+    CHECK(level.size() == 4);
+}
+} // namespace
+
+int main() {
+    sizes();
+    known_values();
+    odd_sizes();
+    pitches();
+    mip_chain();
+    return check::result();
+}
@@ -0,0 +1,118 @@
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+
+#include "DrawList.hpp"
+#include "LruCache.hpp"
+#include "TextKey.hpp"
+
+#include "Check.hpp"
+
+// Counts every allocation in the test, to check that lookups don't make any.
+namespace {
+size_t g_allocations{};
+} // namespace
+
+// There are no fonts here, text is recorded without one.
+float DrawList::font_size(const D2DFont&) {
+    return 0.0f;
+}
+
+void* operator new(size_t size) {
+    ++g_allocations;
+
+    if (auto p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+using TextCache = LruCache<std::string, int, TextKey::Hash, TextKey::Equal>;
+
+TextKey::Hashed hashed(std::string_view text) {
+    return {text, TextKey::hash(text)};
+}
+
+void eviction() {
+    LruCache<int, int> cache{2};
+    cache.put(1, 10);
+    cache.put(2, 20);
+
+    // Getting 1 makes 2 the least recently used.
+    CHECK(cache.get(1) && cache.get(1)->get() == 10);
+    cache.put(3, 30);
+    CHECK(cache.size() == 2);
+    CHECK(cache.has(1) && !cache.has(2) && cache.has(3));
+
+    // Putting an existing key replaces its value and counts as a use.
+    cache.put(1, 11);
+    cache.put(4, 40);
+    CHECK(cache.get(1)->get() == 11);
+    CHECK(!cache.has(3) && cache.has(4));
+    CHECK(!cache.get(3));
+}
+
+void transparent_lookups() {
+    // Longer than any small string buffer, so making a std::string out of them would allocate.
+    const std::string_view cached{"a line of text long enough to need the heap"};
+    const std::string_view missing{"another line of text that was never cached"};
+
+    TextCache cache{4};
+    cache.put(std::string{cached}, 1);
+
+    auto before = g_allocations;
+    auto hit = cache.get(hashed(cached));
+    auto miss = cache.get(hashed(missing));
+    auto by_view = cache.get(cached);
+    auto has = cache.has(hashed(cached)) && !cache.has(hashed(missing));
+    CHECK(g_allocations == before);
+
+    CHECK(hit && hit->get() == 1);
+    CHECK(!miss);
+    CHECK(by_view && by_view->get() == 1);
+    CHECK(has);
+}
+void borrowed_text() {
+    // Text borrowed from memory the owner keeps alive is neither copied into the command nor hashed into anything allocated.
+    const std::string text(1000, 'x');
+    auto owner = std::make_shared<std::string>();
+    std::shared_ptr<D2DFont> font{};
+
+    DrawList drawlist{};
+    auto producer = drawlist.create_producer();
+    DrawList::Recorder cmds{*producer};
+    producer->batch().reserve(4);
+
+    auto before = g_allocations;
+    cmds.text(font, std::string_view{text}, owner, 10, 10, 0xFFFFFFFF);
+    CHECK(g_allocations == before);
+
+    auto& batch = producer->batch();
+    CHECK(batch.size() == 1);
+    CHECK(batch[0].text_str().data() == text.data() && batch[0].text_str().size() == text.size());
+    CHECK(batch[0].str_hash == TextKey::hash(text));
+
+    // The owned overload has to store its copy.
+    cmds.text(font, text, 10, 10, 0xFFFFFFFF);
+    CHECK(g_allocations > before);
+}
+} // namespace
+
+int main() {
+    eviction();
+    transparent_lookups();
+    borrowed_text();
+    return check::result();
+}
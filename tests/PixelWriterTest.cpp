@@ -0,0 +1,108 @@
+#include <cstring>
+#include <vector>
+
+#include "PixelWriter.hpp"
+
+#include "Check.hpp"
+
+namespace {
+bool pixel_is(const uint8_t* px, uint8_t b, uint8_t g, uint8_t r, uint8_t a) {
+    return px[0] == b && px[1] == g && px[2] == r && px[3] == a;
+}
+
+void premultiply() {
+    uint8_t px[4]{};
+
+    // Rounded to nearest.
+    auto half = PixelWriter::premultiply_argb(0x80FF8000);
+    std::memcpy(px, &half, 4);
+    CHECK(pixel_is(px, 0, 64, 128, 128));
+
+    auto opaque = PixelWriter::premultiply_argb(0xFF123456);
+    std::memcpy(px, &opaque, 4);
+    CHECK(pixel_is(px, 0x56, 0x34, 0x12, 0xFF));
+
+    CHECK(PixelWriter::premultiply_argb(0x00FFFFFF) == 0);
+}
+
+void writes() {
+    // 2x2 into a 3 pixel wide destination, from a 3 pixel wide source. The third column of each is padding.
+    const uint8_t rgba[2 * 12]{
+        255, 0, 0, 255, 0, 255, 0, 128, 9, 9, 9, 9, //
+        0, 0, 255, 0, 10, 20, 30, 255, 9, 9, 9, 9, //
+    };
+    std::vector<uint8_t> dst(2 * 12, 0xCD);
+    PixelWriter::write_rgba(dst.data(), 12, rgba, 12, 2, 2);
+
+    CHECK(pixel_is(&dst[0], 0, 0, 255, 255));
+    CHECK(pixel_is(&dst[4], 0, 128, 0, 128));
+    CHECK(pixel_is(&dst[8], 0xCD, 0xCD, 0xCD, 0xCD));
+    CHECK(pixel_is(&dst[12], 0, 0, 0, 0));
+    CHECK(pixel_is(&dst[16], 30, 20, 10, 255));
+    CHECK(pixel_is(&dst[20], 0xCD, 0xCD, 0xCD, 0xCD));
+
+    const uint32_t argb[2 * 3]{0xFFFF0000, 0x8000FF00, 0x99999999, 0x000000FF, 0xFF0A141E, 0x99999999};
+    std::fill(dst.begin(), dst.end(), 0xCD);
+    PixelWriter::write_argb(dst.data(), 12, argb, 12, 2, 2);
+
+    CHECK(pixel_is(&dst[0], 0, 0, 255, 255));
+    CHECK(pixel_is(&dst[4], 0, 128, 0, 128));
+    CHECK(pixel_is(&dst[8], 0xCD, 0xCD, 0xCD, 0xCD));
+    CHECK(pixel_is(&dst[12], 0, 0, 0, 0));
+    CHECK(pixel_is(&dst[16], 30, 20, 10, 255));
+
+    std::fill(dst.begin(), dst.end(), 0xCD);
+    PixelWriter::fill_argb(dst.data() + 4, 12, 0xFF0A141E, 2, 2);
+    CHECK(pixel_is(&dst[0], 0xCD, 0xCD, 0xCD, 0xCD));
+    CHECK(pixel_is(&dst[4], 30, 20, 10, 255) && pixel_is(&dst[8], 30, 20, 10, 255));
+    CHECK(pixel_is(&dst[12], 0xCD, 0xCD, 0xCD, 0xCD));
+    CHECK(pixel_is(&dst[16], 30, 20, 10, 255) && pixel_is(&dst[20], 30, 20, 10, 255));
+}
+
+bool clip_is(const PixelWriter::Clip& c, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t src_x, uint32_t src_y) {
+    return c.x == x && c.y == y && c.w == w && c.h == h && c.src_x == src_x && c.src_y == src_y;
+}
+
+void clipping() {
+    PixelWriter::Clip c{};
+    CHECK(PixelWriter::clip(1, 2, 3, 4, 10, 10, c) && clip_is(c, 1, 2, 3, 4, 0, 0));
+
+    // Cut off on the top left the source starts further in, on the bottom right it just gets shorter.
+    CHECK(PixelWriter::clip(-2, -3, 5, 5, 10, 10, c) && clip_is(c, 0, 0, 3, 2, 2, 3));
+    CHECK(PixelWriter::clip(8, 9, 5, 5, 10, 10, c) && clip_is(c, 8, 9, 2, 1, 0, 0));
+    CHECK(PixelWriter::clip(-5, -5, 100, 100, 10, 10, c) && clip_is(c, 0, 0, 10, 10, 5, 5));
+
+    // Sizes large enough to overflow 32 bits are still clipped correctly.
+    CHECK(!PixelWriter::clip(2147483647, 0, 0xFFFFFFFF, 1, 10, 10, c));
+    CHECK(PixelWriter::clip(-2147483647 - 1, 0, 0xFFFFFFFF, 1, 10, 10, c) && clip_is(c, 0, 0, 10, 1, 2147483648u, 0));
+
+    CHECK(!PixelWriter::clip(10, 0, 1, 1, 10, 10, c));
+    CHECK(!PixelWriter::clip(0, -1, 1, 1, 10, 10, c));
+    CHECK(!PixelWriter::clip(0, 0, 0, 5, 10, 10, c));
+    CHECK(!PixelWriter::clip(0, 0, 5, 5, 0, 0, c));
+}
+
+void clipped_write() {
+    // A 3x3 source written at (-1, -1) into a 2x2 image: what lands is the source's bottom right 2x2, the way D2DPixelImage writes.
+    uint32_t src[9]{};
+
+    for (auto i = 0u; i < 9; ++i) {
+        src[i] = 0xFF000000 | i;
+    }
+
+    uint8_t dst[2 * 2 * 4]{};
+    PixelWriter::Clip c{};
+    CHECK(PixelWriter::clip(-1, -1, 3, 3, 2, 2, c));
+    PixelWriter::write_argb(dst + (c.y * 2 + c.x) * 4, 2 * 4, src + c.src_y * 3 + c.src_x, 3 * 4, c.w, c.h);
+
+    CHECK(dst[0] == 4 && dst[4] == 5 && dst[8] == 7 && dst[12] == 8);
+}
+} // namespace
+
+int main() {
+    premultiply();
+    writes();
+    clipping();
+    clipped_write();
+    return check::result();
+}
@@ -0,0 +1,185 @@
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "ProducerBuffers.hpp"
+
+#include "Check.hpp"
+
+namespace {
+using Buffers = ProducerBuffers<uint64_t>;
+
+void order_and_replacement() {
+    Buffers buffers{};
+    auto late = buffers.create_producer(1);
+    auto early = buffers.create_producer(-1);
+    auto second = buffers.create_producer(1);
+
+    for (auto& [producer, value] : {std::pair{late, 1}, std::pair{early, 2}, std::pair{second, 3}}) {
+        producer->batch().push_back(value);
+        producer->submit();
+    }
+
+    // By order, then by creation.
+    auto& published = buffers.publish();
+    CHECK(published.size() == 3);
+    CHECK(published[0]->front() == 2 && published[1]->front() == 1 && published[2]->front() == 3);
+
+    // Only the newest submission counts, and it stays until it's replaced.
+    late->batch().push_back(4);
+    late->submit();
+    late->batch().push_back(5);
+    late->submit();
+    CHECK(buffers.publish().size() == 3 && buffers.publish()[1]->front() == 5);
+    CHECK(buffers.publish()[1]->size() == 1);
+
+    // Empty submissions hide a producer without it going away.
+    early->submit();
+    CHECK(buffers.publish().size() == 2);
+    CHECK(buffers.producer_count() == 3);
+}
+
+void going_away() {
+    Buffers buffers{};
+    auto producer = buffers.create_producer();
+    auto kept = buffers.create_producer();
+    producer->batch().push_back(1);
+    producer->submit();
+    kept->batch().push_back(2);
+    kept->submit();
+    CHECK(buffers.publish().size() == 2);
+
+    // Going away counts as a change, and takes both the published and any unclaimed batch with it.
+    auto before = buffers.submissions();
+    producer->batch().push_back(3);
+    producer->submit();
+    producer.reset();
+    CHECK(buffers.submissions() == before + 2);
+
+    auto& published = buffers.publish();
+    CHECK(published.size() == 1 && published[0]->front() == 2);
+    CHECK(buffers.producer_count() == 1);
+}
+
+void recycling() {
+    Buffers buffers{};
+    auto producer = buffers.create_producer();
+
+    // Once the consumer has replaced a batch it goes back to the producer, which records into it on its next submit.
+    producer->batch().assign(100, 1);
+    auto first = &producer->batch();
+    producer->submit();
+    buffers.publish();
+    producer->batch().push_back(2);
+    producer->submit();
+    buffers.publish();
+    CHECK(&producer->batch() != first);
+    producer->submit();
+    CHECK(&producer->batch() == first);
+    CHECK(producer->batch().empty() && producer->batch().capacity() >= 100);
+}
+
+// Batches hold copies of (producer << 32 | sequence), a consumer seeing a mix of them would have read a batch being written.
+constexpr uint64_t item(uint64_t producer, uint64_t sequence) {
+    return producer << 32 | sequence;
+}
+
+void stress() {
+    constexpr int PRODUCERS = 4;
+    constexpr uint64_t SUBMITS = 20000;
+    constexpr uint64_t CHURN = 100;
+
+    Buffers buffers{};
+    std::vector<std::shared_ptr<Buffers::Producer>> producers{};
+
+    for (auto i = 0; i < PRODUCERS; ++i) {
+        producers.push_back(buffers.create_producer(i));
+    }
+
+    std::atomic<int> running{PRODUCERS + 1};
+    std::vector<std::thread> threads{};
+
+    for (auto i = 0; i < PRODUCERS; ++i) {
+        threads.emplace_back([&, i] {
+            auto& producer = *producers[i];
+
+            for (uint64_t seq = 0; seq < SUBMITS; ++seq) {
+                producer.batch().assign(seq % 5 + 1, item(i, seq));
+                producer.submit();
+            }
+
+            running.fetch_sub(1);
+        });
+    }
+
+    // Producers coming and going while the others submit, one at a time with sequences that keep counting up.
+    threads.emplace_back([&] {
+        for (uint64_t seq = 0; seq < SUBMITS; seq += 50) {
+            auto producer = buffers.create_producer(CHURN);
+
+            for (auto i = 0; i < 50; ++i) {
+                producer->batch().assign(3, item(CHURN, seq + i));
+                producer->submit();
+            }
+        }
+
+        running.fetch_sub(1);
+    });
+
+    std::vector<uint64_t> last(CHURN + 1);
+    auto consistent = true;
+    auto ordered = true;
+    auto monotonic = true;
+    auto publishes = 0;
+
+    while (running.load() > 0) {
+        auto& published = buffers.publish();
+        uint64_t previous{};
+        ++publishes;
+
+        for (auto batch : published) {
+            auto first = batch->front();
+
+            for (auto value : *batch) {
+                consistent &= value == first;
+            }
+
+            auto id = first >> 32;
+            auto seq = first & 0xFFFFFFFF;
+            consistent &= id < PRODUCERS || id == CHURN;
+            ordered &= id >= previous;
+            monotonic &= seq >= last[id];
+            previous = id;
+            last[id] = seq;
+        }
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    CHECK(consistent);
+    CHECK(ordered);
+    CHECK(monotonic);
+    CHECK(publishes > 0);
+
+    // Once everyone is done the consumer sees every producer's last batch, and the churned ones are gone.
+    auto& published = buffers.publish();
+    CHECK(published.size() == PRODUCERS);
+
+    for (auto i = 0; i < (int)published.size(); ++i) {
+        CHECK(published[i]->size() == (SUBMITS - 1) % 5 + 1 && published[i]->front() == item(i, SUBMITS - 1));
+    }
+
+    CHECK(buffers.producer_count() == PRODUCERS);
+}
+} // namespace
+
+int main() {
+    order_and_replacement();
+    going_away();
+    recycling();
+    stress();
+    return check::result();
+}
@@ -0,0 +1,154 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "AtlasSource.hpp"
+#include "RectPacker.hpp"
+
+#include "Check.hpp"
+
+namespace {
+bool rect_is(const std::optional<RectPacker::Rect>& r, int x, int y, int w, int h) {
+    return r && r->x == x && r->y == y && r->w == w && r->h == h;
+}
+
+void invalid_sizes() {
+    RectPacker packer{64, 64};
+    CHECK(!packer.insert(0, 10));
+    CHECK(!packer.insert(10, -1));
+    CHECK(!packer.insert(65, 1));
+    CHECK(!packer.insert(1, 65));
+    CHECK(rect_is(packer.insert(64, 64), 0, 0, 64, 64));
+    CHECK(!packer.insert(1, 1));
+}
+
+void bottom_left() {
+    RectPacker packer{128, 128};
+
+    // Left to right along the bottom, then on top of the lowest part of the skyline.
+    CHECK(rect_is(packer.insert(40, 20), 0, 0, 40, 20));
+    CHECK(rect_is(packer.insert(40, 10), 40, 0, 40, 10));
+    CHECK(rect_is(packer.insert(48, 30), 80, 0, 48, 30));
+    CHECK(rect_is(packer.insert(40, 5), 40, 10, 40, 5));
+
+    // Too wide for the low spot, it goes wherever its bottom ends up lowest.
+    CHECK(rect_is(packer.insert(60, 10), 0, 20, 60, 10));
+}
+
+void exact_fit() {
+    RectPacker packer{128, 128};
+
+    for (auto i = 0; i < 4; ++i) {
+        CHECK(packer.insert(64, 64));
+    }
+
+    CHECK(!packer.insert(1, 1));
+    CHECK(packer.occupancy() == 1.0f);
+}
+
+void no_overlaps() {
+    constexpr int SIZE = 256;
+    RectPacker packer{SIZE, SIZE};
+    std::vector<int> owner(SIZE * SIZE, -1);
+    std::mt19937 rng{7};
+    std::uniform_int_distribution<int> size{1, 40};
+    auto inside = true;
+    auto overlaps = 0;
+    auto placed = 0;
+    auto area = 0;
+
+    for (auto i = 0; i < 2000; ++i) {
+        auto r = packer.insert(size(rng), size(rng));
+
+        if (!r) {
+            continue;
+        }
+
+        inside &= r->x >= 0 && r->y >= 0 && r->x + r->w <= SIZE && r->y + r->h <= SIZE;
+
+        for (auto y = r->y; y < r->y + r->h && inside; ++y) {
+            for (auto x = r->x; x < r->x + r->w; ++x) {
+                overlaps += owner[y * SIZE + x] != -1;
+                owner[y * SIZE + x] = i;
+            }
+        }
+
+        ++placed;
+        area += r->w * r->h;
+    }
+
+    CHECK(inside);
+    CHECK(overlaps == 0);
+    CHECK(placed > 50);
+    CHECK(packer.occupancy() == (float)area / (SIZE * SIZE));
+
+    // Bottom-left packing of small random sizes shouldn't waste most of the page.
+    CHECK(packer.occupancy() > 0.7f);
+}
+
+void release_and_clear() {
+    RectPacker packer{100, 100};
+    auto a = packer.insert(50, 50);
+    auto b = packer.insert(50, 50);
+    CHECK(a && b);
+    CHECK(packer.occupancy() == 0.5f && packer.fragmentation() == 0.0f);
+
+    // Released space is only accounted for, nothing is reused until the page is cleared.
+    packer.release(*a);
+    CHECK(packer.occupancy() == 0.25f && packer.fragmentation() == 0.25f);
+    CHECK(rect_is(packer.insert(50, 50), 0, 50, 50, 50));
+
+    packer.clear();
+    CHECK(packer.occupancy() == 0.0f && packer.fragmentation() == 0.0f);
+    CHECK(rect_is(packer.insert(100, 100), 0, 0, 100, 100));
+}
+void atlas_sources() {
+    // Two 16x16 images packed side by side the way the atlas does it, with a 1 pixel gutter around each.
+    constexpr int GUTTER = 1;
+    RectPacker packer{64, 64};
+    auto a = packer.insert(16 + GUTTER * 2, 16 + GUTTER * 2);
+    auto b = packer.insert(16 + GUTTER * 2, 16 + GUTTER * 2);
+    CHECK(a && b);
+
+    auto slot = [](const RectPacker::Rect& r) {
+        return AtlasSource::Rect{(float)(r.x + GUTTER), (float)(r.y + GUTTER), (float)(r.x + r.w - GUTTER), (float)(r.y + r.h - GUTTER)};
+    };
+    auto within = [](const AtlasSource::Rect& r, const AtlasSource::Rect& slot) {
+        return r.left >= slot.left && r.top >= slot.top && r.right <= slot.right && r.bottom <= slot.bottom;
+    };
+
+    auto sa = slot(*a);
+    auto sb = slot(*b);
+    CHECK(sa.right < sb.left);
+
+    auto whole = AtlasSource::map(sa, 0, 0, 16, 16);
+    CHECK(whole && whole->left == sa.left && whole->top == sa.top && whole->right == sa.right && whole->bottom == sa.bottom);
+
+    auto part = AtlasSource::map(sb, 4, 2, 8, 6);
+    CHECK(part && part->left == sb.left + 4 && part->top == sb.top + 2 && part->right == sb.left + 12 && part->bottom == sb.top + 8);
+    CHECK(within(*part, sb));
+
+    // Anything partly outside the image would reach over the gutter into the neighbour, those go back to the standalone bitmap.
+    CHECK(!AtlasSource::map(sa, 8, 0, 16, 16));
+    CHECK(!AtlasSource::map(sa, 0, 1, 16, 16));
+    CHECK(!AtlasSource::map(sb, -2, 0, 8, 8));
+    CHECK(!AtlasSource::map(sb, 0, -0.5f, 8, 8));
+    CHECK(!AtlasSource::map(sa, 4, 4, -2, 2));
+    CHECK(!AtlasSource::map(sa, 4, 4, 2, 20));
+    CHECK(!AtlasSource::map(sa, std::nanf(""), 0, 2, 2));
+
+    // Exactly at the far edge is still inside.
+    auto edge = AtlasSource::map(sa, 15, 15, 1, 1);
+    CHECK(edge && within(*edge, sa) && edge->right == sa.right && edge->bottom == sa.bottom);
+}
+} // namespace
+
+int main() {
+    invalid_sizes();
+    bottom_left();
+    exact_fit();
+    no_overlaps();
+    release_and_clear();
+    atlas_sources();
+    return check::result();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+// What the benchmarks share: argument parsing and timing.
+namespace bench {
+using Clock = std::chrono::steady_clock;
+
+// Written to by every benchmark so the work it measures can't be optimized away.
+inline volatile uint64_t g_sink{};
+
+// The value following name on the command line, or fallback. Always at least 1.
+inline int arg(int argc, char** argv, std::string_view name, int fallback) {
+    for (auto i = 1; i + 1 < argc; ++i) {
+        if (argv[i] == name) {
+            return std::max(std::atoi(argv[i + 1]), 1);
+        }
+    }
+
+    return fallback;
+}
+
+// Seconds the fastest of runs calls to fn took, the slower ones only measured more noise.
+template <typename Fn> double best_of(int runs, Fn&& fn) {
+    auto best = Clock::duration::max();
+
+    for (auto i = 0; i < runs; ++i) {
+        auto start = Clock::now();
+        fn();
+        best = std::min(best, Clock::now() - start);
+    }
+
+    return std::chrono::duration<double>{best}.count();
+}
+} // namespace bench
@@ -0,0 +1,150 @@
+// Times the two ways d2d functions are bound to Lua, see LuaStack.hpp: sol2 lambdas like most of the d2d table, and raw C functions
+// like the ones scripts call every frame. Both record into a plain vector, so what's left is the cost of the call and its arguments.
+//
+//     refd2d-bench-lua [--calls N] [--runs N]
+
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "LuaStack.hpp"
+
+#include "Bench.hpp"
+
+namespace {
+struct Recorded {
+    float x{};
+    float y{};
+    float w{};
+    float h{};
+    unsigned int color{};
+    bool clockwise{};
+};
+
+std::vector<Recorded> g_recorded{};
+
+std::pair<float, float> measure(std::string_view text) {
+    return {(float)text.size() * 8.0f, 16.0f};
+}
+
+// The same shapes as the plugin's lua_draw functions: every argument read first, then the work in protect.
+namespace raw {
+using namespace lua_stack;
+
+int fill_rect(lua_State* l) {
+    auto x = number(l, 1);
+    auto y = number(l, 2);
+    auto w = number(l, 3);
+    auto h = number(l, 4);
+    auto c = color(l, 5);
+
+    return protect(l, [&] {
+        g_recorded.push_back({x, y, w, h, c, true});
+        return 0;
+    });
+}
+
+int pie(lua_State* l) {
+    auto x = number(l, 1);
+    auto y = number(l, 2);
+    auto r = number(l, 3);
+    auto start_angle = number(l, 4);
+    auto sweep_angle = number(l, 5);
+    auto c = color(l, 6);
+    auto clockwise = opt_bool(l, 7, true);
+
+    return protect(l, [&] {
+        g_recorded.push_back({x, y, r + start_angle, sweep_angle, c, clockwise});
+        return 0;
+    });
+}
+
+int measure_text(lua_State* l) {
+    size_t length{};
+    auto str = luaL_checklstring(l, 1, &length);
+
+    return protect(l, [&] {
+        auto [w, h] = measure(std::string_view{str, length});
+        lua_pushnumber(l, w);
+        lua_pushnumber(l, h);
+        return 2;
+    });
+}
+} // namespace raw
+
+// The sol2 bindings these replaced in the plugin.
+void bind_sol(sol::table d2d) {
+    d2d["fill_rect"] = [](float x, float y, float w, float h, unsigned int color) { g_recorded.push_back({x, y, w, h, color, true}); };
+    d2d["pie"] = [](float x, float y, float r, float start_angle, float sweep_angle, unsigned int color, sol::object clockwise_obj) {
+        auto clockwise = true;
+
+        if (clockwise_obj.is<bool>()) {
+            clockwise = clockwise_obj.as<bool>();
+        }
+
+        g_recorded.push_back({x, y, r + start_angle, sweep_angle, color, clockwise});
+    };
+    d2d["measure_text"] = [](sol::this_state s, const char* text) {
+        auto [w, h] = measure(text);
+        sol::variadic_results results{};
+        results.push_back(sol::make_object(s, w));
+        results.push_back(sol::make_object(s, h));
+        return results;
+    };
+}
+
+void bind_raw(sol::table d2d) {
+    d2d["fill_rect"] = &raw::fill_rect;
+    d2d["pie"] = &raw::pie;
+    d2d["measure_text"] = &raw::measure_text;
+}
+
+struct Case {
+    const char* name;
+    const char* function;
+    // Called with the function and the number of calls to make.
+    const char* script;
+};
+
+constexpr Case CASES[]{
+    {"fill_rect", "fill_rect", "local f, n = ... for i = 1, n do f(i, i, 10, 10, 0xFF00FF00) end"},
+    {"pie", "pie", "local f, n = ... for i = 1, n do f(i, i, 10, 0, 90, 0xFF00FF00) end"},
+    {"pie, clockwise given", "pie", "local f, n = ... for i = 1, n do f(i, i, 10, 0, 90, 0xFF00FF00, false) end"},
+    {"measure_text", "measure_text", "local f, n = ... local w, h for i = 1, n do w, h = f('hello') end"},
+};
+} // namespace
+
+int main(int argc, char** argv) {
+    auto calls = bench::arg(argc, argv, "--calls", 1000000);
+    auto runs = bench::arg(argc, argv, "--runs", 10);
+
+    sol::state lua{};
+    lua.open_libraries(sol::lib::base);
+    bind_sol(lua.create_named_table("sol_d2d"));
+    bind_raw(lua.create_named_table("raw_d2d"));
+    g_recorded.reserve(calls);
+
+    for (const auto& c : CASES) {
+        sol::protected_function script = lua.load(c.script);
+        double seconds[2]{};
+
+        for (auto i = 0; i < 2; ++i) {
+            sol::object fn = lua[i == 0 ? "sol_d2d" : "raw_d2d"][c.function];
+            seconds[i] = bench::best_of(runs, [&] {
+                g_recorded.clear();
+                auto result = script(fn, calls);
+
+                if (!result.valid()) {
+                    sol::error e = result;
+                    std::fprintf(stderr, "refd2d-bench-lua: %s\n", e.what());
+                    std::exit(1);
+                }
+            });
+        }
+
+        bench::g_sink = bench::g_sink + g_recorded.size();
+        std::printf("%-22s sol2 %6.1f ns, raw %6.1f ns per call\n", c.name, seconds[0] * 1e9 / calls, seconds[1] * 1e9 / calls);
+    }
+}
@@ -0,0 +1,113 @@
+// Times DrawList::prepare over a synthetic frame recorded through a DrawList::Recorder: mostly untransformed draws of every kind with
+// a few nested transforms, some of them off screen.
+//
+//     refd2d-bench-prepass [--commands N] [--runs N]
+//
+// refd2d-bench-prepass-scalar is the same built with DRAWPREPASS_SCALAR, to compare against the fallback.
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "DrawList.hpp"
+
+#include "Bench.hpp"
+
+// There are no fonts here, text is recorded without one.
+float DrawList::font_size(const D2DFont&) {
+    return 0.0f;
+}
+
+namespace {
+constexpr float WIDTH = 2560.0f;
+constexpr float HEIGHT = 1440.0f;
+
+void record(DrawList::Recorder& cmds, int count) {
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> x{-WIDTH * 0.05f, WIDTH * 1.05f};
+    std::uniform_real_distribution<float> y{-HEIGHT * 0.05f, HEIGHT * 1.05f};
+    std::uniform_real_distribution<float> size{1.0f, 200.0f};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+    std::shared_ptr<D2DFont> font{};
+    auto depth = 0;
+
+    for (auto i = 0; i < count; ++i) {
+        auto roll = unit(rng);
+
+        if (roll < 0.05f && depth < 4) {
+            // Rotated and scaled a little around the middle, nested ones stay mostly on screen.
+            auto t = DrawPrepass::Transform::make(0.0f, 0.0f, unit(rng) * 20.0f - 10.0f, 0.9f + unit(rng) * 0.2f, 0.9f + unit(rng) * 0.2f);
+            auto center = DrawPrepass::Transform::make(-WIDTH * 0.5f, -HEIGHT * 0.5f, 0.0f, 1.0f, 1.0f);
+            auto back = DrawPrepass::Transform::make(WIDTH * 0.5f, HEIGHT * 0.5f, 0.0f, 1.0f, 1.0f);
+            cmds.push_transform(DrawPrepass::multiply(DrawPrepass::multiply(center, t), back));
+            ++depth;
+            continue;
+        }
+
+        if (roll < 0.10f && depth > 0) {
+            cmds.pop_transform();
+            --depth;
+            continue;
+        }
+
+        auto color = (unsigned int)rng();
+        auto ox = x(rng);
+        auto oy = y(rng);
+        auto kind = rng() % 8;
+
+        if (kind < 3) {
+            cmds.fill_rect(ox, oy, size(rng), size(rng), color);
+        } else if (kind == 3) {
+            cmds.outline_rect(ox, oy, size(rng), size(rng), 2.0f, color);
+        } else if (kind == 4) {
+            cmds.line(ox, oy, ox + size(rng), oy + size(rng), 1.0f, color);
+        } else if (kind == 5) {
+            cmds.fill_circle(ox, oy, size(rng), size(rng), color);
+        } else if (kind == 6) {
+            cmds.text(font, "Some text", ox, oy, color);
+        } else {
+            std::string points(sizeof(float) * 2 * (3 + rng() % 6), '\0');
+            auto xy = (float*)points.data();
+
+            for (size_t j = 0; j < points.size() / sizeof(float); j += 2) {
+                xy[j] = ox + size(rng);
+                xy[j + 1] = oy + size(rng);
+            }
+
+            cmds.fill_polygon(std::move(points), color);
+        }
+    }
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    auto count = bench::arg(argc, argv, "--commands", 100000);
+    auto runs = bench::arg(argc, argv, "--runs", 50);
+
+    DrawList drawlist{};
+    auto producer = drawlist.create_producer();
+    DrawList::Recorder cmds{*producer};
+    record(cmds, count);
+    auto& batch = producer->batch();
+
+    DrawList::Prepared prepared{};
+    auto seconds = bench::best_of(runs, [&] {
+        DrawList::prepare(batch, WIDTH, HEIGHT, prepared);
+        bench::g_sink = bench::g_sink + prepared.draws.culled.size();
+    });
+
+    uint64_t culled{};
+
+    for (auto c : prepared.draws.culled) {
+        culled += c;
+    }
+
+#ifdef DRAWPREPASS_SSE2
+    const char* path = "SSE2";
+#else
+    const char* path = "scalar";
+#endif
+
+    std::printf("prepass (%s): %zu commands, %zu draws, %llu culled, best of %d: %.3f ms, %.2f ns per command\n", path, batch.size(),
+        prepared.draws.size(), (unsigned long long)culled, runs, seconds * 1e3, seconds * 1e9 / batch.size());
+}
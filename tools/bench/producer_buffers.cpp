@@ -0,0 +1,78 @@
+// Times ProducerBuffers with several threads recording and submitting batches while a consumer publishes as fast as it can, the way
+// Lua, the native API and the render worker use it.
+//
+//     refd2d-bench-producers [--producers N] [--submits N] [--items N] [--runs N]
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "ProducerBuffers.hpp"
+
+#include "Bench.hpp"
+
+namespace {
+using Buffers = ProducerBuffers<uint64_t>;
+} // namespace
+
+int main(int argc, char** argv) {
+    auto producer_count = bench::arg(argc, argv, "--producers", 4);
+    auto submits = bench::arg(argc, argv, "--submits", 100000);
+    auto items = bench::arg(argc, argv, "--items", 64);
+    auto runs = bench::arg(argc, argv, "--runs", 5);
+    uint64_t publishes{};
+
+    auto seconds = bench::best_of(runs, [&] {
+        Buffers buffers{};
+        std::vector<std::shared_ptr<Buffers::Producer>> producers{};
+
+        for (auto i = 0; i < producer_count; ++i) {
+            producers.push_back(buffers.create_producer(i));
+        }
+
+        std::atomic<int> running{producer_count};
+        std::vector<std::thread> threads{};
+
+        for (auto& producer : producers) {
+            threads.emplace_back([&, producer] {
+                for (auto seq = 0; seq < submits; ++seq) {
+                    for (auto i = 0; i < items; ++i) {
+                        producer->batch().push_back((uint64_t)seq);
+                    }
+
+                    producer->submit();
+                }
+
+                running.fetch_sub(1);
+            });
+        }
+
+        // Only publishes when something changed, like the render worker.
+        uint64_t seen{};
+        uint64_t total{};
+        publishes = 0;
+
+        while (running.load() > 0) {
+            if (auto now = buffers.submissions(); now != seen) {
+                seen = now;
+
+                for (auto batch : buffers.publish()) {
+                    total += batch->size();
+                }
+
+                ++publishes;
+            }
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        bench::g_sink = bench::g_sink + total;
+    });
+
+    auto batches = (double)producer_count * submits;
+    std::printf("%d producers, %d items per batch: %.1f ns per batch submitted, %.2f M batches/s, %llu publishes in the best run\n",
+        producer_count, items, seconds * 1e9 / submits, batches / seconds / 1e6, (unsigned long long)publishes);
+}
@@ -0,0 +1,53 @@
+// Times RectPacker filling ImageAtlas sized pages with image sized rectangles. A page that doesn't fit the next one starts over,
+// like the atlas does when it compacts.
+//
+//     refd2d-bench-packer [--rects N] [--max-size N] [--runs N]
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "RectPacker.hpp"
+
+#include "Bench.hpp"
+
+int main(int argc, char** argv) {
+    constexpr int PAGE_SIZE = 2048;
+    auto count = bench::arg(argc, argv, "--rects", 100000);
+    auto max_size = bench::arg(argc, argv, "--max-size", 128);
+    auto runs = bench::arg(argc, argv, "--runs", 5);
+
+    // Generated up front, the same for every run.
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> size{1, max_size};
+    std::vector<std::pair<int, int>> sizes(count);
+
+    for (auto& s : sizes) {
+        s = {size(rng), size(rng)};
+    }
+
+    auto pages = 0;
+    double occupancy{};
+
+    auto seconds = bench::best_of(runs, [&] {
+        RectPacker packer{PAGE_SIZE, PAGE_SIZE};
+        pages = 0;
+        occupancy = 0.0;
+
+        for (auto [w, h] : sizes) {
+            auto r = packer.insert(w, h);
+
+            if (!r) {
+                occupancy += packer.occupancy();
+                ++pages;
+                packer.clear();
+                r = packer.insert(w, h);
+            }
+
+            bench::g_sink = bench::g_sink + (uint64_t)r->x + (uint64_t)r->y;
+        }
+    });
+
+    std::printf("%d rects up to %dx%d: %.1f ns per insert, %d full pages, %.1f%% average occupancy when full\n", count, max_size,
+        max_size, seconds * 1e9 / count, pages, pages ? occupancy * 100.0 / pages : 0.0);
+}
@@ -0,0 +1,264 @@
+// Replays a capture written by reframework-d2d (see src/CaptureFile.hpp) as fast as it can, for benchmarking outside the game.
+//
+//     refd2d-replay <capture> [--backend null|d2d] [--loops N]
+//
+// The null backend only decodes the records, the d2d backend (Windows only) draws them with the plugin's painter into an offscreen
+// texture of the size the capture was made at.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "CaptureFile.hpp"
+
+#ifdef REFD2D_REPLAY_D2D
+#include <d3d11.h>
+
+#include "ChannelRecorder.hpp"
+#include "D2DPainter.hpp"
+#include "DrawList.hpp"
+#endif
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// A backend is the sink frames are replayed into. finish waits for any work it has queued up.
+class Backend : public ChannelSink {
+public:
+    virtual void finish() {}
+};
+
+// Decodes without drawing, the cost of reading the capture itself.
+class NullBackend : public Backend {
+public:
+    void define_font(uint32_t, std::string_view, std::string_view, int, bool, bool) override {}
+    void define_image(uint32_t, std::string_view) override {}
+    void begin_frame() override {}
+    void draw(const ChannelDraw&) override { ++m_draws; }
+    void end_frame() override {}
+
+    uint64_t draws() const { return m_draws; }
+
+private:
+    // Counted so the dispatch can't be optimized away.
+    uint64_t m_draws{};
+};
+
+#ifdef REFD2D_REPLAY_D2D
+// Draws with D2DPainter into a texture, the same way the plugin's render worker does.
+class D2DBackend : public Backend {
+public:
+    template <typename T> using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+    D2DBackend(uint32_t width, uint32_t height) {
+        m_factories = D2DPainter::Factories::create();
+
+        if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, D3D11_CREATE_DEVICE_BGRA_SUPPORT, nullptr, 0,
+                D3D11_SDK_VERSION, &m_device, nullptr, &m_context))) {
+            throw std::runtime_error{"Failed to create D3D11 device"};
+        }
+
+        D3D11_TEXTURE2D_DESC desc{};
+        desc.Width = width;
+        desc.Height = height;
+        desc.MipLevels = 1;
+        desc.ArraySize = 1;
+        desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+        desc.SampleDesc.Count = 1;
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+
+        if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &m_texture))) {
+            throw std::runtime_error{"Failed to create render texture"};
+        }
+
+        ComPtr<IDXGISurface> surface{};
+
+        if (FAILED(m_texture.As(&surface))) {
+            throw std::runtime_error{"Failed to query DXGI surface"};
+        }
+
+        m_painter = std::make_unique<D2DPainter>(
+            m_factories, m_device.Get(), std::vector<IDXGISurface*>{surface.Get()}, D2D1::SizeU(width, height));
+        m_recorder = std::make_unique<ChannelRecorder>(m_drawlist, DrawList::LUA_ORDER,
+            [this]() -> const D2DPainter::Factories& { return m_factories; },
+            [](const std::string& msg) { std::fprintf(stderr, "%s\n", msg.c_str()); });
+    }
+
+    void define_font(uint32_t id, std::string_view path, std::string_view family, int size, bool bold, bool italic) override {
+        m_recorder->define_font(id, path, family, size, bold, italic);
+    }
+    void define_image(uint32_t id, std::string_view path) override { m_recorder->define_image(id, path); }
+    void begin_frame() override { m_recorder->begin_frame(); }
+    void draw(const ChannelDraw& draw) override { m_recorder->draw(draw); }
+
+    void end_frame() override {
+        m_recorder->end_frame();
+        m_painter->begin(0);
+
+        for (auto batch : m_drawlist.publish()) {
+            DrawList::replay(*m_painter, *batch, m_prepared);
+        }
+
+        m_painter->end();
+    }
+
+    void finish() override {
+        D3D11_QUERY_DESC desc{D3D11_QUERY_EVENT};
+        ComPtr<ID3D11Query> query{};
+
+        if (FAILED(m_device->CreateQuery(&desc, &query))) {
+            throw std::runtime_error{"Failed to create query"};
+        }
+
+        m_context->End(query.Get());
+        BOOL done{};
+
+        while (m_context->GetData(query.Get(), &done, sizeof(done), 0) == S_FALSE) {
+        }
+    }
+
+private:
+    D2DPainter::Factories m_factories{};
+    ComPtr<ID3D11Device> m_device{};
+    ComPtr<ID3D11DeviceContext> m_context{};
+    ComPtr<ID3D11Texture2D> m_texture{};
+    std::unique_ptr<D2DPainter> m_painter{};
+    DrawList m_drawlist{};
+    DrawList::Prepared m_prepared{};
+    std::unique_ptr<ChannelRecorder> m_recorder{};
+};
+#endif
+
+// Passes each definition on only the first time its id comes up, so looping over a capture doesn't load fonts and images again.
+class DefineOnce : public ChannelSink {
+public:
+    explicit DefineOnce(ChannelSink& sink)
+        : m_sink{sink} {}
+
+    void define_font(uint32_t id, std::string_view path, std::string_view family, int size, bool bold, bool italic) override {
+        if (m_fonts.insert(id).second) {
+            m_sink.define_font(id, path, family, size, bold, italic);
+        }
+    }
+    void define_image(uint32_t id, std::string_view path) override {
+        if (m_images.insert(id).second) {
+            m_sink.define_image(id, path);
+        }
+    }
+    void begin_frame() override { m_sink.begin_frame(); }
+    void draw(const ChannelDraw& draw) override { m_sink.draw(draw); }
+    void end_frame() override { m_sink.end_frame(); }
+
+private:
+    ChannelSink& m_sink;
+    std::unordered_set<uint32_t> m_fonts{};
+    std::unordered_set<uint32_t> m_images{};
+};
+
+int usage() {
+    std::fprintf(stderr, "usage: refd2d-replay <capture> [--backend null|d2d] [--loops N]\n");
+    return 2;
+}
+} // namespace
+
+int main(int argc, char** argv) try {
+    std::string path{};
+    std::string backend_name{"null"};
+    auto loops = 1;
+
+    for (auto i = 1; i < argc; ++i) {
+        std::string_view arg{argv[i]};
+
+        if (arg == "--backend" && i + 1 < argc) {
+            backend_name = argv[++i];
+        } else if (arg == "--loops" && i + 1 < argc) {
+            loops = std::max(std::atoi(argv[++i]), 1);
+        } else if (path.empty() && !arg.starts_with("--")) {
+            path = arg;
+        } else {
+            return usage();
+        }
+    }
+
+    if (path.empty()) {
+        return usage();
+    }
+
+    std::ifstream file{path, std::ios::binary};
+
+    if (!file) {
+        throw std::runtime_error{"Failed to open " + path};
+    }
+
+    // Everything is read up front so the file isn't part of what's measured.
+    CaptureReader reader{file};
+    std::vector<CaptureFrame> frames{};
+    size_t bytes{};
+
+    for (CaptureFrame frame{}; reader.read_frame(frame);) {
+        bytes += frame.size();
+        frames.emplace_back(std::move(frame));
+    }
+
+    auto& header = reader.header();
+    std::printf("%s: %zu frames, %zu bytes, %ux%u\n", path.c_str(), frames.size(), bytes, header.width, header.height);
+
+    if (frames.empty()) {
+        return 0;
+    }
+
+    std::unique_ptr<Backend> backend{};
+
+    if (backend_name == "null") {
+        backend = std::make_unique<NullBackend>();
+    }
+#ifdef REFD2D_REPLAY_D2D
+    else if (backend_name == "d2d") {
+        if (FAILED(CoInitializeEx(nullptr, COINIT_MULTITHREADED))) {
+            throw std::runtime_error{"Failed to initialize COM"};
+        }
+
+        backend = std::make_unique<D2DBackend>(std::max(header.width, 1u), std::max(header.height, 1u));
+    }
+#endif
+    else {
+        throw std::runtime_error{"Unknown or unsupported backend " + backend_name};
+    }
+
+    DefineOnce sink{*backend};
+
+    // The first pass loads the resources and warms up, it isn't measured.
+    for (auto& frame : frames) {
+        replay_capture_frame(frame, sink);
+    }
+
+    backend->finish();
+    auto start = Clock::now();
+
+    for (auto loop = 0; loop < loops; ++loop) {
+        for (auto& frame : frames) {
+            replay_capture_frame(frame, sink);
+        }
+    }
+
+    backend->finish();
+
+    auto seconds = std::chrono::duration<double>{Clock::now() - start}.count();
+    auto replayed = (double)frames.size() * loops;
+    std::printf("%s: %.0f frames in %.3f s, %.1f frames/s, %.4f ms per frame\n", backend_name.c_str(), replayed, seconds,
+        replayed / seconds, seconds * 1000.0 / replayed);
+
+    return 0;
+} catch (const std::exception& e) {
+    std::fprintf(stderr, "refd2d-replay: %s\n", e.what());
+    return 1;
+}